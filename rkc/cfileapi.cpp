@@ -21,17 +21,17 @@ static rkcUFilePos_t CFileTell(void *f)
 
 static int CFileSeekStart(void *f, rkcUFilePos_t pos)
 {
-	return fseek(static_cast<FILE*>(f), static_cast<rkcUFilePos_t>(pos), SEEK_SET) != 0;
+	return fseek(static_cast<FILE*>(f), static_cast<rkcUFilePos_t>(pos), SEEK_SET) == 0;
 }
 
 static int CFileSeekEnd(void *f, rkcFilePos_t pos)
 {
-	return fseek(static_cast<FILE*>(f), static_cast<rkcUFilePos_t>(pos), SEEK_END) != 0;
+	return fseek(static_cast<FILE*>(f), static_cast<rkcUFilePos_t>(pos), SEEK_END) == 0;
 }
 
 static int CFileSeekCurrent(void *f, rkcFilePos_t pos)
 {
-	return fseek(static_cast<FILE*>(f), static_cast<rkcUFilePos_t>(pos), SEEK_CUR) != 0;
+	return fseek(static_cast<FILE*>(f), static_cast<rkcUFilePos_t>(pos), SEEK_CUR) == 0;
 }
 
 static void CFileClose(void *f)
@@ -0,0 +1,155 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rkclib/rkclib.h"
+
+RkcStreamSpec StreamFromCFile(FILE *f, bool isReadable, bool isWriteable);
+
+static const size_t kMaxPathLength = 1024;
+
+// Source trees may be on network storage, so reads are overlapped with lexing
+static const size_t kReadAheadBufferSize = 256 * 1024;
+
+// Module names are the file names without directories or extension
+static void GetModuleName(const char *path, char *outName, size_t maxLength)
+{
+	const char *nameStart = path;
+	for (const char *c = path; *c; c++)
+	{
+		if (*c == '/' || *c == '\\')
+			nameStart = c + 1;
+	}
+
+	size_t nameLength = strlen(nameStart);
+	const char *extension = strrchr(nameStart, '.');
+	if (extension)
+		nameLength = static_cast<size_t>(extension - nameStart);
+
+	if (nameLength >= maxLength)
+		nameLength = maxLength - 1;
+
+	memcpy(outName, nameStart, nameLength);
+	outName[nameLength] = 0;
+}
+
+static void GetBlobPath(const char *cacheDir, const char *moduleName, char *outPath, size_t maxLength)
+{
+	snprintf(outPath, maxLength, "%s/%s.rkcm", cacheDir, moduleName);
+}
+
+// Compiles a set of source files, reusing module blobs from cacheDir for modules whose source hasn't
+// changed since the previous run, and storing blobs for the modules that were compiled.
+int CompileWithDirectoryCache(const char *cacheDir, const char **paths, size_t numPaths, const RkcAllocatorSpec *allocSpec)
+{
+	RkcContextOptions options;
+	options.m_structSize = sizeof(RkcContextOptions);
+	options.m_trackAllocations = 0;
+	options.m_readAheadBufferSize = kReadAheadBufferSize;
+	options.m_lexerBufferSize = 0;
+	options.m_readAheadThreads = 0;
+
+	IRkcContext *context = nullptr;
+	int resultCode = RkcCreateContext(&context, allocSpec, &options);
+	if (resultCode != 0)
+		return resultCode;
+
+	IRkcComposite *composite = nullptr;
+	resultCode = RkcCreateComposite(context, &composite);
+	if (resultCode != 0)
+	{
+		RkcDestroyContext(context);
+		return resultCode;
+	}
+
+	// The composite reads the sources again if they need to be recompiled, so they stay open until it's destroyed
+	FILE **sourceFiles = static_cast<FILE**>(calloc(numPaths, sizeof(FILE*)));
+	if (numPaths > 0 && !sourceFiles)
+	{
+		RkcDestroyComposite(composite);
+		RkcDestroyContext(context);
+		return 1;
+	}
+
+	char moduleName[kMaxPathLength];
+	char blobPath[kMaxPathLength];
+
+	size_t numAdded = 0;
+	for (size_t i = 0; i < numPaths && resultCode == 0; i++)
+	{
+		FILE *f = fopen(paths[i], "rb");
+		if (!f)
+		{
+			fprintf(stderr, "Couldn't open %s\n", paths[i]);
+			resultCode = 1;
+			break;
+		}
+
+		sourceFiles[i] = f;
+
+		GetModuleName(paths[i], moduleName, sizeof(moduleName));
+
+		RkcStreamSpec streamSpec = StreamFromCFile(f, true, false);
+
+		size_t moduleIndex = 0;
+		resultCode = RkcCompositeAddProgram(composite, moduleName, &streamSpec, &moduleIndex);
+		if (resultCode != 0)
+			break;
+
+		numAdded++;
+
+		GetBlobPath(cacheDir, moduleName, blobPath, sizeof(blobPath));
+
+		FILE *blobFile = fopen(blobPath, "rb");
+		if (blobFile)
+		{
+			RkcStreamSpec blobSpec = StreamFromCFile(blobFile, true, false);
+
+			int accepted = 0;
+			resultCode = RkcCompositeImportCompiledProgram(composite, moduleIndex, &blobSpec, &accepted);
+			fclose(blobFile);
+		}
+	}
+
+	if (resultCode == 0)
+		resultCode = RkcCompositeCompile(composite, nullptr);
+
+	if (resultCode == 0)
+	{
+		for (size_t i = 0; i < numAdded; i++)
+		{
+			GetModuleName(paths[i], moduleName, sizeof(moduleName));
+			GetBlobPath(cacheDir, moduleName, blobPath, sizeof(blobPath));
+
+			FILE *blobFile = fopen(blobPath, "wb");
+			if (!blobFile)
+				continue;
+
+			RkcStreamSpec blobSpec = StreamFromCFile(blobFile, false, true);
+			const int exportResult = RkcCompiledProgramExport(composite, i, &blobSpec);
+			fclose(blobFile);
+
+			// Don't leave a truncated blob behind
+			if (exportResult != 0)
+				remove(blobPath);
+		}
+
+		RkcCompositeCompileStats stats;
+		RkcCompositeGetCompileStats(composite, &stats);
+		printf("%zu modules compiled, %zu reused\n", stats.m_numModulesCompiled, stats.m_numModulesSkipped);
+	}
+
+	RkcDestroyComposite(composite);
+	RkcDestroyContext(context);
+
+	for (size_t i = 0; i < numPaths; i++)
+	{
+		if (sourceFiles[i])
+			fclose(sourceFiles[i]);
+	}
+
+	free(sourceFiles);
+
+	return resultCode;
+}
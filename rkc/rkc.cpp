@@ -1,12 +1,15 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../rkclib/rkclib.h"
 
 
 RkcStreamSpec StreamFromCFile(FILE *f, bool isReadable, bool isWriteable);
 void RkcTest(const RkcAllocatorSpec *allocSpec);
+int RkcBenchmark(const RkcAllocatorSpec *allocSpec);
+int CompileWithDirectoryCache(const char *cacheDir, const char **paths, size_t numPaths, const RkcAllocatorSpec *allocSpec);
 
 static void *ReallocThunk(void *userdata, void *buf, size_t newSize)
 {
@@ -15,6 +18,25 @@ static void *ReallocThunk(void *userdata, void *buf, size_t newSize)
 
 int main(int argc, const char **argv)
 {
+	if (argc >= 3 && !strcmp(argv[1], "--cache-dir"))
+	{
+		RkcAllocatorSpec cacheAllocSpec;
+		cacheAllocSpec.m_realloc = ReallocThunk;
+		cacheAllocSpec.m_userdata = nullptr;
+
+		return CompileWithDirectoryCache(argv[2], argv + 3, static_cast<size_t>(argc - 3), &cacheAllocSpec);
+	}
+
+	// Times the lexer and decimal conversion loops, which are best measured in a release build
+	if (argc >= 2 && !strcmp(argv[1], "--benchmark"))
+	{
+		RkcAllocatorSpec benchmarkAllocSpec;
+		benchmarkAllocSpec.m_realloc = ReallocThunk;
+		benchmarkAllocSpec.m_userdata = nullptr;
+
+		return RkcBenchmark(&benchmarkAllocSpec);
+	}
+
 	FILE *f = fopen("D:\\experiments\\rkctests\\test.rk", "rb");
 	RkcStreamSpec streamSpec = StreamFromCFile(f, true, false);
 
@@ -0,0 +1,144 @@
+#include "AccessPatternAnalysis.h"
+#include "IAllocator.h"
+#include "RangeAnalysis.h"
+#include "Result.h"
+#include "UniformityAnalysis.h"
+
+rkci::AccessPatternAnalysis::AccessPatternAnalysis(IAllocator *alloc)
+	: m_strides(alloc)
+	, m_isLinear(alloc)
+	, m_patterns(alloc)
+{
+}
+
+rkci::Result rkci::AccessPatternAnalysis::Analyze(const Kernel::Function &function, const UniformityAnalysis &uniformity, const RangeAnalysis &ranges)
+{
+	const size_t numInstructions = function.NumInstructions();
+
+	{
+		AllocatorTagScope tagScope(*m_strides.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_strides.Resize(0));
+		RKC_CHECK(m_strides.Resize(numInstructions));
+		RKC_CHECK(m_isLinear.Resize(0));
+		RKC_CHECK(m_isLinear.Resize(numInstructions));
+		RKC_CHECK(m_patterns.Resize(0));
+		RKC_CHECK(m_patterns.Resize(numInstructions));
+	}
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::ValueIndex_t index = static_cast<Kernel::ValueIndex_t>(i);
+		const Kernel::Instruction &instr = function.GetInstruction(index);
+
+		m_strides[i] = 0;
+		m_isLinear[i] = 0;
+		m_patterns[i] = AccessPattern::kArbitrary;
+
+		if (instr.m_opcode == Kernel::Opcode::kLoad || instr.m_opcode == Kernel::Opcode::kStore)
+		{
+			const Kernel::ValueIndex_t address = instr.m_operands[0];
+			m_patterns[i] = ClassifyStride(m_isLinear[address] != 0, m_strides[address]);
+		}
+
+		if (instr.m_type == Kernel::kInvalidTypeIndex || function.GetType(instr.m_type).m_kind != Kernel::TypeKind::kInt)
+			continue;
+
+		if (uniformity.IsValueUniform(index))
+		{
+			m_isLinear[i] = 1;
+			continue;
+		}
+
+		int64_t stride = 0;
+		if (ComputeStride(function, index, ranges, stride))
+		{
+			m_strides[i] = stride;
+			m_isLinear[i] = 1;
+		}
+	}
+
+	return Result::Ok();
+}
+
+bool rkci::AccessPatternAnalysis::GetLaneStride(Kernel::ValueIndex_t value, int64_t &outStride) const
+{
+	if (!m_isLinear[value])
+		return false;
+
+	outStride = m_strides[value];
+	return true;
+}
+
+rkci::AccessPattern rkci::AccessPatternAnalysis::GetAccessPattern(Kernel::ValueIndex_t loadOrStore) const
+{
+	return m_patterns[loadOrStore];
+}
+
+bool rkci::AccessPatternAnalysis::ComputeStride(const Kernel::Function &function, Kernel::ValueIndex_t value, const RangeAnalysis &ranges, int64_t &outStride) const
+{
+	const Kernel::Instruction &instr = function.GetInstruction(value);
+
+	if (instr.m_opcode == Kernel::Opcode::kLaneIndex)
+	{
+		outStride = 1;
+		return true;
+	}
+
+	if (ranges.MayOverflow(value))
+		return false;
+
+	const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+	for (size_t i = 0; i < numOperands; i++)
+	{
+		if (!m_isLinear[instr.m_operands[i]])
+			return false;
+	}
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kConvert:
+		// Linear operands are always integers
+		outStride = m_strides[instr.m_operands[0]];
+		return true;
+
+	case Kernel::Opcode::kAdd:
+		return RangeAnalysis::CheckedAdd(m_strides[instr.m_operands[0]], m_strides[instr.m_operands[1]], outStride);
+
+	case Kernel::Opcode::kSub:
+		return RangeAnalysis::CheckedSub(m_strides[instr.m_operands[0]], m_strides[instr.m_operands[1]], outStride);
+
+	case Kernel::Opcode::kMul:
+		{
+			// A product with a uniform value that isn't known until run time has a stride that isn't
+			// either
+			const Kernel::Instruction &a = function.GetInstruction(instr.m_operands[0]);
+			const Kernel::Instruction &b = function.GetInstruction(instr.m_operands[1]);
+
+			if (a.m_opcode == Kernel::Opcode::kConstant)
+				return RangeAnalysis::CheckedMul(static_cast<int64_t>(a.m_immediate), m_strides[instr.m_operands[1]], outStride);
+
+			if (b.m_opcode == Kernel::Opcode::kConstant)
+				return RangeAnalysis::CheckedMul(m_strides[instr.m_operands[0]], static_cast<int64_t>(b.m_immediate), outStride);
+
+			return false;
+		}
+
+	default:
+		return false;
+	}
+}
+
+rkci::AccessPattern rkci::AccessPatternAnalysis::ClassifyStride(bool isLinear, int64_t stride)
+{
+	if (!isLinear)
+		return AccessPattern::kArbitrary;
+
+	if (stride == 0)
+		return AccessPattern::kUniform;
+
+	if (stride == 1)
+		return AccessPattern::kContiguous;
+
+	return AccessPattern::kStrided;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Vector.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	class RangeAnalysis;
+	class Result;
+	class UniformityAnalysis;
+
+	enum class AccessPattern : uint8_t
+	{
+		kUniform,		// Every lane addresses the same element
+		kContiguous,	// Consecutive lanes address consecutive elements
+		kStrided,		// Consecutive lanes are a constant number of elements apart
+		kArbitrary,
+	};
+
+	// Classifies the elements that each load and store addresses across the lanes of a vector, so that
+	// the backend can use broadcasts and vector loads and stores instead of gathers and scatters.
+	//
+	// An integer value is linear if it's a uniform value plus a constant multiple of the lane index.
+	// Uniform values (see UniformityAnalysis) are linear with a stride of 0 and the lane index with a
+	// stride of 1, and sums, differences, products with a constant and conversions of linear values are
+	// linear if they can't overflow (see RangeAnalysis), since wrapping would break the progression.
+	class AccessPatternAnalysis
+	{
+	public:
+		explicit AccessPatternAnalysis(IAllocator *alloc);
+
+		Result Analyze(const Kernel::Function &function, const UniformityAnalysis &uniformity, const RangeAnalysis &ranges);
+
+		// Returns false for values that aren't linear
+		bool GetLaneStride(Kernel::ValueIndex_t value, int64_t &outStride) const;
+
+		// Only meaningful for loads and stores
+		AccessPattern GetAccessPattern(Kernel::ValueIndex_t loadOrStore) const;
+
+	private:
+		bool ComputeStride(const Kernel::Function &function, Kernel::ValueIndex_t value, const RangeAnalysis &ranges, int64_t &outStride) const;
+		static AccessPattern ClassifyStride(bool isLinear, int64_t stride);
+
+		Vector<int64_t> m_strides;
+		Vector<uint8_t> m_isLinear;
+		Vector<AccessPattern> m_patterns;
+	};
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace rkc
+{
+	namespace AllocatorTags
+	{
+		// Subsystems that allocation statistics are attributed to
+		enum AllocatorTag
+		{
+			kGeneral = 0,
+
+			kLexer,
+			kBigNum,
+			kHashMap,
+			kAst,
+			kBackend,
+
+			kCount,
+		};
+	}
+
+	typedef AllocatorTags::AllocatorTag AllocatorTag_t;
+}
@@ -0,0 +1,178 @@
+#include "Arena.h"
+
+#include <string.h>
+
+rkci::Arena::Arena(IAllocator *backingAlloc, size_t chunkSize)
+	: m_backingAlloc(backingAlloc)
+	, m_chunkSize(chunkSize)
+	, m_currentChunk(nullptr)
+	, m_chunkPos(nullptr)
+	, m_chunkEnd(nullptr)
+	, m_topBlock(nullptr)
+	, m_numChunks(0)
+	, m_bytesUsed(0)
+{
+}
+
+rkci::Arena::~Arena()
+{
+	Reset();
+}
+
+void *rkci::Arena::Realloc(void *buf, size_t newSize)
+{
+	if (buf == nullptr)
+	{
+		if (newSize == 0)
+			return nullptr;
+
+		return AllocBlock(newSize);
+	}
+
+	uint8_t *block = static_cast<uint8_t*>(buf) - kBlockHeaderSize;
+	BlockHeader *header = reinterpret_cast<BlockHeader*>(block);
+	const size_t oldSize = header->m_size;
+
+	if (IsTopBlock(block))
+	{
+		if (newSize == 0)
+		{
+			m_bytesUsed -= AlignSize(oldSize);
+			m_chunkPos = block;
+			m_topBlock = nullptr;
+			return nullptr;
+		}
+
+		const size_t alignedSize = AlignSize(newSize);
+		if (alignedSize != 0 && alignedSize <= static_cast<size_t>(m_chunkEnd - static_cast<uint8_t*>(buf)))
+		{
+			m_bytesUsed = m_bytesUsed - AlignSize(oldSize) + alignedSize;
+			m_chunkPos = static_cast<uint8_t*>(buf) + alignedSize;
+			header->m_size = newSize;
+			return buf;
+		}
+	}
+	else
+	{
+		if (newSize == 0)
+			return nullptr;
+
+		if (newSize <= oldSize)
+		{
+			header->m_size = newSize;
+			return buf;
+		}
+	}
+
+	void *newBuf = AllocBlock(newSize);
+	if (!newBuf)
+		return nullptr;
+
+	memcpy(newBuf, buf, (oldSize < newSize) ? oldSize : newSize);
+	return newBuf;
+}
+
+void rkci::Arena::PushTag(rkc::AllocatorTag_t tag)
+{
+	m_backingAlloc->PushTag(tag);
+}
+
+void rkci::Arena::PopTag()
+{
+	m_backingAlloc->PopTag();
+}
+
+void rkci::Arena::Reset()
+{
+	ChunkHeader *chunk = m_currentChunk;
+	while (chunk)
+	{
+		ChunkHeader *prev = chunk->m_prev;
+		m_backingAlloc->Release(chunk);
+		chunk = prev;
+	}
+
+	m_currentChunk = nullptr;
+	m_chunkPos = nullptr;
+	m_chunkEnd = nullptr;
+	m_topBlock = nullptr;
+	m_numChunks = 0;
+	m_bytesUsed = 0;
+}
+
+size_t rkci::Arena::GetNumChunks() const
+{
+	return m_numChunks;
+}
+
+size_t rkci::Arena::GetBytesUsed() const
+{
+	return m_bytesUsed;
+}
+
+rkci::IAllocator *rkci::Arena::GetBackingAllocator() const
+{
+	return m_backingAlloc;
+}
+
+size_t rkci::Arena::AlignSize(size_t size)
+{
+	if (size > static_cast<size_t>(-1) - kMaxAlignment)
+		return 0;
+
+	return (size + kMaxAlignment - 1) / kMaxAlignment * kMaxAlignment;
+}
+
+void *rkci::Arena::AllocBlock(size_t size)
+{
+	const size_t alignedSize = AlignSize(size);
+	if (alignedSize == 0 || alignedSize > static_cast<size_t>(-1) - kBlockHeaderSize)
+		return nullptr;
+
+	const size_t blockSize = kBlockHeaderSize + alignedSize;
+	if (static_cast<size_t>(m_chunkEnd - m_chunkPos) < blockSize)
+	{
+		if (!AddChunk(blockSize))
+			return nullptr;
+	}
+
+	uint8_t *block = m_chunkPos;
+	reinterpret_cast<BlockHeader*>(block)->m_size = size;
+
+	m_chunkPos += blockSize;
+	m_topBlock = block;
+	m_bytesUsed += alignedSize;
+
+	return block + kBlockHeaderSize;
+}
+
+bool rkci::Arena::IsTopBlock(const uint8_t *block) const
+{
+	return block == m_topBlock;
+}
+
+bool rkci::Arena::AddChunk(size_t minimumSize)
+{
+	size_t capacity = m_chunkSize;
+	if (capacity < minimumSize)
+		capacity = minimumSize;
+
+	if (capacity > static_cast<size_t>(-1) - kChunkHeaderSize)
+		return false;
+
+	uint8_t *chunkMem = static_cast<uint8_t*>(m_backingAlloc->Alloc(kChunkHeaderSize + capacity));
+	if (!chunkMem)
+		return false;
+
+	ChunkHeader *chunk = reinterpret_cast<ChunkHeader*>(chunkMem);
+	chunk->m_prev = m_currentChunk;
+	chunk->m_capacity = capacity;
+
+	m_currentChunk = chunk;
+	m_chunkPos = chunkMem + kChunkHeaderSize;
+	m_chunkEnd = m_chunkPos + capacity;
+	m_topBlock = nullptr;
+	m_numChunks++;
+
+	return true;
+}
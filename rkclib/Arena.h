@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "IAllocator.h"
+
+namespace rkci
+{
+	// Bump allocator that carves blocks out of large chunks obtained from a backing allocator.
+	// Releasing a block only reclaims it if it was the most recent allocation; everything else is
+	// reclaimed at once when the arena is reset or destroyed.  Growing the most recent block is done
+	// in place, so a single growing Vector backed by an arena doesn't copy.
+	class Arena final : public IAllocator
+	{
+	public:
+		static const size_t kDefaultChunkSize = 64 * 1024;
+
+		explicit Arena(IAllocator *backingAlloc, size_t chunkSize = kDefaultChunkSize);
+		~Arena();
+
+		void *Realloc(void *buf, size_t newSize) override;
+		void PushTag(rkc::AllocatorTag_t tag) override;
+		void PopTag() override;
+
+		// Releases every chunk.  All blocks allocated from the arena become invalid.
+		void Reset();
+
+		size_t GetNumChunks() const;
+		size_t GetBytesUsed() const;
+
+		IAllocator *GetBackingAllocator() const;
+
+	private:
+		Arena(const Arena &other) = delete;
+		Arena &operator=(const Arena &other) = delete;
+
+		struct ChunkHeader
+		{
+			ChunkHeader *m_prev;
+			size_t m_capacity;
+		};
+
+		struct BlockHeader
+		{
+			size_t m_size;
+		};
+
+		static const size_t kMaxAlignment = alignof(max_align_t);
+		static const size_t kChunkHeaderSize = (sizeof(ChunkHeader) + kMaxAlignment - 1) / kMaxAlignment * kMaxAlignment;
+		static const size_t kBlockHeaderSize = (sizeof(BlockHeader) + kMaxAlignment - 1) / kMaxAlignment * kMaxAlignment;
+
+		static size_t AlignSize(size_t size);
+
+		void *AllocBlock(size_t size);
+		bool IsTopBlock(const uint8_t *block) const;
+		bool AddChunk(size_t minimumSize);
+
+		IAllocator *m_backingAlloc;
+		size_t m_chunkSize;
+
+		ChunkHeader *m_currentChunk;
+		uint8_t *m_chunkPos;
+		uint8_t *m_chunkEnd;
+		uint8_t *m_topBlock;
+
+		size_t m_numChunks;
+		size_t m_bytesUsed;
+	};
+}
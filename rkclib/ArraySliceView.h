@@ -201,11 +201,19 @@ size_t rkci::ArraySliceView<T>::Count() const
 template<class T>
 typename rkci::ArraySliceView<T>::Iterator_t rkci::ArraySliceView<T>::begin() const
 {
+#if RKC_IS_DEBUG
 	return rkci::ArraySliceViewIterator<T>(m_buffer, 0, m_count);
+#else
+	return m_buffer;
+#endif
 }
 
 template<class T>
 typename rkci::ArraySliceView<T>::Iterator_t rkci::ArraySliceView<T>::end() const
-{
+{
+#if RKC_IS_DEBUG
 	return rkci::ArraySliceViewIterator<T>(m_buffer, m_count, m_count);
+#else
+	return m_buffer + m_count;
+#endif
 }
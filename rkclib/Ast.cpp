@@ -0,0 +1,186 @@
+#include "Ast.h"
+#include "Arena.h"
+#include "ArraySliceView.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+#include <new>
+
+rkci::ResultRV<rkci::Ast::ModuleFile> rkci::Ast::ModuleFile::Create(IAllocator &alloc, size_t arenaChunkSize)
+{
+	AllocatorTagScope tagScope(alloc, rkc::AllocatorTags::kAst);
+
+	void *arenaMem = alloc.Alloc(sizeof(Arena));
+	if (!arenaMem)
+		return rkc::ResultCodes::kOutOfMemory;
+
+	Arena *arena = new (arenaMem) Arena(&alloc, arenaChunkSize);
+
+	return ModuleFile(arena);
+}
+
+rkci::Ast::ModuleFile::ModuleFile(Arena *arena)
+	: m_arena(arena)
+	, m_root(kInvalidNodeIndex)
+	, m_kinds(arena)
+	, m_nodes(arena)
+	, m_childIndexes(arena)
+	, m_stringBytes(arena)
+	, m_strings(arena)
+{
+}
+
+rkci::Ast::ModuleFile::ModuleFile(ModuleFile &&other)
+	: m_arena(other.m_arena)
+	, m_root(other.m_root)
+	, m_kinds(static_cast<Vector<uint8_t>&&>(other.m_kinds))
+	, m_nodes(static_cast<Vector<Node>&&>(other.m_nodes))
+	, m_childIndexes(static_cast<Vector<NodeIndex_t>&&>(other.m_childIndexes))
+	, m_stringBytes(static_cast<Vector<uint8_t>&&>(other.m_stringBytes))
+	, m_strings(static_cast<Vector<StringRef>&&>(other.m_strings))
+{
+	other.m_arena = nullptr;
+	other.m_root = kInvalidNodeIndex;
+}
+
+rkci::Ast::ModuleFile::~ModuleFile()
+{
+	DestroyArena();
+}
+
+rkci::Ast::ModuleFile &rkci::Ast::ModuleFile::operator=(ModuleFile &&other)
+{
+	if (this != &other)
+	{
+		// Destroying the arena empties this module's vectors, so it has to happen before they take the
+		// other module's storage
+		DestroyArena();
+
+		m_arena = other.m_arena;
+		m_root = other.m_root;
+
+		m_kinds = static_cast<Vector<uint8_t>&&>(other.m_kinds);
+		m_nodes = static_cast<Vector<Node>&&>(other.m_nodes);
+		m_childIndexes = static_cast<Vector<NodeIndex_t>&&>(other.m_childIndexes);
+		m_stringBytes = static_cast<Vector<uint8_t>&&>(other.m_stringBytes);
+		m_strings = static_cast<Vector<StringRef>&&>(other.m_strings);
+
+		other.m_arena = nullptr;
+		other.m_root = kInvalidNodeIndex;
+	}
+
+	return *this;
+}
+
+rkci::ResultRV<rkci::Ast::NodeIndex_t> rkci::Ast::ModuleFile::AddNode(NodeKind kind, const ArraySliceView<const NodeIndex_t> &children, uint32_t data, uint32_t filePos)
+{
+	const size_t nodeIndex = m_nodes.Count();
+	const size_t firstChildSlot = m_childIndexes.Count();
+
+	if (nodeIndex >= kInvalidNodeIndex || children.Count() > 0xffffffffu - firstChildSlot)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+#if RKC_IS_DEBUG
+	for (NodeIndex_t child : children)
+	{
+		RKC_ASSERT(child < nodeIndex);
+	}
+#endif
+
+	Node node;
+	node.m_firstChildSlot = static_cast<uint32_t>(firstChildSlot);
+	node.m_numChildren = static_cast<uint32_t>(children.Count());
+	node.m_data = data;
+	node.m_filePos = filePos;
+
+	AllocatorTagScope tagScope(*m_arena, rkc::AllocatorTags::kAst);
+
+	RKC_CHECK(m_childIndexes.AppendRange(children));
+	RKC_CHECK(m_nodes.Append(node));
+	RKC_CHECK(m_kinds.Append(static_cast<uint8_t>(kind)));
+
+	return static_cast<NodeIndex_t>(nodeIndex);
+}
+
+rkci::ResultRV<rkci::Ast::StringIndex_t> rkci::Ast::ModuleFile::AddString(const ArraySliceView<const uint8_t> &bytes)
+{
+	const size_t stringIndex = m_strings.Count();
+	const size_t offset = m_stringBytes.Count();
+
+	if (stringIndex >= 0xffffffffu || bytes.Count() > 0xffffffffu - offset)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	StringRef stringRef;
+	stringRef.m_offset = static_cast<uint32_t>(offset);
+	stringRef.m_length = static_cast<uint32_t>(bytes.Count());
+
+	AllocatorTagScope tagScope(*m_arena, rkc::AllocatorTags::kAst);
+
+	RKC_CHECK(m_stringBytes.AppendRange(bytes));
+	RKC_CHECK(m_strings.Append(stringRef));
+
+	return static_cast<StringIndex_t>(stringIndex);
+}
+
+void rkci::Ast::ModuleFile::SetRoot(NodeIndex_t root)
+{
+	RKC_ASSERT(root < m_nodes.Count());
+	m_root = root;
+}
+
+rkci::Ast::NodeIndex_t rkci::Ast::ModuleFile::GetRoot() const
+{
+	return m_root;
+}
+
+size_t rkci::Ast::ModuleFile::NumNodes() const
+{
+	return m_nodes.Count();
+}
+
+rkci::Ast::NodeKind rkci::Ast::ModuleFile::GetKind(NodeIndex_t index) const
+{
+	return static_cast<NodeKind>(m_kinds[index]);
+}
+
+const rkci::Ast::Node &rkci::Ast::ModuleFile::GetNode(NodeIndex_t index) const
+{
+	return m_nodes[index];
+}
+
+rkci::ArraySliceView<const rkci::Ast::NodeIndex_t> rkci::Ast::ModuleFile::GetChildren(NodeIndex_t index) const
+{
+	const Node &node = m_nodes[index];
+	return m_childIndexes.Slice().Subrange(node.m_firstChildSlot, node.m_numChildren);
+}
+
+rkci::ArraySliceView<const uint8_t> rkci::Ast::ModuleFile::GetString(StringIndex_t index) const
+{
+	const StringRef &stringRef = m_strings[index];
+	return m_stringBytes.Slice().Subrange(stringRef.m_offset, stringRef.m_length);
+}
+
+const rkci::Arena *rkci::Ast::ModuleFile::GetArena() const
+{
+	return m_arena;
+}
+
+void rkci::Ast::ModuleFile::DestroyArena()
+{
+	if (!m_arena)
+		return;
+
+	// The vectors' storage belongs to the arena, so empty them first to keep their destructors from
+	// touching released chunks
+	m_kinds = Vector<uint8_t>(m_arena);
+	m_nodes = Vector<Node>(m_arena);
+	m_childIndexes = Vector<NodeIndex_t>(m_arena);
+	m_stringBytes = Vector<uint8_t>(m_arena);
+	m_strings = Vector<StringRef>(m_arena);
+
+	IAllocator *alloc = m_arena->GetBackingAllocator();
+	m_arena->~Arena();
+	alloc->Release(m_arena);
+
+	m_arena = nullptr;
+}
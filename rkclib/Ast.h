@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "Vector.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	class Arena;
+	template<class T> class ArraySliceView;
+	template<class T> class ResultRV;
+
+	namespace Ast
+	{
+		typedef uint32_t NodeIndex_t;
+		typedef uint32_t StringIndex_t;
+
+		static const NodeIndex_t kInvalidNodeIndex = 0xffffffffu;
+
+		enum class NodeKind : uint8_t
+		{
+			kInvalid,
+
+			kModule,
+			kName,
+			kNumberLiteral,
+			kStringLiteral,
+			kCharacterLiteral,
+			kPunctuation,
+		};
+
+		// Nodes refer to their children through a contiguous run of the module's child index array, so
+		// the parser builds bottom-up: children are added before their parent.  The node kind lives in a
+		// separate byte array so that kind-driven traversals only touch one byte per node.
+		struct Node
+		{
+			uint32_t m_firstChildSlot;
+			uint32_t m_numChildren;
+			uint32_t m_data;
+			uint32_t m_filePos;
+		};
+
+		struct StringRef
+		{
+			uint32_t m_offset;
+			uint32_t m_length;
+		};
+
+		// All of a module's AST storage comes from one arena, so building it costs a handful of large
+		// allocations and destroying it releases every node at once without visiting them.
+		class ModuleFile
+		{
+		public:
+			static ResultRV<ModuleFile> Create(IAllocator &alloc, size_t arenaChunkSize);
+
+			ModuleFile(ModuleFile &&other);
+			~ModuleFile();
+
+			ModuleFile &operator=(ModuleFile &&other);
+
+			ResultRV<NodeIndex_t> AddNode(NodeKind kind, const ArraySliceView<const NodeIndex_t> &children, uint32_t data, uint32_t filePos);
+			ResultRV<StringIndex_t> AddString(const ArraySliceView<const uint8_t> &bytes);
+
+			void SetRoot(NodeIndex_t root);
+			NodeIndex_t GetRoot() const;
+
+			size_t NumNodes() const;
+			NodeKind GetKind(NodeIndex_t index) const;
+			const Node &GetNode(NodeIndex_t index) const;
+			ArraySliceView<const NodeIndex_t> GetChildren(NodeIndex_t index) const;
+			ArraySliceView<const uint8_t> GetString(StringIndex_t index) const;
+
+			const Arena *GetArena() const;
+
+		private:
+			explicit ModuleFile(Arena *arena);
+			ModuleFile(const ModuleFile &other) = delete;
+
+			void DestroyArena();
+
+			Arena *m_arena;
+			NodeIndex_t m_root;
+
+			Vector<uint8_t> m_kinds;
+			Vector<Node> m_nodes;
+			Vector<NodeIndex_t> m_childIndexes;
+			Vector<uint8_t> m_stringBytes;
+			Vector<StringRef> m_strings;
+		};
+	}
+}
@@ -0,0 +1,138 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "BigUBinFloatProto.h"
+#include "BigUDecFloatProto.h"
+#include "BigUFloat.h"
+#include "DecBin.h"
+#include "DecPowerCache.h"
+#include "FeedStream.h"
+#include "FloatSpec.h"
+#include "Lexer.h"
+#include "MoveOrCopy.h"
+#include "NumStr.h"
+#include "Vector.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace rkci
+{
+	namespace Benchmarks
+	{
+		// Names, operators, numbers, strings and comments, so every token parser is on the path
+		static const char *const kLexBenchmarkLine =
+			"\tresult_value = (first_operand + 0x1F) * 12.5e-3f - other_name[index] // trailing comment\n"
+			"\tmessage = \"a string with \\\" an escape\" /* block comment */ <<= shift_amount\n";
+
+		// NumStr doesn't take exponents yet, so large and small values are written out
+		static const char *const kDecBinBenchmarkNumbers[] =
+		{
+			"22223.511111111111111111111111111111",
+			"0.1",
+			"123456.789",
+			"602214076000000000000000",
+			"0.000000000000000000000000000001",
+			"299792458",
+		};
+
+		static double SecondsSince(const std::chrono::steady_clock::time_point &start)
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		static Result BenchmarkLexer(IAllocator &alloc, size_t numLines)
+		{
+			const size_t lineLength = strlen(kLexBenchmarkLine);
+			const ArraySliceView<const uint8_t> line(reinterpret_cast<const uint8_t*>(kLexBenchmarkLine), lineLength);
+
+			FeedStream stream(&alloc);
+			for (size_t i = 0; i < numLines; i++)
+			{
+				RKC_CHECK(stream.Append(line));
+			}
+
+			Lexer lexer(&stream, &alloc, Lexer::kDefaultBufferSize);
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			size_t numTokens = 0;
+			for (;;)
+			{
+				RKC_CHECK_RV(LexToken, token, lexer.GetNextToken());
+
+				if (token.m_tokenType == LexTokenType::kEndOfFile)
+					break;
+
+				numTokens++;
+			}
+
+			const double seconds = SecondsSince(start);
+			const double numMegabytes = static_cast<double>(lineLength * numLines) / (1024.0 * 1024.0);
+
+			printf("lexer: %zu tokens from %.1f MB in %.3f s, %.1f MB/s\n", numTokens, numMegabytes, seconds, numMegabytes / seconds);
+
+			return Result::Ok();
+		}
+
+		static Result BenchmarkDecBin(IAllocator &alloc, size_t numRounds, DecPowerCache *powerCache)
+		{
+			const size_t kNumNumbers = sizeof(kDecBinBenchmarkNumbers) / sizeof(kDecBinBenchmarkNumbers[0]);
+			const FloatSpec floatSpecs[] =
+			{
+				FloatSpec(true, 8, 23, 127, true, true),
+				FloatSpec(true, 11, 52, 1023, true, true),
+			};
+
+			NumStr numStr(alloc);
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			size_t numConversions = 0;
+			for (size_t round = 0; round < numRounds; round++)
+			{
+				for (size_t i = 0; i < kNumNumbers; i++)
+				{
+					const char *number = kDecBinBenchmarkNumbers[i];
+
+					uint32_t numTrailingZeroes = 0;
+					RKC_CHECK_RV(BigUDecFloat_t, dec, numStr.DecimalUTF8ToDecFloat(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(number), strlen(number)), numTrailingZeroes));
+
+					for (const FloatSpec &floatSpec : floatSpecs)
+					{
+						RKC_CHECK_RV(BigUBinFloat_t, bin, DecBin::DecToBin(dec, floatSpec, numTrailingZeroes, powerCache));
+						RKC_CHECK(DecBin::BinToDecWithFloatSpec(bin, floatSpec, powerCache).DiscardValue());
+
+						numConversions += 2;
+					}
+				}
+			}
+
+			const double seconds = SecondsSince(start);
+
+			printf("decbin (%s): %zu conversions in %.3f s, %.2f us each\n", powerCache ? "cached powers" : "uncached", numConversions, seconds, seconds * 1000000.0 / static_cast<double>(numConversions));
+
+			return Result::Ok();
+		}
+	}
+}
+
+static rkci::Result RkcBenchmarkInternal(rkci::IAllocator &alloc)
+{
+	RKC_CHECK(rkci::Benchmarks::BenchmarkLexer(alloc, 200000));
+	RKC_CHECK(rkci::Benchmarks::BenchmarkDecBin(alloc, 20000, nullptr));
+
+	rkci::DecPowerCache powerCache(alloc);
+	RKC_CHECK(rkci::Benchmarks::BenchmarkDecBin(alloc, 20000, &powerCache));
+
+	return rkci::Result::Ok();
+}
+
+int RkcRunBenchmarks(rkci::IAllocator &alloc)
+{
+	rkci::Result result((RkcBenchmarkInternal(alloc)));
+	result.Handle();
+
+	return static_cast<int>(result.GetCode());
+}
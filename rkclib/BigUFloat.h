@@ -90,6 +90,7 @@ namespace rkci
 		BigUFloat<T> &operator=(const BigUFloat<T> &other) = delete;
 
 		Result AssignAddInPlaceSorted(const BigUFloat<T> &lower, const BigUFloat<T> &higher);
+		Fragment_t GetDigitsAtPlace(int32_t place) const;
 		bool CompareFirstMismatchedFragment(const BigUFloat<T> &other, bool(*func)(const Fragment_t &a, const Fragment_t &b)) const;
 
 		static Result NormalizeFragments(FragmentVector_t &fragVector, uint32_t &outRemovedLowDigits, uint32_t &outSignificantDigits);
@@ -214,7 +215,7 @@ rkci::Result rkci::BigUFloat<T>::ShiftInPlace(int32_t offset)
 		return rkc::ResultCodes::kIntegerOverflow;
 
 	const int32_t newLowPlace = m_lowPlace + offset;
-	if (newLowPlace >= -kMinLowPlace || newLowPlace >= kMaxLowPlace)
+	if (newLowPlace < kMinLowPlace || newLowPlace >= kMaxLowPlace)
 		return rkc::ResultCodes::kIntegerOverflow;
 
 	m_lowPlace = newLowPlace;
@@ -344,7 +345,7 @@ rkci::Result rkci::BigUFloat<T>::SubtractInPlace(const BigUFloat<T> &other)
 		for (size_t thisFragIndex = 0; thisFragIndex < thisFragmentsCount; thisFragIndex++)
 		{
 			size_t resultFragIndex = thisFragIndex + fragmentsBelowThis;
-			FragmentWithCarry_t added = newFragmentsSlice[resultFragIndex] + thisFragmentsSlice[thisFragIndex];
+			FragmentWithCarry_t added = static_cast<FragmentWithCarry_t>(newFragmentsSlice[resultFragIndex]) + thisFragmentsSlice[thisFragIndex];
 			if (carry)
 				added++;
 
@@ -370,9 +371,15 @@ rkci::Result rkci::BigUFloat<T>::SubtractInPlace(const BigUFloat<T> &other)
 template<class T>
 rkci::Result rkci::BigUFloat<T>::MultiplyInPlace(const BigUFloat<T> &other)
 {
-	if (other.IsZero() || this->IsZero())
+	if (this->IsZero())
 		return rkci::Result::Ok();
 
+	if (other.IsZero())
+	{
+		(*this) = BigUFloat<T>();
+		return rkci::Result::Ok();
+	}
+
 	if (this->GetNumDigits() == 1)
 	{
 		const Fragment_t fragment = this->GetFragment(0);
@@ -643,105 +650,52 @@ rkci::Result rkci::BigUFloat<T>::AssignAddInPlaceSorted(const rkci::BigUFloat<T>
 	return Result::Ok();
 }
 
+// Gets the kDigitsPerFragment digits starting at a place, as a fragment
 template<class T>
-bool rkci::BigUFloat<T>::CompareFirstMismatchedFragment(const BigUFloat<T> &other, bool(*func)(const Fragment_t &a, const Fragment_t &b)) const
+typename rkci::BigUFloat<T>::Fragment_t rkci::BigUFloat<T>::GetDigitsAtPlace(int32_t place) const
 {
-	RKC_ASSERT(static_cast<int32_t>(m_numDigits) + m_lowPlace == static_cast<int32_t>(other.m_numDigits) + other.m_lowPlace);
+	const int32_t relativePlace = place - m_lowPlace;
+	const int32_t numFragments = static_cast<int32_t>(m_fragments.Count());
 
-	int32_t otherPlaceToThisPlace = m_lowPlace - other.m_lowPlace;
-	int32_t thisPlaceToOtherPlace = other.m_lowPlace - m_lowPlace;
+	if (numFragments == 0 || relativePlace <= -static_cast<int32_t>(kDigitsPerFragment))
+		return 0;
 
-	const ArraySliceView<const Fragment_t> thisFrags = m_fragments.Slice();
-	const ArraySliceView<const Fragment_t> otherFrags = other.m_fragments.Slice();
+	// Starts below the low digit, so only the first fragment's low digits are in it
+	if (relativePlace < 0)
+		return m_fragments[0] % T::GetFragmentPower(kDigitsPerFragment + relativePlace) * T::GetFragmentPower(-relativePlace);
 
-	int32_t digitMisalignment = otherPlaceToThisPlace % static_cast<int32_t>(kDigitsPerFragment);
-	int32_t fragmentMisalignment = 0;
-	if (digitMisalignment < 0)
-		digitMisalignment += kDigitsPerFragment;
+	const int32_t fragmentIndex = relativePlace / static_cast<int32_t>(kDigitsPerFragment);
+	const uint32_t offset = static_cast<uint32_t>(relativePlace) % kDigitsPerFragment;
 
-	fragmentMisalignment = (otherPlaceToThisPlace - digitMisalignment) / kDigitsPerFragment;
+	Fragment_t digits = 0;
+	if (fragmentIndex < numFragments)
+		digits = m_fragments[fragmentIndex] / T::GetFragmentPower(offset);
 
-	// digit + fragment misalignment is how far RIGHT other needs to be shifted to align with our fragments
-
-	if (digitMisalignment == 0)
-	{
-		for (size_t rfi = 0; rfi < thisFrags.Count(); rfi++)
-		{
-			const size_t fragmentIndex = thisFrags.Count() - 1 - rfi;
-			const int32_t otherFragmentIndex = static_cast<int32_t>(fragmentIndex) + fragmentMisalignment;
-
-			Fragment_t otherFrag = 0;
-			const Fragment_t thisFrag = thisFrags[otherFragmentIndex];
-			if (otherFragmentIndex < 0 || static_cast<size_t>(otherFragmentIndex) >= otherFrags.Count())
-				otherFrag = otherFrags[otherFragmentIndex];
-		}
+	if (offset != 0 && fragmentIndex + 1 < numFragments)
+		digits += m_fragments[fragmentIndex + 1] % T::GetFragmentPower(offset) * T::GetFragmentPower(kDigitsPerFragment - offset);
 
-		if (fragmentMisalignment > 0)
-		{
-			for (size_t rfi = 0; rfi < static_cast<size_t>(fragmentMisalignment); rfi++)
-			{
-				const size_t otherSplittableFragmentIndex = static_cast<size_t>(fragmentMisalignment - 1) - rfi;
+	return digits;
+}
 
-				const Fragment_t otherFragment = otherFrags[otherSplittableFragmentIndex];
+// Compares fragment-sized runs of digits from the top down, so the two values don't need their
+// fragments to line up
+template<class T>
+bool rkci::BigUFloat<T>::CompareFirstMismatchedFragment(const BigUFloat<T> &other, bool(*func)(const Fragment_t &a, const Fragment_t &b)) const
+{
+	RKC_ASSERT(static_cast<int32_t>(m_numDigits) + m_lowPlace == static_cast<int32_t>(other.m_numDigits) + other.m_lowPlace);
 
-				if (otherFragment != 0)
-					return func(0, otherFragment);
-			}
-		}
+	const int32_t lowestPlace = (m_lowPlace < other.m_lowPlace) ? m_lowPlace : other.m_lowPlace;
 
-		return false;
-	}
-	else
+	for (int32_t place = m_lowPlace + static_cast<int32_t>(m_numDigits) - static_cast<int32_t>(kDigitsPerFragment); place + static_cast<int32_t>(kDigitsPerFragment) > lowestPlace; place -= static_cast<int32_t>(kDigitsPerFragment))
 	{
-		const Fragment_t split = T::GetFragmentPower(digitMisalignment);
-		const Fragment_t raise = T::GetFragmentPower(kDigitsPerFragment - digitMisalignment);
-
-		const int32_t otherFragmentWithHighHalf = static_cast<int32_t>(thisFrags.Count()) + fragmentMisalignment;
-		Fragment_t nextOtherFragment = 0;
-		if (otherFragmentWithHighHalf >= 0 && static_cast<size_t>(otherFragmentWithHighHalf) < otherFrags.Count())
-			nextOtherFragment = otherFrags[otherFragmentWithHighHalf] % split * raise;
-
-		for (size_t rfi = 0; rfi < thisFrags.Count(); rfi++)
-		{
-			const size_t fragmentIndex = thisFrags.Count() - 1 - rfi;
-			const int32_t otherSplittableFragmentIndex = static_cast<int32_t>(fragmentIndex) + fragmentMisalignment;
-
-			Fragment_t otherFragment = nextOtherFragment;
-			nextOtherFragment = 0;
-
-
-			if (otherSplittableFragmentIndex >= 0 && static_cast<size_t>(otherSplittableFragmentIndex) < otherFrags.Count())
-			{
-				const Fragment_t otherFragmentUnsplit = otherFrags[otherSplittableFragmentIndex];
-				otherFragment += otherFragmentUnsplit / split;
-				nextOtherFragment = otherFragmentUnsplit % split * raise;
-			}
-
-			const Fragment_t thisFragment = thisFrags[fragmentIndex];
-			if (thisFragment != otherFragment)
-				return func(thisFragment, otherFragment);
-		}
-
-		if (fragmentMisalignment > 0)
-		{
-			for (size_t rfi = 0; rfi < static_cast<size_t>(fragmentMisalignment); rfi++)
-			{
-				const size_t otherSplittableFragmentIndex = static_cast<size_t>(fragmentMisalignment - 1) - rfi;
-
-				const Fragment_t otherFragmentUnsplit = otherFrags[otherSplittableFragmentIndex];
-				const Fragment_t otherFragment = nextOtherFragment + otherFragmentUnsplit / split;
-				nextOtherFragment = otherFragmentUnsplit % split * raise;
-			}
-
-			if (nextOtherFragment != 0)
-				return func(0, nextOtherFragment);
-		}
-
-		if (nextOtherFragment != 0)
-			return func(0, nextOtherFragment);
+		const Fragment_t thisDigits = GetDigitsAtPlace(place);
+		const Fragment_t otherDigits = other.GetDigitsAtPlace(place);
 
-		return false;
+		if (thisDigits != otherDigits)
+			return func(thisDigits, otherDigits);
 	}
+
+	return false;
 }
 
 template<class T>
@@ -822,6 +776,11 @@ rkci::BigUFloat<T> &rkci::BigUFloat<T>::operator=(BigUFloat<T> &&other)
 template<class T>
 bool rkci::BigUFloat<T>::operator<(const BigUFloat<T> &other) const
 {
+	if (other.IsZero())
+		return false;
+	if (this->IsZero())
+		return true;
+
 	const int32_t thisTopDigit = m_lowPlace + m_numDigits;
 	const int32_t otherTopDigit = other.m_lowPlace + other.m_numDigits;
 
@@ -836,6 +795,11 @@ bool rkci::BigUFloat<T>::operator<(const BigUFloat<T> &other) const
 template<class T>
 bool rkci::BigUFloat<T>::operator<=(const BigUFloat<T> &other) const
 {
+	if (this->IsZero())
+		return true;
+	if (other.IsZero())
+		return false;
+
 	const int32_t thisTopDigit = m_lowPlace + m_numDigits;
 	const int32_t otherTopDigit = other.m_lowPlace + other.m_numDigits;
 
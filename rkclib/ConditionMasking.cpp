@@ -0,0 +1,528 @@
+#include "ConditionMasking.h"
+#include "ArraySliceView.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+rkci::ConditionMasking::ConditionMasking(IAllocator *alloc)
+	: m_input(nullptr)
+	, m_output(nullptr)
+	, m_isEmitting(false)
+	, m_regionEnds(alloc)
+	, m_elses(alloc)
+	, m_breakableDepths(alloc)
+	, m_valueMap(alloc)
+	, m_flags(alloc)
+	, m_flagStack(alloc)
+	, m_nextFlag(0)
+	, m_currentBreakableDepth(0)
+	, m_numFlagVariables(0)
+	, m_flagType(Kernel::kInvalidTypeIndex)
+	, m_flagClear(Kernel::kInvalidValueIndex)
+	, m_flagSet(Kernel::kInvalidValueIndex)
+{
+}
+
+rkci::Result rkci::ConditionMasking::Run(const Kernel::Function &input, Kernel::Function &output)
+{
+	if (output.NumTypes() != 0 || output.NumParams() != 0 || output.NumVariables() != 0 || output.NumInstructions() != 0)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	RKC_CHECK(input.Validate());
+
+	m_input = &input;
+	m_output = &output;
+	RKC_CHECK(m_flags.Resize(0));
+	m_numFlagVariables = 0;
+
+	RKC_CHECK(IndexRegions());
+
+	// The first traversal only creates the KE flags and finds out which ones are significant
+	m_isEmitting = false;
+	RKC_CHECK(Traverse());
+
+	RKC_CHECK(output.CopyDeclarations(input));
+
+	const size_t numFlags = m_flags.Count();
+	if (numFlags > 0)
+	{
+		RKC_CHECK_RV(Kernel::TypeIndex_t, flagLaneType, output.AddIntType(0, 1));
+		RKC_CHECK_RV(Kernel::TypeIndex_t, flagType, output.AddMaskType(flagLaneType));
+		m_flagType = flagType;
+
+		// Insignificant flags share the variable of their nearest significant ancestor, and parents
+		// always come before their children
+		for (size_t i = 0; i < numFlags; i++)
+		{
+			Flag &flag = m_flags[i];
+			if (flag.m_parent == kNoFlag)
+				flag.m_isSignificant = true;
+
+			if (flag.m_isSignificant)
+			{
+				RKC_CHECK_RV(Kernel::VariableIndex_t, flagVariable, output.AddVariable(m_flagType));
+				flag.m_variable = flagVariable;
+				m_numFlagVariables++;
+			}
+			else
+				flag.m_variable = m_flags[flag.m_parent].m_variable;
+		}
+	}
+
+	m_isEmitting = true;
+
+	if (numFlags > 0)
+	{
+		RKC_CHECK_RV(Kernel::ValueIndex_t, flagClear, EmitValue(Kernel::Opcode::kConstant, m_flagType, Kernel::kInvalidValueIndex, 0));
+		RKC_CHECK_RV(Kernel::ValueIndex_t, flagSet, EmitValue(Kernel::Opcode::kConstant, m_flagType, Kernel::kInvalidValueIndex, 1));
+		m_flagClear = flagClear;
+		m_flagSet = flagSet;
+	}
+
+	RKC_CHECK(Traverse());
+
+	m_input = nullptr;
+	m_output = nullptr;
+
+	return output.Validate();
+}
+
+size_t rkci::ConditionMasking::GetNumFlagVariables() const
+{
+	return m_numFlagVariables;
+}
+
+rkci::Result rkci::ConditionMasking::IndexRegions()
+{
+	const size_t numInstructions = m_input->NumInstructions();
+
+	{
+		AllocatorTagScope tagScope(*m_regionEnds.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_regionEnds.Resize(0));
+		RKC_CHECK(m_elses.Resize(0));
+		RKC_CHECK(m_breakableDepths.Resize(0));
+		RKC_CHECK(m_valueMap.Resize(0));
+
+		RKC_CHECK(m_regionEnds.Resize(numInstructions));
+		RKC_CHECK(m_elses.Resize(numInstructions));
+		RKC_CHECK(m_breakableDepths.Resize(numInstructions));
+		RKC_CHECK(m_valueMap.Resize(numInstructions));
+	}
+
+	// Validate has already checked the nesting, so every end matches the region on top of the stack
+	Vector<Kernel::ValueIndex_t> regionStack(m_regionEnds.GetAllocator());
+	uint32_t breakableDepth = 0;
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::ValueIndex_t index = static_cast<Kernel::ValueIndex_t>(i);
+
+		m_elses[i] = Kernel::kInvalidValueIndex;
+
+		switch (m_input->GetInstruction(index).m_opcode)
+		{
+		case Kernel::Opcode::kBreakable:
+			if (breakableDepth >= kMaxBreakableDepth)
+				return rkc::ResultCodes::kNotYetImplemented;
+
+			m_breakableDepths[i] = breakableDepth;
+			breakableDepth++;
+			// Fall through
+		case Kernel::Opcode::kIf:
+		case Kernel::Opcode::kLoop:
+			{
+				AllocatorTagScope tagScope(*m_regionEnds.GetAllocator(), rkc::AllocatorTags::kBackend);
+				RKC_CHECK(regionStack.Append(index));
+			}
+			break;
+
+		case Kernel::Opcode::kElse:
+			m_elses[regionStack[regionStack.Count() - 1]] = index;
+			break;
+
+		case Kernel::Opcode::kEndBreakable:
+			breakableDepth--;
+			// Fall through
+		case Kernel::Opcode::kEndIf:
+		case Kernel::Opcode::kEndLoop:
+			m_regionEnds[regionStack[regionStack.Count() - 1]] = index;
+			RKC_CHECK(regionStack.Resize(regionStack.Count() - 1));
+			break;
+
+		case Kernel::Opcode::kBeginMasked:
+		case Kernel::Opcode::kEndMasked:
+		case Kernel::Opcode::kBreakIfNone:
+			// Already masked
+			return rkc::ResultCodes::kInvalidOperation;
+
+		default:
+			break;
+		}
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::ConditionMasking::Traverse()
+{
+	RKC_CHECK(m_flagStack.Resize(0));
+	m_nextFlag = 0;
+	m_currentBreakableDepth = 0;
+
+	return LowerSequence(0, static_cast<Kernel::ValueIndex_t>(m_input->NumInstructions()));
+}
+
+rkci::ConditionMasking::Flow rkci::ConditionMasking::ComputeSequenceFlow(Kernel::ValueIndex_t begin, Kernel::ValueIndex_t end) const
+{
+	Flow flow;
+	flow.m_canContinue = true;
+	flow.m_breakDepths = 0;
+
+	Kernel::ValueIndex_t index = begin;
+	while (index < end)
+	{
+		Kernel::ValueIndex_t next = 0;
+		const Flow itemFlow = ComputeItemFlow(index, next);
+
+		flow.m_breakDepths |= itemFlow.m_breakDepths;
+
+		// Anything after an item that can't continue is dead
+		if (!itemFlow.m_canContinue)
+		{
+			flow.m_canContinue = false;
+			break;
+		}
+
+		index = next;
+	}
+
+	return flow;
+}
+
+rkci::ConditionMasking::Flow rkci::ConditionMasking::ComputeItemFlow(Kernel::ValueIndex_t index, Kernel::ValueIndex_t &outNext) const
+{
+	const Kernel::Instruction &instr = m_input->GetInstruction(index);
+
+	Flow flow;
+	flow.m_canContinue = true;
+	flow.m_breakDepths = 0;
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kIf:
+		{
+			const Kernel::ValueIndex_t elseIndex = m_elses[index];
+			const Kernel::ValueIndex_t endIndex = m_regionEnds[index];
+
+			if (elseIndex == Kernel::kInvalidValueIndex)
+			{
+				const Flow thenFlow = ComputeSequenceFlow(index + 1, endIndex);
+
+				// Lanes that fail the condition continue
+				flow.m_breakDepths = thenFlow.m_breakDepths;
+			}
+			else
+			{
+				const Flow thenFlow = ComputeSequenceFlow(index + 1, elseIndex);
+				const Flow elseFlow = ComputeSequenceFlow(elseIndex + 1, endIndex);
+
+				flow.m_canContinue = thenFlow.m_canContinue || elseFlow.m_canContinue;
+				flow.m_breakDepths = thenFlow.m_breakDepths | elseFlow.m_breakDepths;
+			}
+
+			outNext = endIndex + 1;
+		}
+		break;
+
+	case Kernel::Opcode::kLoop:
+		{
+			const Kernel::ValueIndex_t endIndex = m_regionEnds[index];
+			const Flow bodyFlow = ComputeSequenceFlow(index + 1, endIndex);
+
+			// A loop only ends by breaking out of it
+			flow.m_canContinue = false;
+			flow.m_breakDepths = bodyFlow.m_breakDepths;
+
+			outNext = endIndex + 1;
+		}
+		break;
+
+	case Kernel::Opcode::kBreakable:
+		{
+			const Kernel::ValueIndex_t endIndex = m_regionEnds[index];
+			const Flow bodyFlow = ComputeSequenceFlow(index + 1, endIndex);
+			const uint64_t depthBit = static_cast<uint64_t>(1) << m_breakableDepths[index];
+
+			// Breaking out of this region continues after it
+			flow.m_canContinue = bodyFlow.m_canContinue || (bodyFlow.m_breakDepths & depthBit) != 0;
+			flow.m_breakDepths = bodyFlow.m_breakDepths & ~depthBit;
+
+			outNext = endIndex + 1;
+		}
+		break;
+
+	case Kernel::Opcode::kBreak:
+		flow.m_canContinue = false;
+		flow.m_breakDepths = static_cast<uint64_t>(1) << m_breakableDepths[static_cast<size_t>(instr.m_immediate)];
+		outNext = index + 1;
+		break;
+
+	default:
+		outNext = index + 1;
+		break;
+	}
+
+	return flow;
+}
+
+rkci::ConditionMasking::Intention rkci::ConditionMasking::GetIntention(const Flow &flow)
+{
+	if (!flow.m_canContinue)
+		return Intention::kBreakOnly;
+
+	if (flow.m_breakDepths == 0)
+		return Intention::kContinueOnly;
+
+	return Intention::kContinueOrBreak;
+}
+
+rkci::Result rkci::ConditionMasking::LowerSequence(Kernel::ValueIndex_t begin, Kernel::ValueIndex_t end)
+{
+	Kernel::ValueIndex_t index = begin;
+	while (index < end)
+	{
+		Kernel::ValueIndex_t next = 0;
+		const Intention intention = GetIntention(ComputeItemFlow(index, next));
+
+		if (intention == Intention::kContinueOrBreak && next < end)
+		{
+			// The rest of the sequence only runs on the lanes that didn't break
+			RKC_CHECK(BeginFlag(false));
+
+			const size_t flagIndex = m_flagStack[m_flagStack.Count() - 1];
+
+			RKC_CHECK(LowerItem(index));
+			RKC_CHECK(EndFlag());
+
+			RKC_CHECK(BeginMaskedByFlag(flagIndex));
+			RKC_CHECK(LowerSequence(next, end));
+			return EmitStatement(Kernel::Opcode::kEndMasked, Kernel::kInvalidValueIndex, 0);
+		}
+
+		RKC_CHECK(LowerItem(index));
+
+		// Everything after an item that always breaks is dead
+		if (intention == Intention::kBreakOnly)
+			break;
+
+		index = next;
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::ConditionMasking::LowerItem(Kernel::ValueIndex_t index)
+{
+	const Kernel::Instruction &instr = m_input->GetInstruction(index);
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kIf:
+		{
+			const Kernel::ValueIndex_t elseIndex = m_elses[index];
+			const Kernel::ValueIndex_t endIndex = m_regionEnds[index];
+			const Kernel::ValueIndex_t thenEnd = (elseIndex == Kernel::kInvalidValueIndex) ? endIndex : elseIndex;
+			const Kernel::ValueIndex_t condition = m_valueMap[instr.m_operands[0]];
+
+			if (thenEnd > index + 1)
+			{
+				RKC_CHECK(EmitStatement(Kernel::Opcode::kBeginMasked, condition, 0));
+				RKC_CHECK(LowerSequence(index + 1, thenEnd));
+				RKC_CHECK(EmitStatement(Kernel::Opcode::kEndMasked, Kernel::kInvalidValueIndex, 0));
+			}
+
+			if (elseIndex != Kernel::kInvalidValueIndex && endIndex > elseIndex + 1)
+			{
+				const Kernel::TypeIndex_t conditionType = m_input->GetInstruction(instr.m_operands[0]).m_type;
+
+				RKC_CHECK_RV(Kernel::ValueIndex_t, elseCondition, EmitValue(Kernel::Opcode::kNot, conditionType, condition, 0));
+				RKC_CHECK(EmitStatement(Kernel::Opcode::kBeginMasked, elseCondition, 0));
+				RKC_CHECK(LowerSequence(elseIndex + 1, endIndex));
+				RKC_CHECK(EmitStatement(Kernel::Opcode::kEndMasked, Kernel::kInvalidValueIndex, 0));
+			}
+		}
+		return Result::Ok();
+
+	case Kernel::Opcode::kLoop:
+		return LowerLoop(index);
+
+	case Kernel::Opcode::kBreakable:
+		m_currentBreakableDepth++;
+		RKC_CHECK(LowerSequence(index + 1, m_regionEnds[index]));
+		m_currentBreakableDepth--;
+		return Result::Ok();
+
+	case Kernel::Opcode::kBreak:
+		return LowerBreak(index);
+
+	default:
+		return CopyInstruction(index);
+	}
+}
+
+rkci::Result rkci::ConditionMasking::LowerLoop(Kernel::ValueIndex_t index)
+{
+	const Kernel::ValueIndex_t endIndex = m_regionEnds[index];
+
+	switch (GetIntention(ComputeSequenceFlow(index + 1, endIndex)))
+	{
+	case Intention::kContinueOnly:
+		// Never ends
+		return rkc::ResultCodes::kInternalError;
+
+	case Intention::kBreakOnly:
+		// Dead loop, the body never runs twice
+		return LowerSequence(index + 1, endIndex);
+
+	case Intention::kContinueOrBreak:
+		{
+			RKC_CHECK(BeginFlag(true));
+
+			const size_t flagIndex = m_flagStack[m_flagStack.Count() - 1];
+
+			RKC_CHECK(EmitStatement(Kernel::Opcode::kLoop, Kernel::kInvalidValueIndex, 0));
+			RKC_CHECK(BeginMaskedByFlag(flagIndex));
+			RKC_CHECK(LowerSequence(index + 1, endIndex));
+			RKC_CHECK(EmitStatement(Kernel::Opcode::kEndMasked, Kernel::kInvalidValueIndex, 0));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, keepExecuting, EmitValue(Kernel::Opcode::kReadVar, m_flagType, Kernel::kInvalidValueIndex, m_flags[flagIndex].m_variable));
+			RKC_CHECK(EmitStatement(Kernel::Opcode::kBreakIfNone, keepExecuting, 0));
+			RKC_CHECK(EmitStatement(Kernel::Opcode::kEndLoop, Kernel::kInvalidValueIndex, 0));
+
+			RKC_CHECK(EndFlag());
+		}
+		return Result::Ok();
+
+	default:
+		return rkc::ResultCodes::kInternalError;
+	}
+}
+
+// A break clears every KE flag inside the breakable region that it leaves.  Flags on the stack are
+// ordered from outermost to innermost, so the first one cleared is the one that has to be kept.
+rkci::Result rkci::ConditionMasking::LowerBreak(Kernel::ValueIndex_t index)
+{
+	const uint32_t targetDepth = m_breakableDepths[static_cast<size_t>(m_input->GetInstruction(index).m_immediate)];
+	const size_t stackSize = m_flagStack.Count();
+
+	Kernel::VariableIndex_t lastCleared = 0;
+	bool haveCleared = false;
+
+	for (size_t stackIndex = 0; stackIndex < stackSize; stackIndex++)
+	{
+		Flag &flag = m_flags[m_flagStack[stackIndex]];
+		if (flag.m_breakableDepth <= targetDepth)
+			continue;
+
+		if (!m_isEmitting)
+		{
+			flag.m_isSignificant = true;
+			break;
+		}
+
+		// Insignificant flags share their ancestor's variable, so runs of them only need one write
+		if (haveCleared && flag.m_variable == lastCleared)
+			continue;
+
+		RKC_CHECK(EmitStatement(Kernel::Opcode::kWriteVar, m_flagClear, flag.m_variable));
+
+		lastCleared = flag.m_variable;
+		haveCleared = true;
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::ConditionMasking::BeginFlag(bool isLoop)
+{
+	const size_t flagIndex = m_nextFlag++;
+	const size_t stackSize = m_flagStack.Count();
+
+	if (!m_isEmitting)
+	{
+		Flag flag;
+		flag.m_parent = kNoFlag;
+		if (stackSize > 0)
+			flag.m_parent = m_flagStack[stackSize - 1];
+
+		flag.m_breakableDepth = m_currentBreakableDepth;
+		flag.m_isSignificant = isLoop;
+		flag.m_variable = 0;
+
+		AllocatorTagScope tagScope(*m_flags.GetAllocator(), rkc::AllocatorTags::kBackend);
+		RKC_CHECK(m_flags.Append(flag));
+	}
+	else
+	{
+		const Flag &flag = m_flags[flagIndex];
+
+		// An insignificant flag is already set for every executing lane
+		if (flag.m_isSignificant)
+		{
+			RKC_CHECK(EmitStatement(Kernel::Opcode::kWriteVar, m_flagSet, flag.m_variable));
+		}
+	}
+
+	AllocatorTagScope tagScope(*m_flagStack.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	return m_flagStack.Append(flagIndex);
+}
+
+rkci::Result rkci::ConditionMasking::EndFlag()
+{
+	return m_flagStack.Resize(m_flagStack.Count() - 1);
+}
+
+rkci::Result rkci::ConditionMasking::BeginMaskedByFlag(size_t flagIndex)
+{
+	if (!m_isEmitting)
+		return Result::Ok();
+
+	RKC_CHECK_RV(Kernel::ValueIndex_t, keepExecuting, EmitValue(Kernel::Opcode::kReadVar, m_flagType, Kernel::kInvalidValueIndex, m_flags[flagIndex].m_variable));
+
+	return EmitStatement(Kernel::Opcode::kBeginMasked, keepExecuting, 0);
+}
+
+rkci::ResultRV<rkci::Kernel::ValueIndex_t> rkci::ConditionMasking::EmitValue(Kernel::Opcode opcode, Kernel::TypeIndex_t type, Kernel::ValueIndex_t operand0, uint64_t immediate)
+{
+	if (!m_isEmitting)
+		return Kernel::kInvalidValueIndex;
+
+	return m_output->AddInstruction(opcode, type, operand0, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, immediate);
+}
+
+rkci::Result rkci::ConditionMasking::EmitStatement(Kernel::Opcode opcode, Kernel::ValueIndex_t operand0, uint64_t immediate)
+{
+	RKC_CHECK_RV(Kernel::ValueIndex_t, instrIndex, EmitValue(opcode, Kernel::kInvalidTypeIndex, operand0, immediate));
+	(void)instrIndex;
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::ConditionMasking::CopyInstruction(Kernel::ValueIndex_t index)
+{
+	if (!m_isEmitting)
+		return Result::Ok();
+
+	const Kernel::Instruction &instr = m_input->GetInstruction(index);
+	const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+
+	Kernel::ValueIndex_t operands[3] = { Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex };
+	for (size_t i = 0; i < numOperands; i++)
+		operands[i] = m_valueMap[instr.m_operands[i]];
+
+	RKC_CHECK_RV(Kernel::ValueIndex_t, newIndex, m_output->AddInstruction(instr.m_opcode, instr.m_type, operands[0], operands[1], operands[2], instr.m_immediate));
+	m_valueMap[index] = newIndex;
+
+	return Result::Ok();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	struct IAllocator;
+	class Result;
+
+	// Lowers a kernel's structured control flow to masked control flow, as laid out in
+	// notes/condition_masking.txt.
+	//
+	// Every statement has a continuation intention possibility (CIP): it either always continues to
+	// the next statement, always breaks out of an enclosing breakable region, or may do either
+	// depending on the lane.  Statements after one that always breaks are dead and are dropped, and a
+	// loop whose body always breaks runs its body once without looping.  A statement that may do
+	// either runs under a keep-executing (KE) flag, which is a mask variable that its breaks clear for
+	// the lanes that took them, and the statements after it run masked by that flag.  Loops keep going
+	// while any lane of their KE flag is still set.
+	//
+	// A KE flag is only kept if it is the outermost flag cleared by one of the breaks.  Otherwise every
+	// break that clears it also clears its parent, so it shares the variable of the nearest enclosing
+	// flag that is kept, which keeps the number of live masks down.
+	class ConditionMasking
+	{
+	public:
+		explicit ConditionMasking(IAllocator *alloc);
+
+		// Writes the masked form of a structured kernel to output, which must be empty.  Returns
+		// kInternalError for loops that can never end.
+		Result Run(const Kernel::Function &input, Kernel::Function &output);
+
+		// Number of KE flag variables added by the last Run
+		size_t GetNumFlagVariables() const;
+
+	private:
+		enum class Intention : uint8_t
+		{
+			kContinueOnly,
+			kBreakOnly,
+			kContinueOrBreak,
+		};
+
+		struct Flow
+		{
+			bool m_canContinue;
+			uint64_t m_breakDepths;		// Bit per breakable nesting depth that a break may leave to
+		};
+
+		struct Flag
+		{
+			size_t m_parent;
+			uint32_t m_breakableDepth;
+			bool m_isSignificant;
+			Kernel::VariableIndex_t m_variable;
+		};
+
+		static const size_t kNoFlag = static_cast<size_t>(-1);
+		static const uint32_t kMaxBreakableDepth = 64;
+
+		Result IndexRegions();
+		Result Traverse();
+
+		Flow ComputeSequenceFlow(Kernel::ValueIndex_t begin, Kernel::ValueIndex_t end) const;
+		Flow ComputeItemFlow(Kernel::ValueIndex_t index, Kernel::ValueIndex_t &outNext) const;
+		static Intention GetIntention(const Flow &flow);
+
+		Result LowerSequence(Kernel::ValueIndex_t begin, Kernel::ValueIndex_t end);
+		Result LowerItem(Kernel::ValueIndex_t index);
+		Result LowerLoop(Kernel::ValueIndex_t index);
+		Result LowerBreak(Kernel::ValueIndex_t index);
+
+		Result BeginFlag(bool isLoop);
+		Result EndFlag();
+		Result BeginMaskedByFlag(size_t flagIndex);
+
+		ResultRV<Kernel::ValueIndex_t> EmitValue(Kernel::Opcode opcode, Kernel::TypeIndex_t type, Kernel::ValueIndex_t operand0, uint64_t immediate);
+		Result EmitStatement(Kernel::Opcode opcode, Kernel::ValueIndex_t operand0, uint64_t immediate);
+		Result CopyInstruction(Kernel::ValueIndex_t index);
+
+		const Kernel::Function *m_input;
+		Kernel::Function *m_output;
+		bool m_isEmitting;
+
+		// Per input instruction: the matching end of a region, the else of an if, the breakable depth
+		// of a breakable, and the output value
+		Vector<Kernel::ValueIndex_t> m_regionEnds;
+		Vector<Kernel::ValueIndex_t> m_elses;
+		Vector<uint32_t> m_breakableDepths;
+		Vector<Kernel::ValueIndex_t> m_valueMap;
+
+		Vector<Flag> m_flags;
+		Vector<size_t> m_flagStack;
+		size_t m_nextFlag;
+		uint32_t m_currentBreakableDepth;
+		size_t m_numFlagVariables;
+
+		Kernel::TypeIndex_t m_flagType;
+		Kernel::ValueIndex_t m_flagClear;
+		Kernel::ValueIndex_t m_flagSet;
+	};
+}
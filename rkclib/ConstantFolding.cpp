@@ -0,0 +1,667 @@
+#include "ConstantFolding.h"
+#include "ArraySliceView.h"
+#include "FloatSpec.h"
+#include "IAllocator.h"
+#include "MoveOrCopy.h"
+#include "NumUtils.h"
+#include "RangeAnalysis.h"
+#include "Result.h"
+
+rkci::ConstantFolding::FloatValue::FloatValue()
+	: m_class(FloatClass::kFinite)
+	, m_isNegative(false)
+{
+}
+
+rkci::ConstantFolding::ConstantFolding(IAllocator *alloc)
+	: m_input(nullptr)
+	, m_alloc(alloc)
+	, m_folds(alloc)
+	, m_isUsed(alloc)
+	, m_valueMap(alloc)
+	, m_numFolded(0)
+{
+}
+
+rkci::Result rkci::ConstantFolding::Run(const Kernel::Function &input, Kernel::Function &output)
+{
+	if (output.NumTypes() != 0 || output.NumParams() != 0 || output.NumVariables() != 0 || output.NumInstructions() != 0)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	RKC_CHECK(input.Validate());
+
+	m_input = &input;
+	m_numFolded = 0;
+
+	const size_t numInstructions = input.NumInstructions();
+
+	{
+		AllocatorTagScope tagScope(*m_alloc, rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_folds.Resize(numInstructions));
+		RKC_CHECK(m_isUsed.Resize(numInstructions));
+		RKC_CHECK(m_valueMap.Resize(numInstructions));
+	}
+
+	// Operands always come first, so one pass folds whole chains of constant operations
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		RKC_CHECK(FoldInstruction(static_cast<Kernel::ValueIndex_t>(i)));
+	}
+
+	// Folded operations no longer use their operands, so only the others keep constants alive
+	for (size_t i = 0; i < numInstructions; i++)
+		m_isUsed[i] = 0;
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		if (m_folds[i].m_kind != FoldKind::kNotFolded)
+			continue;
+
+		const Kernel::Instruction &instr = input.GetInstruction(static_cast<Kernel::ValueIndex_t>(i));
+		const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+		for (size_t operandIndex = 0; operandIndex < numOperands; operandIndex++)
+			m_isUsed[Resolve(instr.m_operands[operandIndex])] = 1;
+	}
+
+	RKC_CHECK(output.CopyDeclarations(input));
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::Instruction &instr = input.GetInstruction(static_cast<Kernel::ValueIndex_t>(i));
+		const Fold &fold = m_folds[i];
+
+		m_valueMap[i] = Kernel::kInvalidValueIndex;
+
+		if (fold.m_kind == FoldKind::kAlias)
+		{
+			m_valueMap[i] = m_valueMap[static_cast<size_t>(fold.m_value)];
+			continue;
+		}
+
+		const bool isConstant = (fold.m_kind == FoldKind::kConstant || instr.m_opcode == Kernel::Opcode::kConstant);
+		if (isConstant && !m_isUsed[i])
+			continue;
+
+		if (fold.m_kind == FoldKind::kConstant)
+		{
+			RKC_CHECK_RV(Kernel::ValueIndex_t, constantIndex, output.AddInstruction(Kernel::Opcode::kConstant, instr.m_type, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, fold.m_value));
+			m_valueMap[i] = constantIndex;
+			continue;
+		}
+
+		const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+
+		Kernel::ValueIndex_t operands[3] = { Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex };
+		for (size_t operandIndex = 0; operandIndex < numOperands; operandIndex++)
+			operands[operandIndex] = m_valueMap[instr.m_operands[operandIndex]];
+
+		RKC_CHECK_RV(Kernel::ValueIndex_t, newIndex, output.AddInstruction(instr.m_opcode, instr.m_type, operands[0], operands[1], operands[2], instr.m_immediate));
+		m_valueMap[i] = newIndex;
+	}
+
+	m_input = nullptr;
+
+	return output.Validate();
+}
+
+size_t rkci::ConstantFolding::GetNumFolded() const
+{
+	return m_numFolded;
+}
+
+rkci::Result rkci::ConstantFolding::FoldInstruction(Kernel::ValueIndex_t index)
+{
+	const Kernel::Instruction &instr = m_input->GetInstruction(index);
+	Fold &fold = m_folds[index];
+
+	fold.m_kind = FoldKind::kNotFolded;
+	fold.m_value = 0;
+
+	if (instr.m_opcode == Kernel::Opcode::kSelect)
+	{
+		uint64_t mask = 0;
+		if (GetConstant(instr.m_operands[0], mask))
+		{
+			fold.m_kind = FoldKind::kAlias;
+			fold.m_value = Resolve(instr.m_operands[(mask != 0) ? 1 : 2]);
+			m_numFolded++;
+		}
+
+		return Result::Ok();
+	}
+
+	// Loads have a constant index but not a constant value, and statements have no value at all
+	if (instr.m_opcode == Kernel::Opcode::kLoad || !Kernel::Function::DefinesValue(instr.m_opcode))
+		return Result::Ok();
+
+	const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+	if (numOperands == 0)
+		return Result::Ok();
+
+	uint64_t operands[2] = { 0, 0 };
+	for (size_t i = 0; i < numOperands; i++)
+	{
+		if (!GetConstant(instr.m_operands[i], operands[i]))
+			return Result::Ok();
+	}
+
+	const Kernel::Type &type = m_input->GetType(instr.m_type);
+
+	bool isFolded = false;
+	uint64_t immediate = 0;
+
+	if (instr.m_opcode == Kernel::Opcode::kConvert)
+	{
+		RKC_CHECK(FoldConvert(instr, operands[0], isFolded, immediate));
+	}
+	else if (Kernel::Function::IsComparison(instr.m_opcode))
+	{
+		const Kernel::Type &laneType = m_input->GetType(type.m_laneType);
+		if (laneType.m_kind == Kernel::TypeKind::kInt)
+		{
+			const int64_t a = static_cast<int64_t>(operands[0]);
+			const int64_t b = static_cast<int64_t>(operands[1]);
+
+			isFolded = true;
+			immediate = FoldComparison(instr.m_opcode, (a < b) ? -1 : ((a > b) ? 1 : 0)) ? 1u : 0u;
+		}
+		else if (CanEncode(laneType.m_floatSpec))
+		{
+			FloatValue a;
+			FloatValue b;
+			RKC_CHECK(DecodeFloat(laneType.m_floatSpec, operands[0], a));
+			RKC_CHECK(DecodeFloat(laneType.m_floatSpec, operands[1], b));
+
+			if (a.m_class != FloatClass::kNan && b.m_class != FloatClass::kNan)
+			{
+				isFolded = true;
+				immediate = FoldComparison(instr.m_opcode, CompareFloats(a, b)) ? 1u : 0u;
+			}
+		}
+	}
+	else if (type.m_kind == Kernel::TypeKind::kMask)
+	{
+		isFolded = true;
+		switch (instr.m_opcode)
+		{
+		case Kernel::Opcode::kAnd:
+			immediate = operands[0] & operands[1];
+			break;
+		case Kernel::Opcode::kOr:
+			immediate = operands[0] | operands[1];
+			break;
+		case Kernel::Opcode::kXor:
+			immediate = operands[0] ^ operands[1];
+			break;
+		case Kernel::Opcode::kNot:
+			immediate = operands[0] ^ 1u;
+			break;
+		default:
+			isFolded = false;
+			break;
+		}
+	}
+	else if (type.m_kind == Kernel::TypeKind::kInt)
+	{
+		int64_t result = 0;
+		if (FoldIntOperation(instr.m_opcode, static_cast<int64_t>(operands[0]), static_cast<int64_t>(operands[1]), result) && IsInTypeRange(instr.m_type, result))
+		{
+			isFolded = true;
+			immediate = static_cast<uint64_t>(result);
+		}
+	}
+	else if (instr.m_opcode == Kernel::Opcode::kMin || instr.m_opcode == Kernel::Opcode::kMax)
+	{
+		if (CanEncode(type.m_floatSpec))
+		{
+			FloatValue a;
+			FloatValue b;
+			RKC_CHECK(DecodeFloat(type.m_floatSpec, operands[0], a));
+			RKC_CHECK(DecodeFloat(type.m_floatSpec, operands[1], b));
+
+			// Same as the SSE instructions: the second operand unless the first one is strictly lower
+			// or higher, so it's the second one for zeros of either sign
+			if (a.m_class != FloatClass::kNan && b.m_class != FloatClass::kNan)
+			{
+				const int compared = CompareFloats(a, b);
+				const bool isFirst = (instr.m_opcode == Kernel::Opcode::kMin) ? (compared < 0) : (compared > 0);
+
+				isFolded = true;
+				immediate = operands[isFirst ? 0 : 1];
+			}
+		}
+	}
+	else
+	{
+		RKC_CHECK(FoldFloatArithmetic(instr.m_opcode, type.m_floatSpec, operands[0], operands[1], isFolded, immediate));
+	}
+
+	if (isFolded)
+	{
+		fold.m_kind = FoldKind::kConstant;
+		fold.m_value = immediate;
+		m_numFolded++;
+	}
+
+	return Result::Ok();
+}
+
+// Conversions are all exact and then rounded once, and conversions to integers truncate
+rkci::Result rkci::ConstantFolding::FoldConvert(const Kernel::Instruction &instr, uint64_t operand, bool &outIsFolded, uint64_t &outImmediate) const
+{
+	const Kernel::Type &fromType = m_input->GetType(m_input->GetInstruction(instr.m_operands[0]).m_type);
+	const Kernel::Type &toType = m_input->GetType(instr.m_type);
+
+	outIsFolded = false;
+
+	if (toType.m_kind == Kernel::TypeKind::kMask)
+	{
+		outIsFolded = true;
+		outImmediate = operand;
+		return Result::Ok();
+	}
+
+	FloatValue value;
+
+	if (fromType.m_kind == Kernel::TypeKind::kInt)
+	{
+		const int64_t intValue = static_cast<int64_t>(operand);
+
+		if (toType.m_kind == Kernel::TypeKind::kInt)
+		{
+			if (IsInTypeRange(instr.m_type, intValue))
+			{
+				outIsFolded = true;
+				outImmediate = operand;
+			}
+
+			return Result::Ok();
+		}
+
+		value.m_isNegative = (intValue < 0);
+
+		RKC_CHECK_RV(BigUBinFloat_t, magnitude, MakeMagnitude(value.m_isNegative ? (0u - operand) : operand, 0));
+		value.m_magnitude = rkci::Move(magnitude);
+	}
+	else
+	{
+		if (!CanEncode(fromType.m_floatSpec))
+			return Result::Ok();
+
+		RKC_CHECK(DecodeFloat(fromType.m_floatSpec, operand, value));
+
+		if (value.m_class == FloatClass::kNan)
+			return Result::Ok();
+
+		if (toType.m_kind == Kernel::TypeKind::kInt)
+		{
+			int64_t intValue = 0;
+			if (value.m_class == FloatClass::kFinite && TruncateToInt(value, intValue) && IsInTypeRange(instr.m_type, intValue))
+			{
+				outIsFolded = true;
+				outImmediate = static_cast<uint64_t>(intValue);
+			}
+
+			return Result::Ok();
+		}
+	}
+
+	if (!CanEncode(toType.m_floatSpec))
+		return Result::Ok();
+
+	RKC_CHECK(EncodeFloat(toType.m_floatSpec, value, outImmediate));
+	outIsFolded = true;
+
+	return Result::Ok();
+}
+
+bool rkci::ConstantFolding::FoldIntOperation(Kernel::Opcode opcode, int64_t a, int64_t b, int64_t &outResult)
+{
+	switch (opcode)
+	{
+	case Kernel::Opcode::kAdd:
+		return RangeAnalysis::CheckedAdd(a, b, outResult);
+	case Kernel::Opcode::kSub:
+		return RangeAnalysis::CheckedSub(a, b, outResult);
+	case Kernel::Opcode::kMul:
+		return RangeAnalysis::CheckedMul(a, b, outResult);
+	case Kernel::Opcode::kMin:
+		outResult = (a < b) ? a : b;
+		return true;
+	case Kernel::Opcode::kMax:
+		outResult = (a > b) ? a : b;
+		return true;
+	case Kernel::Opcode::kAnd:
+		outResult = (a & b);
+		return true;
+	case Kernel::Opcode::kOr:
+		outResult = (a | b);
+		return true;
+	case Kernel::Opcode::kXor:
+		outResult = (a ^ b);
+		return true;
+	case Kernel::Opcode::kNot:
+		outResult = ~a;
+		return true;
+	default:
+		return false;
+	}
+}
+
+rkci::Result rkci::ConstantFolding::FoldFloatArithmetic(Kernel::Opcode opcode, const FloatSpec &floatSpec, uint64_t a, uint64_t b, bool &outIsFolded, uint64_t &outImmediate) const
+{
+	outIsFolded = false;
+
+	if (opcode != Kernel::Opcode::kAdd && opcode != Kernel::Opcode::kSub && opcode != Kernel::Opcode::kMul)
+		return Result::Ok();
+
+	if (!CanEncode(floatSpec))
+		return Result::Ok();
+
+	FloatValue left;
+	FloatValue right;
+	RKC_CHECK(DecodeFloat(floatSpec, a, left));
+	RKC_CHECK(DecodeFloat(floatSpec, b, right));
+
+	if (left.m_class == FloatClass::kNan || right.m_class == FloatClass::kNan)
+		return Result::Ok();
+
+	if (opcode == Kernel::Opcode::kSub)
+		right.m_isNegative = !right.m_isNegative;
+
+	const bool isLeftInfinite = (left.m_class == FloatClass::kInfinity);
+	const bool isRightInfinite = (right.m_class == FloatClass::kInfinity);
+
+	FloatValue result;
+
+	if (opcode == Kernel::Opcode::kMul)
+	{
+		result.m_isNegative = (left.m_isNegative != right.m_isNegative);
+
+		if (isLeftInfinite || isRightInfinite)
+		{
+			// Infinity times zero is NaN
+			if ((!isLeftInfinite && left.m_magnitude.IsZero()) || (!isRightInfinite && right.m_magnitude.IsZero()))
+				return Result::Ok();
+
+			result.m_class = FloatClass::kInfinity;
+		}
+		else
+		{
+			RKC_CHECK_RV(BigUBinFloat_t, product, left.m_magnitude.Clone());
+			RKC_CHECK(product.MultiplyInPlace(right.m_magnitude));
+			result.m_magnitude = rkci::Move(product);
+		}
+	}
+	else if (isLeftInfinite || isRightInfinite)
+	{
+		// Infinities of opposite signs add up to NaN
+		if (isLeftInfinite && isRightInfinite && left.m_isNegative != right.m_isNegative)
+			return Result::Ok();
+
+		result.m_class = FloatClass::kInfinity;
+		result.m_isNegative = isLeftInfinite ? left.m_isNegative : right.m_isNegative;
+	}
+	else if (left.m_isNegative == right.m_isNegative)
+	{
+		// Zeros keep their sign only if they both have it
+		RKC_CHECK_RV(BigUBinFloat_t, sum, left.m_magnitude.Clone());
+		RKC_CHECK(sum.AddInPlace(right.m_magnitude));
+		result.m_magnitude = rkci::Move(sum);
+		result.m_isNegative = left.m_isNegative;
+	}
+	else if (left.m_magnitude != right.m_magnitude)
+	{
+		// An exact difference of zero is positive when rounding to nearest
+		const bool isLeftLarger = (left.m_magnitude > right.m_magnitude);
+		const FloatValue &larger = isLeftLarger ? left : right;
+		const FloatValue &smaller = isLeftLarger ? right : left;
+
+		RKC_CHECK_RV(BigUBinFloat_t, difference, larger.m_magnitude.Clone());
+		RKC_CHECK(difference.SubtractInPlace(smaller.m_magnitude));
+		result.m_magnitude = rkci::Move(difference);
+		result.m_isNegative = larger.m_isNegative;
+	}
+
+	RKC_CHECK(EncodeFloat(floatSpec, result, outImmediate));
+	outIsFolded = true;
+
+	return Result::Ok();
+}
+
+bool rkci::ConstantFolding::FoldComparison(Kernel::Opcode opcode, int compared)
+{
+	switch (opcode)
+	{
+	case Kernel::Opcode::kCmpEq:
+		return compared == 0;
+	case Kernel::Opcode::kCmpNe:
+		return compared != 0;
+	case Kernel::Opcode::kCmpLt:
+		return compared < 0;
+	case Kernel::Opcode::kCmpLe:
+		return compared <= 0;
+	case Kernel::Opcode::kCmpGt:
+		return compared > 0;
+	case Kernel::Opcode::kCmpGe:
+		return compared >= 0;
+	default:
+		return false;
+	}
+}
+
+rkci::Kernel::ValueIndex_t rkci::ConstantFolding::Resolve(Kernel::ValueIndex_t value) const
+{
+	const Fold &fold = m_folds[value];
+	if (fold.m_kind == FoldKind::kAlias)
+		return static_cast<Kernel::ValueIndex_t>(fold.m_value);
+
+	return value;
+}
+
+bool rkci::ConstantFolding::GetConstant(Kernel::ValueIndex_t value, uint64_t &outImmediate) const
+{
+	const Kernel::ValueIndex_t resolved = Resolve(value);
+	const Fold &fold = m_folds[resolved];
+
+	if (fold.m_kind == FoldKind::kConstant)
+	{
+		outImmediate = fold.m_value;
+		return true;
+	}
+
+	const Kernel::Instruction &instr = m_input->GetInstruction(resolved);
+	if (instr.m_opcode == Kernel::Opcode::kConstant)
+	{
+		outImmediate = instr.m_immediate;
+		return true;
+	}
+
+	return false;
+}
+
+bool rkci::ConstantFolding::IsInTypeRange(Kernel::TypeIndex_t type, int64_t value) const
+{
+	const Kernel::Type &intType = m_input->GetType(type);
+	return value >= intType.m_minValue && value <= intType.m_maxValue;
+}
+
+// Float constants are folded if their encoding fits in an immediate
+bool rkci::ConstantFolding::CanEncode(const FloatSpec &floatSpec)
+{
+	const uint32_t exponentBits = floatSpec.GetExponentBits();
+	return exponentBits >= 1 && exponentBits <= 15 && (floatSpec.IsSigned() ? 1u : 0u) + exponentBits + floatSpec.GetMantissaBits() <= 64;
+}
+
+// Decodes the same way as CustomFloatFormat::Unpack, so a zero exponent without denormals is zero
+rkci::Result rkci::ConstantFolding::DecodeFloat(const FloatSpec &floatSpec, uint64_t bits, FloatValue &outValue) const
+{
+	const uint32_t exponentBits = floatSpec.GetExponentBits();
+	const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+	const uint64_t allOnesExponent = (static_cast<uint64_t>(1) << exponentBits) - 1u;
+	const uint64_t fieldExponent = (bits >> mantissaBits) & allOnesExponent;
+	const uint64_t mantissa = bits & ((static_cast<uint64_t>(1) << mantissaBits) - 1u);
+
+	outValue.m_class = FloatClass::kFinite;
+	outValue.m_isNegative = (floatSpec.IsSigned() && ((bits >> (exponentBits + mantissaBits)) & 1u) != 0);
+	outValue.m_magnitude = BigUBinFloat_t();
+
+	if (floatSpec.SupportsNans() && fieldExponent == allOnesExponent)
+	{
+		outValue.m_class = (mantissa != 0) ? FloatClass::kNan : FloatClass::kInfinity;
+		return Result::Ok();
+	}
+
+	const int32_t denormalExponent = 1 - floatSpec.GetExponentOfOne() - static_cast<int32_t>(mantissaBits);
+
+	if (fieldExponent == 0)
+	{
+		if (floatSpec.SupportsDenormals())
+		{
+			RKC_CHECK_RV(BigUBinFloat_t, magnitude, MakeMagnitude(mantissa, denormalExponent));
+			outValue.m_magnitude = rkci::Move(magnitude);
+		}
+	}
+	else
+	{
+		RKC_CHECK_RV(BigUBinFloat_t, magnitude, MakeMagnitude(mantissa | (static_cast<uint64_t>(1) << mantissaBits), denormalExponent + static_cast<int32_t>(fieldExponent) - 1));
+		outValue.m_magnitude = rkci::Move(magnitude);
+	}
+
+	return Result::Ok();
+}
+
+// Rounds an exact value to a floatspec and encodes it, with the encoding policy of CustomFloatFormat
+rkci::Result rkci::ConstantFolding::EncodeFloat(const FloatSpec &floatSpec, const FloatValue &value, uint64_t &outBits) const
+{
+	const uint32_t exponentBits = floatSpec.GetExponentBits();
+	const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+	const uint64_t allOnesExponent = (static_cast<uint64_t>(1) << exponentBits) - 1u;
+	const uint64_t mantissaMask = (static_cast<uint64_t>(1) << mantissaBits) - 1u;
+	const int32_t maxFieldExponent = static_cast<int32_t>(allOnesExponent) - (floatSpec.SupportsNans() ? 1 : 0);
+
+	// Unsigned floatspecs have no sign bit, and negative values convert to zero
+	if (value.m_isNegative && !floatSpec.IsSigned())
+	{
+		outBits = 0;
+		return Result::Ok();
+	}
+
+	const uint64_t sign = value.m_isNegative ? (static_cast<uint64_t>(1) << (exponentBits + mantissaBits)) : 0u;
+
+	bool isOverflow = (value.m_class == FloatClass::kInfinity);
+	outBits = sign;
+
+	if (!isOverflow)
+	{
+		RKC_CHECK_RV(BigUBinFloat_t, rounded, NumUtils::RoundToFloatSpec(value.m_magnitude, floatSpec));
+
+		if (rounded.IsZero())
+			return Result::Ok();
+
+		uint64_t significand = 0;
+		if (!GetSignificand(rounded, significand))
+			return rkc::ResultCodes::kInternalError;
+
+		const uint32_t numDigits = rounded.GetNumDigits();
+		const int32_t lowPlace = rounded.GetLowPlace();
+		const int32_t fieldExponent = static_cast<int32_t>(numDigits) + lowPlace - 1 + floatSpec.GetExponentOfOne();
+
+		if (fieldExponent > maxFieldExponent)
+			isOverflow = true;
+		else if (fieldExponent >= 1)
+			outBits |= (static_cast<uint64_t>(fieldExponent) << mantissaBits) | ((significand << (mantissaBits + 1u - numDigits)) & mantissaMask);
+		else if (floatSpec.SupportsDenormals())
+		{
+			const int32_t denormalExponent = 1 - floatSpec.GetExponentOfOne() - static_cast<int32_t>(mantissaBits);
+			outBits |= significand << (lowPlace - denormalExponent);
+		}
+		// Otherwise it flushes to zero
+	}
+
+	// Overflow is infinity, or the largest finite value without NaNs
+	if (isOverflow)
+		outBits = sign | (allOnesExponent << mantissaBits) | (floatSpec.SupportsNans() ? 0u : mantissaMask);
+
+	return Result::Ok();
+}
+
+int rkci::ConstantFolding::CompareFloats(const FloatValue &a, const FloatValue &b)
+{
+	const bool isAZero = (a.m_class == FloatClass::kFinite && a.m_magnitude.IsZero());
+	const bool isBZero = (b.m_class == FloatClass::kFinite && b.m_magnitude.IsZero());
+
+	// Zeros are equal whatever their signs
+	const bool isANegative = (a.m_isNegative && !isAZero);
+	const bool isBNegative = (b.m_isNegative && !isBZero);
+
+	if (isANegative != isBNegative)
+		return isANegative ? -1 : 1;
+
+	int comparedMagnitudes = 0;
+	if (a.m_class == FloatClass::kInfinity || b.m_class == FloatClass::kInfinity)
+		comparedMagnitudes = (a.m_class == b.m_class) ? 0 : ((a.m_class == FloatClass::kInfinity) ? 1 : -1);
+	else if (a.m_magnitude < b.m_magnitude)
+		comparedMagnitudes = -1;
+	else if (a.m_magnitude > b.m_magnitude)
+		comparedMagnitudes = 1;
+
+	return isANegative ? -comparedMagnitudes : comparedMagnitudes;
+}
+
+// Truncates toward zero, and returns false if that doesn't fit in 63 bits and a sign
+bool rkci::ConstantFolding::TruncateToInt(const FloatValue &value, int64_t &outValue)
+{
+	const BigUBinFloat_t &magnitude = value.m_magnitude;
+
+	outValue = 0;
+	if (magnitude.IsZero())
+		return true;
+
+	const int32_t lowPlace = magnitude.GetLowPlace();
+	if (static_cast<int32_t>(magnitude.GetNumDigits()) + lowPlace > 63)
+		return false;
+
+	uint64_t significand = 0;
+	if (!GetSignificand(magnitude, significand))
+		return false;
+
+	uint64_t intMagnitude = 0;
+	if (lowPlace >= 0)
+		intMagnitude = significand << lowPlace;
+	else if (lowPlace > -64)
+		intMagnitude = significand >> (-lowPlace);
+
+	outValue = static_cast<int64_t>(intMagnitude);
+	if (value.m_isNegative)
+		outValue = -outValue;
+
+	return true;
+}
+
+// Gets the digits of a value with at most 64 of them, as an integer
+bool rkci::ConstantFolding::GetSignificand(const BigUBinFloat_t &magnitude, uint64_t &outSignificand)
+{
+	const uint32_t numFragments = magnitude.GetNumFragments();
+	if (magnitude.GetNumDigits() > 64 || numFragments > 2)
+		return false;
+
+	outSignificand = 0;
+	for (uint32_t i = 0; i < numFragments; i++)
+		outSignificand |= static_cast<uint64_t>(magnitude.GetFragment(i)) << (i * BigUBinFloat_t::kDigitsPerFragment);
+
+	return true;
+}
+
+rkci::ResultRV<rkci::BigUBinFloat_t> rkci::ConstantFolding::MakeMagnitude(uint64_t significand, int32_t exponent) const
+{
+	BigUBinFloat_t value(static_cast<uint32_t>(significand & 0xffffffffu), *m_alloc);
+	BigUBinFloat_t high(static_cast<uint32_t>(significand >> 32), *m_alloc);
+
+	RKC_CHECK(high.ShiftInPlace(32));
+	RKC_CHECK(value.AddInPlace(high));
+	RKC_CHECK(value.ShiftInPlace(exponent));
+
+	return value;
+}
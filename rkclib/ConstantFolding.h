@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "BigUBinFloatProto.h"
+#include "BigUFloat.h"
+#include "KernelIR.h"
+#include "Vector.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	class FloatSpec;
+	class Result;
+
+	// Evaluates operations whose operands are all constants, so that the backend gets their results as
+	// constants instead of computing them in every lane.
+	//
+	// Float operations are computed exactly with BigUBinFloat_t and rounded once to the result's
+	// floatspec with NumUtils::RoundToFloatSpec, then flushed, saturated or clamped to zero the same way
+	// as the backend does for that floatspec (see CustomFloatFormat), so a folded value is the same bits
+	// that the kernel would have computed.  Float constants are in the floatspec's encoding, which is the
+	// IEEE one for IEEE floatspecs.
+	//
+	// Anything whose result the target doesn't pin down is left for run time: integer results outside of
+	// their declared range, conversions from floats to integers that don't truncate into range, and float
+	// operations involving NaNs, since which payload survives depends on the target.  A select on a
+	// constant mask is replaced by the value that it selects, and constants that nothing uses anymore are
+	// dropped.  Variables aren't tracked, so values read from them are never constant.
+	class ConstantFolding
+	{
+	public:
+		explicit ConstantFolding(IAllocator *alloc);
+
+		// Writes the folded form of a kernel to output, which must be empty
+		Result Run(const Kernel::Function &input, Kernel::Function &output);
+
+		// Number of operations replaced by a constant or by one of their operands in the last Run
+		size_t GetNumFolded() const;
+
+	private:
+		enum class FoldKind : uint8_t
+		{
+			kNotFolded,
+			kConstant,
+			kAlias,
+		};
+
+		struct Fold
+		{
+			FoldKind m_kind;
+			uint64_t m_value;	// Constant immediate, or the input value that an alias stands for
+		};
+
+		enum class FloatClass : uint8_t
+		{
+			kFinite,
+			kInfinity,
+			kNan,
+		};
+
+		struct FloatValue
+		{
+			FloatValue();
+
+			FloatClass m_class;
+			bool m_isNegative;
+			BigUBinFloat_t m_magnitude;
+		};
+
+		Result FoldInstruction(Kernel::ValueIndex_t index);
+		Result FoldConvert(const Kernel::Instruction &instr, uint64_t operand, bool &outIsFolded, uint64_t &outImmediate) const;
+		static bool FoldIntOperation(Kernel::Opcode opcode, int64_t a, int64_t b, int64_t &outResult);
+		Result FoldFloatArithmetic(Kernel::Opcode opcode, const FloatSpec &floatSpec, uint64_t a, uint64_t b, bool &outIsFolded, uint64_t &outImmediate) const;
+		static bool FoldComparison(Kernel::Opcode opcode, int compared);
+
+		Kernel::ValueIndex_t Resolve(Kernel::ValueIndex_t value) const;
+		bool GetConstant(Kernel::ValueIndex_t value, uint64_t &outImmediate) const;
+		bool IsInTypeRange(Kernel::TypeIndex_t type, int64_t value) const;
+
+		static bool CanEncode(const FloatSpec &floatSpec);
+		Result DecodeFloat(const FloatSpec &floatSpec, uint64_t bits, FloatValue &outValue) const;
+		Result EncodeFloat(const FloatSpec &floatSpec, const FloatValue &value, uint64_t &outBits) const;
+		static int CompareFloats(const FloatValue &a, const FloatValue &b);
+		static bool TruncateToInt(const FloatValue &value, int64_t &outValue);
+		static bool GetSignificand(const BigUBinFloat_t &magnitude, uint64_t &outSignificand);
+		ResultRV<BigUBinFloat_t> MakeMagnitude(uint64_t significand, int32_t exponent) const;
+
+		const Kernel::Function *m_input;
+		IAllocator *m_alloc;
+
+		Vector<Fold> m_folds;
+		Vector<uint8_t> m_isUsed;
+		Vector<Kernel::ValueIndex_t> m_valueMap;
+		size_t m_numFolded;
+	};
+}
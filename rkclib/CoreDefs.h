@@ -46,7 +46,9 @@
 #endif
 
 #if RKC_IS_GCC || RKC_IS_CLANG
-#	define RKC_IS_CLANG_OR_GCC
+#	define RKC_IS_CLANG_OR_GCC	1
+#else
+#	define RKC_IS_CLANG_OR_GCC	0
 #endif
 
 #if RKC_IS_CLANG_OR_GCC
@@ -55,6 +57,14 @@
 #	define RKC_WARN_UNUSED_RESULT_ATTRIB _Must_inspect_result_
 #endif
 
+#if RKC_IS_CLANG_OR_GCC
+#	define RKC_LIKELY(n)	__builtin_expect(!!(n), 1)
+#	define RKC_UNLIKELY(n)	__builtin_expect(!!(n), 0)
+#else
+#	define RKC_LIKELY(n)	(n)
+#	define RKC_UNLIKELY(n)	(n)
+#endif
+
 #if RKC_IS_DEBUG
 #	include <cassert>
 #	define RKC_ASSERT(n) assert(n)
@@ -67,6 +77,24 @@
 #	define RKC_ASSERTS_ENABLED	0
 #endif
 
+// Debug-only instrumentation that records how large each Vector instantiation grows and how often it
+// spills out of its inline storage.  A histogram is printed when the process exits.
+#ifndef RKC_CONFIG_VECTOR_STATS
+#	define RKC_CONFIG_VECTOR_STATS 0
+#endif
+
+#if RKC_IS_DEBUG && RKC_CONFIG_VECTOR_STATS
+#	define RKC_VECTOR_STATS_ENABLED	1
+#else
+#	define RKC_VECTOR_STATS_ENABLED	0
+#endif
+
+#if RKC_IS_VISUAL_STUDIO
+#	define RKC_FUNCTION_SIGNATURE	__FUNCSIG__
+#else
+#	define RKC_FUNCTION_SIGNATURE	__PRETTY_FUNCTION__
+#endif
+
 #define RKC_STATIC_ASSERT(n) static_assert((n), "Static assert condition (" #n ") not satisfied")
 
 #define RKC_COMBINE_TOKENS(a, b) a##b
@@ -0,0 +1,290 @@
+#include "CustomFloatFormat.h"
+#include "Result.h"
+
+rkci::CustomFloatFormat::CustomFloatFormat(const FloatSpec &floatSpec, SimdElementFormat wideFormat, SimdElementFormat storageFormat)
+	: m_floatSpec(floatSpec)
+	, m_wideFormat(wideFormat)
+	, m_storageFormat(storageFormat)
+{
+}
+
+rkci::ResultRV<rkci::CustomFloatFormat> rkci::CustomFloatFormat::Create(const FloatSpec &floatSpec)
+{
+	const uint32_t exponentBits = floatSpec.GetExponentBits();
+	const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+	const uint32_t totalBits = (floatSpec.IsSigned() ? 1u : 0u) + exponentBits + mantissaBits;
+
+	// NaNs need a mantissa bit to tell them from infinity
+	if (exponentBits == 0 || exponentBits > 16 || totalBits > 32 || (floatSpec.SupportsNans() && mantissaBits == 0))
+		return rkc::ResultCodes::kNotYetImplemented;
+
+	SimdElementFormat storageFormat = SimdElementFormat::kUInt32;
+	if (totalBits <= 8)
+		storageFormat = SimdElementFormat::kUInt8;
+	else if (totalBits <= 16)
+		storageFormat = SimdElementFormat::kUInt16;
+
+	const SimdElementFormat wideFormats[] = { SimdElementFormat::kFloat32, SimdElementFormat::kFloat64 };
+	for (size_t i = 0; i < sizeof(wideFormats) / sizeof(wideFormats[0]); i++)
+	{
+		const CustomFloatFormat format(floatSpec, wideFormats[i], storageFormat);
+		const int32_t wideMaxExponent = GetIeeeMaxExponent(wideFormats[i]);
+
+		if (format.GetMaxExponent() < format.GetMinNormalExponent())
+			return rkc::ResultCodes::kNotYetImplemented;
+
+		// Denormals are rounded against a power of two whose last mantissa bit is the smallest one
+		const int32_t denormalBaseExponent = format.GetDenormalExponent() + GetIeeeMantissaBits(wideFormats[i]);
+
+		if (2 * mantissaBits + 3 <= GetIeeeMantissaBits(wideFormats[i])
+			&& format.GetMinNormalExponent() >= 1 - wideMaxExponent
+			&& format.GetMaxExponent() <= wideMaxExponent
+			&& (!floatSpec.SupportsDenormals() || denormalBaseExponent <= wideMaxExponent))
+			return format;
+	}
+
+	return rkc::ResultCodes::kNotYetImplemented;
+}
+
+const rkci::FloatSpec &rkci::CustomFloatFormat::GetFloatSpec() const
+{
+	return m_floatSpec;
+}
+
+rkci::SimdElementFormat rkci::CustomFloatFormat::GetWideFormat() const
+{
+	return m_wideFormat;
+}
+
+rkci::SimdElementFormat rkci::CustomFloatFormat::GetStorageFormat() const
+{
+	return m_storageFormat;
+}
+
+rkci::CustomFloatFormat::RoundingParams rkci::CustomFloatFormat::GetRoundingParams(SimdElementFormat sourceFormat) const
+{
+	const uint8_t sourceMantissaBits = GetIeeeMantissaBits(sourceFormat);
+	const uint32_t mantissaBits = m_floatSpec.GetMantissaBits();
+
+	// Ties between the largest finite value and the next power of two round up, since the largest
+	// finite value is odd, and so do ties between the smallest normal and the value under it
+	const uint64_t tieSignificand = (static_cast<uint64_t>(1) << (mantissaBits + 2)) - 1u;
+
+	RoundingParams params;
+	params.m_sourceFormat = sourceFormat;
+	params.m_dropBits = static_cast<uint8_t>(sourceMantissaBits - mantissaBits);
+	params.m_minNormal = CeilToFloatBits(sourceFormat, 1, GetMinNormalExponent());
+	params.m_flushThreshold = CeilToFloatBits(sourceFormat, tieSignificand, GetMinNormalExponent() - static_cast<int32_t>(mantissaBits) - 2);
+	params.m_denormalBase = CeilToFloatBits(sourceFormat, 1, GetDenormalExponent() + sourceMantissaBits);
+	params.m_overflowThreshold = CeilToFloatBits(sourceFormat, tieSignificand, GetMaxExponent() - static_cast<int32_t>(mantissaBits) - 1);
+	params.m_maxFinite = CeilToFloatBits(sourceFormat, (static_cast<uint64_t>(1) << (mantissaBits + 1)) - 1u, GetMaxExponent() - static_cast<int32_t>(mantissaBits));
+	params.m_infinity = CeilToFloatBits(sourceFormat, 1, GetIeeeMaxExponent(sourceFormat) + 1);
+	params.m_quietBit = static_cast<uint64_t>(1) << (sourceMantissaBits - 1);
+
+	return params;
+}
+
+uint64_t rkci::CustomFloatFormat::Round(SimdElementFormat sourceFormat, uint64_t bits) const
+{
+	const RoundingParams params = GetRoundingParams(sourceFormat);
+	const uint64_t signMask = static_cast<uint64_t>(1) << (SimdTarget::GetElementBits(sourceFormat) - 1);
+	const uint64_t keepMask = ~((static_cast<uint64_t>(1) << params.m_dropBits) - 1u);
+	const uint64_t magnitude = bits & ~signMask;
+	const uint64_t sign = m_floatSpec.IsSigned() ? (bits & signMask) : 0;
+
+	// NaNs are quieted and keep the high bits of their payload
+	if (magnitude > params.m_infinity)
+	{
+		if (!m_floatSpec.SupportsNans())
+			return 0;
+
+		return ((magnitude | params.m_quietBit) & keepMask) | sign;
+	}
+
+	if (!m_floatSpec.IsSigned() && (bits & signMask) != 0)
+		return 0;
+
+	uint64_t rounded = 0;
+	if (magnitude >= params.m_overflowThreshold)
+		rounded = m_floatSpec.SupportsNans() ? params.m_infinity : params.m_maxFinite;
+	else if (magnitude < params.m_minNormal)
+	{
+		if (!m_floatSpec.SupportsDenormals())
+			rounded = (magnitude >= params.m_flushThreshold) ? params.m_minNormal : 0;
+		else
+		{
+			// Rounds to a whole number of the smallest denormal
+			int32_t exponent = 0;
+			const uint64_t significand = GetSignificand(sourceFormat, magnitude, exponent);
+			const int32_t shift = GetDenormalExponent() - exponent;
+
+			uint64_t units = significand;
+			if (shift >= 64)
+				units = 0;
+			else if (shift > 0)
+			{
+				const uint64_t remainder = significand & ((static_cast<uint64_t>(1) << shift) - 1u);
+				const uint64_t half = static_cast<uint64_t>(1) << (shift - 1);
+
+				units = significand >> shift;
+				if (remainder > half || (remainder == half && (units & 1u) != 0))
+					units++;
+			}
+
+			rounded = CeilToFloatBits(sourceFormat, units, GetDenormalExponent());
+		}
+	}
+	else if (params.m_dropBits == 0)
+		rounded = magnitude;
+	else
+		rounded = (magnitude + (static_cast<uint64_t>(1) << (params.m_dropBits - 1)) - 1u + ((magnitude >> params.m_dropBits) & 1u)) & keepMask;
+
+	return rounded | sign;
+}
+
+uint64_t rkci::CustomFloatFormat::Pack(uint64_t wideBits) const
+{
+	const RoundingParams params = GetRoundingParams(m_wideFormat);
+	const uint8_t wideMantissaBits = GetIeeeMantissaBits(m_wideFormat);
+	const uint32_t exponentBits = m_floatSpec.GetExponentBits();
+	const uint32_t mantissaBits = m_floatSpec.GetMantissaBits();
+	const uint64_t signMask = static_cast<uint64_t>(1) << (SimdTarget::GetElementBits(m_wideFormat) - 1);
+	const uint64_t magnitude = wideBits & ~signMask;
+
+	uint64_t packed = 0;
+	if (magnitude >= params.m_infinity)
+	{
+		const uint64_t allOnesExponent = (static_cast<uint64_t>(1) << exponentBits) - 1u;
+		packed = (allOnesExponent << mantissaBits) | ((magnitude & ((static_cast<uint64_t>(1) << wideMantissaBits) - 1u)) >> params.m_dropBits);
+	}
+	else if (magnitude < params.m_minNormal)
+	{
+		// A whole number of the smallest denormal
+		int32_t exponent = 0;
+		const uint64_t significand = GetSignificand(m_wideFormat, magnitude, exponent);
+		const int32_t shift = exponent - GetDenormalExponent();
+		packed = (shift >= 0) ? (significand << shift) : (significand >> -shift);
+	}
+	else
+		packed = (magnitude >> params.m_dropBits) - (static_cast<uint64_t>(GetIeeeMaxExponent(m_wideFormat) - m_floatSpec.GetExponentOfOne()) << mantissaBits);
+
+	if (m_floatSpec.IsSigned() && (wideBits & signMask) != 0)
+		packed |= static_cast<uint64_t>(1) << (exponentBits + mantissaBits);
+
+	return packed;
+}
+
+uint64_t rkci::CustomFloatFormat::Unpack(uint64_t packedBits) const
+{
+	const uint8_t wideMantissaBits = GetIeeeMantissaBits(m_wideFormat);
+	const uint32_t exponentBits = m_floatSpec.GetExponentBits();
+	const uint32_t mantissaBits = m_floatSpec.GetMantissaBits();
+	const uint64_t allOnesExponent = (static_cast<uint64_t>(1) << exponentBits) - 1u;
+	const uint64_t fieldExponent = (packedBits >> mantissaBits) & allOnesExponent;
+	const uint64_t mantissa = packedBits & ((static_cast<uint64_t>(1) << mantissaBits) - 1u);
+
+	uint64_t bits = 0;
+	if (m_floatSpec.SupportsNans() && fieldExponent == allOnesExponent)
+		bits = CeilToFloatBits(m_wideFormat, 1, GetIeeeMaxExponent(m_wideFormat) + 1) | (mantissa << (wideMantissaBits - mantissaBits));
+	else if (fieldExponent == 0)
+	{
+		if (m_floatSpec.SupportsDenormals())
+			bits = CeilToFloatBits(m_wideFormat, mantissa, GetDenormalExponent());
+	}
+	else
+		bits = CeilToFloatBits(m_wideFormat, mantissa | (static_cast<uint64_t>(1) << mantissaBits), static_cast<int32_t>(fieldExponent) - m_floatSpec.GetExponentOfOne() - static_cast<int32_t>(mantissaBits));
+
+	if (m_floatSpec.IsSigned() && ((packedBits >> (exponentBits + mantissaBits)) & 1u) != 0)
+		bits |= static_cast<uint64_t>(1) << (SimdTarget::GetElementBits(m_wideFormat) - 1);
+
+	return bits;
+}
+
+uint64_t rkci::CustomFloatFormat::CeilToFloatBits(SimdElementFormat format, uint64_t significand, int32_t exponent)
+{
+	if (significand == 0)
+		return 0;
+
+	const uint8_t mantissaBits = GetIeeeMantissaBits(format);
+	const int32_t maxExponent = GetIeeeMaxExponent(format);
+
+	int32_t topBit = 0;
+	while ((significand >> (topBit + 1)) != 0)
+		topBit++;
+
+	const int32_t valueExponent = exponent + topBit;
+	if (valueExponent > maxExponent)
+		return static_cast<uint64_t>(2 * maxExponent + 1) << mantissaBits;
+
+	// Denormals all have the smallest normal's last mantissa bit
+	const bool isDenormal = (valueExponent < 1 - maxExponent);
+	const int32_t lastBitExponent = isDenormal ? (1 - maxExponent - mantissaBits) : (valueExponent - mantissaBits);
+	const int32_t shift = lastBitExponent - exponent;
+
+	uint64_t units = 1;
+	if (shift <= 0)
+		units = significand << -shift;
+	else if (shift < 64)
+	{
+		units = significand >> shift;
+		if ((significand & ((static_cast<uint64_t>(1) << shift) - 1u)) != 0)
+			units++;
+	}
+
+	// Rounding up can carry into the next exponent, or from the denormals into the smallest normal
+	if (isDenormal)
+		return units;
+
+	return (static_cast<uint64_t>(valueExponent + maxExponent) << mantissaBits) + units - (static_cast<uint64_t>(1) << mantissaBits);
+}
+
+// Splits a finite, non-negative value into significand * 2^exponent
+uint64_t rkci::CustomFloatFormat::GetSignificand(SimdElementFormat format, uint64_t magnitude, int32_t &outExponent)
+{
+	const uint8_t mantissaBits = GetIeeeMantissaBits(format);
+	const uint64_t fieldExponent = magnitude >> mantissaBits;
+	const uint64_t mantissa = magnitude & ((static_cast<uint64_t>(1) << mantissaBits) - 1u);
+
+	if (fieldExponent == 0)
+	{
+		outExponent = 1 - GetIeeeMaxExponent(format) - mantissaBits;
+		return mantissa;
+	}
+
+	outExponent = static_cast<int32_t>(fieldExponent) - GetIeeeMaxExponent(format) - mantissaBits;
+	return mantissa | (static_cast<uint64_t>(1) << mantissaBits);
+}
+
+uint8_t rkci::CustomFloatFormat::GetIeeeMantissaBits(SimdElementFormat format)
+{
+	if (format == SimdElementFormat::kFloat32)
+		return 23;
+
+	return 52;
+}
+
+int32_t rkci::CustomFloatFormat::GetIeeeMaxExponent(SimdElementFormat format)
+{
+	if (format == SimdElementFormat::kFloat32)
+		return 127;
+
+	return 1023;
+}
+
+// The exponent of the largest finite value
+int32_t rkci::CustomFloatFormat::GetMaxExponent() const
+{
+	const int32_t maxField = (1 << m_floatSpec.GetExponentBits()) - (m_floatSpec.SupportsNans() ? 2 : 1);
+	return maxField - m_floatSpec.GetExponentOfOne();
+}
+
+int32_t rkci::CustomFloatFormat::GetMinNormalExponent() const
+{
+	return 1 - m_floatSpec.GetExponentOfOne();
+}
+
+// The exponent of the smallest denormal, which is also the last mantissa bit of the smallest normal
+int32_t rkci::CustomFloatFormat::GetDenormalExponent() const
+{
+	return GetMinNormalExponent() - static_cast<int32_t>(m_floatSpec.GetMantissaBits());
+}
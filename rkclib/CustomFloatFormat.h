@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "FloatSpec.h"
+#include "SimdTarget.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	template<class T> class ResultRV;
+
+	// How the SIMD backend lowers a floatspec that isn't IEEE binary16, 32 or 64, such as bfloat16, the
+	// 8-bit E4M3 and E5M2 formats, or the unsigned 11 and 10-bit ones.
+	//
+	// Values are held in registers in a wide IEEE format that holds every value of the floatspec
+	// exactly, with at least twice the precision plus two bits, so rounding an arithmetic result to the
+	// wide format first doesn't change how it rounds to the floatspec.  Results are rounded to the
+	// floatspec to nearest even, the same as NumUtils::RoundToFloatSpec.  Buffers and uniforms hold the
+	// packed encoding in the narrowest unsigned integer that fits it.
+	//
+	// The encoding is a sign bit if the floatspec is signed, then the exponent and then the mantissa.  A
+	// zero exponent is zero, or a denormal if the floatspec has them, and otherwise values that round
+	// below the smallest normal flush to zero.  With NaNs, the all-ones exponent is infinity and NaN as
+	// in IEEE.  Without them it's an ordinary exponent, overflow and infinity saturate to the largest
+	// finite value, and NaN converts to zero.  Unsigned floatspecs convert negative values to zero.
+	class CustomFloatFormat
+	{
+	public:
+		// Constants for rounding from one IEEE format, as bits of that format
+		struct RoundingParams
+		{
+			SimdElementFormat m_sourceFormat;
+			uint8_t m_dropBits;				// Low mantissa bits that the floatspec doesn't have
+			uint64_t m_minNormal;			// Smallest normal value of the floatspec
+			uint64_t m_flushThreshold;		// Without denormals, smaller values flush to zero
+			uint64_t m_denormalBase;		// Power of two whose last mantissa bit is the floatspec's smallest denormal
+			uint64_t m_overflowThreshold;	// Smallest value that rounds past the largest finite value
+			uint64_t m_maxFinite;
+			uint64_t m_infinity;
+			uint64_t m_quietBit;
+		};
+
+		// Returns kNotYetImplemented if no wide format holds the floatspec
+		static ResultRV<CustomFloatFormat> Create(const FloatSpec &floatSpec);
+
+		const FloatSpec &GetFloatSpec() const;
+		SimdElementFormat GetWideFormat() const;
+		SimdElementFormat GetStorageFormat() const;
+
+		// The source format is the wide format or float64
+		RoundingParams GetRoundingParams(SimdElementFormat sourceFormat) const;
+
+		// Scalar versions of the emitted operations, with values as the bits of their IEEE format.  Round
+		// returns a value of the source format, and Pack takes a value that's already rounded.
+		uint64_t Round(SimdElementFormat sourceFormat, uint64_t bits) const;
+		uint64_t Pack(uint64_t wideBits) const;
+		uint64_t Unpack(uint64_t packedBits) const;
+
+		// Gets the bits of the smallest value of an IEEE format that's at least significand * 2^exponent,
+		// which is infinity if it's past the largest finite value
+		static uint64_t CeilToFloatBits(SimdElementFormat format, uint64_t significand, int32_t exponent);
+
+	private:
+		CustomFloatFormat(const FloatSpec &floatSpec, SimdElementFormat wideFormat, SimdElementFormat storageFormat);
+
+		static uint64_t GetSignificand(SimdElementFormat format, uint64_t magnitude, int32_t &outExponent);
+		static uint8_t GetIeeeMantissaBits(SimdElementFormat format);
+		static int32_t GetIeeeMaxExponent(SimdElementFormat format);
+
+		int32_t GetMaxExponent() const;
+		int32_t GetMinNormalExponent() const;
+		int32_t GetDenormalExponent() const;
+
+		FloatSpec m_floatSpec;
+		SimdElementFormat m_wideFormat;
+		SimdElementFormat m_storageFormat;
+	};
+}
@@ -6,9 +6,22 @@
 #include "NumUtils.h"
 #include "FloatSpec.h"
 #include "MoveOrCopy.h"
+#include "IAllocator.h"
+#include "DecPowerCache.h"
 
 
-rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const MoveOrCopy<BigUBinFloat_t> &binMOC, const FloatSpec &floatSpec)
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const BigUBinFloat_t &bin, const FloatSpec &floatSpec, DecPowerCache *powerCache)
+{
+	return BinToDecWithFloatSpecImpl(MoveOrCopy<BigUBinFloat_t, false>(bin), floatSpec, powerCache);
+}
+
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(BigUBinFloat_t &&bin, const FloatSpec &floatSpec, DecPowerCache *powerCache)
+{
+	return BinToDecWithFloatSpecImpl(MoveOrCopy<BigUBinFloat_t, true>(rkci::Move(bin)), floatSpec, powerCache);
+}
+
+template<bool TIsMove>
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpecImpl(const MoveOrCopy<BigUBinFloat_t, TIsMove> &binMOC, const FloatSpec &floatSpec, DecPowerCache *powerCache)
 {
 	const BigUBinFloat_t &bin = binMOC.Get();
 
@@ -18,6 +31,9 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 		return BigUDecFloat_t();
 	}
 
+	IAllocator &alloc = *bin.GetAllocator();
+	AllocatorTagScope tagScope(alloc, rkc::AllocatorTags::kBigNum);
+
 	const int32_t highBitPos = bin.GetLowPlace() + static_cast<int32_t>(bin.GetNumDigits()) - 1;
 	const int32_t codedExponent = highBitPos + floatSpec.GetExponentOfOne();
 
@@ -28,19 +44,19 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 	if (bin.GetLowPlace() < lowestPossibleBitPos)
 	{
 		RKC_CHECK_RV(BigUBinFloat_t, rounded, NumUtils::RoundToFloatSpec(binMOC, floatSpec));
-		return BinToDecWithFloatSpec(rkci::Move(rounded), floatSpec);
+		return BinToDecWithFloatSpecImpl(MoveOrCopy<BigUBinFloat_t, true>(rkci::Move(rounded)), floatSpec, powerCache);
 	}
 
 	BigUBinFloat_t nextAboveStep;
 	BigUBinFloat_t nextBelowStep;
 
 	{
-		nextAboveStep = BigUBinFloat_t(1, *bin.GetAllocator());
+		nextAboveStep = BigUBinFloat_t(1, alloc);
 		RKC_CHECK(nextAboveStep.ShiftInPlace(lowestPossibleBitPos));
 	}
 
 	{
-		nextBelowStep = BigUBinFloat_t(1, *bin.GetAllocator());
+		nextBelowStep = BigUBinFloat_t(1, alloc);
 		if (bin.GetNumDigits() == 1)
 		{
 			// Subtracting 1 will produce a lower value
@@ -85,9 +101,9 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 	RKC_CHECK(nextAboveStep.ShiftInPlace(-1));
 	RKC_CHECK(nextBelowStep.ShiftInPlace(-1));
 
-	RKC_CHECK_RV(BigUBinFloat_t, upperBounds, bin.Clone());
+	// If the input is owned, the upper bound takes it over instead of cloning it
 	RKC_CHECK_RV(BigUBinFloat_t, lowerBounds, bin.Clone());
-	binMOC.Consume();
+	RKC_CHECK_RV(BigUBinFloat_t, upperBounds, binMOC.Produce());
 
 	RKC_CHECK(upperBounds.AddInPlace(nextAboveStep));
 	nextAboveStep = BigUBinFloat_t();
@@ -95,10 +111,10 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 	RKC_CHECK(lowerBounds.SubtractInPlace(nextBelowStep));
 	nextBelowStep = BigUBinFloat_t();
 
-	RKC_CHECK_RV(BigUDecFloat_t, upperBoundsDec, DecBin::BinToDec(upperBounds));
+	RKC_CHECK_RV(BigUDecFloat_t, upperBoundsDec, DecBin::BinToDec(upperBounds, powerCache));
 	upperBounds = BigUBinFloat_t();
 
-	RKC_CHECK_RV(BigUDecFloat_t, lowerBoundsDec, DecBin::BinToDec(lowerBounds));
+	RKC_CHECK_RV(BigUDecFloat_t, lowerBoundsDec, DecBin::BinToDec(lowerBounds, powerCache));
 	lowerBounds = BigUBinFloat_t();
 
 	// The true value falls exclusively between upperBoundsDec and lowerBoundsDec
@@ -114,7 +130,7 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 
 		const int32_t highDigitPlace = upperHighDigitExclusive - 1;
 
-		BigUDecFloat_t result(highDigit, *bin.GetAllocator());
+		BigUDecFloat_t result(highDigit, alloc);
 		RKC_CHECK(result.ShiftInPlace(highDigitPlace));
 
 		return result;
@@ -132,7 +148,7 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 		BigUDecFloat_t::Fragment_t upperRemainder = upperBoundsDec.GetFragment(upperBoundsDec.GetNumFragments() - 1);
 		BigUDecFloat_t::Fragment_t lowerRemainder = lowerBoundsDec.GetFragment(lowerBoundsDec.GetNumFragments() - 1);
 
-		BigUDecFloat_t::FragmentVector_t reconstructedFrags(bin.GetAllocator());
+		BigUDecFloat_t::FragmentVector_t reconstructedFrags(&alloc);
 
 		uint32_t fragTopPos = 0;
 
@@ -204,12 +220,13 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDecWithFloatSpec(const M
 	}
 }
 
-rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDec(const MoveOrCopy<BigUBinFloat_t> &binMOC)
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDec(const BigUBinFloat_t &bin, DecPowerCache *powerCache)
 {
-	const BigUBinFloat_t &bin = binMOC.Get();
 	if (bin.IsZero())
 		return BigUDecFloat_t();
 
+	AllocatorTagScope tagScope(*bin.GetAllocator(), rkc::AllocatorTags::kBigNum);
+
 	const unsigned int kBitsPerSlice = 16;
 	RKC_STATIC_ASSERT(BigUBinFloat_t::kDigitsPerFragment % kBitsPerSlice == 0);
 	RKC_STATIC_ASSERT((static_cast<uintmax_t>(1) << kBitsPerSlice) - 1 < BigUDecFloat_t::kFragmentModulo);
@@ -221,13 +238,13 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDec(const MoveOrCopy<Big
 	BigUDecFloat_t currentSliceMultiplier;
 	if (lowPlace < 0)
 	{
-		RKC_CHECK_RV(BigUDecFloat_t, multiplier , NumUtils::PositivePow(BigUDecFloat_t(5, *bin.GetAllocator()), static_cast<uint32_t>(-lowPlace)));
+		RKC_CHECK_RV(BigUDecFloat_t, multiplier , PowerOfFive(static_cast<uint32_t>(-lowPlace), *bin.GetAllocator(), powerCache));
 		RKC_CHECK(multiplier.ShiftInPlace(lowPlace));
 		currentSliceMultiplier = rkci::Move(multiplier);
 	}
 	else if (lowPlace > 0)
 	{
-		RKC_CHECK_RV(BigUDecFloat_t, multiplier, NumUtils::PositivePow(BigUDecFloat_t(2, *bin.GetAllocator()), static_cast<uint32_t>(lowPlace)));
+		RKC_CHECK_RV(BigUDecFloat_t, multiplier, PowerOfTwo(static_cast<uint32_t>(lowPlace), *bin.GetAllocator(), powerCache));
 		currentSliceMultiplier = rkci::Move(multiplier);
 	}
 	else //if (lowPlace == 0)
@@ -258,13 +275,13 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::BinToDec(const MoveOrCopy<Big
 	return result;
 }
 
-rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBin(const MoveOrCopy<BigUDecFloat_t> &decMOC, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes)
+rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBin(const BigUDecFloat_t &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes, DecPowerCache *powerCache)
 {
-	const BigUDecFloat_t &dec = decMOC.Get();
-
 	if (dec.IsZero())
 		return rkci::BigUBinFloat_t();
 
+	AllocatorTagScope tagScope(*dec.GetAllocator(), rkc::AllocatorTags::kBigNum);
+
 	int32_t lowPlace = dec.GetLowPlace();
 	if (dec.GetLowPlace() >= 0)
 	{
@@ -279,9 +296,7 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBin(const MoveOrCopy<Big
 	if (lowDigit == 5)
 	{
 		// Could be an exact binary number
-		BigUDecFloat_t two(2, *dec.GetAllocator());
-
-		RKC_CHECK_RV(BigUDecFloat_t, twoToPowerOfTrailingDigits, NumUtils::PositivePow(two, -lowPlace));
+		RKC_CHECK_RV(BigUDecFloat_t, twoToPowerOfTrailingDigits, PowerOfTwo(static_cast<uint32_t>(-lowPlace), *dec.GetAllocator(), powerCache));
 
 		RKC_CHECK_RV(BigUDecFloat_t, decRaised, dec.Clone());
 		RKC_CHECK(decRaised.MultiplyInPlace(twoToPowerOfTrailingDigits));
@@ -294,14 +309,14 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBin(const MoveOrCopy<Big
 			decRaised = BigUDecFloat_t();
 
 			RKC_CHECK(binInt.ShiftInPlace(lowPlace));
-			RKC_CHECK_RV(BigUBinFloat_t, truncated, NumUtils::RoundToFloatSpec(binInt, floatSpec));
+			RKC_CHECK_RV(BigUBinFloat_t, truncated, NumUtils::RoundToFloatSpec(rkci::Move(binInt), floatSpec));
 
 			return truncated;
 		}
 	}
 
 	// Not an exact binary number
-	return DecToBinNonExact(dec, floatSpec, numSignificantTrailingZeroes);
+	return DecToBinNonExact(dec, floatSpec, numSignificantTrailingZeroes, powerCache);
 }
 
 
@@ -351,7 +366,7 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBinInteger(const BigUDec
 }
 
 // Returns a binary float from an inexact decimal float that can't be rounded to a power of two
-rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBinNonExact(const BigUDecFloat_t &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes)
+rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBinNonExact(const BigUDecFloat_t &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes, DecPowerCache *powerCache)
 {
 	RKC_ASSERT(!dec.IsZero());
 
@@ -366,12 +381,12 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBinNonExact(const BigUDe
 
 	if (longDivideBitPosition >= 0)
 	{
-		RKC_CHECK_RV(BigUDecFloat_t, raised, NumUtils::PositivePow(BigUDecFloat_t(2, alloc), static_cast<uint32_t>(longDivideBitPosition)));
+		RKC_CHECK_RV(BigUDecFloat_t, raised, PowerOfTwo(static_cast<uint32_t>(longDivideBitPosition), alloc, powerCache));
 		longDivideBitDec = rkci::Move(raised);
 	}
 	else
 	{
-		RKC_CHECK_RV(BigUDecFloat_t, raised, NumUtils::PositivePow(BigUDecFloat_t(5, alloc), static_cast<uint32_t>(-longDivideBitPosition)));
+		RKC_CHECK_RV(BigUDecFloat_t, raised, PowerOfFive(static_cast<uint32_t>(-longDivideBitPosition), alloc, powerCache));
 		RKC_CHECK(raised.ShiftInPlace(longDivideBitPosition));
 		longDivideBitDec = rkci::Move(raised);
 	}
@@ -438,3 +453,25 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::DecBin::DecToBinNonExact(const BigUDe
 
 	return NumUtils::RoundToFloatSpec(BigUBinFloat_t(lowPlace, numBitsResolved, rkci::Move(binFragments)), floatSpec);
 }
+
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::PowerOfTwo(uint32_t power, IAllocator &alloc, DecPowerCache *powerCache)
+{
+	if (powerCache)
+	{
+		RKC_ASSERT(powerCache->GetAllocator() == &alloc);
+		return powerCache->PowerOfTwo(power);
+	}
+
+	return NumUtils::PositivePow(BigUDecFloat_t(2, alloc), power);
+}
+
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecBin::PowerOfFive(uint32_t power, IAllocator &alloc, DecPowerCache *powerCache)
+{
+	if (powerCache)
+	{
+		RKC_ASSERT(powerCache->GetAllocator() == &alloc);
+		return powerCache->PowerOfFive(power);
+	}
+
+	return NumUtils::PositivePow(BigUDecFloat_t(5, alloc), power);
+}
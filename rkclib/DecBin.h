@@ -7,18 +7,29 @@
 namespace rkci
 {
 	class FloatSpec;
+	class DecPowerCache;
+	struct IAllocator;
 	template<class T> class ResultRV;
-	template<class T> class MoveOrCopy;
+	template<class T, bool TIsMove> class MoveOrCopy;
 
+	// powerCache may be null, in which case powers of 2 and 5 are recomputed on every call
 	struct DecBin
 	{
-		static ResultRV<BigUDecFloat_t> BinToDec(const MoveOrCopy<BigUBinFloat_t> &bin);
-		static ResultRV<BigUDecFloat_t> BinToDecWithFloatSpec(const MoveOrCopy<BigUBinFloat_t> &bin, const FloatSpec &floatSpec);
-		static ResultRV<BigUBinFloat_t> DecToBin(const MoveOrCopy<BigUDecFloat_t> &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes);
+		static ResultRV<BigUDecFloat_t> BinToDec(const BigUBinFloat_t &bin, DecPowerCache *powerCache);
+		static ResultRV<BigUDecFloat_t> BinToDecWithFloatSpec(const BigUBinFloat_t &bin, const FloatSpec &floatSpec, DecPowerCache *powerCache);
+		static ResultRV<BigUDecFloat_t> BinToDecWithFloatSpec(BigUBinFloat_t &&bin, const FloatSpec &floatSpec, DecPowerCache *powerCache);
+		static ResultRV<BigUBinFloat_t> DecToBin(const BigUDecFloat_t &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes, DecPowerCache *powerCache);
 
 		// Returns a binary float from an integral decimal float
 		static ResultRV<BigUBinFloat_t> DecToBinInteger(const BigUDecFloat_t &dec);
 		// Returns a binary float from an inexact decimal float that can't be rounded to a power of two
-		static ResultRV<BigUBinFloat_t> DecToBinNonExact(const BigUDecFloat_t &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes);
+		static ResultRV<BigUBinFloat_t> DecToBinNonExact(const BigUDecFloat_t &dec, const FloatSpec &floatSpec, uint32_t numSignificantTrailingZeroes, DecPowerCache *powerCache);
+
+	private:
+		template<bool TIsMove>
+		static ResultRV<BigUDecFloat_t> BinToDecWithFloatSpecImpl(const MoveOrCopy<BigUBinFloat_t, TIsMove> &bin, const FloatSpec &floatSpec, DecPowerCache *powerCache);
+
+		static ResultRV<BigUDecFloat_t> PowerOfTwo(uint32_t power, IAllocator &alloc, DecPowerCache *powerCache);
+		static ResultRV<BigUDecFloat_t> PowerOfFive(uint32_t power, IAllocator &alloc, DecPowerCache *powerCache);
 	};
 }
@@ -0,0 +1,63 @@
+#include "DecPowerCache.h"
+#include "BigUFloat.h"
+#include "IAllocator.h"
+#include "NumUtils.h"
+#include "Result.h"
+
+rkci::DecPowerCache::DecPowerCache(IAllocator &alloc)
+	: m_alloc(alloc)
+	, m_powersOfTwo(&alloc)
+	, m_powersOfFive(&alloc)
+	, m_numCachedPowers(0)
+{
+}
+
+rkci::DecPowerCache::~DecPowerCache()
+{
+}
+
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecPowerCache::PowerOfTwo(uint32_t power)
+{
+	return GetPower(m_powersOfTwo, 2, power);
+}
+
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecPowerCache::PowerOfFive(uint32_t power)
+{
+	return GetPower(m_powersOfFive, 5, power);
+}
+
+rkci::IAllocator *rkci::DecPowerCache::GetAllocator() const
+{
+	return &m_alloc;
+}
+
+size_t rkci::DecPowerCache::NumCachedPowers() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_numCachedPowers;
+}
+
+rkci::ResultRV<rkci::BigUDecFloat_t> rkci::DecPowerCache::GetPower(Vector<BigUDecFloat_t> &cache, uint32_t base, uint32_t power)
+{
+	AllocatorTagScope tagScope(m_alloc, rkc::AllocatorTags::kBigNum);
+
+	if (power > kMaxCachedPower)
+		return NumUtils::PositivePow(BigUDecFloat_t(base, m_alloc), power);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (power >= cache.Count())
+	{
+		RKC_CHECK(cache.Resize(power + 1));
+	}
+
+	// Powers of a non-zero base are never zero, so zero marks an empty entry
+	if (cache[power].IsZero())
+	{
+		RKC_CHECK_RV(BigUDecFloat_t, raised, NumUtils::PositivePow(BigUDecFloat_t(base, m_alloc), power));
+		cache[power] = rkci::Move(raised);
+		m_numCachedPowers++;
+	}
+
+	return cache[power].Clone();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "BigUDecFloatProto.h"
+#include "Vector.h"
+
+#include <mutex>
+
+namespace rkci
+{
+	struct IAllocator;
+	template<class T> class ResultRV;
+
+	// Memoizes the decimal powers of 2 and 5 used by decimal/binary literal conversion.  Returned
+	// values are clones allocated from the cache's allocator, so the cache must use the same allocator
+	// as the numbers that they are combined with.  Lookups lock the cache, so module jobs that run
+	// concurrently can share one.
+	class DecPowerCache
+	{
+	public:
+		explicit DecPowerCache(IAllocator &alloc);
+		~DecPowerCache();
+
+		ResultRV<BigUDecFloat_t> PowerOfTwo(uint32_t power);
+		ResultRV<BigUDecFloat_t> PowerOfFive(uint32_t power);
+
+		IAllocator *GetAllocator() const;
+		size_t NumCachedPowers() const;
+
+	private:
+		// Enough for every exponent reachable by a double-precision literal
+		static const uint32_t kMaxCachedPower = 1152;
+
+		ResultRV<BigUDecFloat_t> GetPower(Vector<BigUDecFloat_t> &cache, uint32_t base, uint32_t power);
+
+		IAllocator &m_alloc;
+		Vector<BigUDecFloat_t> m_powersOfTwo;
+		Vector<BigUDecFloat_t> m_powersOfFive;
+		size_t m_numCachedPowers;
+
+		mutable std::mutex m_mutex;
+	};
+}
@@ -0,0 +1,160 @@
+#include "ExportInterface.h"
+#include "ArraySliceView.h"
+#include "Hasher.h"
+#include "Lexer.h"
+
+#include <string.h>
+
+rkci::ExportInterfaceHasher::ExportInterfaceHasher()
+	: m_state(State::kStartOfStatement)
+	, m_bracketDepth(0)
+	, m_hasParameterList(false)
+	, m_hash(HashUtil::kStableHash64Seed)
+{
+}
+
+void rkci::ExportInterfaceHasher::AddToken(const LexToken &token)
+{
+	switch (token.m_tokenType)
+	{
+	case LexTokenType::kWhitespace:
+	case LexTokenType::kLineComment:
+	case LexTokenType::kBlockComment:
+		return;
+
+	case LexTokenType::kEndOfLine:
+	case LexTokenType::kEndOfFile:
+		if (m_state == State::kDeclaration)
+		{
+			HashToken(token);
+			if (m_bracketDepth == 0)
+				m_state = State::kDeclarationLineEnd;
+		}
+		else if (m_state == State::kNotExported)
+			m_state = State::kStartOfStatement;
+		return;
+
+	default:
+		break;
+	}
+
+	if (m_state == State::kDeclarationLineEnd)
+	{
+		if (IsName(token, "where") || IsPunctuation(token, '{'))
+			m_state = State::kDeclaration;
+		else
+			m_state = State::kStartOfStatement;
+	}
+
+	switch (m_state)
+	{
+	case State::kStartOfStatement:
+		if (IsExportKeyword(token))
+		{
+			m_state = State::kDeclaration;
+			m_bracketDepth = 0;
+			m_hasParameterList = false;
+			HashToken(token);
+		}
+		else
+			m_state = State::kNotExported;
+		break;
+
+	case State::kDeclaration:
+		AddDeclarationToken(token);
+		break;
+
+	case State::kFunctionBody:
+		if (IsPunctuation(token, '{'))
+			m_bracketDepth++;
+		else if (IsPunctuation(token, '}') && --m_bracketDepth == 0)
+			m_state = State::kStartOfStatement;
+		break;
+
+	default:
+		break;
+	}
+}
+
+uint64_t rkci::ExportInterfaceHasher::GetHash() const
+{
+	return m_hash;
+}
+
+void rkci::ExportInterfaceHasher::AddDeclarationToken(const LexToken &token)
+{
+	if (IsPunctuation(token, '{') && m_bracketDepth == 0 && m_hasParameterList)
+	{
+		// The opening brace is hashed so that giving a prototype a body changes the interface, but the
+		// body itself isn't part of it
+		HashToken(token);
+		m_state = State::kFunctionBody;
+		m_bracketDepth = 1;
+		return;
+	}
+
+	HashToken(token);
+
+	if (IsPunctuation(token, '(') || IsPunctuation(token, '[') || IsPunctuation(token, '{'))
+	{
+		if (m_bracketDepth == 0 && IsPunctuation(token, '('))
+			m_hasParameterList = true;
+
+		m_bracketDepth++;
+	}
+	else if (IsPunctuation(token, ')') || IsPunctuation(token, ']') || IsPunctuation(token, '}'))
+	{
+		if (m_bracketDepth > 0)
+			m_bracketDepth--;
+
+		// A braced type body ends the declaration
+		if (m_bracketDepth == 0 && IsPunctuation(token, '}'))
+			m_state = State::kStartOfStatement;
+	}
+	else if (m_bracketDepth == 0 && IsPunctuation(token, ';'))
+		m_state = State::kStartOfStatement;
+}
+
+bool rkci::ExportInterfaceHasher::IsExportKeyword(const LexToken &token)
+{
+	return IsName(token, "export") || IsName(token, "globalexport");
+}
+
+bool rkci::ExportInterfaceHasher::IsName(const LexToken &token, const char *name)
+{
+	if (token.m_tokenType != LexTokenType::kName)
+		return false;
+
+	const ArraySliceView<const uint8_t> chars = token.m_charBuffer.Slice();
+	const size_t numChars = chars.Count();
+
+	return numChars == strlen(name) && !memcmp(&chars[0], name, numChars);
+}
+
+bool rkci::ExportInterfaceHasher::IsPunctuation(const LexToken &token, char c)
+{
+	if (token.m_tokenType != LexTokenType::kPunctuation)
+		return false;
+
+	const ArraySliceView<const uint8_t> chars = token.m_charBuffer.Slice();
+	return chars.Count() == 1 && chars[0] == static_cast<uint8_t>(c);
+}
+
+void rkci::ExportInterfaceHasher::HashToken(const LexToken &token)
+{
+	// The type and length are hashed along with the characters so that token boundaries affect the hash.
+	// Line breaks are hashed by type alone, so converting line endings doesn't change the hash.
+	const ArraySliceView<const uint8_t> chars = token.m_charBuffer.Slice();
+
+	const bool isLineBreak = (token.m_tokenType == LexTokenType::kEndOfLine || token.m_tokenType == LexTokenType::kEndOfFile);
+	const size_t numChars = isLineBreak ? 0 : chars.Count();
+
+	uint8_t header[5];
+	header[0] = static_cast<uint8_t>(token.m_tokenType);
+	for (int i = 0; i < 4; i++)
+		header[i + 1] = static_cast<uint8_t>(numChars >> (i * 8));
+
+	m_hash = HashUtil::ComputeStableHash64(header, sizeof(header), m_hash);
+	if (numChars > 0)
+		m_hash = HashUtil::ComputeStableHash64(&chars[0], numChars, m_hash);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreDefs.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct LexToken;
+
+	// Computes a hash of a module's exported interface from its token stream.  A declaration that starts
+	// with "export" or "globalexport" is hashed up to its terminator, which is a ";" outside of brackets,
+	// the end of a braced type body, or the end of its last line.  Later lines continue the declaration
+	// if they start with "where" or "{".  Function bodies, recognized as braces that follow a parameter
+	// list, are skipped.  Edits to function bodies, local declarations, comments or whitespace leave the
+	// hash unchanged, so importers don't need to be recompiled.
+	class ExportInterfaceHasher
+	{
+	public:
+		ExportInterfaceHasher();
+
+		void AddToken(const LexToken &token);
+
+		uint64_t GetHash() const;
+
+	private:
+		enum class State
+		{
+			kStartOfStatement,
+			kNotExported,
+			kDeclaration,
+
+			// After the end of a line of a declaration with no open brackets
+			kDeclarationLineEnd,
+
+			kFunctionBody,
+		};
+
+		static bool IsExportKeyword(const LexToken &token);
+		static bool IsName(const LexToken &token, const char *name);
+		static bool IsPunctuation(const LexToken &token, char c);
+
+		void AddDeclarationToken(const LexToken &token);
+		void HashToken(const LexToken &token);
+
+		State m_state;
+		size_t m_bracketDepth;
+		bool m_hasParameterList;
+		uint64_t m_hash;
+	};
+}
@@ -0,0 +1,98 @@
+#include "FeedStream.h"
+#include "ArraySliceView.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+#include <string.h>
+
+rkci::FeedStream::FeedStream(IAllocator *alloc)
+	: m_bytes(alloc)
+	, m_alloc(alloc)
+	, m_basePos(0)
+	, m_discardPos(0)
+	, m_readPos(0)
+{
+}
+
+rkci::Result rkci::FeedStream::Append(const ArraySliceView<const uint8_t> &bytes)
+{
+	AllocatorTagScope tagScope(*m_alloc, rkc::AllocatorTags::kLexer);
+
+	// Compacting here instead of in DiscardBefore keeps discarding after every token cheap
+	const size_t numDiscarded = static_cast<size_t>(m_discardPos - m_basePos);
+	if (numDiscarded > 0)
+	{
+		const size_t numKept = m_bytes.Count() - numDiscarded;
+		if (numKept > 0)
+			memmove(&m_bytes[0], &m_bytes[numDiscarded], numKept);
+
+		RKC_CHECK(m_bytes.Resize(numKept));
+		m_basePos = m_discardPos;
+	}
+
+	return m_bytes.AppendRange(bytes);
+}
+
+void rkci::FeedStream::DiscardBefore(rkcUFilePos_t pos)
+{
+	RKC_ASSERT(pos >= m_discardPos && pos <= m_basePos + m_bytes.Count());
+	m_discardPos = pos;
+}
+
+size_t rkci::FeedStream::Read(void *buf, size_t size)
+{
+	const size_t available = static_cast<size_t>(m_basePos + m_bytes.Count() - m_readPos);
+	if (size > available)
+		size = available;
+
+	if (size > 0)
+	{
+		memcpy(buf, &m_bytes[static_cast<size_t>(m_readPos - m_basePos)], size);
+		m_readPos += size;
+	}
+
+	return size;
+}
+
+size_t rkci::FeedStream::Write(void *, size_t)
+{
+	return 0;
+}
+
+rkcUFilePos_t rkci::FeedStream::Tell() const
+{
+	return m_readPos;
+}
+
+bool rkci::FeedStream::SeekStart(rkcUFilePos_t pos)
+{
+	if (pos < m_discardPos || pos > m_basePos + m_bytes.Count())
+		return false;
+
+	m_readPos = pos;
+	return true;
+}
+
+bool rkci::FeedStream::SeekEnd(rkcFilePos_t pos)
+{
+	return SeekStart(static_cast<rkcUFilePos_t>(m_basePos + m_bytes.Count() + pos));
+}
+
+bool rkci::FeedStream::SeekCurrent(rkcFilePos_t pos)
+{
+	return SeekStart(static_cast<rkcUFilePos_t>(m_readPos + pos));
+}
+
+bool rkci::FeedStream::IsReadable() const
+{
+	return true;
+}
+
+bool rkci::FeedStream::IsWritable() const
+{
+	return false;
+}
+
+void rkci::FeedStream::Close()
+{
+}
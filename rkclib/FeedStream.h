@@ -0,0 +1,43 @@
+#pragma once
+
+#include "IStream.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	template<class T> class ArraySliceView;
+	class Result;
+
+	// Read-only stream over bytes pushed by the host as they arrive.  Reading past the bytes received
+	// so far returns nothing instead of blocking.  Bytes before the discard position are released once
+	// more bytes are appended, so only the unconsumed tail of the input is kept in memory.
+	class FeedStream final : public IStream
+	{
+	public:
+		explicit FeedStream(IAllocator *alloc);
+
+		Result Append(const ArraySliceView<const uint8_t> &bytes);
+
+		// Allows bytes before pos to be released.  Seeking before pos is no longer possible afterwards.
+		void DiscardBefore(rkcUFilePos_t pos);
+
+		size_t Read(void *buf, size_t size) override;
+		size_t Write(void *buf, size_t size) override;
+		rkcUFilePos_t Tell() const override;
+		bool SeekStart(rkcUFilePos_t pos) override;
+		bool SeekEnd(rkcFilePos_t pos) override;
+		bool SeekCurrent(rkcFilePos_t pos) override;
+		bool IsReadable() const override;
+		bool IsWritable() const override;
+		void Close() override;
+
+	private:
+		Vector<uint8_t> m_bytes;
+		IAllocator *m_alloc;
+
+		// Stream position of m_bytes[0]
+		rkcUFilePos_t m_basePos;
+		rkcUFilePos_t m_discardPos;
+		rkcUFilePos_t m_readPos;
+	};
+}
@@ -7,8 +7,9 @@ namespace rkci
 	class FloatSpec
 	{
 	public:
-		FloatSpec(uint16_t numExponentBits, uint16_t numMantissaBits, int16_t exponentOfOne, bool supportDenormals, bool supportNans);
+		FloatSpec(bool isSigned, uint16_t numExponentBits, uint16_t numMantissaBits, int16_t exponentOfOne, bool supportDenormals, bool supportNans);
 
+		bool IsSigned() const;
 		uint16_t GetExponentBits() const;
 		uint16_t GetMantissaBits() const;
 		int16_t GetExponentOfOne() const;
@@ -16,6 +17,7 @@ namespace rkci
 		bool SupportsNans() const;
 
 	private:
+		bool m_isSigned;
 		uint16_t m_numExponentBits;
 		uint16_t m_numMantissaBits;
 		int16_t m_exponentOfOne;
@@ -24,8 +26,9 @@ namespace rkci
 	};
 }
 
-inline rkci::FloatSpec::FloatSpec(uint16_t numExponentBits, uint16_t numMantissaBits, int16_t exponentOfOne, bool supportDenormals, bool supportsNans)
-	: m_numExponentBits(numExponentBits)
+inline rkci::FloatSpec::FloatSpec(bool isSigned, uint16_t numExponentBits, uint16_t numMantissaBits, int16_t exponentOfOne, bool supportDenormals, bool supportsNans)
+	: m_isSigned(isSigned)
+	, m_numExponentBits(numExponentBits)
 	, m_numMantissaBits(numMantissaBits)
 	, m_exponentOfOne(exponentOfOne)
 	, m_supportDenormals(supportDenormals)
@@ -33,6 +36,11 @@ inline rkci::FloatSpec::FloatSpec(uint16_t numExponentBits, uint16_t numMantissa
 {
 }
 
+inline bool rkci::FloatSpec::IsSigned() const
+{
+	return m_isSigned;
+}
+
 inline uint16_t rkci::FloatSpec::GetExponentBits() const
 {
 	return m_numExponentBits;
@@ -56,5 +64,5 @@ inline bool rkci::FloatSpec::SupportsDenormals() const
 
 inline bool rkci::FloatSpec::SupportsNans() const
 {
-	return m_supportDenormals;
+	return m_supportNans;
 }
@@ -163,6 +163,7 @@ namespace rkci
 #include "Hasher.h"
 #include "Comparer.h"
 #include "Cloner.h"
+#include "IAllocator.h"
 #include <new>
 
 
@@ -502,6 +503,8 @@ rkci::HashMapIterator<TKey, TValue> rkci::HashMap<TKey, TValue>::end()
 template<class TKey, class TValue>
 rkci::Result rkci::HashMap<TKey, TValue>::Rehash(size_t size)
 {
+	AllocatorTagScope tagScope(m_alloc, rkc::AllocatorTags::kHashMap);
+
 	const size_t keysPos = 0;
 	size_t valuesPos = keysPos + sizeof(TKey) * size;
 	valuesPos += alignof(TValue) - 1;
@@ -0,0 +1,33 @@
+#include "Hasher.h"
+
+#include <stdint.h>
+
+rkci::Hash_t rkci::HashUtil::ComputePODHash(const void *data, size_t size)
+{
+	// 32-bit FNV-1a
+	const uint8_t *bytes = static_cast<const uint8_t*>(data);
+
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return static_cast<Hash_t>(hash);
+}
+
+uint64_t rkci::HashUtil::ComputeStableHash64(const void *data, size_t size, uint64_t previousHash)
+{
+	// 64-bit FNV-1a
+	const uint8_t *bytes = static_cast<const uint8_t*>(data);
+
+	uint64_t hash = previousHash;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
@@ -7,6 +7,11 @@ namespace rkci
 	namespace HashUtil
 	{
 		Hash_t ComputePODHash(const void *data, size_t size);
+
+		// 64-bit hash that is identical across runs, platforms and compiler versions, for hashes that
+		// are persisted or compared between compiles.  Chain calls by passing the previous result.
+		static const uint64_t kStableHash64Seed = 14695981039346656037ull;
+		uint64_t ComputeStableHash64(const void *data, size_t size, uint64_t previousHash);
 	}
 
 	template<class T>
@@ -0,0 +1,60 @@
+#include "HashingStream.h"
+#include "Hasher.h"
+
+rkci::HashingStream::HashingStream(IStream &baseStream)
+	: m_baseStream(baseStream)
+	, m_hash(HashUtil::kStableHash64Seed)
+{
+}
+
+size_t rkci::HashingStream::Read(void *buf, size_t size)
+{
+	const size_t numRead = m_baseStream.Read(buf, size);
+	m_hash = HashUtil::ComputeStableHash64(buf, numRead, m_hash);
+	return numRead;
+}
+
+size_t rkci::HashingStream::Write(void *, size_t)
+{
+	return 0;
+}
+
+rkcUFilePos_t rkci::HashingStream::Tell() const
+{
+	return m_baseStream.Tell();
+}
+
+// Seeking would make the hash depend on the read order, so it isn't supported
+bool rkci::HashingStream::SeekStart(rkcUFilePos_t)
+{
+	return false;
+}
+
+bool rkci::HashingStream::SeekEnd(rkcFilePos_t)
+{
+	return false;
+}
+
+bool rkci::HashingStream::SeekCurrent(rkcFilePos_t)
+{
+	return false;
+}
+
+bool rkci::HashingStream::IsReadable() const
+{
+	return m_baseStream.IsReadable();
+}
+
+bool rkci::HashingStream::IsWritable() const
+{
+	return false;
+}
+
+void rkci::HashingStream::Close()
+{
+}
+
+uint64_t rkci::HashingStream::GetHash() const
+{
+	return m_hash;
+}
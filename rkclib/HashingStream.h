@@ -0,0 +1,29 @@
+#pragma once
+
+#include "IStream.h"
+
+namespace rkci
+{
+	// Read-only stream that forwards to another stream and hashes every byte read through it
+	class HashingStream final : public IStream
+	{
+	public:
+		explicit HashingStream(IStream &baseStream);
+
+		size_t Read(void *buf, size_t size) override;
+		size_t Write(void *buf, size_t size) override;
+		rkcUFilePos_t Tell() const override;
+		bool SeekStart(rkcUFilePos_t pos) override;
+		bool SeekEnd(rkcFilePos_t pos) override;
+		bool SeekCurrent(rkcFilePos_t pos) override;
+		bool IsReadable() const override;
+		bool IsWritable() const override;
+		void Close() override;
+
+		uint64_t GetHash() const;
+
+	private:
+		IStream &m_baseStream;
+		uint64_t m_hash;
+	};
+}
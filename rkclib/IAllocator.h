@@ -3,13 +3,44 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "AllocatorTag.h"
+
 namespace rkci
 {
 	struct IAllocator
 	{
 		virtual void *Realloc(void *buf, size_t newSize) = 0;
 
+		// Attributes allocations made by the calling thread to a subsystem until the matching PopTag.  Ignored
+		// by untracked allocators.
+		virtual void PushTag(rkc::AllocatorTag_t) {}
+		virtual void PopTag() {}
+
 		inline void *Alloc(size_t size) { return this->Realloc(nullptr, size); }
 		inline void Release(void *ptr) { this->Realloc(ptr, 0); }
 	};
+
+	class AllocatorTagScope
+	{
+	public:
+		AllocatorTagScope(IAllocator &alloc, rkc::AllocatorTag_t tag);
+		~AllocatorTagScope();
+
+	private:
+		AllocatorTagScope(const AllocatorTagScope &other) = delete;
+		AllocatorTagScope &operator=(const AllocatorTagScope &other) = delete;
+
+		IAllocator &m_alloc;
+	};
+}
+
+inline rkci::AllocatorTagScope::AllocatorTagScope(IAllocator &alloc, rkc::AllocatorTag_t tag)
+	: m_alloc(alloc)
+{
+	m_alloc.PushTag(tag);
+}
+
+inline rkci::AllocatorTagScope::~AllocatorTagScope()
+{
+	m_alloc.PopTag();
 }
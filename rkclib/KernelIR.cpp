@@ -0,0 +1,629 @@
+#include "KernelIR.h"
+#include "ArraySliceView.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+rkci::Kernel::Type::Type(TypeKind kind, int64_t minValue, int64_t maxValue, const FloatSpec &floatSpec, TypeIndex_t laneType)
+	: m_kind(kind)
+	, m_minValue(minValue)
+	, m_maxValue(maxValue)
+	, m_floatSpec(floatSpec)
+	, m_laneType(laneType)
+{
+}
+
+rkci::Kernel::Function::Function(IAllocator *alloc)
+	: m_name(alloc)
+	, m_types(alloc)
+	, m_params(alloc)
+	, m_variables(alloc)
+	, m_instructions(alloc)
+{
+}
+
+rkci::Kernel::Function::Function(Function &&other)
+	: m_name(static_cast<Vector<uint8_t>&&>(other.m_name))
+	, m_types(static_cast<Vector<Type>&&>(other.m_types))
+	, m_params(static_cast<Vector<Param>&&>(other.m_params))
+	, m_variables(static_cast<Vector<Variable>&&>(other.m_variables))
+	, m_instructions(static_cast<Vector<Instruction>&&>(other.m_instructions))
+{
+}
+
+rkci::Kernel::Function &rkci::Kernel::Function::operator=(Function &&other)
+{
+	if (this != &other)
+	{
+		m_name = static_cast<Vector<uint8_t>&&>(other.m_name);
+		m_types = static_cast<Vector<Type>&&>(other.m_types);
+		m_params = static_cast<Vector<Param>&&>(other.m_params);
+		m_variables = static_cast<Vector<Variable>&&>(other.m_variables);
+		m_instructions = static_cast<Vector<Instruction>&&>(other.m_instructions);
+	}
+
+	return *this;
+}
+
+rkci::Result rkci::Kernel::Function::SetName(const ArraySliceView<const uint8_t> &name)
+{
+	AllocatorTagScope tagScope(*m_name.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	m_name = Vector<uint8_t>(m_name.GetAllocator());
+	return m_name.AppendRange(name);
+}
+
+rkci::ResultRV<rkci::Kernel::TypeIndex_t> rkci::Kernel::Function::AddIntType(int64_t minValue, int64_t maxValue)
+{
+	if (minValue > maxValue)
+		return rkc::ResultCodes::kInternalError;
+
+	return InternType(Type(TypeKind::kInt, minValue, maxValue, FloatSpec(false, 0, 0, 0, false, false), kInvalidTypeIndex));
+}
+
+rkci::ResultRV<rkci::Kernel::TypeIndex_t> rkci::Kernel::Function::AddFloatType(const FloatSpec &floatSpec)
+{
+	return InternType(Type(TypeKind::kFloat, 0, 0, floatSpec, kInvalidTypeIndex));
+}
+
+rkci::ResultRV<rkci::Kernel::TypeIndex_t> rkci::Kernel::Function::AddMaskType(TypeIndex_t laneType)
+{
+	if (laneType >= m_types.Count() || m_types[laneType].m_kind == TypeKind::kMask)
+		return rkc::ResultCodes::kInternalError;
+
+	return InternType(Type(TypeKind::kMask, 0, 0, FloatSpec(false, 0, 0, 0, false, false), laneType));
+}
+
+rkci::ResultRV<rkci::Kernel::ParamIndex_t> rkci::Kernel::Function::AddParam(ParamKind kind, TypeIndex_t type)
+{
+	if (type >= m_types.Count() || m_types[type].m_kind == TypeKind::kMask)
+		return rkc::ResultCodes::kInternalError;
+
+	const size_t paramIndex = m_params.Count();
+	if (paramIndex >= 0xffffu)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	Param param;
+	param.m_kind = kind;
+	param.m_type = type;
+
+	AllocatorTagScope tagScope(*m_params.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	RKC_CHECK(m_params.Append(param));
+
+	return static_cast<ParamIndex_t>(paramIndex);
+}
+
+rkci::ResultRV<rkci::Kernel::VariableIndex_t> rkci::Kernel::Function::AddVariable(TypeIndex_t type)
+{
+	if (type >= m_types.Count())
+		return rkc::ResultCodes::kInternalError;
+
+	const size_t variableIndex = m_variables.Count();
+	if (variableIndex >= 0xffffffffu)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	Variable variable;
+	variable.m_type = type;
+
+	AllocatorTagScope tagScope(*m_variables.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	RKC_CHECK(m_variables.Append(variable));
+
+	return static_cast<VariableIndex_t>(variableIndex);
+}
+
+rkci::ResultRV<rkci::Kernel::ValueIndex_t> rkci::Kernel::Function::AddInstruction(Opcode opcode, TypeIndex_t type, ValueIndex_t operand0, ValueIndex_t operand1, ValueIndex_t operand2, uint64_t immediate)
+{
+	const size_t valueIndex = m_instructions.Count();
+	if (valueIndex >= kInvalidValueIndex)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	Instruction instr;
+	instr.m_opcode = opcode;
+	instr.m_type = type;
+	instr.m_operands[0] = operand0;
+	instr.m_operands[1] = operand1;
+	instr.m_operands[2] = operand2;
+	instr.m_immediate = immediate;
+
+	AllocatorTagScope tagScope(*m_instructions.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	RKC_CHECK(m_instructions.Append(instr));
+
+	return static_cast<ValueIndex_t>(valueIndex);
+}
+
+rkci::Result rkci::Kernel::Function::CopyDeclarations(const Function &other)
+{
+	if (m_types.Count() != 0 || m_params.Count() != 0 || m_variables.Count() != 0 || m_instructions.Count() != 0)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	RKC_CHECK(SetName(other.GetName()));
+
+	AllocatorTagScope tagScope(*m_types.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	// The other function's types are already interned, so they can be copied as they are
+	RKC_CHECK(m_types.AppendRange(other.m_types.Slice()));
+	RKC_CHECK(m_params.AppendRange(other.m_params.Slice()));
+	RKC_CHECK(m_variables.AppendRange(other.m_variables.Slice()));
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::Kernel::Function::Validate() const
+{
+	const size_t numInstructions = m_instructions.Count();
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		RKC_CHECK(ValidateInstruction(static_cast<ValueIndex_t>(i)));
+	}
+
+	return ValidateRegions();
+}
+
+rkci::ArraySliceView<const uint8_t> rkci::Kernel::Function::GetName() const
+{
+	return m_name.Slice();
+}
+
+size_t rkci::Kernel::Function::NumTypes() const
+{
+	return m_types.Count();
+}
+
+const rkci::Kernel::Type &rkci::Kernel::Function::GetType(TypeIndex_t index) const
+{
+	return m_types[index];
+}
+
+size_t rkci::Kernel::Function::NumParams() const
+{
+	return m_params.Count();
+}
+
+const rkci::Kernel::Param &rkci::Kernel::Function::GetParam(ParamIndex_t index) const
+{
+	return m_params[index];
+}
+
+size_t rkci::Kernel::Function::NumVariables() const
+{
+	return m_variables.Count();
+}
+
+const rkci::Kernel::Variable &rkci::Kernel::Function::GetVariable(VariableIndex_t index) const
+{
+	return m_variables[index];
+}
+
+size_t rkci::Kernel::Function::NumInstructions() const
+{
+	return m_instructions.Count();
+}
+
+const rkci::Kernel::Instruction &rkci::Kernel::Function::GetInstruction(ValueIndex_t index) const
+{
+	return m_instructions[index];
+}
+
+rkci::IAllocator *rkci::Kernel::Function::GetAllocator() const
+{
+	return m_instructions.GetAllocator();
+}
+
+size_t rkci::Kernel::Function::GetNumOperands(Opcode opcode)
+{
+	switch (opcode)
+	{
+	case Opcode::kConstant:
+	case Opcode::kParam:
+	case Opcode::kLaneIndex:
+	case Opcode::kReadVar:
+	case Opcode::kElse:
+	case Opcode::kEndIf:
+	case Opcode::kLoop:
+	case Opcode::kEndLoop:
+	case Opcode::kBreakable:
+	case Opcode::kEndBreakable:
+	case Opcode::kBreak:
+	case Opcode::kEndMasked:
+		return 0;
+
+	case Opcode::kLoad:
+	case Opcode::kConvert:
+	case Opcode::kNot:
+	case Opcode::kWriteVar:
+	case Opcode::kIf:
+	case Opcode::kBeginMasked:
+	case Opcode::kBreakIfNone:
+		return 1;
+
+	case Opcode::kSelect:
+		return 3;
+
+	default:
+		return 2;
+	}
+}
+
+bool rkci::Kernel::Function::IsComparison(Opcode opcode)
+{
+	switch (opcode)
+	{
+	case Opcode::kCmpEq:
+	case Opcode::kCmpNe:
+	case Opcode::kCmpLt:
+	case Opcode::kCmpLe:
+	case Opcode::kCmpGt:
+	case Opcode::kCmpGe:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool rkci::Kernel::Function::DefinesValue(Opcode opcode)
+{
+	switch (opcode)
+	{
+	case Opcode::kStore:
+	case Opcode::kWriteVar:
+	case Opcode::kIf:
+	case Opcode::kElse:
+	case Opcode::kEndIf:
+	case Opcode::kLoop:
+	case Opcode::kEndLoop:
+	case Opcode::kBreakable:
+	case Opcode::kEndBreakable:
+	case Opcode::kBreak:
+	case Opcode::kBeginMasked:
+	case Opcode::kEndMasked:
+	case Opcode::kBreakIfNone:
+		return false;
+
+	default:
+		return true;
+	}
+}
+
+rkci::ResultRV<rkci::Kernel::TypeIndex_t> rkci::Kernel::Function::InternType(const Type &type)
+{
+	const size_t numTypes = m_types.Count();
+	for (size_t i = 0; i < numTypes; i++)
+	{
+		if (TypesEqual(m_types[i], type))
+			return static_cast<TypeIndex_t>(i);
+	}
+
+	if (numTypes >= kInvalidTypeIndex)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	AllocatorTagScope tagScope(*m_types.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	RKC_CHECK(m_types.Append(type));
+
+	return static_cast<TypeIndex_t>(numTypes);
+}
+
+bool rkci::Kernel::Function::TypesEqual(const Type &a, const Type &b)
+{
+	if (a.m_kind != b.m_kind)
+		return false;
+
+	switch (a.m_kind)
+	{
+	case TypeKind::kInt:
+		return a.m_minValue == b.m_minValue && a.m_maxValue == b.m_maxValue;
+
+	case TypeKind::kFloat:
+		return a.m_floatSpec.IsSigned() == b.m_floatSpec.IsSigned()
+			&& a.m_floatSpec.GetExponentBits() == b.m_floatSpec.GetExponentBits()
+			&& a.m_floatSpec.GetMantissaBits() == b.m_floatSpec.GetMantissaBits()
+			&& a.m_floatSpec.GetExponentOfOne() == b.m_floatSpec.GetExponentOfOne()
+			&& a.m_floatSpec.SupportsDenormals() == b.m_floatSpec.SupportsDenormals()
+			&& a.m_floatSpec.SupportsNans() == b.m_floatSpec.SupportsNans();
+
+	case TypeKind::kMask:
+		return a.m_laneType == b.m_laneType;
+
+	default:
+		return false;
+	}
+}
+
+bool rkci::Kernel::Function::IsValueOfKind(ValueIndex_t value, ValueIndex_t user, TypeKind kind) const
+{
+	if (value >= user)
+		return false;
+
+	const TypeIndex_t type = m_instructions[value].m_type;
+	return type != kInvalidTypeIndex && m_types[type].m_kind == kind;
+}
+
+bool rkci::Kernel::Function::IsValueOfType(ValueIndex_t value, ValueIndex_t user, TypeIndex_t type) const
+{
+	return value < user && m_instructions[value].m_type == type;
+}
+
+rkci::Result rkci::Kernel::Function::ValidateInstruction(ValueIndex_t index) const
+{
+	const Instruction &instr = m_instructions[index];
+	const size_t numOperands = GetNumOperands(instr.m_opcode);
+
+	for (size_t i = numOperands; i < 3; i++)
+	{
+		if (instr.m_operands[i] != kInvalidValueIndex)
+			return rkc::ResultCodes::kInternalError;
+	}
+
+	for (size_t i = 0; i < numOperands; i++)
+	{
+		const ValueIndex_t operand = instr.m_operands[i];
+		if (operand >= index || m_instructions[operand].m_type == kInvalidTypeIndex)
+			return rkc::ResultCodes::kInternalError;
+	}
+
+	if (!DefinesValue(instr.m_opcode))
+	{
+		if (instr.m_type != kInvalidTypeIndex)
+			return rkc::ResultCodes::kInternalError;
+	}
+	else if (instr.m_type >= m_types.Count())
+		return rkc::ResultCodes::kInternalError;
+
+	const ValueIndex_t operand0 = instr.m_operands[0];
+	const ValueIndex_t operand1 = instr.m_operands[1];
+	const ValueIndex_t operand2 = instr.m_operands[2];
+
+	bool isValid = false;
+	switch (instr.m_opcode)
+	{
+	case Opcode::kConstant:
+		{
+			const Type &type = m_types[instr.m_type];
+			if (type.m_kind == TypeKind::kInt)
+			{
+				const int64_t value = static_cast<int64_t>(instr.m_immediate);
+				isValid = (value >= type.m_minValue && value <= type.m_maxValue);
+			}
+			else if (type.m_kind == TypeKind::kMask)
+				isValid = (instr.m_immediate <= 1u);	// All lanes clear or all lanes set
+			else
+				isValid = true;
+		}
+		break;
+
+	case Opcode::kParam:
+		isValid = (instr.m_immediate < m_params.Count()
+			&& m_params[static_cast<size_t>(instr.m_immediate)].m_kind == ParamKind::kUniform
+			&& m_params[static_cast<size_t>(instr.m_immediate)].m_type == instr.m_type);
+		break;
+
+	case Opcode::kLaneIndex:
+		isValid = (m_types[instr.m_type].m_kind == TypeKind::kInt);
+		break;
+
+	case Opcode::kLoad:
+		isValid = (IsValueOfKind(operand0, index, TypeKind::kInt)
+			&& instr.m_immediate < m_params.Count()
+			&& m_params[static_cast<size_t>(instr.m_immediate)].m_kind == ParamKind::kInputBuffer
+			&& m_params[static_cast<size_t>(instr.m_immediate)].m_type == instr.m_type);
+		break;
+
+	case Opcode::kStore:
+		isValid = (IsValueOfKind(operand0, index, TypeKind::kInt)
+			&& instr.m_immediate < m_params.Count()
+			&& m_params[static_cast<size_t>(instr.m_immediate)].m_kind == ParamKind::kOutputBuffer
+			&& IsValueOfType(operand1, index, m_params[static_cast<size_t>(instr.m_immediate)].m_type));
+		break;
+
+	case Opcode::kConvert:
+		{
+			const TypeKind fromKind = m_types[m_instructions[operand0].m_type].m_kind;
+			const TypeKind toKind = m_types[instr.m_type].m_kind;
+			isValid = ((fromKind == TypeKind::kMask) == (toKind == TypeKind::kMask));
+		}
+		break;
+
+	case Opcode::kAdd:
+	case Opcode::kSub:
+	case Opcode::kMul:
+	case Opcode::kMin:
+	case Opcode::kMax:
+		isValid = (m_types[instr.m_type].m_kind != TypeKind::kMask
+			&& IsValueOfType(operand0, index, instr.m_type)
+			&& IsValueOfType(operand1, index, instr.m_type));
+		break;
+
+	case Opcode::kAnd:
+	case Opcode::kOr:
+	case Opcode::kXor:
+		isValid = (m_types[instr.m_type].m_kind != TypeKind::kFloat
+			&& IsValueOfType(operand0, index, instr.m_type)
+			&& IsValueOfType(operand1, index, instr.m_type));
+		break;
+
+	case Opcode::kNot:
+		isValid = (m_types[instr.m_type].m_kind != TypeKind::kFloat
+			&& IsValueOfType(operand0, index, instr.m_type));
+		break;
+
+	case Opcode::kCmpEq:
+	case Opcode::kCmpNe:
+	case Opcode::kCmpLt:
+	case Opcode::kCmpLe:
+	case Opcode::kCmpGt:
+	case Opcode::kCmpGe:
+		{
+			const Type &type = m_types[instr.m_type];
+			isValid = (type.m_kind == TypeKind::kMask
+				&& m_types[type.m_laneType].m_kind != TypeKind::kMask
+				&& IsValueOfType(operand0, index, type.m_laneType)
+				&& IsValueOfType(operand1, index, type.m_laneType));
+		}
+		break;
+
+	case Opcode::kSelect:
+		isValid = (m_types[instr.m_type].m_kind != TypeKind::kMask
+			&& IsValueOfKind(operand0, index, TypeKind::kMask)
+			&& IsValueOfType(operand1, index, instr.m_type)
+			&& IsValueOfType(operand2, index, instr.m_type));
+		break;
+
+	case Opcode::kReadVar:
+		isValid = (instr.m_immediate < m_variables.Count()
+			&& m_variables[static_cast<size_t>(instr.m_immediate)].m_type == instr.m_type);
+		break;
+
+	case Opcode::kWriteVar:
+		isValid = (instr.m_immediate < m_variables.Count()
+			&& IsValueOfType(operand0, index, m_variables[static_cast<size_t>(instr.m_immediate)].m_type));
+		break;
+
+	case Opcode::kIf:
+	case Opcode::kBeginMasked:
+	case Opcode::kBreakIfNone:
+		isValid = IsValueOfKind(operand0, index, TypeKind::kMask);
+		break;
+
+	case Opcode::kElse:
+	case Opcode::kEndIf:
+	case Opcode::kLoop:
+	case Opcode::kEndLoop:
+	case Opcode::kBreakable:
+	case Opcode::kEndBreakable:
+	case Opcode::kBreak:
+	case Opcode::kEndMasked:
+		// Checked by ValidateRegions
+		isValid = true;
+		break;
+
+	default:
+		break;
+	}
+
+	if (!isValid)
+		return rkc::ResultCodes::kInternalError;
+
+	return Result::Ok();
+}
+
+// Regions open at kIf, kElse, kLoop, kBreakable and kBeginMasked and close at the matching end, with
+// kElse closing the kIf region.  A value is visible while the region that defined it is open.
+rkci::Result rkci::Kernel::Function::ValidateRegions() const
+{
+	const size_t numInstructions = m_instructions.Count();
+
+	Vector<ValueIndex_t> regionStack(m_instructions.GetAllocator());
+	Vector<ValueIndex_t> definingRegion(m_instructions.GetAllocator());
+	Vector<uint8_t> isRegionOpen(m_instructions.GetAllocator());
+
+	{
+		AllocatorTagScope tagScope(*m_instructions.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(definingRegion.Resize(numInstructions));
+		RKC_CHECK(isRegionOpen.Resize(numInstructions));
+	}
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Instruction &instr = m_instructions[i];
+		const size_t numOperands = GetNumOperands(instr.m_opcode);
+		const size_t stackSize = regionStack.Count();
+		const ValueIndex_t currentRegion = (stackSize > 0) ? regionStack[stackSize - 1] : kInvalidValueIndex;
+
+		for (size_t operandIndex = 0; operandIndex < numOperands; operandIndex++)
+		{
+			const ValueIndex_t operandRegion = definingRegion[instr.m_operands[operandIndex]];
+			if (operandRegion != kInvalidValueIndex && !isRegionOpen[operandRegion])
+				return rkc::ResultCodes::kInternalError;
+		}
+
+		definingRegion[i] = currentRegion;
+
+		Opcode openingOpcode = Opcode::kConstant;
+		bool isOpening = false;
+
+		switch (instr.m_opcode)
+		{
+		case Opcode::kIf:
+		case Opcode::kLoop:
+		case Opcode::kBreakable:
+		case Opcode::kBeginMasked:
+			isOpening = true;
+			break;
+
+		case Opcode::kElse:
+			openingOpcode = Opcode::kIf;
+			isOpening = true;
+			break;
+		case Opcode::kEndIf:
+			openingOpcode = Opcode::kIf;
+			break;
+		case Opcode::kEndLoop:
+			openingOpcode = Opcode::kLoop;
+			break;
+		case Opcode::kEndBreakable:
+			openingOpcode = Opcode::kBreakable;
+			break;
+		case Opcode::kEndMasked:
+			openingOpcode = Opcode::kBeginMasked;
+			break;
+
+		case Opcode::kBreak:
+			if (instr.m_immediate >= i
+				|| m_instructions[static_cast<size_t>(instr.m_immediate)].m_opcode != Opcode::kBreakable
+				|| !isRegionOpen[static_cast<size_t>(instr.m_immediate)])
+				return rkc::ResultCodes::kInternalError;
+			continue;
+
+		case Opcode::kBreakIfNone:
+			{
+				bool isInLoop = false;
+				for (size_t stackIndex = 0; stackIndex < stackSize; stackIndex++)
+				{
+					if (m_instructions[regionStack[stackIndex]].m_opcode == Opcode::kLoop)
+						isInLoop = true;
+				}
+
+				if (!isInLoop)
+					return rkc::ResultCodes::kInternalError;
+			}
+			continue;
+
+		default:
+			continue;
+		}
+
+		if (openingOpcode != Opcode::kConstant)
+		{
+			if (stackSize == 0)
+				return rkc::ResultCodes::kInternalError;
+
+			// An else closes its if, and the if's end closes either of them
+			const Opcode currentOpcode = m_instructions[currentRegion].m_opcode;
+			const bool isMatch = (currentOpcode == openingOpcode)
+				|| (instr.m_opcode == Opcode::kEndIf && currentOpcode == Opcode::kElse);
+
+			if (!isMatch)
+				return rkc::ResultCodes::kInternalError;
+
+			isRegionOpen[currentRegion] = 0;
+			RKC_CHECK(regionStack.Resize(stackSize - 1));
+		}
+
+		if (isOpening)
+		{
+			AllocatorTagScope tagScope(*m_instructions.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+			RKC_CHECK(regionStack.Append(static_cast<ValueIndex_t>(i)));
+			isRegionOpen[i] = 1;
+		}
+	}
+
+	if (regionStack.Count() != 0)
+		return rkc::ResultCodes::kInternalError;
+
+	return Result::Ok();
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "FloatSpec.h"
+#include "Vector.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	template<class T> class ArraySliceView;
+	template<class T> class ResultRV;
+	class Result;
+
+	// Kernel IR: the SPMD form that the SIMD backends consume.  A kernel function runs once per element
+	// of its iteration space, and the backend maps consecutive elements onto the lanes of vector
+	// registers.
+	namespace Kernel
+	{
+		typedef uint16_t TypeIndex_t;
+		typedef uint16_t ParamIndex_t;
+		typedef uint32_t ValueIndex_t;
+		typedef uint32_t VariableIndex_t;
+
+		static const TypeIndex_t kInvalidTypeIndex = 0xffffu;
+		static const ValueIndex_t kInvalidValueIndex = 0xffffffffu;
+
+		enum class TypeKind : uint8_t
+		{
+			kInt,
+			kFloat,
+			kMask,
+		};
+
+		// Integer types carry their intspec range and float types their floatspec, and the backend picks
+		// the storage format.  A mask has one bit of state per lane of its lane type.
+		struct Type
+		{
+			Type(TypeKind kind, int64_t minValue, int64_t maxValue, const FloatSpec &floatSpec, TypeIndex_t laneType);
+
+			TypeKind m_kind;
+			int64_t m_minValue;
+			int64_t m_maxValue;
+			FloatSpec m_floatSpec;
+			TypeIndex_t m_laneType;
+		};
+
+		enum class ParamKind : uint8_t
+		{
+			kUniform,
+			kInputBuffer,
+			kOutputBuffer,
+		};
+
+		struct Param
+		{
+			ParamKind m_kind;
+			TypeIndex_t m_type;
+		};
+
+		enum class Opcode : uint8_t
+		{
+			kConstant,		// m_immediate: value, or for floats the bits of the storage format
+			kParam,			// m_immediate: uniform parameter index
+			kLaneIndex,		// Index of the element that the lane is processing
+
+			kLoad,			// (index), m_immediate: input buffer parameter index.  Reads zero outside of the buffer.
+			kStore,			// (index, value), m_immediate: output buffer parameter index.  Does nothing outside of the buffer.
+
+			kConvert,		// (value)
+
+			kAdd,			// (a, b)
+			kSub,			// (a, b)
+			kMul,			// (a, b)
+			kMin,			// (a, b)
+			kMax,			// (a, b)
+
+			kAnd,			// (a, b), integers and masks
+			kOr,			// (a, b), integers and masks
+			kXor,			// (a, b), integers and masks
+			kNot,			// (a), integers and masks
+
+			kCmpEq,			// (a, b)
+			kCmpNe,			// (a, b)
+			kCmpLt,			// (a, b)
+			kCmpLe,			// (a, b)
+			kCmpGt,			// (a, b)
+			kCmpGe,			// (a, b)
+
+			kSelect,		// (mask, valueIfSet, valueIfClear)
+
+			kReadVar,		// m_immediate: variable index
+			kWriteVar,		// (value), m_immediate: variable index
+
+			// Structured control flow, as produced by the front end.  Lanes are independent, so a varying
+			// condition sends different lanes down different paths.  Every break leaves an enclosing
+			// breakable region, and a loop only ends by breaking out of it.
+			kIf,			// (condition mask)
+			kElse,
+			kEndIf,
+			kLoop,
+			kEndLoop,
+			kBreakable,
+			kEndBreakable,
+			kBreak,			// m_immediate: index of the kBreakable being left
+
+			// Masked control flow, as produced by ConditionMasking.  Stores and variable writes inside a
+			// masked region only affect the lanes that are set in every enclosing region's mask.
+			kBeginMasked,	// (mask)
+			kEndMasked,
+			kBreakIfNone,	// (mask), leaves the innermost loop if no lanes of the mask are set
+		};
+
+		// Instructions are in SSA form and each one defines the value with its own index, so operands
+		// always refer to earlier instructions in the same region or an enclosing one.  Values that flow
+		// across regions go through variables.  Instructions that define no value have an invalid type.
+		struct Instruction
+		{
+			Opcode m_opcode;
+			TypeIndex_t m_type;
+			ValueIndex_t m_operands[3];
+			uint64_t m_immediate;
+		};
+
+		struct Variable
+		{
+			TypeIndex_t m_type;
+		};
+
+		class Function
+		{
+		public:
+			explicit Function(IAllocator *alloc);
+			Function(Function &&other);
+
+			Function &operator=(Function &&other);
+
+			Result SetName(const ArraySliceView<const uint8_t> &name);
+
+			// Types are interned, so equal types always have the same index
+			ResultRV<TypeIndex_t> AddIntType(int64_t minValue, int64_t maxValue);
+			ResultRV<TypeIndex_t> AddFloatType(const FloatSpec &floatSpec);
+			ResultRV<TypeIndex_t> AddMaskType(TypeIndex_t laneType);
+
+			ResultRV<ParamIndex_t> AddParam(ParamKind kind, TypeIndex_t type);
+
+			// Variables start out as zero in every lane
+			ResultRV<VariableIndex_t> AddVariable(TypeIndex_t type);
+
+			ResultRV<ValueIndex_t> AddInstruction(Opcode opcode, TypeIndex_t type, ValueIndex_t operand0, ValueIndex_t operand1, ValueIndex_t operand2, uint64_t immediate);
+
+			// Copies the name, types, params and variables of another function into this one, which must
+			// be empty, so that they keep their indexes.  Passes that rewrite a kernel start with this.
+			Result CopyDeclarations(const Function &other);
+
+			// Checks operand order, operand types and region nesting.  Returns kInternalError for malformed
+			// kernels.
+			Result Validate() const;
+
+			ArraySliceView<const uint8_t> GetName() const;
+
+			size_t NumTypes() const;
+			const Type &GetType(TypeIndex_t index) const;
+
+			size_t NumParams() const;
+			const Param &GetParam(ParamIndex_t index) const;
+
+			size_t NumVariables() const;
+			const Variable &GetVariable(VariableIndex_t index) const;
+
+			size_t NumInstructions() const;
+			const Instruction &GetInstruction(ValueIndex_t index) const;
+
+			IAllocator *GetAllocator() const;
+
+			static size_t GetNumOperands(Opcode opcode);
+			static bool IsComparison(Opcode opcode);
+			static bool DefinesValue(Opcode opcode);
+
+		private:
+			Function(const Function &other) = delete;
+
+			ResultRV<TypeIndex_t> InternType(const Type &type);
+			static bool TypesEqual(const Type &a, const Type &b);
+
+			bool IsValueOfKind(ValueIndex_t value, ValueIndex_t user, TypeKind kind) const;
+			bool IsValueOfType(ValueIndex_t value, ValueIndex_t user, TypeIndex_t type) const;
+			Result ValidateInstruction(ValueIndex_t index) const;
+			Result ValidateRegions() const;
+
+			Vector<uint8_t> m_name;
+			Vector<Type> m_types;
+			Vector<Param> m_params;
+			Vector<Variable> m_variables;
+			Vector<Instruction> m_instructions;
+		};
+	}
+}
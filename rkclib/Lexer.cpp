@@ -3,6 +3,7 @@
 #include "Unicode.h"
 
 #include "ArrayTools.h"
+#include "IAllocator.h"
 #include "Optional.h"
 
 namespace rkci
@@ -34,6 +35,16 @@ namespace rkci
 
 		CharacterCategory CategorizeCharacter(UnicodeChar_t uchar);
 
+		// Token parsers call this when a token is cut off by the end of the input.  If the lexer is only
+		// waiting for more input, the partial token is discarded by GetNextToken instead of failing.
+		Result UnexpectedEndOfInput(Lexer &lexer, rkc::ResultCode_t resultCode)
+		{
+			if (lexer.IsStarved())
+				return Result::Ok();
+
+			return lexer.ReportError(resultCode);
+		}
+
 		Result ConsumeChar(Vector<uint8_t, 4> &chars, UnicodeChar_t uchar, Lexer &lexer)
 		{
 #if RKC_ASSERTS_ENABLED
@@ -44,10 +55,7 @@ namespace rkci
 			StaticArray<uint8_t, rkci::Unicode::Utf8::kMaxEncodedBytes> encoded;
 			size_t charsEmitted = rkci::Unicode::Utf8::Encode(encoded.GetSlice(), uchar);
 
-			for (size_t i = 0; i < charsEmitted; i++)
-			{
-				RKC_CHECK(chars.Append(encoded[i]));
-			}
+			RKC_CHECK(chars.AppendRange(encoded.GetSlice().ToConst().Subrange(0, charsEmitted)));
 
 			lexer.ConsumeChar();
 			return Result::Ok();
@@ -62,7 +70,10 @@ namespace rkci
 				RKC_CHECK_RV(Optional<UnicodeChar_t>, ucharOpt, lexer.PeekChar());
 
 				if (!ucharOpt.IsSet())
+				{
+					lexer.SuspendToken(LexResumePoint::kWhitespace);
 					return Result::Ok();
+				}
 
 				const UnicodeChar_t uchar = ucharOpt.Get();
 
@@ -105,7 +116,10 @@ namespace rkci
 			{
 				RKC_CHECK_RV(Optional<UnicodeChar_t>, nextCharOpt, lexer.PeekChar());
 				if (!nextCharOpt.IsSet())
+				{
+					lexer.SuspendToken(LexResumePoint::kLineComment);
 					return Result::Ok();
+				}
 
 				const UnicodeChar_t nextChar = nextCharOpt.Get();
 
@@ -118,25 +132,28 @@ namespace rkci
 			}
 		}
 
+		// The comment's characters so far are kept when it is suspended, so the character before the
+		// closing slash is looked up in them instead of being tracked
 		Result ParseBlockComment(Lexer &lexer, Vector<uint8_t, 4> &chars, LexTokenType &outTokenType)
 		{
-			bool lastWasAsterisk = false;
-			outTokenType = LexTokenType::kLineComment;
+			outTokenType = LexTokenType::kBlockComment;
 
 			for (;;)
 			{
 				RKC_CHECK_RV(Optional<UnicodeChar_t>, nextCharOpt, lexer.PeekChar());
 
 				if (!nextCharOpt.IsSet())
-					return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+				{
+					lexer.SuspendToken(LexResumePoint::kBlockComment);
+					return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
+				}
 
 				const UnicodeChar_t nextChar = nextCharOpt.Get();
 
 				RKC_CHECK(ConsumeChar(chars, nextChar, lexer));
 
-				if (nextChar == CharCodes::kAsterisk)
-					lastWasAsterisk = true;
-				else if (nextChar == CharCodes::kSlash)
+				// The asterisk of the opening "/*" doesn't close the comment
+				if (nextChar == CharCodes::kSlash && chars.Count() >= 4 && chars[chars.Count() - 2] == CharCodes::kAsterisk)
 					return Result::Ok();
 			}
 		}
@@ -146,10 +163,13 @@ namespace rkci
 			RKC_CHECK_RV(Optional<UnicodeChar_t>, escapeControlOpt, lexer.PeekChar());
 
 			if (!escapeControlOpt.IsSet())
-				return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+				return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 			const UnicodeChar_t escapeControl = escapeControlOpt.Get();
 
+			if (CategorizeCharacter(escapeControl) == CharacterCategory::kEndOfLine)
+				return lexer.ReportError(rkc::ResultCodes::kLexUnexpectedEndOfLine);
+
 			RKC_CHECK(ConsumeChar(chars, escapeControl, lexer));
 
 			size_t numHexDigits = 0;
@@ -177,7 +197,7 @@ namespace rkci
 			case CharCodes::kLowercaseV:
 				return Result::Ok();
 			default:
-				return rkc::ResultCodes::kLexInvalidEscape;
+				return lexer.ReportError(rkc::ResultCodes::kLexInvalidEscape);
 			}
 
 			for (size_t i = 0; i < numHexDigits; i++)
@@ -185,7 +205,7 @@ namespace rkci
 				RKC_CHECK_RV(Optional<UnicodeChar_t>, hexDigitOpt, lexer.PeekChar());
 
 				if (!hexDigitOpt.IsSet())
-					return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+					return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 				const UnicodeChar_t hexDigit = hexDigitOpt.Get();
 
@@ -194,7 +214,7 @@ namespace rkci
 					|| (hexDigit >= CharCodes::kDigit0 && hexDigit <= CharCodes::kDigit9);
 
 				if (!isHexDigit)
-					return rkc::ResultCodes::kLexInvalidEscape;
+					return lexer.ReportError(rkc::ResultCodes::kLexInvalidEscape);
 
 				RKC_CHECK(ConsumeChar(chars, hexDigit, lexer));
 			}
@@ -208,12 +228,16 @@ namespace rkci
 
 			RKC_CHECK_RV(Optional<UnicodeChar_t>, charStartOpt, lexer.PeekChar());
 			if (!charStartOpt.IsSet())
-				return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+				return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 			const UnicodeChar_t charStart = charStartOpt.Get();
 
 			if (charStart == CharCodes::kSingleQuote || charStart == CharCodes::kDoubleQuote)
-				return rkc::ResultCodes::kLexMalformedCharacterLiteral;
+				return lexer.ReportError(rkc::ResultCodes::kLexMalformedCharacterLiteral);
+
+			// Checked before consuming so that the line break stays available to end an error token
+			if (CategorizeCharacter(charStart) == CharacterCategory::kEndOfLine)
+				return lexer.ReportError(rkc::ResultCodes::kLexUnexpectedEndOfLine);
 
 			RKC_CHECK(ConsumeChar(chars, charStart, lexer));
 
@@ -226,9 +250,7 @@ namespace rkci
 				switch (CategorizeCharacter(charStart))
 				{
 				case CharacterCategory::kGarbage:
-					return rkc::ResultCodes::kLexGarbageCharacter;
-				case CharacterCategory::kEndOfLine:
-					return rkc::ResultCodes::kLexUnexpectedEndOfLine;
+					return lexer.ReportError(rkc::ResultCodes::kLexGarbageCharacter);
 				case CharacterCategory::kWhitespace:
 				case CharacterCategory::kPunctuation:
 				case CharacterCategory::kText:
@@ -243,12 +265,12 @@ namespace rkci
 			RKC_CHECK_RV(Optional<UnicodeChar_t>, endQuoteOpt, lexer.PeekChar());
 
 			if (!endQuoteOpt.IsSet())
-				return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+				return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 			if (endQuoteOpt.Get() != CharCodes::kSingleQuote)
-				return rkc::ResultCodes::kLexMalformedCharacterLiteral;
+				return lexer.ReportError(rkc::ResultCodes::kLexMalformedCharacterLiteral);
 
-			RKC_CHECK(ConsumeChar(chars, charStart, lexer));
+			RKC_CHECK(ConsumeChar(chars, endQuoteOpt.Get(), lexer));
 
 			return Result::Ok();
 		}
@@ -262,10 +284,16 @@ namespace rkci
 				RKC_CHECK_RV(Optional<UnicodeChar_t>, charNextOpt, lexer.PeekChar());
 
 				if (!charNextOpt.IsSet())
-					return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+				{
+					lexer.SuspendToken(LexResumePoint::kQuotedString);
+					return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
+				}
 
 				const UnicodeChar_t charNext = charNextOpt.Get();
 
+				if (CategorizeCharacter(charNext) == CharacterCategory::kEndOfLine)
+					return lexer.ReportError(rkc::ResultCodes::kLexUnexpectedEndOfLine);
+
 				RKC_CHECK(ConsumeChar(chars, charNext, lexer));
 
 				if (charNext == CharCodes::kDoubleQuote)
@@ -280,9 +308,7 @@ namespace rkci
 					switch (CategorizeCharacter(charNext))
 					{
 					case CharacterCategory::kGarbage:
-						return rkc::ResultCodes::kLexGarbageCharacter;
-					case CharacterCategory::kEndOfLine:
-						return rkc::ResultCodes::kLexUnexpectedEndOfLine;
+						return lexer.ReportError(rkc::ResultCodes::kLexGarbageCharacter);
 					case CharacterCategory::kWhitespace:
 					case CharacterCategory::kPunctuation:
 					case CharacterCategory::kText:
@@ -409,7 +435,10 @@ namespace rkci
 			{
 				RKC_CHECK_RV(Optional<UnicodeChar_t>, ucharOpt, lexer.PeekChar());
 				if (!ucharOpt.IsSet())
+				{
+					lexer.SuspendToken(LexResumePoint::kName);
 					return Result::Ok();
+				}
 
 				const UnicodeChar_t uchar = ucharOpt.Get();
 				const CharacterCategory category = CategorizeCharacter(uchar);
@@ -417,7 +446,7 @@ namespace rkci
 				switch (category)
 				{
 				case CharacterCategory::kGarbage:
-					return rkc::ResultCodes::kLexGarbageCharacter;
+					return lexer.ReportError(rkc::ResultCodes::kLexGarbageCharacter);
 				case CharacterCategory::kWhitespace:
 				case CharacterCategory::kEndOfLine:
 				case CharacterCategory::kPunctuation:
@@ -449,14 +478,14 @@ namespace rkci
 					RKC_CHECK(ConsumeChar(chars, uchar, lexer));
 					break;
 				case CharacterCategory::kGarbage:
-					return rkc::ResultCodes::kLexGarbageCharacter;
+					return lexer.ReportError(rkc::ResultCodes::kLexGarbageCharacter);
 				case CharacterCategory::kWhitespace:
 				case CharacterCategory::kEndOfLine:
 				case CharacterCategory::kPunctuation:
 					return Result::Ok();
 				case CharacterCategory::kText:
 					if ((uchar < CharCodes::kLowercaseA || uchar > CharCodes::kLowercaseF) && (uchar < CharCodes::kUppercaseA || uchar > CharCodes::kUppercaseF))
-						return rkc::ResultCodes::kLexMalformedNumber;
+						return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 
 					RKC_CHECK(ConsumeChar(chars, uchar, lexer));
 					break;
@@ -494,8 +523,11 @@ namespace rkci
 						RKC_CHECK(ConsumeChar(chars, uchar, lexer));
 
 						RKC_CHECK_RV(Optional<UnicodeChar_t>, firstDigitOpt, lexer.PeekChar());
-						if (!firstDigitOpt.IsSet() || CategorizeCharacter(firstDigitOpt.Get()) != CharacterCategory::kDigit)
-							return rkc::ResultCodes::kLexMalformedNumber;
+						if (!firstDigitOpt.IsSet())
+							return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexMalformedNumber);
+
+						if (CategorizeCharacter(firstDigitOpt.Get()) != CharacterCategory::kDigit)
+							return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 
 						RKC_CHECK(ConsumeChar(chars, firstDigitOpt.Get(), lexer));
 						return ParseHexNumber(lexer, chars);
@@ -509,7 +541,7 @@ namespace rkci
 				switch (category)
 				{
 				case CharacterCategory::kGarbage:
-					return rkc::ResultCodes::kLexGarbageCharacter;
+					return lexer.ReportError(rkc::ResultCodes::kLexGarbageCharacter);
 				case CharacterCategory::kWhitespace:
 				case CharacterCategory::kEndOfLine:
 				case CharacterCategory::kPunctuation:
@@ -520,7 +552,7 @@ namespace rkci
 
 						RKC_CHECK_RV(Optional<UnicodeChar_t>, firstDecimalDigitOpt, lexer.PeekChar());
 						if (!firstDecimalDigitOpt.IsSet())
-							return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+							return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 						const UnicodeChar_t firstDecimalDigit = firstDecimalDigitOpt.Get();
 						if (CategorizeCharacter(firstDecimalDigit) == CharacterCategory::kDigit)
@@ -528,21 +560,21 @@ namespace rkci
 							RKC_CHECK(ConsumeChar(chars, firstDecimalDigit, lexer));
 						}
 						else
-							return rkc::ResultCodes::kLexMalformedNumber;
+							return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 					}
 					else
 						return Result::Ok();
 					break;
 				case CharacterCategory::kDigit:
 					if (!mayHaveDigits)
-						return rkc::ResultCodes::kLexMalformedNumber;
+						return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 					RKC_CHECK(ConsumeChar(chars, uchar, lexer));
 					break;
 				case CharacterCategory::kText:
 					if (uchar == CharCodes::kLowercaseF || uchar == CharCodes::kUppercaseF || uchar == CharCodes::kLowercaseD || uchar == CharCodes::kUppercaseD)
 					{
 						if (!mayHaveSuffix)
-							return rkc::ResultCodes::kLexMalformedNumber;
+							return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 
 						RKC_CHECK(ConsumeChar(chars, uchar, lexer));
 
@@ -554,13 +586,13 @@ namespace rkci
 					else if (uchar == CharCodes::kLowercaseE || uchar == CharCodes::kUppercaseE)
 					{
 						if (!mayHaveExponent)
-							return rkc::ResultCodes::kLexMalformedNumber;
+							return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 
 						RKC_CHECK(ConsumeChar(chars, uchar, lexer));
 
 						RKC_CHECK_RV(Optional<UnicodeChar_t>, firstExponentCharOpt, lexer.PeekChar());
 						if (!firstExponentCharOpt.IsSet())
-							return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+							return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 						const UnicodeChar_t firstExponentChar = firstExponentCharOpt.Get();
 						if (firstExponentChar == CharCodes::kMinus)
@@ -569,7 +601,7 @@ namespace rkci
 
 							RKC_CHECK_RV(Optional<UnicodeChar_t>, firstExponentDigitOpt, lexer.PeekChar());
 							if (!firstExponentDigitOpt.IsSet())
-								return rkc::ResultCodes::kLexUnexpectedEndOfFile;
+								return UnexpectedEndOfInput(lexer, rkc::ResultCodes::kLexUnexpectedEndOfFile);
 
 							const UnicodeChar_t firstExponentDigit = firstExponentDigitOpt.Get();
 							if (CategorizeCharacter(firstExponentDigit) == CharacterCategory::kDigit)
@@ -577,21 +609,21 @@ namespace rkci
 								RKC_CHECK(ConsumeChar(chars, firstExponentDigit, lexer));
 							}
 							else
-								return rkc::ResultCodes::kLexMalformedNumber;
+								return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 						}
 						else if (CategorizeCharacter(firstExponentChar) == CharacterCategory::kDigit)
 						{
 							RKC_CHECK(ConsumeChar(chars, firstExponentChar, lexer));
 						}
 						else
-							return rkc::ResultCodes::kLexMalformedNumber;
+							return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 
 						mayHaveDecimal = false;
 						mayHaveExponent = false;
 					}
 					else
 					{
-						return rkc::ResultCodes::kLexMalformedNumber;
+						return lexer.ReportError(rkc::ResultCodes::kLexMalformedNumber);
 					}
 					break;
 				default:
@@ -600,6 +632,24 @@ namespace rkci
 			}
 		}
 
+		// Newlines are significant, so the end of the line is the nearest point where lexing can resume
+		// after an error
+		Result SkipToEndOfLine(Lexer &lexer, Vector<uint8_t, 4> &chars)
+		{
+			for (;;)
+			{
+				RKC_CHECK_RV(Optional<UnicodeChar_t>, ucharOpt, lexer.PeekChar());
+				if (!ucharOpt.IsSet())
+					return Result::Ok();
+
+				const UnicodeChar_t uchar = ucharOpt.Get();
+				if (CategorizeCharacter(uchar) == CharacterCategory::kEndOfLine)
+					return Result::Ok();
+
+				RKC_CHECK(ConsumeChar(chars, uchar, lexer));
+			}
+		}
+
 		Result ParseToken(Lexer &lexer, Vector<uint8_t, 4> &chars, LexTokenType &outTokenType)
 		{
 			RKC_CHECK_RV(Optional<UnicodeChar_t>, ucharOpt, lexer.PeekChar());
@@ -616,7 +666,7 @@ namespace rkci
 			switch (startCategory)
 			{
 			case CharacterCategory::kGarbage:
-				return Result(rkc::ResultCodes::kLexGarbageCharacter);
+				return lexer.ReportError(rkc::ResultCodes::kLexGarbageCharacter);
 			case CharacterCategory::kWhitespace:
 				return ParseWhitespace(lexer, chars, outTokenType);
 			case CharacterCategory::kEndOfLine:
@@ -632,6 +682,28 @@ namespace rkci
 				return rkc::ResultCodes::kInternalError;
 			};
 		}
+
+		// Continues a token that was suspended when the input ran out, with the lexer and the characters
+		// in the state that they were in at that point
+		Result ResumeToken(Lexer &lexer, Vector<uint8_t, 4> &chars, LexTokenType &outTokenType, LexResumePoint resumePoint)
+		{
+			switch (resumePoint)
+			{
+			case LexResumePoint::kWhitespace:
+				return ParseWhitespace(lexer, chars, outTokenType);
+			case LexResumePoint::kName:
+				return ParseIdentifier(lexer, chars, outTokenType);
+			case LexResumePoint::kQuotedString:
+				return ParseQuotedString(lexer, chars, outTokenType);
+			case LexResumePoint::kLineComment:
+				return ParseLineComment(lexer, chars, outTokenType);
+			case LexResumePoint::kBlockComment:
+				return ParseBlockComment(lexer, chars, outTokenType);
+			default:
+				RKC_ASSERT(false);
+				return rkc::ResultCodes::kInternalError;
+			};
+		}
 	}
 }
 
@@ -692,7 +764,7 @@ rkci::LexerLocal::CharacterCategory rkci::LexerLocal::CategorizeCharacter(Unicod
 	if (uchar >= 91 && uchar <= 96)
 		return CharacterCategory::kPunctuation;
 
-	if (uchar >= 97 && uchar <= 123)
+	if (uchar >= 97 && uchar <= 122)
 		return CharacterCategory::kText;
 
 	if (uchar >= 123 && uchar <= 126)
@@ -704,50 +776,122 @@ rkci::LexerLocal::CharacterCategory rkci::LexerLocal::CategorizeCharacter(Unicod
 	return CharacterCategory::kText;
 }
 
-rkci::Lexer::Lexer(IStream *stream, IAllocator *alloc)
-	: m_stream(stream)
-	, m_bufReadOffset(0)
-	, m_bufSize(0)
-	, m_charBuffer(alloc)
-	, m_leftoverBufferBytes(0)
+rkci::Lexer::Lexer(IStream *stream, IAllocator *alloc, size_t bufferSize)
+	: m_byteBuffer(alloc)
+	, m_bufferSize(bufferSize < Unicode::Utf8::kMaxEncodedBytes ? Unicode::Utf8::kMaxEncodedBytes : bufferSize)
 	, m_isEOF(false)
+	, m_moreInputExpected(false)
+	, m_isStarved(false)
+	, m_canSuspend(false)
+	, m_recoverFromErrors(false)
+	, m_pendingError(rkc::ResultCodes::kOK)
 	, m_lastCharacterWasCR(false)
+	, m_resumePoint(LexResumePoint::kNone)
+	, m_tokenStartPos(0, 0, 0)
 	, m_line(0)
 	, m_col(0)
 	, m_filePos(0)
 	, m_nextChar(0)
 	, m_nextCharSize(0)
 	, m_haveNextChar(false)
+	, m_stream(stream)
+	, m_alloc(alloc)
+	, m_charBuffer(alloc)
 {
 }
 
 rkci::ResultRV<rkci::LexToken> rkci::Lexer::GetNextToken()
 {
-	RKC_CHECK(m_charBuffer.Resize(0));
+	AllocatorTagScope tagScope(*m_alloc, rkc::AllocatorTags::kLexer);
 
-	const LexPosition startPos(m_line, m_col, m_filePos);
+	// Where the stream is rewound to if the token can't be finished or suspended.  This is the start of
+	// the token unless a suspended token is being continued.
+	const LexPosition restartPos(m_line, m_col, m_filePos);
+	const bool restartAfterCR = m_lastCharacterWasCR;
+	const size_t restartCharCount = m_charBuffer.Count();
+	const LexResumePoint resumePoint = m_resumePoint;
+
+	m_resumePoint = LexResumePoint::kNone;
 
 	LexTokenType tokenType = LexTokenType::kUnknown;
-	RKC_CHECK(LexerLocal::ParseToken(*this, m_charBuffer, tokenType));
+	if (resumePoint != LexResumePoint::kNone)
+	{
+		RKC_CHECK(LexerLocal::ResumeToken(*this, m_charBuffer, tokenType, resumePoint));
+	}
+	else
+	{
+		RKC_CHECK(m_charBuffer.Resize(0));
+		m_tokenStartPos = restartPos;
+
+		RKC_CHECK(LexerLocal::ParseToken(*this, m_charBuffer, tokenType));
+	}
+
+	const LexPosition startPos = m_tokenStartPos;
+
+	if (m_pendingError != rkc::ResultCodes::kOK && !m_isStarved)
+	{
+		RKC_CHECK(LexerLocal::SkipToEndOfLine(*this, m_charBuffer));
+	}
+
+	if (m_isStarved)
+	{
+		if (m_resumePoint != LexResumePoint::kNone)
+		{
+			// Bytes that didn't form a whole character yet stay in the byte buffer
+			m_isStarved = false;
+
+			const LexPosition suspendPos(m_line, m_col, m_filePos);
+			return LexToken(LexTokenType::kNeedMoreInput, m_charBuffer, startPos, suspendPos, rkc::ResultCodes::kOK);
+		}
+
+		// The error, if any, is found again when the token is lexed with more input
+		m_pendingError = rkc::ResultCodes::kOK;
+
+		RKC_CHECK(Rewind(restartPos, restartAfterCR));
+		RKC_CHECK(m_charBuffer.Resize(restartCharCount));
+		m_resumePoint = resumePoint;
+
+		return LexToken(LexTokenType::kNeedMoreInput, m_charBuffer, startPos, restartPos, rkc::ResultCodes::kOK);
+	}
 
 	const LexPosition endPos(m_line, m_col, m_filePos);
 
-	return LexToken(tokenType, m_charBuffer, startPos, endPos);
+	if (m_pendingError != rkc::ResultCodes::kOK)
+	{
+		const rkc::ResultCode_t errorCode = m_pendingError;
+		m_pendingError = rkc::ResultCodes::kOK;
+
+		return LexToken(LexTokenType::kError, m_charBuffer, startPos, endPos, errorCode);
+	}
+
+	return LexToken(tokenType, m_charBuffer, startPos, endPos, rkc::ResultCodes::kOK);
 }
 
-rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::PeekChar()
+rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::PeekCharSlow()
 {
-	if (m_haveNextChar)
-		return rkci::Optional<rkci::UnicodeChar_t>(m_nextChar);
-
 	if (m_isEOF)
 		return rkci::Optional<rkci::UnicodeChar_t>();
 
+	if (m_isStarved)
+	{
+		// A parser that carries on after running out of input, such as a string after a cut off escape,
+		// isn't at a point where its token can be continued
+		m_canSuspend = false;
+		m_resumePoint = LexResumePoint::kNone;
+
+		return rkci::Optional<rkci::UnicodeChar_t>();
+	}
+
 	if (m_currentBytes.Count() > 0)
 	{
 		const rkci::Unicode::UnicodeDecodeResult decodeResult = rkci::Unicode::Utf8::Decode(m_currentBytes);
 		if (decodeResult.m_decodeResultType == rkci::Unicode::DecodeResultType::kMalformed)
+		{
+			if (m_recoverFromErrors)
+				return RecoverFromInvalidUnicode(1);
+
 			return rkc::ResultCodes::kLexInvalidUnicode;
+		}
 		if (decodeResult.m_decodeResultType == rkci::Unicode::DecodeResultType::kOK)
 		{
 			SetNextCharacter(decodeResult.m_char, decodeResult.m_countDigested);
@@ -756,18 +900,32 @@ rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::PeekChar()
 	}
 
 	// Need more bytes
-	rkci::ArrayTools::Move(m_byteBuffer.GetSlice(), m_currentBytes);
+	if (m_byteBuffer.Count() == 0)
+	{
+		AllocatorTagScope tagScope(*m_alloc, rkc::AllocatorTags::kLexer);
+		RKC_CHECK(m_byteBuffer.ResizeNoConstruct(m_bufferSize));
+	}
+
+	rkci::ArrayTools::Move(m_byteBuffer.Slice(), m_currentBytes);
 
 	const size_t startOffset = m_currentBytes.Count();
 	const size_t readAdditional = m_stream->Read(&m_byteBuffer[startOffset], m_byteBuffer.Count() - startOffset);
 
-	m_currentBytes = m_byteBuffer.GetSlice().Subrange(0, startOffset + readAdditional);
+	m_currentBytes = m_byteBuffer.Slice().Subrange(0, startOffset + readAdditional);
 
 	if (readAdditional == 0)
 	{
+		if (m_moreInputExpected)
+			return Starve();
+
 		// Partial Unicode character didn't get any extra bytes
 		if (startOffset > 0)
+		{
+			if (m_recoverFromErrors)
+				return RecoverFromInvalidUnicode(static_cast<uint8_t>(startOffset));
+
 			return rkc::ResultCodes::kLexInvalidUnicode;
+		}
 
 		m_isEOF = true;
 		return rkci::Optional<rkci::UnicodeChar_t>();
@@ -781,10 +939,90 @@ rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::PeekChar()
 	}
 
 	// Partial result that couldn't get any more data
+	if (m_moreInputExpected && decodeResult.m_decodeResultType == rkci::Unicode::DecodeResultType::kIncomplete)
+		return Starve();
+
+	if (m_recoverFromErrors)
+	{
+		if (decodeResult.m_decodeResultType == rkci::Unicode::DecodeResultType::kMalformed)
+			return RecoverFromInvalidUnicode(1);
+
+		return RecoverFromInvalidUnicode(static_cast<uint8_t>(m_currentBytes.Count()));
+	}
+
 	m_isEOF = true;
 	return rkc::ResultCodes::kLexInvalidUnicode;
 }
 
+rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::Starve()
+{
+	// Reported as the end of the input, so that the token parsers stop where the bytes ran out
+	m_isStarved = true;
+	m_canSuspend = true;
+	return rkci::Optional<rkci::UnicodeChar_t>();
+}
+
+rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::RecoverFromInvalidUnicode(uint8_t numBytes)
+{
+	// The bad bytes become a replacement character, and the token containing it becomes an error token
+	m_pendingError = rkc::ResultCodes::kLexInvalidUnicode;
+
+	SetNextCharacter(kReplacementCharacter, numBytes);
+	return rkci::Optional<rkci::UnicodeChar_t>(m_nextChar);
+}
+
+rkci::Result rkci::Lexer::Rewind(const LexPosition &pos, bool lastCharacterWasCR)
+{
+	if (!m_stream->SeekStart(pos.m_filePos))
+		return rkc::ResultCodes::kInvalidOperation;
+
+	m_currentBytes = ArraySliceView<uint8_t>();
+	m_haveNextChar = false;
+	m_isStarved = false;
+
+	m_line = pos.m_line;
+	m_col = pos.m_col;
+	m_filePos = pos.m_filePos;
+	m_lastCharacterWasCR = lastCharacterWasCR;
+
+	return Result::Ok();
+}
+
+void rkci::Lexer::SetRecoverFromErrors(bool recoverFromErrors)
+{
+	m_recoverFromErrors = recoverFromErrors;
+}
+
+rkci::Result rkci::Lexer::ReportError(rkc::ResultCode_t resultCode)
+{
+	if (!m_recoverFromErrors)
+		return resultCode;
+
+	// Later errors in the same token are usually caused by the first one
+	if (m_pendingError == rkc::ResultCodes::kOK)
+		m_pendingError = resultCode;
+
+	return Result::Ok();
+}
+
+void rkci::Lexer::SetMoreInputExpected(bool moreInputExpected)
+{
+	m_moreInputExpected = moreInputExpected;
+}
+
+void rkci::Lexer::SuspendToken(LexResumePoint resumePoint)
+{
+	// Tokens with an error are lexed again from where they were last continued, so that the error and the
+	// rest of the line are found again with more input
+	if (m_isStarved && m_canSuspend && m_pendingError == rkc::ResultCodes::kOK)
+		m_resumePoint = resumePoint;
+}
+
+bool rkci::Lexer::IsStarved() const
+{
+	return m_isStarved;
+}
+
 void rkci::Lexer::ConsumeChar()
 {
 	RKC_ASSERT(m_haveNextChar);
@@ -26,6 +26,27 @@ namespace rkci
 		kEndOfFile,
 		kPunctuation,
 		kCharacterLiteral,
+
+		// Only returned while more input is expected.  The stream ran out of bytes in the middle of a
+		// token.  The token is continued from its end position once more bytes are available, and bytes
+		// before that position are no longer needed.
+		kNeedMoreInput,
+
+		// Only returned when recovering from errors.  Covers the malformed input up to the end of the
+		// line, and the token's error code says what was wrong with it.
+		kError,
+	};
+
+	// Where a token that was cut off by the end of the available input is continued from
+	enum class LexResumePoint
+	{
+		kNone,
+
+		kWhitespace,
+		kName,
+		kQuotedString,
+		kLineComment,
+		kBlockComment,
 	};
 
 	struct LexPosition
@@ -43,33 +64,64 @@ namespace rkci
 		const Vector<uint8_t, 4> &m_charBuffer;
 		LexPosition m_startPos;
 		LexPosition m_endPos;
+		rkc::ResultCode_t m_errorCode;
 
-		LexToken(LexTokenType tokenType, const Vector<uint8_t, 4> &charBuffer, const LexPosition &startPos, const LexPosition &endPos);
+		LexToken(LexTokenType tokenType, const Vector<uint8_t, 4> &charBuffer, const LexPosition &startPos, const LexPosition &endPos, rkc::ResultCode_t errorCode);
 	};
 
 	class Lexer
 	{
 	public:
-		Lexer(IStream *stream, IAllocator *alloc);
+		static const size_t kDefaultBufferSize = 64 * 1024;
+
+		// The read buffer is allocated on the first read.  Larger buffers mean fewer stream reads.
+		Lexer(IStream *stream, IAllocator *alloc, size_t bufferSize);
 
 		ResultRV<LexToken> GetNextToken();
 		ResultRV<Optional<UnicodeChar_t>> PeekChar();
 		void ConsumeChar();
 
+		// If set, a stream returning no bytes means that the input isn't available yet instead of the end
+		// of the file.  The stream must support seeking back to the end position of the last token.
+		void SetMoreInputExpected(bool moreInputExpected);
+
+		// Called by the token parsers when the input runs out at a point where the token can be continued,
+		// so that the part lexed so far is kept instead of being lexed again
+		void SuspendToken(LexResumePoint resumePoint);
+
+		// True if a read came up empty while more input is expected
+		bool IsStarved() const;
+
+		// If set, lexical errors produce error tokens instead of failing, and lexing resumes at the end
+		// of the line
+		void SetRecoverFromErrors(bool recoverFromErrors);
+
+		// Called by the token parsers on malformed input.  Returns the error, or records it for the
+		// current token and returns OK when recovering from errors.
+		Result ReportError(rkc::ResultCode_t resultCode);
+
 	private:
+		ResultRV<Optional<UnicodeChar_t>> PeekCharSlow();
+		ResultRV<Optional<UnicodeChar_t>> Starve();
+		ResultRV<Optional<UnicodeChar_t>> RecoverFromInvalidUnicode(uint8_t numBytes);
+		Result Rewind(const LexPosition &pos, bool lastCharacterWasCR);
 		void SetNextCharacter(UnicodeChar_t nextChar, uint8_t numBytes);
 
-		static const size_t kReadaheadCapacity = 4096;
+		static const UnicodeChar_t kReplacementCharacter = 0xfffd;
 
-		StaticArray<uint8_t, kReadaheadCapacity> m_byteBuffer;
+		Vector<uint8_t> m_byteBuffer;
+		size_t m_bufferSize;
 		ArraySliceView<uint8_t> m_currentBytes;
-		size_t m_leftoverBufferBytes;
-
-		size_t m_bufReadOffset;
-		size_t m_bufSize;
 
 		bool m_isEOF;
+		bool m_moreInputExpected;
+		bool m_isStarved;
+		bool m_canSuspend;
+		bool m_recoverFromErrors;
+		rkc::ResultCode_t m_pendingError;
 		bool m_lastCharacterWasCR;
+		LexResumePoint m_resumePoint;
+		LexPosition m_tokenStartPos;
 		size_t m_line;
 		size_t m_col;
 		size_t m_filePos;
@@ -79,19 +131,29 @@ namespace rkci
 		bool m_haveNextChar;
 
 		IStream *m_stream;
+		IAllocator *m_alloc;
 
 		Vector<uint8_t, 4> m_charBuffer;
 	};
 }
 
-inline rkci::LexToken::LexToken(LexTokenType tokenType, const Vector<uint8_t, 4> &charBuffer, const LexPosition &startPos, const LexPosition &endPos)
+inline rkci::LexToken::LexToken(LexTokenType tokenType, const Vector<uint8_t, 4> &charBuffer, const LexPosition &startPos, const LexPosition &endPos, rkc::ResultCode_t errorCode)
 	: m_tokenType(tokenType)
 	, m_charBuffer(charBuffer)
 	, m_startPos(startPos)
 	, m_endPos(endPos)
+	, m_errorCode(errorCode)
 {
 }
 
+inline rkci::ResultRV<rkci::Optional<rkci::UnicodeChar_t>> rkci::Lexer::PeekChar()
+{
+	if (RKC_LIKELY(m_haveNextChar))
+		return rkci::Optional<rkci::UnicodeChar_t>(m_nextChar);
+
+	return PeekCharSlow();
+}
+
 inline rkci::LexPosition::LexPosition(size_t line, size_t col, size_t filePos)
 	: m_line(line)
 	, m_col(col)
@@ -0,0 +1,87 @@
+#include "ModuleBlob.h"
+#include "IStream.h"
+#include "Result.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace ModuleBlobInternal
+	{
+		static const uint8_t kMagic[8] = { 'R', 'K', 'C', 'M', 'O', 'D', 'B', 0 };
+
+		static void EncodeUInt32(uint8_t *bytes, uint32_t value)
+		{
+			for (int i = 0; i < 4; i++)
+				bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+		}
+
+		static void EncodeUInt64(uint8_t *bytes, uint64_t value)
+		{
+			for (int i = 0; i < 8; i++)
+				bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+		}
+
+		static uint32_t DecodeUInt32(const uint8_t *bytes)
+		{
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= static_cast<uint32_t>(bytes[i]) << (i * 8);
+			return value;
+		}
+
+		static uint64_t DecodeUInt64(const uint8_t *bytes)
+		{
+			uint64_t value = 0;
+			for (int i = 0; i < 8; i++)
+				value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+			return value;
+		}
+	}
+}
+
+rkci::Result rkci::ModuleBlob::Write(IStream &stream, const ModuleBlobHeader &header)
+{
+	uint8_t bytes[ModuleBlobHeader::kSize];
+
+	memcpy(bytes, ModuleBlobInternal::kMagic, 8);
+	ModuleBlobInternal::EncodeUInt32(bytes + 8, ModuleBlobHeader::kFormatVersion);
+	ModuleBlobInternal::EncodeUInt32(bytes + 12, ModuleBlobHeader::kCompilerVersion);
+	ModuleBlobInternal::EncodeUInt64(bytes + 16, header.m_sourceHash);
+	ModuleBlobInternal::EncodeUInt64(bytes + 24, header.m_optionsHash);
+	ModuleBlobInternal::EncodeUInt64(bytes + 32, header.m_interfaceHash);
+	ModuleBlobInternal::EncodeUInt64(bytes + 40, header.m_importsInterfaceHash);
+
+	// Lowered IR will be stored in the payload once lowering exists
+	ModuleBlobInternal::EncodeUInt64(bytes + 48, ModuleBlobHeader::kSize);
+	ModuleBlobInternal::EncodeUInt64(bytes + 56, 0);
+
+	if (stream.Write(bytes, sizeof(bytes)) != sizeof(bytes))
+		return rkc::ResultCodes::kIOError;
+
+	return rkci::Result::Ok();
+}
+
+rkci::ResultRV<bool> rkci::ModuleBlob::ReadHeader(IStream &stream, ModuleBlobHeader &outHeader)
+{
+	uint8_t bytes[ModuleBlobHeader::kSize];
+
+	if (stream.Read(bytes, sizeof(bytes)) != sizeof(bytes))
+		return false;
+
+	if (memcmp(bytes, ModuleBlobInternal::kMagic, 8) != 0)
+		return false;
+
+	if (ModuleBlobInternal::DecodeUInt32(bytes + 8) != ModuleBlobHeader::kFormatVersion)
+		return false;
+
+	if (ModuleBlobInternal::DecodeUInt32(bytes + 12) != ModuleBlobHeader::kCompilerVersion)
+		return false;
+
+	outHeader.m_sourceHash = ModuleBlobInternal::DecodeUInt64(bytes + 16);
+	outHeader.m_optionsHash = ModuleBlobInternal::DecodeUInt64(bytes + 24);
+	outHeader.m_interfaceHash = ModuleBlobInternal::DecodeUInt64(bytes + 32);
+	outHeader.m_importsInterfaceHash = ModuleBlobInternal::DecodeUInt64(bytes + 40);
+
+	return true;
+}
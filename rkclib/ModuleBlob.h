@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreDefs.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IStream;
+	class Result;
+	template<class T> class ResultRV;
+
+	// Serialized form of a compiled module, used to skip recompiling unchanged modules across runs.
+	// All fields are little-endian and sections are 8-byte aligned, so a blob can be used in place
+	// from a memory-mapped file.
+	//
+	// Layout:
+	//    0  magic "RKCMODB" followed by a zero byte
+	//    8  uint32 format version
+	//   12  uint32 compiler version
+	//   16  uint64 source hash
+	//   24  uint64 options hash
+	//   32  uint64 export interface hash
+	//   40  uint64 combined export interface hash of the imports that the module was compiled against
+	//   48  uint64 payload offset
+	//   56  uint64 payload size
+	//   64  payload
+	struct ModuleBlobHeader
+	{
+		static const uint32_t kFormatVersion = 1;
+		static const uint32_t kCompilerVersion = 1;
+		static const size_t kSize = 64;
+
+		uint64_t m_sourceHash;
+		uint64_t m_optionsHash;
+		uint64_t m_interfaceHash;
+		uint64_t m_importsInterfaceHash;
+	};
+
+	namespace ModuleBlob
+	{
+		Result Write(IStream &stream, const ModuleBlobHeader &header);
+
+		// Returns false if the stream does not contain a blob written by this version of the compiler
+		ResultRV<bool> ReadHeader(IStream &stream, ModuleBlobHeader &outHeader);
+	}
+}
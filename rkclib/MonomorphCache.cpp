@@ -0,0 +1,342 @@
+#include "MonomorphCache.h"
+#include "AllocatorTag.h"
+#include "ArraySliceView.h"
+#include "Hasher.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+#include <new>
+#include <string.h>
+
+rkci::MonomorphCache::TypeArgument::TypeArgument(Kernel::TypeKind kind, Kernel::TypeKind laneKind, int64_t minValue, int64_t maxValue, const FloatSpec &floatSpec)
+	: m_kind(kind)
+	, m_laneKind(laneKind)
+	, m_minValue(minValue)
+	, m_maxValue(maxValue)
+	, m_floatSpec(floatSpec)
+{
+}
+
+rkci::MonomorphCache::MonomorphCache(IAllocator &alloc)
+	: m_alloc(alloc)
+	, m_instances(&alloc)
+	, m_typeArgs(&alloc)
+	, m_functions(&alloc)
+	, m_buckets(&alloc)
+	, m_numReused(0)
+{
+}
+
+rkci::MonomorphCache::~MonomorphCache()
+{
+	const size_t numFunctions = m_functions.Count();
+	for (size_t i = 0; i < numFunctions; i++)
+	{
+		m_functions[i]->~Function();
+		m_alloc.Release(m_functions[i]);
+	}
+}
+
+rkci::MonomorphCache::TypeArgument rkci::MonomorphCache::MakeTypeArgument(const Kernel::Function &function, Kernel::TypeIndex_t type)
+{
+	const Kernel::Type &kernelType = function.GetType(type);
+
+	const Kernel::Type &laneType = (kernelType.m_kind == Kernel::TypeKind::kMask) ? function.GetType(kernelType.m_laneType) : kernelType;
+	RKC_ASSERT(laneType.m_kind != Kernel::TypeKind::kMask);
+
+	const FloatSpec noFloatSpec(false, 0, 0, 0, false, false);
+
+	if (laneType.m_kind == Kernel::TypeKind::kFloat)
+		return TypeArgument(kernelType.m_kind, laneType.m_kind, 0, 0, laneType.m_floatSpec);
+
+	return TypeArgument(kernelType.m_kind, laneType.m_kind, laneType.m_minValue, laneType.m_maxValue, noFloatSpec);
+}
+
+rkci::ResultRV<rkci::MonomorphCache::InstanceID_t> rkci::MonomorphCache::FindOrAdd(SymbolID_t genericFunction, const ArraySliceView<const TypeArgument> &typeArgs, bool &outIsNew)
+{
+	AllocatorTagScope tagScope(m_alloc, rkc::AllocatorTags::kBackend);
+
+	const uint64_t typeArgsHash = ComputeTypeArgumentsHash(typeArgs);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_buckets.Count() != 0)
+	{
+		const size_t bucket = FindBucket(genericFunction, typeArgs, typeArgsHash);
+		if (m_buckets[bucket] != kEmptyBucket)
+		{
+			m_numReused++;
+			outIsNew = false;
+			return m_buckets[bucket];
+		}
+	}
+
+	const size_t numInstances = m_instances.Count();
+	const size_t firstTypeArg = m_typeArgs.Count();
+	if (numInstances >= kEmptyBucket || typeArgs.Count() > 0xffffffffu - firstTypeArg)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	// Keep the load factor at or below 1/2
+	if ((numInstances + 1) * 2 > m_buckets.Count())
+	{
+		size_t numBuckets = m_buckets.Count() * 2;
+		if (numBuckets < 64)
+			numBuckets = 64;
+
+		RKC_CHECK(Rehash(numBuckets));
+	}
+
+	Instance instance;
+	instance.m_genericFunction = genericFunction;
+	instance.m_firstTypeArg = static_cast<uint32_t>(firstTypeArg);
+	instance.m_numTypeArgs = static_cast<uint32_t>(typeArgs.Count());
+	instance.m_typeArgsHash = typeArgsHash;
+	instance.m_functionIndex = kNotBuilt;
+
+	RKC_CHECK(m_typeArgs.AppendRange(typeArgs));
+	RKC_CHECK(m_instances.Append(instance));
+
+	const InstanceID_t instanceID = static_cast<InstanceID_t>(numInstances);
+	m_buckets[FindBucket(genericFunction, typeArgs, typeArgsHash)] = instanceID;
+
+	outIsNew = true;
+	return instanceID;
+}
+
+bool rkci::MonomorphCache::Find(SymbolID_t genericFunction, const ArraySliceView<const TypeArgument> &typeArgs, InstanceID_t &outInstance)
+{
+	const uint64_t typeArgsHash = ComputeTypeArgumentsHash(typeArgs);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_buckets.Count() == 0)
+		return false;
+
+	const uint32_t instance = m_buckets[FindBucket(genericFunction, typeArgs, typeArgsHash)];
+	if (instance == kEmptyBucket)
+		return false;
+
+	outInstance = instance;
+	return true;
+}
+
+rkci::Result rkci::MonomorphCache::SetFunction(InstanceID_t instance, Kernel::Function &&function)
+{
+	AllocatorTagScope tagScope(m_alloc, rkc::AllocatorTags::kBackend);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (instance >= m_instances.Count() || m_instances[instance].m_functionIndex != kNotBuilt)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	const size_t functionIndex = m_functions.Count();
+	if (functionIndex >= kNotBuilt)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	RKC_CHECK(m_functions.Append(nullptr));
+
+	void *functionMem = m_alloc.Alloc(sizeof(Kernel::Function));
+	if (!functionMem)
+	{
+		RKC_CHECK(m_functions.Resize(functionIndex));
+		return rkc::ResultCodes::kOutOfMemory;
+	}
+
+	m_functions[functionIndex] = new (functionMem) Kernel::Function(rkci::Move(function));
+	m_instances[instance].m_functionIndex = static_cast<uint32_t>(functionIndex);
+
+	return Result::Ok();
+}
+
+const rkci::Kernel::Function *rkci::MonomorphCache::GetFunction(InstanceID_t instance) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const uint32_t functionIndex = m_instances[instance].m_functionIndex;
+	if (functionIndex == kNotBuilt)
+		return nullptr;
+
+	return m_functions[functionIndex];
+}
+
+rkci::SymbolID_t rkci::MonomorphCache::GetGenericFunction(InstanceID_t instance) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_instances[instance].m_genericFunction;
+}
+
+rkci::Result rkci::MonomorphCache::GetTypeArguments(InstanceID_t instance, Vector<TypeArgument> &outTypeArgs) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const Instance &entry = m_instances[instance];
+
+	RKC_CHECK(outTypeArgs.ResizeNoConstruct(0));
+	RKC_CHECK(outTypeArgs.AppendRange(m_typeArgs.Slice().Subrange(entry.m_firstTypeArg, entry.m_numTypeArgs)));
+
+	return Result::Ok();
+}
+
+uint64_t rkci::MonomorphCache::GetTypeArgumentsHash(InstanceID_t instance) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_instances[instance].m_typeArgsHash;
+}
+
+rkci::Result rkci::MonomorphCache::GetLinkName(InstanceID_t instance, const SymbolPool &symbolPool, Vector<uint8_t> &outName) const
+{
+	static const char kHexDigits[] = "0123456789abcdef";
+
+	SymbolID_t genericFunction = 0;
+	uint64_t typeArgsHash = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const Instance &entry = m_instances[instance];
+		genericFunction = entry.m_genericFunction;
+		typeArgsHash = entry.m_typeArgsHash;
+	}
+
+	uint8_t suffix[18];
+	suffix[0] = '_';
+	suffix[1] = 'm';
+	for (int digit = 0; digit < 16; digit++)
+		suffix[2 + digit] = static_cast<uint8_t>(kHexDigits[(typeArgsHash >> ((15 - digit) * 4)) & 0xfu]);
+
+	RKC_CHECK(outName.Resize(0));
+	RKC_CHECK(outName.AppendRange(symbolPool.GetBytes(genericFunction)));
+	RKC_CHECK(outName.AppendRange(ArraySliceView<const uint8_t>(suffix, sizeof(suffix))));
+
+	return Result::Ok();
+}
+
+size_t rkci::MonomorphCache::NumInstances() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_instances.Count();
+}
+
+size_t rkci::MonomorphCache::GetNumReused() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_numReused;
+}
+
+bool rkci::MonomorphCache::TypeArgumentsEqual(const TypeArgument &a, const TypeArgument &b)
+{
+	const FloatSpec &specA = a.m_floatSpec;
+	const FloatSpec &specB = b.m_floatSpec;
+
+	return a.m_kind == b.m_kind
+		&& a.m_laneKind == b.m_laneKind
+		&& a.m_minValue == b.m_minValue
+		&& a.m_maxValue == b.m_maxValue
+		&& specA.IsSigned() == specB.IsSigned()
+		&& specA.GetExponentBits() == specB.GetExponentBits()
+		&& specA.GetMantissaBits() == specB.GetMantissaBits()
+		&& specA.GetExponentOfOne() == specB.GetExponentOfOne()
+		&& specA.SupportsDenormals() == specB.SupportsDenormals()
+		&& specA.SupportsNans() == specB.SupportsNans();
+}
+
+uint64_t rkci::MonomorphCache::ComputeTypeArgumentsHash(const ArraySliceView<const TypeArgument> &typeArgs)
+{
+	// Fields are hashed one at a time in little-endian order, so the hash doesn't depend on the host's
+	// struct layout or byte order
+	uint64_t hash = HashUtil::kStableHash64Seed;
+	hash = AppendStableHash(hash, typeArgs.Count(), 4);
+
+	const size_t numTypeArgs = typeArgs.Count();
+	for (size_t i = 0; i < numTypeArgs; i++)
+	{
+		const TypeArgument &typeArg = typeArgs[i];
+		const FloatSpec &floatSpec = typeArg.m_floatSpec;
+
+		hash = AppendStableHash(hash, static_cast<uint64_t>(typeArg.m_kind), 1);
+		hash = AppendStableHash(hash, static_cast<uint64_t>(typeArg.m_laneKind), 1);
+		hash = AppendStableHash(hash, static_cast<uint64_t>(typeArg.m_minValue), 8);
+		hash = AppendStableHash(hash, static_cast<uint64_t>(typeArg.m_maxValue), 8);
+		hash = AppendStableHash(hash, floatSpec.IsSigned() ? 1 : 0, 1);
+		hash = AppendStableHash(hash, floatSpec.GetExponentBits(), 2);
+		hash = AppendStableHash(hash, floatSpec.GetMantissaBits(), 2);
+		hash = AppendStableHash(hash, static_cast<uint16_t>(floatSpec.GetExponentOfOne()), 2);
+		hash = AppendStableHash(hash, floatSpec.SupportsDenormals() ? 1 : 0, 1);
+		hash = AppendStableHash(hash, floatSpec.SupportsNans() ? 1 : 0, 1);
+	}
+
+	return hash;
+}
+
+uint64_t rkci::MonomorphCache::AppendStableHash(uint64_t hash, uint64_t value, size_t numBytes)
+{
+	uint8_t bytes[8];
+	for (size_t i = 0; i < numBytes; i++)
+		bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+
+	return HashUtil::ComputeStableHash64(bytes, numBytes, hash);
+}
+
+size_t rkci::MonomorphCache::GetBucketHash(SymbolID_t genericFunction, uint64_t typeArgsHash)
+{
+	const uint64_t hash = AppendStableHash(typeArgsHash, genericFunction, 4);
+	return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+size_t rkci::MonomorphCache::FindBucket(SymbolID_t genericFunction, const ArraySliceView<const TypeArgument> &typeArgs, uint64_t typeArgsHash) const
+{
+	const size_t mask = m_buckets.Count() - 1;
+	size_t bucket = GetBucketHash(genericFunction, typeArgsHash) & mask;
+
+	for (;;)
+	{
+		const uint32_t instanceID = m_buckets[bucket];
+		if (instanceID == kEmptyBucket)
+			return bucket;
+
+		const Instance &instance = m_instances[instanceID];
+		if (instance.m_genericFunction == genericFunction && instance.m_typeArgsHash == typeArgsHash && instance.m_numTypeArgs == typeArgs.Count())
+		{
+			bool isMatch = true;
+			for (uint32_t i = 0; i < instance.m_numTypeArgs; i++)
+			{
+				if (!TypeArgumentsEqual(m_typeArgs[instance.m_firstTypeArg + i], typeArgs[i]))
+				{
+					isMatch = false;
+					break;
+				}
+			}
+
+			if (isMatch)
+				return bucket;
+		}
+
+		bucket = (bucket + 1) & mask;
+	}
+}
+
+rkci::Result rkci::MonomorphCache::Rehash(size_t numBuckets)
+{
+	RKC_ASSERT((numBuckets & (numBuckets - 1)) == 0);
+
+	RKC_CHECK(m_buckets.ResizeNoConstruct(numBuckets));
+	memset(&m_buckets[0], 0xff, numBuckets * sizeof(uint32_t));
+
+	const size_t mask = numBuckets - 1;
+	const size_t numInstances = m_instances.Count();
+	for (size_t i = 0; i < numInstances; i++)
+	{
+		const Instance &instance = m_instances[i];
+
+		size_t bucket = GetBucketHash(instance.m_genericFunction, instance.m_typeArgsHash) & mask;
+		while (m_buckets[bucket] != kEmptyBucket)
+			bucket = (bucket + 1) & mask;
+
+		m_buckets[bucket] = static_cast<uint32_t>(i);
+	}
+
+	return Result::Ok();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "FloatSpec.h"
+#include "KernelIR.h"
+#include "SymbolPool.h"
+#include "Vector.h"
+
+#include <mutex>
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	class Result;
+	template<class T> class ArraySliceView;
+	template<class T> class ResultRV;
+
+	// Memoises the instantiations of generic functions, so that each combination of a generic function
+	// and type arguments is built once no matter how many call sites or modules use it.  Instantiations
+	// are keyed by the generic function's name and the canonical form of its type arguments, so type
+	// arguments that came from different kernels are equal if they are the same type.
+	//
+	// Each instantiation also has a link name made of the generic function's name and a stable hash of
+	// its type arguments, so compiles that instantiate the same function with the same types emit it
+	// under the same name and the host only has to build and link one copy.
+	//
+	// Every operation locks, so one cache can be shared by jobs on any thread.  Built functions are
+	// allocated one at a time and never move, so the pointer from GetFunction stays valid while other
+	// threads add to the cache.
+	class MonomorphCache
+	{
+	public:
+		typedef uint32_t InstanceID_t;
+
+		// A kernel type with everything that doesn't apply to its kind cleared.  Masks carry the kind
+		// and range or floatspec of their lane type.
+		struct TypeArgument
+		{
+			TypeArgument(Kernel::TypeKind kind, Kernel::TypeKind laneKind, int64_t minValue, int64_t maxValue, const FloatSpec &floatSpec);
+
+			Kernel::TypeKind m_kind;
+			Kernel::TypeKind m_laneKind;
+			int64_t m_minValue;
+			int64_t m_maxValue;
+			FloatSpec m_floatSpec;
+		};
+
+		explicit MonomorphCache(IAllocator &alloc);
+		~MonomorphCache();
+
+		static TypeArgument MakeTypeArgument(const Kernel::Function &function, Kernel::TypeIndex_t type);
+
+		// Finds the instantiation of a generic function for a list of type arguments, adding it if it
+		// doesn't exist yet.  outIsNew is set if this call added it, in which case the caller is the one
+		// that builds it and passes it to SetFunction.
+		ResultRV<InstanceID_t> FindOrAdd(SymbolID_t genericFunction, const ArraySliceView<const TypeArgument> &typeArgs, bool &outIsNew);
+		bool Find(SymbolID_t genericFunction, const ArraySliceView<const TypeArgument> &typeArgs, InstanceID_t &outInstance);
+
+		Result SetFunction(InstanceID_t instance, Kernel::Function &&function);
+
+		// Returns null if the instantiation hasn't been built yet
+		const Kernel::Function *GetFunction(InstanceID_t instance) const;
+
+		SymbolID_t GetGenericFunction(InstanceID_t instance) const;
+
+		// Copies the type arguments, since the cache's own list moves when other instantiations are added
+		Result GetTypeArguments(InstanceID_t instance, Vector<TypeArgument> &outTypeArgs) const;
+
+		// Hash of the type arguments that is identical across compiles and processes
+		uint64_t GetTypeArgumentsHash(InstanceID_t instance) const;
+
+		// Writes the link name of an instantiation, the generic function's name followed by "_m" and the
+		// type arguments hash in hex
+		Result GetLinkName(InstanceID_t instance, const SymbolPool &symbolPool, Vector<uint8_t> &outName) const;
+
+		size_t NumInstances() const;
+
+		// Number of FindOrAdd calls that returned an existing instantiation
+		size_t GetNumReused() const;
+
+		static bool TypeArgumentsEqual(const TypeArgument &a, const TypeArgument &b);
+		static uint64_t ComputeTypeArgumentsHash(const ArraySliceView<const TypeArgument> &typeArgs);
+
+	private:
+		struct Instance
+		{
+			SymbolID_t m_genericFunction;
+			uint32_t m_firstTypeArg;
+			uint32_t m_numTypeArgs;
+			uint64_t m_typeArgsHash;
+			uint32_t m_functionIndex;
+		};
+
+		MonomorphCache(const MonomorphCache &other) = delete;
+		MonomorphCache &operator=(const MonomorphCache &other) = delete;
+
+		static const uint32_t kEmptyBucket = 0xffffffffu;
+		static const uint32_t kNotBuilt = 0xffffffffu;
+
+		static uint64_t AppendStableHash(uint64_t hash, uint64_t value, size_t numBytes);
+		static size_t GetBucketHash(SymbolID_t genericFunction, uint64_t typeArgsHash);
+
+		size_t FindBucket(SymbolID_t genericFunction, const ArraySliceView<const TypeArgument> &typeArgs, uint64_t typeArgsHash) const;
+		Result Rehash(size_t numBuckets);
+
+		IAllocator &m_alloc;
+
+		mutable std::mutex m_mutex;
+		Vector<Instance> m_instances;
+		Vector<TypeArgument> m_typeArgs;
+		Vector<Kernel::Function *> m_functions;
+		Vector<uint32_t> m_buckets;
+		size_t m_numReused;
+	};
+}
@@ -6,44 +6,40 @@ namespace rkci
 	template<class T> class ResultRV;
 	class Result;
 
-	template<class T>
+	// Wraps a reference to an object that is either owned by the callee (TIsMove) or borrowed from the caller.
+	// Produce returns an owned copy (moving out of the source if possible) and Consume releases the source
+	// if the callee owns it.  Ownership is resolved at compile time so calls can be inlined.
+	template<class T, bool TIsMove>
 	class MoveOrCopy
 	{
+	};
+
+	template<class T>
+	class MoveOrCopy<T, false>
+	{
 	public:
-		MoveOrCopy(const T &obj);
-		MoveOrCopy(T &&obj);
+		explicit MoveOrCopy(const T &obj);
 
 		ResultRV<T> Produce() const;
 		void Consume() const;
 		const T &Get() const;
 
 	private:
-		struct IBehavior
-		{
-			virtual ResultRV<T> Produce(T &ref) const = 0;
-			virtual void Consume(T &ref) const = 0;
-		};
-
-		class CloneBehavior final : public IBehavior
-		{
-		public:
-			ResultRV<T> Produce(T &ref) const override;
-			void Consume(T &ref) const override;
-
-			static CloneBehavior ms_instance;
-		};
-
-		class MoveBehavior final : public IBehavior
-		{
-		public:
-			ResultRV<T> Produce(T &ref) const override;
-			void Consume(T &ref) const override;
-
-			static MoveBehavior ms_instance;
-		};
+		const T &m_ref;
+	};
+
+	template<class T>
+	class MoveOrCopy<T, true>
+	{
+	public:
+		explicit MoveOrCopy(T &&obj);
+
+		ResultRV<T> Produce() const;
+		void Consume() const;
+		const T &Get() const;
 
+	private:
 		T &m_ref;
-		const IBehavior &m_behavior;
 	};
 }
 
@@ -51,65 +47,49 @@ namespace rkci
 #include "Result.h"
 
 template<class T>
-rkci::MoveOrCopy<T>::MoveOrCopy(const T &obj)
-	: m_ref(const_cast<T&>(obj))
-	, m_behavior(CloneBehavior::ms_instance)
-{
-}
-
-template<class T>
-rkci::MoveOrCopy<T>::MoveOrCopy(T &&obj)
+inline rkci::MoveOrCopy<T, false>::MoveOrCopy(const T &obj)
 	: m_ref(obj)
-	, m_behavior(MoveBehavior::ms_instance)
 {
 }
 
 template<class T>
-rkci::ResultRV<T> rkci::MoveOrCopy<T>::Produce() const
+inline rkci::ResultRV<T> rkci::MoveOrCopy<T, false>::Produce() const
 {
-	return m_behavior.Produce(m_ref);
+	return rkci::Cloner<T>::Clone(m_ref);
 }
 
 template<class T>
-void rkci::MoveOrCopy<T>::Consume() const
+inline void rkci::MoveOrCopy<T, false>::Consume() const
 {
-	return m_behavior.Consume(m_ref);
 }
 
 template<class T>
-const T &rkci::MoveOrCopy<T>::Get() const
+inline const T &rkci::MoveOrCopy<T, false>::Get() const
 {
 	return m_ref;
 }
 
-
 template<class T>
-rkci::ResultRV<T> rkci::MoveOrCopy<T>::CloneBehavior::Produce(T &ref) const
+inline rkci::MoveOrCopy<T, true>::MoveOrCopy(T &&obj)
+	: m_ref(obj)
 {
-	RKC_CHECK_RV(T, clone, rkci::Cloner<T>::Clone(ref));
-	return clone;
 }
 
 template<class T>
-void rkci::MoveOrCopy<T>::CloneBehavior::Consume(T &ref) const
+inline rkci::ResultRV<T> rkci::MoveOrCopy<T, true>::Produce() const
 {
+	return T(static_cast<T&&>(m_ref));
 }
 
 template<class T>
-rkci::ResultRV<T> rkci::MoveOrCopy<T>::MoveBehavior::Produce(T &ref) const
+inline void rkci::MoveOrCopy<T, true>::Consume() const
 {
-	return T(static_cast<T&&>(ref));
+	T discarded(static_cast<T&&>(m_ref));
+	(void)discarded;
 }
 
 template<class T>
-void rkci::MoveOrCopy<T>::MoveBehavior::Consume(T &ref) const
+inline const T &rkci::MoveOrCopy<T, true>::Get() const
 {
-	T discarded(static_cast<T&&>(ref));
-	(void)discarded;
+	return m_ref;
 }
-
-template<class T>
-typename rkci::MoveOrCopy<T>::MoveBehavior rkci::MoveOrCopy<T>::MoveBehavior::ms_instance;
-
-template<class T>
-typename rkci::MoveOrCopy<T>::CloneBehavior rkci::MoveOrCopy<T>::CloneBehavior::ms_instance;
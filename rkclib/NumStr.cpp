@@ -4,6 +4,7 @@
 #include "BigUFloat.h"
 #include "Unicode.h"
 #include "CharCodes.h"
+#include "IAllocator.h"
 
 #include <cstring>
 
@@ -14,6 +15,8 @@ rkci::NumStr::NumStr(IAllocator &alloc)
 
 rkci::ResultRV<rkci::BigUDecFloat_t> rkci::NumStr::DecimalUTF8ToDecInt(const ArraySliceView<const uint8_t> &utf8Str, uint32_t &outNumTrailingZeroes) const
 {
+	AllocatorTagScope tagScope(m_alloc, rkc::AllocatorTags::kBigNum);
+
 	rkci::BigUDecFloat_t result;
 
 	const size_t strLength = utf8Str.Count();
@@ -72,6 +75,8 @@ rkci::ResultRV<rkci::BigUDecFloat_t> rkci::NumStr::DecimalUTF8ToDecInt(const Arr
 
 rkci::ResultRV<rkci::BigUDecFloat_t> rkci::NumStr::DecimalUTF8ToDecFloat(const ArraySliceView<const uint8_t> &utf8Str, uint32_t &outNumTrailingZeroes) const
 {
+	AllocatorTagScope tagScope(m_alloc, rkc::AllocatorTags::kBigNum);
+
 	bool hasE = false;
 	bool hasDot = false;
 	bool expHasSign = false;
@@ -6,7 +6,8 @@
 #include "FloatSpec.h"
 #include "MoveOrCopy.h"
 
-rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec(const MoveOrCopy<BigUBinFloat_t> &fMOC, const FloatSpec &floatSpec)
+template<bool TIsMove>
+rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec(const MoveOrCopy<BigUBinFloat_t, TIsMove> &fMOC, const FloatSpec &floatSpec)
 {
 	const BigUBinFloat_t &f = fMOC.Get();
 
@@ -43,9 +44,16 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec(const Move
 	}
 	else //if (roundingBitPosRelativeToLowBit > 0)
 	{
-		roundUp = true;
+		// Bits below the rounding bit are set, so this rounds up if the rounding bit is too
+		const size_t roundingBitFragment = static_cast<size_t>(roundingBitPosRelativeToLowBit) / BigUBinFloat_t::kDigitsPerFragment;
+		const size_t roundingBitOffsetInFragment = static_cast<size_t>(roundingBitPosRelativeToLowBit) % BigUBinFloat_t::kDigitsPerFragment;
+		roundUp = (((f.GetFragment(roundingBitFragment) >> roundingBitOffsetInFragment) & 1) != 0);
 	}
 
+	// A denormal that's half of the smallest one ties to zero
+	if (!roundUp && highBit < lastBit)
+		return BigUBinFloat_t();
+
 
 	BigUBinFloat_t::FragmentVector_t newFragments(f.GetAllocator());
 
@@ -104,3 +112,5 @@ rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec(const Move
 	return BigUBinFloat_t(newLowPos, significantDigits, rkci::Move(newFragments));
 }
 
+template rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec<false>(const MoveOrCopy<BigUBinFloat_t, false> &fMOC, const FloatSpec &floatSpec);
+template rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec<true>(const MoveOrCopy<BigUBinFloat_t, true> &fMOC, const FloatSpec &floatSpec);
@@ -8,7 +8,7 @@
 namespace rkci
 {
 	template<class T> class ResultRV;
-	template<class T> class MoveOrCopy;
+	template<class T, bool TIsMove> class MoveOrCopy;
 	class FloatSpec;
 
 	struct NumUtils
@@ -16,10 +16,26 @@ namespace rkci
 		template<class T>
 		static ResultRV<BigUFloat<T>> PositivePow(const BigUFloat<T> &f, uint32_t power);
 
-		static ResultRV<BigUBinFloat_t> RoundToFloatSpec(const MoveOrCopy<BigUBinFloat_t> &f, const FloatSpec &floatSpec);
+		static ResultRV<BigUBinFloat_t> RoundToFloatSpec(const BigUBinFloat_t &f, const FloatSpec &floatSpec);
+		static ResultRV<BigUBinFloat_t> RoundToFloatSpec(BigUBinFloat_t &&f, const FloatSpec &floatSpec);
+
+		template<bool TIsMove>
+		static ResultRV<BigUBinFloat_t> RoundToFloatSpec(const MoveOrCopy<BigUBinFloat_t, TIsMove> &f, const FloatSpec &floatSpec);
 	};
 }
 
+#include "MoveOrCopy.h"
+
+inline rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec(const BigUBinFloat_t &f, const FloatSpec &floatSpec)
+{
+	return RoundToFloatSpec(MoveOrCopy<BigUBinFloat_t, false>(f), floatSpec);
+}
+
+inline rkci::ResultRV<rkci::BigUBinFloat_t> rkci::NumUtils::RoundToFloatSpec(BigUBinFloat_t &&f, const FloatSpec &floatSpec)
+{
+	return RoundToFloatSpec(MoveOrCopy<BigUBinFloat_t, true>(static_cast<BigUBinFloat_t&&>(f)), floatSpec);
+}
+
 template<class T>
 rkci::ResultRV<rkci::BigUFloat<T>> rkci::NumUtils::PositivePow(const BigUFloat<T> &f, const uint32_t power)
 {
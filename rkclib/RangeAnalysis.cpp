@@ -0,0 +1,280 @@
+#include "RangeAnalysis.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+rkci::RangeAnalysis::RangeAnalysis(IAllocator *alloc)
+	: m_ranges(alloc)
+	, m_exactRanges(alloc)
+	, m_mayOverflow(alloc)
+	, m_isUnbounded(alloc)
+{
+}
+
+rkci::Result rkci::RangeAnalysis::Analyze(const Kernel::Function &function)
+{
+	RKC_CHECK(function.Validate());
+
+	const size_t numInstructions = function.NumInstructions();
+
+	{
+		AllocatorTagScope tagScope(*m_ranges.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_ranges.Resize(0));
+		RKC_CHECK(m_ranges.Resize(numInstructions));
+		RKC_CHECK(m_exactRanges.Resize(0));
+		RKC_CHECK(m_exactRanges.Resize(numInstructions));
+		RKC_CHECK(m_mayOverflow.Resize(0));
+		RKC_CHECK(m_mayOverflow.Resize(numInstructions));
+		RKC_CHECK(m_isUnbounded.Resize(0));
+		RKC_CHECK(m_isUnbounded.Resize(numInstructions));
+	}
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::Instruction &instr = function.GetInstruction(static_cast<Kernel::ValueIndex_t>(i));
+
+		if (instr.m_type == Kernel::kInvalidTypeIndex || function.GetType(instr.m_type).m_kind != Kernel::TypeKind::kInt)
+			continue;
+
+		const Kernel::Type &type = function.GetType(instr.m_type);
+
+		Range declaredRange;
+		declaredRange.m_min = type.m_minValue;
+		declaredRange.m_max = type.m_maxValue;
+
+		Range operandRanges[3];
+		const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+		for (size_t operandIndex = 0; operandIndex < numOperands; operandIndex++)
+			operandRanges[operandIndex] = m_ranges[instr.m_operands[operandIndex]];
+
+		Range range;
+		const RangeKind rangeKind = ComputeRange(function, instr, operandRanges, range);
+
+		m_ranges[i] = declaredRange;
+		m_exactRanges[i] = declaredRange;
+		m_mayOverflow[i] = 0;
+		m_isUnbounded[i] = 0;
+
+		if (rangeKind == RangeKind::kUnbounded)
+		{
+			m_mayOverflow[i] = 1;
+			m_isUnbounded[i] = 1;
+		}
+		else if (rangeKind == RangeKind::kExact)
+		{
+			m_exactRanges[i] = range;
+
+			if (range.m_min < declaredRange.m_min || range.m_max > declaredRange.m_max)
+				m_mayOverflow[i] = 1;
+			else
+				m_ranges[i] = range;
+		}
+	}
+
+	return Result::Ok();
+}
+
+const rkci::RangeAnalysis::Range &rkci::RangeAnalysis::GetRange(Kernel::ValueIndex_t value) const
+{
+	return m_ranges[value];
+}
+
+bool rkci::RangeAnalysis::MayOverflow(Kernel::ValueIndex_t value) const
+{
+	return m_mayOverflow[value] != 0;
+}
+
+bool rkci::RangeAnalysis::GetExactRange(Kernel::ValueIndex_t value, Range &outRange) const
+{
+	if (m_isUnbounded[value])
+		return false;
+
+	outRange = m_exactRanges[value];
+	return true;
+}
+
+// The computed range is exact, so it's outside of the declared range if the operation can overflow
+rkci::RangeAnalysis::RangeKind rkci::RangeAnalysis::ComputeRange(const Kernel::Function &function, const Kernel::Instruction &instr, const Range *operandRanges, Range &outRange)
+{
+	const Range &a = operandRanges[0];
+	const Range &b = operandRanges[1];
+
+	outRange.m_min = INT64_MIN;
+	outRange.m_max = INT64_MAX;
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kConstant:
+		outRange.m_min = static_cast<int64_t>(instr.m_immediate);
+		outRange.m_max = outRange.m_min;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kConvert:
+		// Float conversions can land anywhere
+		if (function.GetType(function.GetInstruction(instr.m_operands[0]).m_type).m_kind != Kernel::TypeKind::kInt)
+			return RangeKind::kUnbounded;
+
+		outRange = a;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kAdd:
+		if (!CheckedAdd(a.m_min, b.m_min, outRange.m_min) || !CheckedAdd(a.m_max, b.m_max, outRange.m_max))
+			return RangeKind::kUnbounded;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kSub:
+		if (!CheckedSub(a.m_min, b.m_max, outRange.m_min) || !CheckedSub(a.m_max, b.m_min, outRange.m_max))
+			return RangeKind::kUnbounded;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kMul:
+		{
+			// The extremes are at the corners
+			const int64_t corners[4][2] =
+			{
+				{ a.m_min, b.m_min },
+				{ a.m_min, b.m_max },
+				{ a.m_max, b.m_min },
+				{ a.m_max, b.m_max },
+			};
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				int64_t product = 0;
+				if (!CheckedMul(corners[i][0], corners[i][1], product))
+					return RangeKind::kUnbounded;
+
+				if (i == 0 || product < outRange.m_min)
+					outRange.m_min = product;
+				if (i == 0 || product > outRange.m_max)
+					outRange.m_max = product;
+			}
+		}
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kMin:
+		outRange.m_min = (a.m_min < b.m_min) ? a.m_min : b.m_min;
+		outRange.m_max = (a.m_max < b.m_max) ? a.m_max : b.m_max;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kMax:
+		outRange.m_min = (a.m_min > b.m_min) ? a.m_min : b.m_min;
+		outRange.m_max = (a.m_max > b.m_max) ? a.m_max : b.m_max;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kAnd:
+		// Anding with a non-negative value can only clear bits
+		if (a.m_min >= 0 || b.m_min >= 0)
+		{
+			outRange.m_min = 0;
+			outRange.m_max = INT64_MAX;
+			if (a.m_min >= 0)
+				outRange.m_max = a.m_max;
+			if (b.m_min >= 0 && b.m_max < outRange.m_max)
+				outRange.m_max = b.m_max;
+		}
+		else
+			outRange = BitwiseBounds(a, b);
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kOr:
+	case Kernel::Opcode::kXor:
+		outRange = BitwiseBounds(a, b);
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kNot:
+		outRange.m_min = ~a.m_max;
+		outRange.m_max = ~a.m_min;
+		return RangeKind::kExact;
+
+	case Kernel::Opcode::kSelect:
+		{
+			const Range &c = operandRanges[2];
+			outRange.m_min = (b.m_min < c.m_min) ? b.m_min : c.m_min;
+			outRange.m_max = (b.m_max > c.m_max) ? b.m_max : c.m_max;
+		}
+		return RangeKind::kExact;
+
+	default:
+		return RangeKind::kDeclared;
+	}
+}
+
+bool rkci::RangeAnalysis::CheckedAdd(int64_t a, int64_t b, int64_t &outResult)
+{
+	if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b))
+		return false;
+
+	outResult = a + b;
+	return true;
+}
+
+bool rkci::RangeAnalysis::CheckedSub(int64_t a, int64_t b, int64_t &outResult)
+{
+	if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b))
+		return false;
+
+	outResult = a - b;
+	return true;
+}
+
+bool rkci::RangeAnalysis::CheckedMul(int64_t a, int64_t b, int64_t &outResult)
+{
+	if (a == 0 || b == 0)
+	{
+		outResult = 0;
+		return true;
+	}
+
+	if ((a == -1 && b == INT64_MIN) || (b == -1 && a == INT64_MIN))
+		return false;
+
+	const int64_t product = static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+	if (product / b != a)
+		return false;
+
+	outResult = product;
+	return true;
+}
+
+// Bitwise results of values that fit in n-bit two's complement also fit in n bits, and every value fits
+// in 64
+rkci::RangeAnalysis::Range rkci::RangeAnalysis::BitwiseBounds(const Range &a, const Range &b)
+{
+	const int64_t values[4] = { a.m_min, a.m_max, b.m_min, b.m_max };
+
+	uint8_t bits = 1;
+	for (size_t i = 0; i < 4; i++)
+	{
+		// Counts the bits of the magnitude, with negative values counted as their complement
+		uint64_t magnitude = static_cast<uint64_t>((values[i] < 0) ? ~values[i] : values[i]);
+		uint8_t valueBits = 1;
+		while (magnitude != 0)
+		{
+			magnitude >>= 1;
+			valueBits++;
+		}
+
+		if (valueBits > bits)
+			bits = valueBits;
+	}
+
+	Range range;
+	if (bits >= 64)
+	{
+		range.m_min = INT64_MIN;
+		range.m_max = INT64_MAX;
+	}
+	else if (a.m_min >= 0 && b.m_min >= 0)
+	{
+		range.m_min = 0;
+		range.m_max = (static_cast<int64_t>(1) << (bits - 1)) - 1;
+	}
+	else
+	{
+		range.m_min = -(static_cast<int64_t>(1) << (bits - 1));
+		range.m_max = (static_cast<int64_t>(1) << (bits - 1)) - 1;
+	}
+
+	return range;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Vector.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	class Result;
+
+	// Value-range propagation over a kernel's integer values.
+	//
+	// Values that come from outside of the computation (parameters, loads, lane indexes and variables)
+	// have their declared intspec range, and every operation's range is computed exactly from its
+	// operands' ranges.  An operation whose exact range doesn't fit in its declared type may overflow.
+	// Otherwise its range is usually narrower than the declared one, and the backend can hold it in a
+	// narrower lane.
+	class RangeAnalysis
+	{
+	public:
+		struct Range
+		{
+			int64_t m_min;
+			int64_t m_max;
+		};
+
+		explicit RangeAnalysis(IAllocator *alloc);
+
+		Result Analyze(const Kernel::Function &function);
+
+		// Only meaningful for integer values.  A value that may overflow has its declared range.
+		const Range &GetRange(Kernel::ValueIndex_t value) const;
+		bool MayOverflow(Kernel::ValueIndex_t value) const;
+
+		// Gets the range of an operation's result before it's checked against its declared range.
+		// Returns false if the result can land outside of 64 bits, or anywhere at all for conversions
+		// from floats.
+		bool GetExactRange(Kernel::ValueIndex_t value, Range &outRange) const;
+
+		// 64-bit arithmetic that returns false instead of overflowing
+		static bool CheckedAdd(int64_t a, int64_t b, int64_t &outResult);
+		static bool CheckedSub(int64_t a, int64_t b, int64_t &outResult);
+		static bool CheckedMul(int64_t a, int64_t b, int64_t &outResult);
+
+	private:
+		enum class RangeKind
+		{
+			kDeclared,
+			kExact,
+			kUnbounded,
+		};
+
+		static RangeKind ComputeRange(const Kernel::Function &function, const Kernel::Instruction &instr, const Range *operandRanges, Range &outRange);
+
+		static Range BitwiseBounds(const Range &a, const Range &b);
+
+		Vector<Range> m_ranges;
+		Vector<Range> m_exactRanges;
+		Vector<uint8_t> m_mayOverflow;
+		Vector<uint8_t> m_isUnbounded;
+	};
+}
@@ -0,0 +1,329 @@
+#include "ReadAheadStream.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+#include <string.h>
+
+rkci::ReadAheadPool::ReadAheadPool(size_t maxThreads)
+	: m_firstQueued(nullptr)
+	, m_lastQueued(nullptr)
+	, m_stopRequested(false)
+	, m_maxThreads(maxThreads == 0 ? kDefaultMaxThreads : (maxThreads < kMaxThreads ? maxThreads : kMaxThreads))
+	, m_numStreams(0)
+	, m_numThreads(0)
+{
+}
+
+rkci::ReadAheadPool::~ReadAheadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		RKC_ASSERT(m_firstQueued == nullptr);
+		RKC_ASSERT(m_numStreams == 0);
+		m_stopRequested = true;
+	}
+
+	m_streamQueued.notify_all();
+
+	for (size_t i = 0; i < m_numThreads; i++)
+		m_threads[i].join();
+}
+
+size_t rkci::ReadAheadPool::GetMaxThreads() const
+{
+	return m_maxThreads;
+}
+
+void rkci::ReadAheadPool::AddStream()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_numStreams++;
+
+	// Threads are kept once started, so a pool that has warmed up doesn't start threads again
+	if (m_numThreads < m_numStreams && m_numThreads < m_maxThreads)
+	{
+		m_threads[m_numThreads] = std::thread(&ReadAheadPool::FillBuffers, this);
+		m_numThreads++;
+	}
+}
+
+void rkci::ReadAheadPool::RemoveStream()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	RKC_ASSERT(m_numStreams > 0);
+	m_numStreams--;
+}
+
+void rkci::ReadAheadPool::FillBuffers()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (;;)
+	{
+		while (m_firstQueued == nullptr && !m_stopRequested)
+			m_streamQueued.wait(lock);
+
+		if (m_stopRequested)
+			return;
+
+		ReadAheadStream &stream = *m_firstQueued;
+		UnqueueStream(stream);
+		stream.m_isBeingFilled = true;
+
+		lock.unlock();
+		const size_t size = stream.FillBuffer();
+		lock.lock();
+
+		ReadAheadStream::Buffer &buffer = stream.m_buffers[stream.m_fillBuffer];
+		buffer.m_size = size;
+		buffer.m_isFilled = true;
+
+		stream.m_fillBuffer = (stream.m_fillBuffer + 1) % ReadAheadStream::kNumBuffers;
+		stream.m_isBeingFilled = false;
+		stream.m_isAtEnd = (size == 0);
+
+		// Going to the back of the queue lets other streams fill a buffer in between
+		if (!stream.m_isAtEnd && !stream.m_stopRequested && !stream.m_buffers[stream.m_fillBuffer].m_isFilled)
+			QueueStream(stream);
+
+		m_bufferFilled.notify_all();
+	}
+}
+
+void rkci::ReadAheadPool::QueueStream(ReadAheadStream &stream)
+{
+	RKC_ASSERT(!stream.m_isQueued);
+
+	stream.m_isQueued = true;
+	stream.m_nextQueued = nullptr;
+
+	if (m_lastQueued)
+		m_lastQueued->m_nextQueued = &stream;
+	else
+		m_firstQueued = &stream;
+
+	m_lastQueued = &stream;
+}
+
+void rkci::ReadAheadPool::UnqueueStream(ReadAheadStream &stream)
+{
+	RKC_ASSERT(stream.m_isQueued);
+
+	ReadAheadStream *prev = nullptr;
+	ReadAheadStream *current = m_firstQueued;
+	while (current != &stream)
+	{
+		prev = current;
+		current = current->m_nextQueued;
+	}
+
+	if (prev)
+		prev->m_nextQueued = stream.m_nextQueued;
+	else
+		m_firstQueued = stream.m_nextQueued;
+
+	if (m_lastQueued == &stream)
+		m_lastQueued = prev;
+
+	stream.m_isQueued = false;
+	stream.m_nextQueued = nullptr;
+}
+
+rkci::ReadAheadStream::ReadAheadStream(IStream &baseStream, ReadAheadPool &pool, IAllocator *alloc, size_t bufferSize)
+	: m_baseStream(baseStream)
+	, m_pool(pool)
+	, m_alloc(alloc)
+	, m_bufferSize(bufferSize)
+	, m_readBuffer(0)
+	, m_readOffset(0)
+	, m_haveReadBuffer(false)
+	, m_position(0)
+	, m_isStarted(false)
+	, m_fillBuffer(0)
+	, m_isQueued(false)
+	, m_isBeingFilled(false)
+	, m_isAtEnd(false)
+	, m_stopRequested(false)
+	, m_nextQueued(nullptr)
+{
+	for (size_t i = 0; i < kNumBuffers; i++)
+	{
+		m_buffers[i].m_bytes = nullptr;
+		m_buffers[i].m_size = 0;
+		m_buffers[i].m_isFilled = false;
+	}
+}
+
+rkci::ReadAheadStream::~ReadAheadStream()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+		m_stopRequested = true;
+
+		if (m_isQueued)
+			m_pool.UnqueueStream(*this);
+
+		while (m_isBeingFilled)
+			m_pool.m_bufferFilled.wait(lock);
+	}
+
+	if (m_isStarted)
+		m_pool.RemoveStream();
+
+	for (size_t i = 0; i < kNumBuffers; i++)
+	{
+		if (m_buffers[i].m_bytes)
+			m_alloc->Release(m_buffers[i].m_bytes);
+	}
+}
+
+rkci::Result rkci::ReadAheadStream::Start()
+{
+	RKC_ASSERT(m_buffers[0].m_bytes == nullptr);
+
+	if (m_bufferSize == 0)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	AllocatorTagScope tagScope(*m_alloc, rkc::AllocatorTags::kLexer);
+
+	for (size_t i = 0; i < kNumBuffers; i++)
+	{
+		m_buffers[i].m_bytes = static_cast<uint8_t*>(m_alloc->Alloc(m_bufferSize));
+		if (!m_buffers[i].m_bytes)
+			return rkc::ResultCodes::kOutOfMemory;
+	}
+
+	m_pool.AddStream();
+	m_isStarted = true;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+		m_pool.QueueStream(*this);
+	}
+
+	m_pool.m_streamQueued.notify_one();
+
+	return Result::Ok();
+}
+
+size_t rkci::ReadAheadStream::Read(void *buf, size_t size)
+{
+	uint8_t *outBytes = static_cast<uint8_t*>(buf);
+	size_t numRead = 0;
+
+	while (numRead < size)
+	{
+		if (!m_haveReadBuffer)
+			AcquireReadBuffer();
+
+		const Buffer &buffer = m_buffers[m_readBuffer];
+		if (buffer.m_size == 0)
+			break;
+
+		size_t numToCopy = buffer.m_size - m_readOffset;
+		if (numToCopy > size - numRead)
+			numToCopy = size - numRead;
+
+		memcpy(outBytes + numRead, buffer.m_bytes + m_readOffset, numToCopy);
+		numRead += numToCopy;
+		m_readOffset += numToCopy;
+
+		if (m_readOffset == buffer.m_size)
+			ReleaseReadBuffer();
+	}
+
+	m_position += numRead;
+	return numRead;
+}
+
+size_t rkci::ReadAheadStream::Write(void *, size_t)
+{
+	return 0;
+}
+
+rkcUFilePos_t rkci::ReadAheadStream::Tell() const
+{
+	return m_position;
+}
+
+bool rkci::ReadAheadStream::SeekStart(rkcUFilePos_t)
+{
+	return false;
+}
+
+bool rkci::ReadAheadStream::SeekEnd(rkcFilePos_t)
+{
+	return false;
+}
+
+bool rkci::ReadAheadStream::SeekCurrent(rkcFilePos_t)
+{
+	return false;
+}
+
+bool rkci::ReadAheadStream::IsReadable() const
+{
+	return m_baseStream.IsReadable();
+}
+
+bool rkci::ReadAheadStream::IsWritable() const
+{
+	return false;
+}
+
+void rkci::ReadAheadStream::Close()
+{
+}
+
+size_t rkci::ReadAheadStream::FillBuffer()
+{
+	uint8_t *bytes = m_buffers[m_fillBuffer].m_bytes;
+
+	// Short reads don't mean the end of the stream, only a read of 0 bytes does
+	size_t size = 0;
+	while (size < m_bufferSize)
+	{
+		const size_t numRead = m_baseStream.Read(bytes + size, m_bufferSize - size);
+		if (numRead == 0)
+			break;
+
+		size += numRead;
+	}
+
+	return size;
+}
+
+void rkci::ReadAheadStream::AcquireReadBuffer()
+{
+	std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+	while (!m_buffers[m_readBuffer].m_isFilled)
+		m_pool.m_bufferFilled.wait(lock);
+
+	m_haveReadBuffer = true;
+	m_readOffset = 0;
+}
+
+void rkci::ReadAheadStream::ReleaseReadBuffer()
+{
+	bool queued = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+		m_buffers[m_readBuffer].m_isFilled = false;
+
+		// The pool stops filling a stream when both of its buffers are full
+		if (!m_isQueued && !m_isBeingFilled && !m_isAtEnd)
+		{
+			m_pool.QueueStream(*this);
+			queued = true;
+		}
+	}
+
+	if (queued)
+		m_pool.m_streamQueued.notify_one();
+
+	m_readBuffer = (m_readBuffer + 1) % kNumBuffers;
+	m_haveReadBuffer = false;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "IStream.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace rkci
+{
+	struct IAllocator;
+	class ReadAheadStream;
+	class Result;
+
+	// Background threads that fill the buffers of every read-ahead stream using them.  Owned by a context and
+	// grown as streams start, up to one thread per stream reading ahead at the same time and no more than
+	// the pool's thread limit, so that several slow reads can be in flight without starting a thread per
+	// module.  Streams needing a buffer filled are served in turn, one buffer at a time, and a stream only
+	// has one fill in flight at once since its base stream is read in order.
+	class ReadAheadPool
+	{
+	public:
+		static const size_t kMaxThreads = 16;
+		static const size_t kDefaultMaxThreads = 4;
+
+		// maxThreads is clamped to kMaxThreads, and 0 selects kDefaultMaxThreads
+		explicit ReadAheadPool(size_t maxThreads);
+		~ReadAheadPool();
+
+		size_t GetMaxThreads() const;
+
+	private:
+		friend class ReadAheadStream;
+
+		ReadAheadPool(const ReadAheadPool &other) = delete;
+		ReadAheadPool &operator=(const ReadAheadPool &other) = delete;
+
+		// Counts a stream as reading ahead and starts another thread if there are fewer threads than streams
+		void AddStream();
+		void RemoveStream();
+		void FillBuffers();
+
+		// Must be called with the mutex held
+		void QueueStream(ReadAheadStream &stream);
+		void UnqueueStream(ReadAheadStream &stream);
+
+		// Guards the queue and the buffer states of every stream using the pool
+		std::mutex m_mutex;
+		std::condition_variable m_streamQueued;
+		std::condition_variable m_bufferFilled;
+
+		ReadAheadStream *m_firstQueued;
+		ReadAheadStream *m_lastQueued;
+		bool m_stopRequested;
+
+		size_t m_maxThreads;
+		size_t m_numStreams;
+		size_t m_numThreads;
+		std::thread m_threads[kMaxThreads];
+	};
+
+	// Read-only stream that reads ahead from another stream on a read-ahead pool.  While the reader
+	// consumes one buffer, a pool thread fills the next one, so reads from slow storage overlap with lexing
+	// instead of stalling it.  The base stream must not be used by anything else until this is destroyed,
+	// and seeking isn't supported.
+	class ReadAheadStream final : public IStream
+	{
+	public:
+		static const size_t kNumBuffers = 2;
+
+		ReadAheadStream(IStream &baseStream, ReadAheadPool &pool, IAllocator *alloc, size_t bufferSize);
+		~ReadAheadStream();
+
+		// Allocates the buffers and starts reading
+		Result Start();
+
+		size_t Read(void *buf, size_t size) override;
+		size_t Write(void *buf, size_t size) override;
+		rkcUFilePos_t Tell() const override;
+		bool SeekStart(rkcUFilePos_t pos) override;
+		bool SeekEnd(rkcFilePos_t pos) override;
+		bool SeekCurrent(rkcFilePos_t pos) override;
+		bool IsReadable() const override;
+		bool IsWritable() const override;
+		void Close() override;
+
+	private:
+		friend class ReadAheadPool;
+
+		ReadAheadStream(const ReadAheadStream &other) = delete;
+		ReadAheadStream &operator=(const ReadAheadStream &other) = delete;
+
+		// A filled buffer with no bytes marks the end of the base stream
+		struct Buffer
+		{
+			uint8_t *m_bytes;
+			size_t m_size;
+			bool m_isFilled;
+		};
+
+		// Called by a pool thread without the mutex held.  Only touches the buffer being filled,
+		// which the reader doesn't use until it is marked as filled.
+		size_t FillBuffer();
+
+		void AcquireReadBuffer();
+		void ReleaseReadBuffer();
+
+		IStream &m_baseStream;
+		ReadAheadPool &m_pool;
+		IAllocator *m_alloc;
+		size_t m_bufferSize;
+
+		Buffer m_buffers[kNumBuffers];
+
+		// Reader state, only touched by the reading thread
+		size_t m_readBuffer;
+		size_t m_readOffset;
+		bool m_haveReadBuffer;
+		rkcUFilePos_t m_position;
+		bool m_isStarted;
+
+		// Fill state, guarded by the pool's mutex
+		size_t m_fillBuffer;
+		bool m_isQueued;
+		bool m_isBeingFilled;
+		bool m_isAtEnd;
+		bool m_stopRequested;
+		ReadAheadStream *m_nextQueued;
+	};
+}
@@ -2,6 +2,11 @@
 
 #include <assert.h>
 
+#if !RKC_IS_DEBUG
+RKC_STATIC_ASSERT(std::is_trivially_copyable<rkci::Result>::value);
+RKC_STATIC_ASSERT(std::is_trivially_copyable<rkci::ResultRV<uint32_t>>::value);
+#endif
+
 #if RKC_IS_DEBUG
 
 void rkci::Result::Unhandled()
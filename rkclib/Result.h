@@ -2,24 +2,43 @@
 
 #include "CoreDefs.h"
 #include "ResultCode.h"
+#include "Nothing.h"
+
+#include <new>
 
 namespace rkci
 {
+	template<class T> class ResultRV;
+
 	class RKC_TYPE_NODISCARD Result
 	{
 	public:
+		template<class T> friend class ResultRV;
+
 		Result(rkc::ResultCode_t resultCode);
+#if RKC_IS_DEBUG
 		Result(Result&& other) noexcept;
 		~Result();
+#else
+		// Trivial in release so that results are returned in a register
+		Result(Result&& other) noexcept = default;
+		~Result() = default;
+#endif
 
 		static Result Ok();
 
+		// Returns an error that was already reported, such as a stored sticky error, without reporting it again
+		static Result Propagate(rkc::ResultCode_t resultCode);
+
 		bool IsOK() const;
 		rkc::ResultCode_t GetCode() const;
 		void Handle();
 
 	private:
+		struct PropagateTag {};
+
 		Result();
+		Result(rkc::ResultCode_t resultCode, const PropagateTag &);
 		Result(const Result& other) = delete;
 		rkc::ResultCode_t m_resultCode;
 #if RKC_IS_DEBUG
@@ -27,61 +46,118 @@ namespace rkci
 
 		static void Unhandled();
 		static void AlreadyHandled();
-#	if RKC_IS_DEBUG
 		static void OnError();
-#	endif
 #endif
 	};
 
+	namespace ResultInternal
+	{
+		// In release builds, return values that are trivial to copy and destroy are stored with no destructor
+		// or move logic, so the ResultRV itself is trivially copyable and can be returned in registers.
+		template<class T>
+		class IsTrivialReturnValue
+		{
+		public:
+			static const bool kValue = !RKC_IS_DEBUG && std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value;
+		};
+
+		template<class T, bool TIsTrivial>
+		class ResultRVStorage
+		{
+		};
+
+		template<class T>
+		class ResultRVStorage<T, true>
+		{
+		protected:
+			explicit ResultRVStorage(const T &rv);
+			explicit ResultRVStorage(T &&rv);
+			explicit ResultRVStorage(rkc::ResultCode_t resultCode);
+
+			union ReturnValueUnion
+			{
+				Nothing m_nothing;
+				T m_returnValue;
+
+				ReturnValueUnion();
+				explicit ReturnValueUnion(const T &returnValue);
+				explicit ReturnValueUnion(T &&returnValue);
+			};
+
+			ReturnValueUnion m_u;
+			rkc::ResultCode_t m_resultCode;
+		};
+
+		template<class T>
+		class ResultRVStorage<T, false>
+		{
+		protected:
+			explicit ResultRVStorage(const T &rv);
+			explicit ResultRVStorage(T &&rv);
+			explicit ResultRVStorage(rkc::ResultCode_t resultCode);
+			ResultRVStorage(ResultRVStorage<T, false> &&other);
+			~ResultRVStorage();
+
+			union ReturnValueUnion
+			{
+				Nothing m_nothing;
+				T m_returnValue;
+
+				ReturnValueUnion();
+				explicit ReturnValueUnion(const T &returnValue);
+				explicit ReturnValueUnion(T &&returnValue);
+				~ReturnValueUnion();
+			};
+
+			ReturnValueUnion m_u;
+			rkc::ResultCode_t m_resultCode;
+#if RKC_IS_DEBUG
+			bool m_isHandled;
+#endif
+
+		private:
+			ResultRVStorage(const ResultRVStorage<T, false> &other) = delete;
+		};
+	}
+
 	template<class T>
-	class ResultRV
+	class RKC_TYPE_NODISCARD ResultRV final : public ResultInternal::ResultRVStorage<T, ResultInternal::IsTrivialReturnValue<T>::kValue>
 	{
 	public:
 		ResultRV(T &&rv);
 		ResultRV(const T &rv);
 		ResultRV(rkc::ResultCode_t resultCode);
 		ResultRV(Result &&result);
-		ResultRV(ResultRV<T> &&result);
-		~ResultRV();
+		ResultRV(ResultRV<T> &&result) = default;
 
 		bool IsOK() const;
 		void Handle();
 
-		Result &GetResult();
-		const Result &GetResult() const;
+		rkc::ResultCode_t GetCode() const;
+
+		// Returns the error as a Result for propagation to the caller
+		Result TakeResult();
+
+		// Handles this result and returns its code as a Result, discarding the return value.  Used to check
+		// calls whose return value isn't needed.
+		Result DiscardValue();
 
 		T &Get();
 		const T &Get() const;
 
 	private:
-		ResultRV(const ResultRV &other) = delete;
-
-		union ResultOrReturnValueUnion
-		{
-			Result m_result;
-			T m_returnValue;
+		typedef ResultInternal::ResultRVStorage<T, ResultInternal::IsTrivialReturnValue<T>::kValue> Storage_t;
 
-			explicit ResultOrReturnValueUnion(Result &&result);
-			explicit ResultOrReturnValueUnion(T &&returnValue);
-			explicit ResultOrReturnValueUnion(const T &returnValue);
-			~ResultOrReturnValueUnion();
-		};
-
-		ResultOrReturnValueUnion m_u;
-		bool m_hasRV;
-
-#if RKC_IS_DEBUG
-		bool m_isHandled;
-#endif
+		ResultRV(const ResultRV &other) = delete;
 	};
 }
 
-#define RKC_CHECK(n) do { ::rkci::Result rkc_check_##__LINE__(n); if (!rkc_check_##__LINE__.IsOK()) return rkc_check_##__LINE__; else rkc_check_##__LINE__.Handle(); } while(false)
+#define RKC_CHECK(n) do { ::rkci::Result rkc_check_##__LINE__(n); if (RKC_UNLIKELY(!rkc_check_##__LINE__.IsOK())) return rkc_check_##__LINE__; else rkc_check_##__LINE__.Handle(); } while(false)
 #define RKC_CHECK_RV(type, name, n)	\
 	::rkci::ResultRV<type> RKC_COMBINE_TOKENS2(rkc_check_, __LINE__)(n);\
 	RKC_COMBINE_TOKENS2(rkc_check_, __LINE__).Handle(); \
-	if (!RKC_COMBINE_TOKENS2(rkc_check_, __LINE__).IsOK())\
-		return ::rkci::Result(static_cast<::rkci::Result&&>(RKC_COMBINE_TOKENS2(rkc_check_, __LINE__).GetResult()));\
+	if (RKC_UNLIKELY(!RKC_COMBINE_TOKENS2(rkc_check_, __LINE__).IsOK()))\
+		return RKC_COMBINE_TOKENS2(rkc_check_, __LINE__).TakeResult();\
 	type name(static_cast<type&&>(RKC_COMBINE_TOKENS2(rkc_check_, __LINE__).Get()))
 
 namespace rkci
@@ -106,24 +182,29 @@ namespace rkci
 #endif
 	}
 
-	inline Result::Result(Result&& other) noexcept
-		: m_resultCode(other.m_resultCode)
+	// Used when an error that was already reported is passed up the stack
+	inline Result::Result(rkc::ResultCode_t resultCode, const PropagateTag &)
+		: m_resultCode(resultCode)
 #if RKC_IS_DEBUG
 		, m_isHandled(false)
 #endif
 	{
+	}
+
 #if RKC_IS_DEBUG
+	inline Result::Result(Result&& other) noexcept
+		: m_resultCode(other.m_resultCode)
+		, m_isHandled(false)
+	{
 		other.Handle();
-#endif
 	}
 
 	inline Result::~Result()
 	{
-#if RKC_IS_DEBUG
 		if (!m_isHandled)
 			this->Unhandled();
-#endif
 	}
+#endif
 
 	inline bool Result::IsOK() const
 	{
@@ -140,6 +221,11 @@ namespace rkci
 		return Result(::rkc::ResultCodes::kOK);
 	}
 
+	inline Result Result::Propagate(rkc::ResultCode_t resultCode)
+	{
+		return Result(resultCode, PropagateTag());
+	}
+
 	inline void rkci::Result::Handle()
 	{
 #if RKC_IS_DEBUG
@@ -150,20 +236,51 @@ namespace rkci
 #endif
 	}
 
+	// Trivial storage
 	template<class T>
-	ResultRV<T>::ResultRV(const T &rv)
+	ResultInternal::ResultRVStorage<T, true>::ResultRVStorage(const T &rv)
 		: m_u(rv)
-		, m_hasRV(true)
-#if RKC_IS_DEBUG
-		, m_isHandled(false)
-#endif
+		, m_resultCode(rkc::ResultCodes::kOK)
 	{
 	}
 
 	template<class T>
-	ResultRV<T>::ResultRV(T &&rv)
+	ResultInternal::ResultRVStorage<T, true>::ResultRVStorage(T &&rv)
 		: m_u(static_cast<T&&>(rv))
-		, m_hasRV(true)
+		, m_resultCode(rkc::ResultCodes::kOK)
+	{
+	}
+
+	template<class T>
+	ResultInternal::ResultRVStorage<T, true>::ResultRVStorage(rkc::ResultCode_t resultCode)
+		: m_u()
+		, m_resultCode(resultCode)
+	{
+	}
+
+	template<class T>
+	ResultInternal::ResultRVStorage<T, true>::ReturnValueUnion::ReturnValueUnion()
+		: m_nothing()
+	{
+	}
+
+	template<class T>
+	ResultInternal::ResultRVStorage<T, true>::ReturnValueUnion::ReturnValueUnion(const T &returnValue)
+		: m_returnValue(returnValue)
+	{
+	}
+
+	template<class T>
+	ResultInternal::ResultRVStorage<T, true>::ReturnValueUnion::ReturnValueUnion(T &&returnValue)
+		: m_returnValue(static_cast<T&&>(returnValue))
+	{
+	}
+
+	// Non-trivial storage
+	template<class T>
+	ResultInternal::ResultRVStorage<T, false>::ResultRVStorage(const T &rv)
+		: m_u(rv)
+		, m_resultCode(rkc::ResultCodes::kOK)
 #if RKC_IS_DEBUG
 		, m_isHandled(false)
 #endif
@@ -171,115 +288,154 @@ namespace rkci
 	}
 
 	template<class T>
-	ResultRV<T>::ResultRV(rkc::ResultCode_t resultCode)
-		: m_u(Result(resultCode))
-		, m_hasRV(false)
+	ResultInternal::ResultRVStorage<T, false>::ResultRVStorage(T &&rv)
+		: m_u(static_cast<T&&>(rv))
+		, m_resultCode(rkc::ResultCodes::kOK)
 #if RKC_IS_DEBUG
 		, m_isHandled(false)
 #endif
 	{
-		RKC_ASSERT(resultCode != ::rkc::ResultCodes::kOK);
 	}
 
 	template<class T>
-	ResultRV<T>::ResultRV(Result &&result)
-		: m_u(static_cast<Result&&>(result))
-		, m_hasRV(false)
+	ResultInternal::ResultRVStorage<T, false>::ResultRVStorage(rkc::ResultCode_t resultCode)
+		: m_u()
+		, m_resultCode(resultCode)
 #if RKC_IS_DEBUG
 		, m_isHandled(false)
 #endif
 	{
-		RKC_ASSERT(result.GetCode() != ::rkc::ResultCodes::kOK);
 	}
 
 	template<class T>
-	ResultRV<T>::ResultRV(ResultRV<T> &&result)
-		: m_hasRV(result.m_hasRV)
+	ResultInternal::ResultRVStorage<T, false>::ResultRVStorage(ResultRVStorage<T, false> &&other)
+		: m_u()
+		, m_resultCode(other.m_resultCode)
 #if RKC_IS_DEBUG
-		, m_isHandled(result.m_isHandled)
+		, m_isHandled(other.m_isHandled)
 #endif
 	{
-		m_u.~ResultOrValueUnion();
-		if (result.m_hasRV)
-			new (&m_u) ResultOrReturnValueUnion(static_cast<T&&>(result.m_u.m_returnValue));
-		else
-			new (&m_u) ResultOrReturnValueUnion(static_cast<Result&&>(result.m_u.m_result));
+		if (m_resultCode == rkc::ResultCodes::kOK)
+			new (&m_u.m_returnValue) T(static_cast<T&&>(other.m_u.m_returnValue));
+
+#if RKC_IS_DEBUG
+		other.m_isHandled = true;
+#endif
 	}
 
 	template<class T>
-	ResultRV<T>::~ResultRV()
+	ResultInternal::ResultRVStorage<T, false>::~ResultRVStorage()
 	{
 #if RKC_IS_DEBUG
 		RKC_ASSERT(m_isHandled);
 #endif
 
-		if (m_hasRV)
+		if (m_resultCode == rkc::ResultCodes::kOK)
 			m_u.m_returnValue.~T();
-		else
-			m_u.m_result.~Result();
 	}
 
 	template<class T>
-	bool ResultRV<T>::IsOK() const
+	ResultInternal::ResultRVStorage<T, false>::ReturnValueUnion::ReturnValueUnion()
+		: m_nothing()
 	{
-		return m_hasRV;
 	}
 
 	template<class T>
-	void ResultRV<T>::Handle()
+	ResultInternal::ResultRVStorage<T, false>::ReturnValueUnion::ReturnValueUnion(const T &returnValue)
+		: m_returnValue(returnValue)
 	{
-		RKC_ASSERT(!m_isHandled);
-		m_isHandled = true;
 	}
 
 	template<class T>
-	Result &ResultRV<T>::GetResult()
+	ResultInternal::ResultRVStorage<T, false>::ReturnValueUnion::ReturnValueUnion(T &&returnValue)
+		: m_returnValue(static_cast<T&&>(returnValue))
 	{
-		RKC_ASSERT(!m_hasRV);
-		return m_u.m_result;
 	}
 
 	template<class T>
-	const Result &ResultRV<T>::GetResult() const
+	ResultInternal::ResultRVStorage<T, false>::ReturnValueUnion::~ReturnValueUnion()
 	{
-		RKC_ASSERT(!m_hasRV);
-		return m_u.m_result;
 	}
 
+	// ResultRV
 	template<class T>
-	T &ResultRV<T>::Get()
+	ResultRV<T>::ResultRV(const T &rv)
+		: Storage_t(rv)
 	{
-		RKC_ASSERT(m_hasRV);
-		return m_u.m_returnValue;
 	}
 
 	template<class T>
-	const T &ResultRV<T>::Get() const
+	ResultRV<T>::ResultRV(T &&rv)
+		: Storage_t(static_cast<T&&>(rv))
+	{
+	}
+
+	template<class T>
+	ResultRV<T>::ResultRV(rkc::ResultCode_t resultCode)
+		: Storage_t(resultCode)
 	{
-		RKC_ASSERT(m_hasRV);
-		return m_u.m_returnValue;
+		RKC_ASSERT(resultCode != ::rkc::ResultCodes::kOK);
+
+		// Report the error the same way a plain Result would
+		Result(resultCode).Handle();
 	}
 
 	template<class T>
-	ResultRV<T>::ResultOrReturnValueUnion::ResultOrReturnValueUnion(Result &&result)
-		: m_result(static_cast<Result&&>(result))
+	ResultRV<T>::ResultRV(Result &&result)
+		: Storage_t(result.GetCode())
 	{
+		RKC_ASSERT(result.GetCode() != ::rkc::ResultCodes::kOK);
+		result.Handle();
 	}
 
 	template<class T>
-	ResultRV<T>::ResultOrReturnValueUnion::ResultOrReturnValueUnion(const T &returnValue)
-		: m_returnValue(returnValue)
+	bool ResultRV<T>::IsOK() const
 	{
+		return this->m_resultCode == rkc::ResultCodes::kOK;
 	}
 
 	template<class T>
-	ResultRV<T>::ResultOrReturnValueUnion::ResultOrReturnValueUnion(T &&returnValue)
-		: m_returnValue(static_cast<T&&>(returnValue))
+	void ResultRV<T>::Handle()
 	{
+#if RKC_IS_DEBUG
+		RKC_ASSERT(!this->m_isHandled);
+		this->m_isHandled = true;
+#endif
 	}
 
 	template<class T>
-	ResultRV<T>::ResultOrReturnValueUnion::~ResultOrReturnValueUnion()
+	rkc::ResultCode_t ResultRV<T>::GetCode() const
+	{
+		return this->m_resultCode;
+	}
+
+	template<class T>
+	Result ResultRV<T>::TakeResult()
+	{
+		RKC_ASSERT(this->m_resultCode != rkc::ResultCodes::kOK);
+		return Result(this->m_resultCode, Result::PropagateTag());
+	}
+
+	template<class T>
+	Result ResultRV<T>::DiscardValue()
+	{
+		Handle();
+
+		// Errors were already reported when this result was created
+		return Result(this->m_resultCode, Result::PropagateTag());
+	}
+
+	template<class T>
+	T &ResultRV<T>::Get()
+	{
+		RKC_ASSERT(this->m_resultCode == rkc::ResultCodes::kOK);
+		return this->m_u.m_returnValue;
+	}
+
+	template<class T>
+	const T &ResultRV<T>::Get() const
 	{
+		RKC_ASSERT(this->m_resultCode == rkc::ResultCodes::kOK);
+		return this->m_u.m_returnValue;
 	}
 }
@@ -23,6 +23,13 @@ namespace rkc
 
 			kInternalError,
 			kNotYetImplemented,
+			kInvalidOperation,
+
+			kCompositeUnresolvedImport,
+			kCompositeImportCycle,
+			kCompositeImportFailed,
+
+			kIOError,
 		};
 	}
 
@@ -0,0 +1,759 @@
+#include "RkcComposite.h"
+#include "RkcContext.h"
+#include "RkcStream.h"
+#include "ArraySliceView.h"
+#include "ExportInterface.h"
+#include "HashingStream.h"
+#include "Hasher.h"
+#include "Lexer.h"
+#include "ModuleBlob.h"
+#include "ReadAheadStream.h"
+#include "Result.h"
+
+#include <new>
+#include <string.h>
+
+IRkcComposite::IRkcComposite(IRkcContext &context)
+	: m_context(context)
+	, m_modules(&context.GetAllocator())
+	, m_imports(&context.GetAllocator())
+	, m_dependentSlots(&context.GetAllocator())
+	, m_importSlots(&context.GetAllocator())
+	, m_dependentReleased(&context.GetAllocator())
+	, m_jobs(&context.GetAllocator())
+	, m_deferredModules(&context.GetAllocator())
+	, m_jobSystem(nullptr)
+	, m_monomorphCache(context.GetAllocator())
+	, m_numModulesRemaining(0)
+	, m_numDeferred(0)
+	, m_firstError(rkc::ResultCodes::kOK)
+	, m_numModulesCompiled(0)
+	, m_numModulesSkipped(0)
+{
+}
+
+rkci::ResultRV<size_t> IRkcComposite::AddProgram(const rkci::ArraySliceView<const uint8_t> &moduleName, const RkcStreamSpec &stream)
+{
+	RKC_CHECK_RV(rkci::SymbolID_t, name, m_context.GetSymbolPool().Intern(moduleName));
+
+	size_t existingIndex = 0;
+	if (FindModule(name, existingIndex))
+		return rkc::ResultCodes::kInvalidOperation;
+
+	Module module;
+	module.m_name = name;
+	module.m_stream = stream;
+	module.m_sourceHash = 0;
+	module.m_interfaceHash = 0;
+	module.m_importsInterfaceHash = 0;
+	module.m_hasCompiled = false;
+	module.m_isDirty = true;
+	module.m_streamConsumed = false;
+	module.m_firstDependentSlot = 0;
+	module.m_numDependents = 0;
+	module.m_firstImportSlot = 0;
+	module.m_numImports = 0;
+	module.m_numPendingImports = 0;
+	module.m_resultCode = rkc::ResultCodes::kOK;
+	module.m_importFailed = false;
+	module.m_wasCompiled = false;
+
+	RKC_CHECK(m_modules.Append(module));
+
+	return m_modules.Count() - 1;
+}
+
+rkci::Result IRkcComposite::AddImport(size_t importerIndex, const rkci::ArraySliceView<const uint8_t> &importedModuleName)
+{
+	if (importerIndex >= m_modules.Count())
+		return rkc::ResultCodes::kInvalidOperation;
+
+	RKC_CHECK_RV(rkci::SymbolID_t, name, m_context.GetSymbolPool().Intern(importedModuleName));
+
+	Import import;
+	import.m_importerIndex = importerIndex;
+	import.m_moduleName = name;
+
+	RKC_CHECK(m_imports.Append(import));
+
+	m_modules[importerIndex].m_isDirty = true;
+
+	return rkci::Result::Ok();
+}
+
+rkci::Result IRkcComposite::UpdateProgram(size_t moduleIndex, const RkcStreamSpec &stream)
+{
+	if (moduleIndex >= m_modules.Count())
+		return rkc::ResultCodes::kInvalidOperation;
+
+	Module &module = m_modules[moduleIndex];
+	module.m_stream = stream;
+	module.m_isDirty = true;
+	module.m_streamConsumed = false;
+
+	return rkci::Result::Ok();
+}
+
+size_t IRkcComposite::GetUnresolvedImports(RkcUnresolvedImport *outImports, size_t maxImports) const
+{
+	const rkci::SymbolPool &symbolPool = m_context.GetSymbolPool();
+
+	size_t numUnresolved = 0;
+	const size_t numImports = m_imports.Count();
+	for (size_t i = 0; i < numImports; i++)
+	{
+		const Import &import = m_imports[i];
+
+		size_t moduleIndex = 0;
+		if (FindModule(import.m_moduleName, moduleIndex))
+			continue;
+
+		if (numUnresolved < maxImports)
+		{
+			const rkci::ArraySliceView<const uint8_t> nameBytes = symbolPool.GetBytes(import.m_moduleName);
+
+			RkcUnresolvedImport &outImport = outImports[numUnresolved];
+			outImport.m_importerIndex = import.m_importerIndex;
+			outImport.m_name = nameBytes.Count() ? &nameBytes[0] : nullptr;
+			outImport.m_nameLength = nameBytes.Count();
+		}
+
+		numUnresolved++;
+	}
+
+	return numUnresolved;
+}
+
+rkci::Result IRkcComposite::Compile(const RkcJobSystem *jobSystem)
+{
+	m_context.BeginCompile();
+	m_jobSystem = jobSystem;
+
+	rkci::Result result(CompileModules());
+
+	m_jobSystem = nullptr;
+	m_context.EndCompile();
+
+	return result;
+}
+
+rkci::Result IRkcComposite::CompileModules()
+{
+	RKC_CHECK(BuildSchedule());
+
+	m_numModulesRemaining = m_modules.Count();
+	m_numDeferred = 0;
+	m_firstError = rkc::ResultCodes::kOK;
+	m_numModulesCompiled = 0;
+	m_numModulesSkipped = 0;
+
+	if (m_modules.Count() == 0)
+		return rkci::Result::Ok();
+
+	if (m_jobSystem)
+	{
+		RKC_CHECK(CompileParallel());
+	}
+	else
+	{
+		RKC_CHECK(CompileSerial());
+	}
+
+	if (m_firstError != rkc::ResultCodes::kOK)
+		return m_firstError;
+
+	return rkci::Result::Ok();
+}
+
+void IRkcComposite::GetCompileStats(RkcCompositeCompileStats &outStats) const
+{
+	outStats.m_numModulesCompiled = m_numModulesCompiled;
+	outStats.m_numModulesSkipped = m_numModulesSkipped;
+	outStats.m_numInstantiations = m_monomorphCache.NumInstances();
+	outStats.m_numInstantiationsReused = m_monomorphCache.GetNumReused();
+}
+
+rkci::Result IRkcComposite::ExportCompiledProgram(size_t moduleIndex, rkci::IStream &stream) const
+{
+	if (moduleIndex >= m_modules.Count())
+		return rkc::ResultCodes::kInvalidOperation;
+
+	const Module &module = m_modules[moduleIndex];
+	if (!module.m_hasCompiled || module.m_isDirty)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	rkci::ModuleBlobHeader header;
+	header.m_sourceHash = module.m_sourceHash;
+	header.m_optionsHash = ComputeOptionsHash();
+	header.m_interfaceHash = module.m_interfaceHash;
+	header.m_importsInterfaceHash = module.m_importsInterfaceHash;
+
+	return rkci::ModuleBlob::Write(stream, header);
+}
+
+rkci::ResultRV<bool> IRkcComposite::ImportCompiledProgram(size_t moduleIndex, rkci::IStream &stream)
+{
+	if (moduleIndex >= m_modules.Count())
+		return rkc::ResultCodes::kInvalidOperation;
+
+	rkci::ModuleBlobHeader header;
+	RKC_CHECK_RV(bool, isValidBlob, rkci::ModuleBlob::ReadHeader(stream, header));
+
+	if (!isValidBlob || header.m_optionsHash != ComputeOptionsHash())
+		return false;
+
+	// The source still has to be read to check that it's unchanged, but not lexed
+	Module &module = m_modules[moduleIndex];
+	RkcStream sourceStream(module.m_stream);
+
+	if (module.m_streamConsumed)
+	{
+		if (!sourceStream.SeekStart(0))
+			return rkc::ResultCodes::kInvalidOperation;
+	}
+
+	module.m_streamConsumed = true;
+
+	rkci::HashingStream hashingStream(sourceStream);
+
+	uint8_t buffer[4096];
+	while (hashingStream.Read(buffer, sizeof(buffer)) != 0)
+	{
+	}
+
+	if (hashingStream.GetHash() != header.m_sourceHash)
+		return false;
+
+	// The imports hash is checked against the imports' interfaces by the next compile, which recompiles
+	// the module if any of them changed
+	module.m_sourceHash = header.m_sourceHash;
+	module.m_interfaceHash = header.m_interfaceHash;
+	module.m_importsInterfaceHash = header.m_importsInterfaceHash;
+	module.m_hasCompiled = true;
+	module.m_isDirty = false;
+
+	return true;
+}
+
+rkci::MonomorphCache &IRkcComposite::GetMonomorphCache()
+{
+	return m_monomorphCache;
+}
+
+void IRkcComposite::Destroy()
+{
+	rkci::IAllocator &alloc = m_context.GetAllocator();
+
+	this->~IRkcComposite();
+	alloc.Release(this);
+}
+
+bool IRkcComposite::FindModule(rkci::SymbolID_t name, size_t &outIndex) const
+{
+	const size_t numModules = m_modules.Count();
+	for (size_t i = 0; i < numModules; i++)
+	{
+		if (m_modules[i].m_name == name)
+		{
+			outIndex = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+rkci::Result IRkcComposite::BuildSchedule()
+{
+	const size_t numModules = m_modules.Count();
+	const size_t numImports = m_imports.Count();
+
+	for (size_t i = 0; i < numModules; i++)
+	{
+		Module &module = m_modules[i];
+		module.m_firstDependentSlot = 0;
+		module.m_numDependents = 0;
+		module.m_firstImportSlot = 0;
+		module.m_numImports = 0;
+		module.m_numPendingImports = 0;
+		module.m_resultCode = rkc::ResultCodes::kOK;
+		module.m_importFailed = false;
+		module.m_wasCompiled = false;
+	}
+
+	// Count edges, then lay each module's dependents out contiguously
+	for (size_t i = 0; i < numImports; i++)
+	{
+		const Import &import = m_imports[i];
+
+		size_t importedIndex = 0;
+		if (!FindModule(import.m_moduleName, importedIndex))
+			return rkc::ResultCodes::kCompositeUnresolvedImport;
+
+		m_modules[importedIndex].m_numDependents++;
+		m_modules[import.m_importerIndex].m_numPendingImports++;
+	}
+
+	size_t nextSlot = 0;
+	size_t nextImportSlot = 0;
+	for (size_t i = 0; i < numModules; i++)
+	{
+		Module &module = m_modules[i];
+
+		module.m_firstDependentSlot = nextSlot;
+		nextSlot += module.m_numDependents;
+		module.m_numDependents = 0;
+
+		module.m_firstImportSlot = nextImportSlot;
+		nextImportSlot += module.m_numPendingImports;
+	}
+
+	RKC_CHECK(m_dependentSlots.ResizeNoConstruct(numImports));
+	RKC_CHECK(m_importSlots.ResizeNoConstruct(numImports));
+	RKC_CHECK(m_dependentReleased.ResizeNoConstruct(numImports));
+	if (numImports > 0)
+		memset(&m_dependentReleased[0], 0, numImports);
+
+	for (size_t i = 0; i < numImports; i++)
+	{
+		const Import &import = m_imports[i];
+
+		size_t importedIndex = 0;
+		FindModule(import.m_moduleName, importedIndex);
+
+		Module &imported = m_modules[importedIndex];
+		m_dependentSlots[imported.m_firstDependentSlot + imported.m_numDependents] = import.m_importerIndex;
+		imported.m_numDependents++;
+
+		// Import slots stay in the order the imports were added, which the imports hash depends on
+		Module &importer = m_modules[import.m_importerIndex];
+		m_importSlots[importer.m_firstImportSlot + importer.m_numImports] = importedIndex;
+		importer.m_numImports++;
+	}
+
+	// Reject cycles up front, since modules in a cycle would never become ready
+	rkci::Vector<size_t> pendingCounts(&m_context.GetAllocator());
+	rkci::Vector<size_t> readyQueue(&m_context.GetAllocator());
+	RKC_CHECK(pendingCounts.ResizeNoConstruct(numModules));
+	RKC_CHECK(readyQueue.Reserve(numModules));
+
+	for (size_t i = 0; i < numModules; i++)
+	{
+		pendingCounts[i] = m_modules[i].m_numPendingImports;
+		if (pendingCounts[i] == 0)
+		{
+			RKC_CHECK(readyQueue.Append(i));
+		}
+	}
+
+	for (size_t queuePos = 0; queuePos < readyQueue.Count(); queuePos++)
+	{
+		const Module &module = m_modules[readyQueue[queuePos]];
+		for (size_t i = 0; i < module.m_numDependents; i++)
+		{
+			const size_t dependentIndex = m_dependentSlots[module.m_firstDependentSlot + i];
+			if (--pendingCounts[dependentIndex] == 0)
+			{
+				RKC_CHECK(readyQueue.Append(dependentIndex));
+			}
+		}
+	}
+
+	if (readyQueue.Count() != numModules)
+		return rkc::ResultCodes::kCompositeImportCycle;
+
+	RKC_CHECK(m_jobs.ResizeNoConstruct(numModules));
+	for (size_t i = 0; i < numModules; i++)
+	{
+		m_jobs[i].m_composite = this;
+		m_jobs[i].m_moduleIndex = i;
+	}
+
+	// Each module is submitted once, so it can be deferred at most once
+	RKC_CHECK(m_deferredModules.ResizeNoConstruct(numModules));
+
+	return rkci::Result::Ok();
+}
+
+uint64_t IRkcComposite::ComputeImportsInterfaceHash(size_t moduleIndex) const
+{
+	const Module &module = m_modules[moduleIndex];
+
+	uint64_t hash = rkci::HashUtil::kStableHash64Seed;
+	for (size_t i = 0; i < module.m_numImports; i++)
+	{
+		const uint64_t interfaceHash = m_modules[m_importSlots[module.m_firstImportSlot + i]].m_interfaceHash;
+
+		uint8_t hashBytes[8];
+		for (int byteIndex = 0; byteIndex < 8; byteIndex++)
+			hashBytes[byteIndex] = static_cast<uint8_t>(interfaceHash >> (byteIndex * 8));
+
+		hash = rkci::HashUtil::ComputeStableHash64(hashBytes, sizeof(hashBytes), hash);
+	}
+
+	return hash;
+}
+
+uint64_t IRkcComposite::ComputeOptionsHash()
+{
+	// There are no target options yet, so every compile uses the same options
+	return rkci::HashUtil::kStableHash64Seed;
+}
+
+rkc::ResultCode_t IRkcComposite::RunModule(size_t moduleIndex)
+{
+	Module &module = m_modules[moduleIndex];
+
+	// Failed modules stay dirty so that they are retried by the next compile
+	if (module.m_importFailed)
+	{
+		module.m_isDirty = true;
+		return rkc::ResultCodes::kCompositeImportFailed;
+	}
+
+	// Every import has finished by now, so their interface hashes are final
+	const uint64_t importsInterfaceHash = ComputeImportsInterfaceHash(moduleIndex);
+
+	if (module.m_hasCompiled && !module.m_isDirty && module.m_importsInterfaceHash == importsInterfaceHash)
+		return rkc::ResultCodes::kOK;
+
+	uint64_t sourceHash = 0;
+	uint64_t interfaceHash = 0;
+
+	rkci::Result result(CompileModule(moduleIndex, sourceHash, interfaceHash));
+	result.Handle();
+
+	module.m_wasCompiled = true;
+
+	if (!result.IsOK())
+	{
+		module.m_isDirty = true;
+		return result.GetCode();
+	}
+
+	module.m_sourceHash = sourceHash;
+	module.m_interfaceHash = interfaceHash;
+	module.m_importsInterfaceHash = importsInterfaceHash;
+	module.m_hasCompiled = true;
+	module.m_isDirty = false;
+
+	return rkc::ResultCodes::kOK;
+}
+
+rkci::Result IRkcComposite::CompileModule(size_t moduleIndex, uint64_t &outSourceHash, uint64_t &outInterfaceHash)
+{
+	// Name resolution and lowering don't exist yet, so compiling a module currently means lexing it
+	Module &module = m_modules[moduleIndex];
+	RkcStream stream(module.m_stream);
+
+	// Importers are recompiled from the same stream when an import's interface changes
+	if (module.m_streamConsumed)
+	{
+		if (!stream.SeekStart(0))
+			return rkc::ResultCodes::kInvalidOperation;
+	}
+
+	module.m_streamConsumed = true;
+
+	rkci::IStream *sourceStream = &stream;
+
+	rkci::ReadAheadStream readAheadStream(stream, m_context.GetReadAheadPool(), &m_context.GetAllocator(), m_context.GetReadAheadBufferSize());
+	if (m_context.GetReadAheadBufferSize() > 0)
+	{
+		RKC_CHECK(readAheadStream.Start());
+		sourceStream = &readAheadStream;
+	}
+
+	rkci::HashingStream hashingStream(*sourceStream);
+	rkci::Lexer lexer(&hashingStream, &m_context.GetAllocator(), m_context.GetLexerBufferSize());
+	rkci::ExportInterfaceHasher interfaceHasher;
+
+	for (;;)
+	{
+		RKC_CHECK_RV(rkci::LexToken, lexToken, lexer.GetNextToken());
+
+		interfaceHasher.AddToken(lexToken);
+
+		if (lexToken.m_tokenType == rkci::LexTokenType::kEndOfFile)
+			break;
+	}
+
+	outSourceHash = hashingStream.GetHash();
+	outInterfaceHash = interfaceHasher.GetHash();
+
+	return rkci::Result::Ok();
+}
+
+void IRkcComposite::FinishModule(size_t moduleIndex, rkc::ResultCode_t resultCode)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Module &module = m_modules[moduleIndex];
+	module.m_resultCode = resultCode;
+
+	if (resultCode != rkc::ResultCodes::kOK && m_firstError == rkc::ResultCodes::kOK)
+		m_firstError = resultCode;
+
+	if (module.m_wasCompiled)
+		m_numModulesCompiled++;
+	else if (resultCode == rkc::ResultCodes::kOK)
+		m_numModulesSkipped++;
+
+	for (size_t i = 0; i < module.m_numDependents; i++)
+	{
+		const size_t slot = module.m_firstDependentSlot + i;
+		Module &dependent = m_modules[m_dependentSlots[slot]];
+
+		if (resultCode != rkc::ResultCodes::kOK)
+			dependent.m_importFailed = true;
+
+		if (--dependent.m_numPendingImports == 0)
+			m_dependentReleased[slot] = 1;
+	}
+}
+
+void IRkcComposite::RetireModule()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (--m_numModulesRemaining == 0)
+		m_compileStateChanged.notify_all();
+}
+
+bool IRkcComposite::RetireModuleAndTakeDeferred(size_t &outModuleIndex)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (--m_numModulesRemaining == 0)
+	{
+		m_compileStateChanged.notify_all();
+		return false;
+	}
+
+	if (m_numDeferred == 0)
+		return false;
+
+	outModuleIndex = m_deferredModules[--m_numDeferred];
+	return true;
+}
+
+void IRkcComposite::SubmitModule(size_t moduleIndex)
+{
+	if (m_jobSystem->m_submit(m_jobSystem->m_userdata, RunModuleJob, &m_jobs[moduleIndex]) != 0)
+		return;
+
+	// Running a refused job here would recurse once per module along an import chain, so it's queued
+	// for a thread that is between modules instead
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_deferredModules[m_numDeferred++] = moduleIndex;
+	m_compileStateChanged.notify_all();
+}
+
+void IRkcComposite::RunModuleAndSubmitDependents(size_t moduleIndex)
+{
+	do
+	{
+		FinishModule(moduleIndex, RunModule(moduleIndex));
+
+		const Module &module = m_modules[moduleIndex];
+		for (size_t i = 0; i < module.m_numDependents; i++)
+		{
+			const size_t slot = module.m_firstDependentSlot + i;
+			if (m_dependentReleased[slot])
+			{
+				const size_t dependentIndex = m_dependentSlots[slot];
+				SubmitModule(dependentIndex);
+			}
+		}
+
+		// Must be the last access to the composite unless another module was taken, since Compile may
+		// return as soon as every module is retired
+	} while (RetireModuleAndTakeDeferred(moduleIndex));
+}
+
+void IRkcComposite::RunModuleJob(void *jobData)
+{
+	const ModuleJob *job = static_cast<const ModuleJob*>(jobData);
+	job->m_composite->RunModuleAndSubmitDependents(job->m_moduleIndex);
+}
+
+rkci::Result IRkcComposite::CompileSerial()
+{
+	const size_t numModules = m_modules.Count();
+
+	rkci::Vector<size_t> readyQueue(&m_context.GetAllocator());
+	RKC_CHECK(readyQueue.Reserve(numModules));
+
+	for (size_t i = 0; i < numModules; i++)
+	{
+		if (m_modules[i].m_numPendingImports == 0)
+		{
+			RKC_CHECK(readyQueue.Append(i));
+		}
+	}
+
+	for (size_t queuePos = 0; queuePos < readyQueue.Count(); queuePos++)
+	{
+		const size_t moduleIndex = readyQueue[queuePos];
+
+		FinishModule(moduleIndex, RunModule(moduleIndex));
+
+		const Module &module = m_modules[moduleIndex];
+		for (size_t i = 0; i < module.m_numDependents; i++)
+		{
+			const size_t slot = module.m_firstDependentSlot + i;
+			if (m_dependentReleased[slot])
+			{
+				RKC_CHECK(readyQueue.Append(m_dependentSlots[slot]));
+			}
+		}
+
+		RetireModule();
+	}
+
+	return rkci::Result::Ok();
+}
+
+rkci::Result IRkcComposite::CompileParallel()
+{
+	const size_t numModules = m_modules.Count();
+
+	// Roots are collected before any are submitted, since a submitted job may finish and mark its
+	// dependents ready before the scan reaches them
+	rkci::Vector<size_t> roots(&m_context.GetAllocator());
+	for (size_t i = 0; i < numModules; i++)
+	{
+		if (m_modules[i].m_numPendingImports == 0)
+		{
+			RKC_CHECK(roots.Append(i));
+		}
+	}
+
+	const size_t numRoots = roots.Count();
+	for (size_t i = 0; i < numRoots; i++)
+		SubmitModule(roots[i]);
+
+	// Wait for every module, running any whose job was refused
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_numModulesRemaining != 0)
+	{
+		if (m_numDeferred == 0)
+		{
+			m_compileStateChanged.wait(lock);
+			continue;
+		}
+
+		const size_t moduleIndex = m_deferredModules[--m_numDeferred];
+
+		lock.unlock();
+		RunModuleAndSubmitDependents(moduleIndex);
+		lock.lock();
+	}
+
+	return rkci::Result::Ok();
+}
+
+int RkcCreateComposite(IRkcContext *context, IRkcComposite **outComposite)
+{
+	rkci::IAllocator &alloc = context->GetAllocator();
+
+	void *compositeMemory = alloc.Alloc(sizeof(IRkcComposite));
+	if (!compositeMemory)
+		return rkc::ResultCodes::kOutOfMemory;
+
+	*outComposite = new (compositeMemory) IRkcComposite(*context);
+	return rkc::ResultCodes::kOK;
+}
+
+void RkcDestroyComposite(IRkcComposite *composite)
+{
+	if (composite)
+		composite->Destroy();
+}
+
+int RkcCompositeAddProgram(IRkcComposite *composite, const char *moduleName, const RkcStreamSpec *stream, size_t *outModuleIndex)
+{
+	const rkci::ArraySliceView<const uint8_t> nameBytes(reinterpret_cast<const uint8_t*>(moduleName), strlen(moduleName));
+
+	rkci::ResultRV<size_t> result(composite->AddProgram(nameBytes, *stream));
+	if (!result.IsOK())
+	{
+		const int resultCode = result.GetCode();
+		result.Handle();
+		return resultCode;
+	}
+
+	*outModuleIndex = result.Get();
+	result.Handle();
+
+	return rkc::ResultCodes::kOK;
+}
+
+int RkcCompositeAddImport(IRkcComposite *composite, size_t importerIndex, const char *importedModuleName)
+{
+	const rkci::ArraySliceView<const uint8_t> nameBytes(reinterpret_cast<const uint8_t*>(importedModuleName), strlen(importedModuleName));
+
+	rkci::Result result(composite->AddImport(importerIndex, nameBytes));
+	result.Handle();
+
+	return result.GetCode();
+}
+
+int RkcCompositeUpdateProgram(IRkcComposite *composite, size_t moduleIndex, const RkcStreamSpec *stream)
+{
+	rkci::Result result(composite->UpdateProgram(moduleIndex, *stream));
+	result.Handle();
+
+	return result.GetCode();
+}
+
+int RkcCompositeGetUnresolvedImports(const IRkcComposite *composite, RkcUnresolvedImport *outImports, size_t *inOutCount)
+{
+	const size_t maxImports = outImports ? *inOutCount : 0;
+
+	*inOutCount = composite->GetUnresolvedImports(outImports, maxImports);
+	return rkc::ResultCodes::kOK;
+}
+
+int RkcCompositeCompile(IRkcComposite *composite, const RkcJobSystem *jobSystem)
+{
+	rkci::Result result(composite->Compile(jobSystem));
+	result.Handle();
+
+	return result.GetCode();
+}
+
+int RkcCompositeGetCompileStats(const IRkcComposite *composite, RkcCompositeCompileStats *outStats)
+{
+	composite->GetCompileStats(*outStats);
+	return rkc::ResultCodes::kOK;
+}
+
+int RkcCompiledProgramExport(const IRkcComposite *composite, size_t moduleIndex, const RkcStreamSpec *outStream)
+{
+	RkcStream stream(*outStream);
+
+	rkci::Result result(composite->ExportCompiledProgram(moduleIndex, stream));
+	result.Handle();
+
+	return result.GetCode();
+}
+
+int RkcCompositeImportCompiledProgram(IRkcComposite *composite, size_t moduleIndex, const RkcStreamSpec *inStream, int *outAccepted)
+{
+	RkcStream stream(*inStream);
+
+	rkci::ResultRV<bool> result(composite->ImportCompiledProgram(moduleIndex, stream));
+	if (!result.IsOK())
+	{
+		const int resultCode = result.GetCode();
+		result.Handle();
+		return resultCode;
+	}
+
+	*outAccepted = result.Get() ? 1 : 0;
+	result.Handle();
+
+	return rkc::ResultCodes::kOK;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "rkclib.h"
+#include "IStream.h"
+#include "MonomorphCache.h"
+#include "SymbolPool.h"
+#include "Vector.h"
+
+#include <condition_variable>
+#include <mutex>
+
+struct IRkcContext;
+
+// A graph of modules connected by imports.  Compile schedules one job per module, and a module's job
+// is submitted as soon as the last of its imports has finished, so independent modules run
+// concurrently on the host's job system.
+//
+// Composites are incremental: a module is only recompiled if its source was replaced or the export
+// interface hash of one of its imports changed since the last compile.  Compiled modules can be
+// exported to blobs and imported into another composite, so unchanged modules are also skipped
+// across processes.
+struct IRkcComposite
+{
+public:
+	explicit IRkcComposite(IRkcContext &context);
+
+	rkci::ResultRV<size_t> AddProgram(const rkci::ArraySliceView<const uint8_t> &moduleName, const RkcStreamSpec &stream);
+	rkci::Result AddImport(size_t importerIndex, const rkci::ArraySliceView<const uint8_t> &importedModuleName);
+
+	// Replaces a module's source, marking it for recompilation
+	rkci::Result UpdateProgram(size_t moduleIndex, const RkcStreamSpec &stream);
+
+	// Returns the total number of unresolved imports, and writes up to maxImports of them to outImports
+	size_t GetUnresolvedImports(RkcUnresolvedImport *outImports, size_t maxImports) const;
+
+	rkci::Result Compile(const RkcJobSystem *jobSystem);
+	void GetCompileStats(RkcCompositeCompileStats &outStats) const;
+
+	// Writes a module compiled by the last Compile to a module blob
+	rkci::Result ExportCompiledProgram(size_t moduleIndex, rkci::IStream &stream) const;
+
+	// Marks a module as compiled from a module blob.  Returns false if the blob is stale or was written
+	// by a different compiler, in which case the module is compiled normally.  The module's imports must
+	// already be added.
+	rkci::ResultRV<bool> ImportCompiledProgram(size_t moduleIndex, rkci::IStream &stream);
+
+	// Instantiations of generic functions, shared by every module so that each one is built once
+	rkci::MonomorphCache &GetMonomorphCache();
+
+	// Releases the composite's own memory through the context's allocator
+	void Destroy();
+
+private:
+	struct Import
+	{
+		size_t m_importerIndex;
+		rkci::SymbolID_t m_moduleName;
+	};
+
+	struct Module
+	{
+		rkci::SymbolID_t m_name;
+		RkcStreamSpec m_stream;
+
+		// Incremental state, kept across compiles
+		uint64_t m_sourceHash;
+		uint64_t m_interfaceHash;
+		uint64_t m_importsInterfaceHash;
+		bool m_hasCompiled;
+		bool m_isDirty;
+		bool m_streamConsumed;
+
+		// Scheduling state, rebuilt by each Compile
+		size_t m_firstDependentSlot;
+		size_t m_numDependents;
+		size_t m_firstImportSlot;
+		size_t m_numImports;
+		size_t m_numPendingImports;
+		rkc::ResultCode_t m_resultCode;
+		bool m_importFailed;
+		bool m_wasCompiled;
+	};
+
+	struct ModuleJob
+	{
+		IRkcComposite *m_composite;
+		size_t m_moduleIndex;
+	};
+
+	bool FindModule(rkci::SymbolID_t name, size_t &outIndex) const;
+	rkci::Result BuildSchedule();
+
+	uint64_t ComputeImportsInterfaceHash(size_t moduleIndex) const;
+	static uint64_t ComputeOptionsHash();
+
+	rkc::ResultCode_t RunModule(size_t moduleIndex);
+	rkci::Result CompileModule(size_t moduleIndex, uint64_t &outSourceHash, uint64_t &outInterfaceHash);
+	void FinishModule(size_t moduleIndex, rkc::ResultCode_t resultCode);
+	void RetireModule();
+	bool RetireModuleAndTakeDeferred(size_t &outModuleIndex);
+
+	void SubmitModule(size_t moduleIndex);
+	void RunModuleAndSubmitDependents(size_t moduleIndex);
+	static void RunModuleJob(void *jobData);
+
+	rkci::Result CompileModules();
+	rkci::Result CompileSerial();
+	rkci::Result CompileParallel();
+
+	IRkcContext &m_context;
+
+	rkci::Vector<Module> m_modules;
+	rkci::Vector<Import> m_imports;
+	rkci::Vector<size_t> m_dependentSlots;
+	rkci::Vector<size_t> m_importSlots;
+
+	// Per dependent slot, set when finishing the imported module released the last pending import of
+	// the dependent.  Only the thread that finished the imported module touches its slots.
+	rkci::Vector<uint8_t> m_dependentReleased;
+	rkci::Vector<ModuleJob> m_jobs;
+
+	// Modules whose job the job system refused, waiting for a thread that is between modules.  Guarded
+	// by m_mutex.
+	rkci::Vector<size_t> m_deferredModules;
+
+	const RkcJobSystem *m_jobSystem;
+
+	rkci::MonomorphCache m_monomorphCache;
+
+	std::mutex m_mutex;
+
+	// Signaled when the last module is retired or a module is deferred
+	std::condition_variable m_compileStateChanged;
+	size_t m_numModulesRemaining;
+	size_t m_numDeferred;
+	rkc::ResultCode_t m_firstError;
+	size_t m_numModulesCompiled;
+	size_t m_numModulesSkipped;
+};
@@ -0,0 +1,166 @@
+#include "RkcContext.h"
+#include "Lexer.h"
+
+#include "Result.h"
+
+#include <new>
+#include <string.h>
+
+RkcAllocator::RkcAllocator(const RkcAllocatorSpec &allocatorSpec)
+	: m_allocSpec(allocatorSpec)
+{
+}
+
+void *RkcAllocator::Realloc(void *buf, size_t newSize)
+{
+	return m_allocSpec.m_realloc(m_allocSpec.m_userdata, buf, newSize);
+}
+
+IRkcContext::IRkcContext(const RkcAllocatorSpec &allocSpec, const RkcContextOptions &options)
+	: m_hostAlloc(allocSpec)
+	, m_trackingAlloc(m_hostAlloc)
+	, m_isTracking(options.m_trackAllocations != 0)
+	, m_readAheadBufferSize(options.m_readAheadBufferSize)
+	, m_lexerBufferSize(options.m_lexerBufferSize ? options.m_lexerBufferSize : rkci::Lexer::kDefaultBufferSize)
+	, m_symbolPool(SelectAllocator(m_hostAlloc, m_trackingAlloc, options))
+	, m_powerCache(SelectAllocator(m_hostAlloc, m_trackingAlloc, options))
+	, m_readAheadPool(options.m_readAheadThreads)
+	, m_isCompiling(false)
+{
+}
+
+rkci::IAllocator &IRkcContext::SelectAllocator(RkcAllocator &hostAlloc, rkci::TrackingAllocator &trackingAlloc, const RkcContextOptions &options)
+{
+	if (options.m_trackAllocations != 0)
+		return trackingAlloc;
+
+	return hostAlloc;
+}
+
+rkci::IAllocator &IRkcContext::GetAllocator()
+{
+	if (m_isTracking)
+		return m_trackingAlloc;
+
+	return m_hostAlloc;
+}
+
+const rkci::TrackingAllocator *IRkcContext::GetTrackingAllocator() const
+{
+	if (m_isTracking)
+		return &m_trackingAlloc;
+
+	return nullptr;
+}
+
+size_t IRkcContext::GetReadAheadBufferSize() const
+{
+	return m_readAheadBufferSize;
+}
+
+size_t IRkcContext::GetLexerBufferSize() const
+{
+	return m_lexerBufferSize;
+}
+
+rkci::ReadAheadPool &IRkcContext::GetReadAheadPool()
+{
+	return m_readAheadPool;
+}
+
+rkci::SymbolPool &IRkcContext::GetSymbolPool()
+{
+	return m_symbolPool;
+}
+
+rkci::DecPowerCache &IRkcContext::GetPowerCache()
+{
+	return m_powerCache;
+}
+
+void IRkcContext::GetStats(RkcContextStats &outStats) const
+{
+	outStats.m_numSymbols = m_symbolPool.NumSymbols();
+	outStats.m_numCachedPowers = m_powerCache.NumCachedPowers();
+}
+
+void IRkcContext::BeginCompile()
+{
+	RKC_ASSERT(!m_isCompiling);
+	m_isCompiling = true;
+}
+
+void IRkcContext::EndCompile()
+{
+	RKC_ASSERT(m_isCompiling);
+	m_isCompiling = false;
+}
+
+bool IRkcContext::IsCompiling() const
+{
+	return m_isCompiling;
+}
+
+void IRkcContext::Destroy()
+{
+	RkcAllocator hostAlloc(m_hostAlloc);
+
+	this->~IRkcContext();
+	hostAlloc.Release(this);
+}
+
+bool IRkcContext::ReadOptions(const RkcContextOptions *options, RkcContextOptions &outOptions)
+{
+	memset(&outOptions, 0, sizeof(outOptions));
+	outOptions.m_structSize = sizeof(RkcContextOptions);
+
+	if (options == nullptr)
+		return true;
+
+	if (options->m_structSize < sizeof(options->m_structSize))
+		return false;
+
+	const size_t sizeToCopy = (options->m_structSize < sizeof(RkcContextOptions)) ? options->m_structSize : sizeof(RkcContextOptions);
+	memcpy(&outOptions, options, sizeToCopy);
+	outOptions.m_structSize = sizeof(RkcContextOptions);
+
+	return true;
+}
+
+int RkcCreateContext(IRkcContext **outContext, const RkcAllocatorSpec *allocSpec, const RkcContextOptions *options)
+{
+	RkcContextOptions contextOptions;
+	if (!IRkcContext::ReadOptions(options, contextOptions))
+		return rkc::ResultCodes::kInvalidOperation;
+
+	RkcAllocator hostAlloc(*allocSpec);
+
+	void *contextMemory = hostAlloc.Alloc(sizeof(IRkcContext));
+	if (!contextMemory)
+		return rkc::ResultCodes::kOutOfMemory;
+
+	*outContext = new (contextMemory) IRkcContext(*allocSpec, contextOptions);
+	return rkc::ResultCodes::kOK;
+}
+
+void RkcDestroyContext(IRkcContext *context)
+{
+	if (context)
+		context->Destroy();
+}
+
+int RkcGetAllocatorStats(const IRkcContext *context, RkcAllocatorStats *outStats)
+{
+	const rkci::TrackingAllocator *trackingAlloc = context->GetTrackingAllocator();
+	if (!trackingAlloc)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	trackingAlloc->GetStats(*outStats);
+	return rkc::ResultCodes::kOK;
+}
+
+int RkcGetContextStats(const IRkcContext *context, RkcContextStats *outStats)
+{
+	context->GetStats(*outStats);
+	return rkc::ResultCodes::kOK;
+}
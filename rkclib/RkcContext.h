@@ -0,0 +1,70 @@
+#pragma once
+
+#include "rkclib.h"
+#include "IAllocator.h"
+#include "TrackingAllocator.h"
+#include "DecPowerCache.h"
+#include "ReadAheadStream.h"
+#include "SymbolPool.h"
+
+struct RkcAllocator final : public rkci::IAllocator
+{
+	explicit RkcAllocator(const RkcAllocatorSpec &allocatorSpec);
+
+	void *Realloc(void *buf, size_t newSize) override;
+
+	RkcAllocatorSpec m_allocSpec;
+};
+
+// Long-lived compiler state.  Everything here survives across compiles so that a host compiling
+// many modules only pays for warm-up once.  A context may only run one compile at a time.
+//
+// There is no parser yet, so there is no parsed-module cache or per-compile scratch arena either.
+// They belong here once parsing produces modules worth keeping.
+struct IRkcContext
+{
+public:
+	IRkcContext(const RkcAllocatorSpec &allocSpec, const RkcContextOptions &options);
+
+	rkci::IAllocator &GetAllocator();
+
+	const rkci::TrackingAllocator *GetTrackingAllocator() const;
+
+	// Size of each read-ahead buffer, or 0 to read sources on the lexing thread
+	size_t GetReadAheadBufferSize() const;
+	size_t GetLexerBufferSize() const;
+
+	rkci::ReadAheadPool &GetReadAheadPool();
+
+	rkci::SymbolPool &GetSymbolPool();
+
+	// Powers of 2 and 5 for numeric literal conversion.  Shared by every module job in a compile.
+	rkci::DecPowerCache &GetPowerCache();
+
+	void GetStats(RkcContextStats &outStats) const;
+
+	void BeginCompile();
+	void EndCompile();
+	bool IsCompiling() const;
+
+	// Releases the context's own memory through the host allocator
+	void Destroy();
+
+	// Copies the options the host knows about over the defaults.  Returns false if the options are malformed.
+	static bool ReadOptions(const RkcContextOptions *options, RkcContextOptions &outOptions);
+
+private:
+	static rkci::IAllocator &SelectAllocator(RkcAllocator &hostAlloc, rkci::TrackingAllocator &trackingAlloc, const RkcContextOptions &options);
+
+	RkcAllocator m_hostAlloc;
+	rkci::TrackingAllocator m_trackingAlloc;
+	bool m_isTracking;
+	size_t m_readAheadBufferSize;
+	size_t m_lexerBufferSize;
+
+	rkci::SymbolPool m_symbolPool;
+	rkci::DecPowerCache m_powerCache;
+	rkci::ReadAheadPool m_readAheadPool;
+
+	bool m_isCompiling;
+};
@@ -0,0 +1,137 @@
+#include "RkcLexer.h"
+#include "RkcContext.h"
+#include "Result.h"
+
+#include <new>
+#include <string.h>
+
+IRkcLexer::IRkcLexer(IRkcContext &context, const RkcStreamSpec &stream, const RkcLexerOptions &options)
+	: m_context(context)
+	, m_stream(stream)
+	, m_lexer(&m_stream, &context.GetAllocator(), context.GetLexerBufferSize())
+	, m_reachedEndOfFile(false)
+	, m_resultCode(rkc::ResultCodes::kOK)
+{
+	m_lexer.SetRecoverFromErrors(options.m_recoverFromErrors != 0);
+}
+
+rkci::Result IRkcLexer::LexBatch(RkcToken *outTokens, size_t maxTokens, size_t &outNumTokens)
+{
+	outNumTokens = 0;
+
+	if (m_resultCode != rkc::ResultCodes::kOK)
+		return rkci::Result::Propagate(m_resultCode);
+
+	rkci::Result result(LexTokens(outTokens, maxTokens, outNumTokens));
+
+	m_resultCode = result.GetCode();
+	return result;
+}
+
+rkci::Result IRkcLexer::LexTokens(RkcToken *outTokens, size_t maxTokens, size_t &outNumTokens)
+{
+	while (outNumTokens < maxTokens && !m_reachedEndOfFile)
+	{
+		RKC_CHECK_RV(rkci::LexToken, lexToken, m_lexer.GetNextToken());
+
+		RkcToken &outToken = outTokens[outNumTokens++];
+		outToken.m_tokenType = ConvertTokenType(lexToken.m_tokenType);
+		outToken.m_startOffset = lexToken.m_startPos.m_filePos;
+		outToken.m_endOffset = lexToken.m_endPos.m_filePos;
+		outToken.m_line = lexToken.m_startPos.m_line;
+		outToken.m_col = lexToken.m_startPos.m_col;
+		outToken.m_errorCode = lexToken.m_errorCode;
+
+		if (lexToken.m_tokenType == rkci::LexTokenType::kEndOfFile)
+			m_reachedEndOfFile = true;
+	}
+
+	return rkci::Result::Ok();
+}
+
+bool IRkcLexer::ReadOptions(const RkcLexerOptions *options, RkcLexerOptions &outOptions)
+{
+	memset(&outOptions, 0, sizeof(outOptions));
+	outOptions.m_structSize = sizeof(RkcLexerOptions);
+
+	if (options == nullptr)
+		return true;
+
+	if (options->m_structSize < sizeof(options->m_structSize))
+		return false;
+
+	const size_t sizeToCopy = (options->m_structSize < sizeof(RkcLexerOptions)) ? options->m_structSize : sizeof(RkcLexerOptions);
+	memcpy(&outOptions, options, sizeToCopy);
+	outOptions.m_structSize = sizeof(RkcLexerOptions);
+
+	return true;
+}
+
+void IRkcLexer::Destroy()
+{
+	rkci::IAllocator &alloc = m_context.GetAllocator();
+
+	this->~IRkcLexer();
+	alloc.Release(this);
+}
+
+rkc::TokenType_t IRkcLexer::ConvertTokenType(rkci::LexTokenType tokenType)
+{
+	switch (tokenType)
+	{
+	case rkci::LexTokenType::kWhitespace:
+		return rkc::TokenTypes::kWhitespace;
+	case rkci::LexTokenType::kName:
+		return rkc::TokenTypes::kName;
+	case rkci::LexTokenType::kString:
+		return rkc::TokenTypes::kString;
+	case rkci::LexTokenType::kNumber:
+		return rkc::TokenTypes::kNumber;
+	case rkci::LexTokenType::kLineComment:
+		return rkc::TokenTypes::kLineComment;
+	case rkci::LexTokenType::kBlockComment:
+		return rkc::TokenTypes::kBlockComment;
+	case rkci::LexTokenType::kEndOfLine:
+		return rkc::TokenTypes::kEndOfLine;
+	case rkci::LexTokenType::kEndOfFile:
+		return rkc::TokenTypes::kEndOfFile;
+	case rkci::LexTokenType::kPunctuation:
+		return rkc::TokenTypes::kPunctuation;
+	case rkci::LexTokenType::kCharacterLiteral:
+		return rkc::TokenTypes::kCharacterLiteral;
+	case rkci::LexTokenType::kError:
+		return rkc::TokenTypes::kError;
+	default:
+		return rkc::TokenTypes::kUnknown;
+	}
+}
+
+int RkcCreateLexer(IRkcContext *context, const RkcStreamSpec *stream, const RkcLexerOptions *options, IRkcLexer **outLexer)
+{
+	RkcLexerOptions lexerOptions;
+	if (!IRkcLexer::ReadOptions(options, lexerOptions))
+		return rkc::ResultCodes::kInvalidOperation;
+
+	rkci::IAllocator &alloc = context->GetAllocator();
+
+	void *lexerMemory = alloc.Alloc(sizeof(IRkcLexer));
+	if (!lexerMemory)
+		return rkc::ResultCodes::kOutOfMemory;
+
+	*outLexer = new (lexerMemory) IRkcLexer(*context, *stream, lexerOptions);
+	return rkc::ResultCodes::kOK;
+}
+
+void RkcDestroyLexer(IRkcLexer *lexer)
+{
+	if (lexer)
+		lexer->Destroy();
+}
+
+int RkcLexBatch(IRkcLexer *lexer, RkcToken *outTokens, size_t maxTokens, size_t *outNumTokens)
+{
+	rkci::Result result(lexer->LexBatch(outTokens, maxTokens, *outNumTokens));
+	result.Handle();
+
+	return result.GetCode();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "rkclib.h"
+#include "RkcStream.h"
+#include "Lexer.h"
+
+struct IRkcContext;
+
+// Lexer exposed to hosts, for tools such as syntax highlighters that only need tokens
+struct IRkcLexer
+{
+public:
+	IRkcLexer(IRkcContext &context, const RkcStreamSpec &stream, const RkcLexerOptions &options);
+
+	// Writes up to maxTokens tokens to outTokens.  The end of file token is the last token written.
+	// Tokens lexed before an error are still written and counted.  After an error, later batches write no
+	// tokens and return the same error.
+	rkci::Result LexBatch(RkcToken *outTokens, size_t maxTokens, size_t &outNumTokens);
+
+	// Releases the lexer's own memory through the context's allocator
+	void Destroy();
+
+	// Copies the part of the host's options that it was built with over the defaults.  options may be null.
+	// Returns false if the options' size is invalid.
+	static bool ReadOptions(const RkcLexerOptions *options, RkcLexerOptions &outOptions);
+
+private:
+	rkci::Result LexTokens(RkcToken *outTokens, size_t maxTokens, size_t &outNumTokens);
+
+	static rkc::TokenType_t ConvertTokenType(rkci::LexTokenType tokenType);
+
+	IRkcContext &m_context;
+	RkcStream m_stream;
+	rkci::Lexer m_lexer;
+	bool m_reachedEndOfFile;
+
+	// A failed lexer keeps returning its first error
+	rkc::ResultCode_t m_resultCode;
+};
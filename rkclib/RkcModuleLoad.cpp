@@ -0,0 +1,137 @@
+#include "RkcModuleLoad.h"
+#include "RkcContext.h"
+#include "ArraySliceView.h"
+#include "Result.h"
+
+#include <new>
+
+IRkcModuleLoad::IRkcModuleLoad(IRkcContext &context)
+	: m_context(context)
+	, m_stream(&context.GetAllocator())
+	, m_lexer(&m_stream, &context.GetAllocator(), context.GetLexerBufferSize())
+	, m_resultCode(rkc::ResultCodes::kOK)
+{
+	m_lexer.SetMoreInputExpected(true);
+}
+
+rkci::Result IRkcModuleLoad::Feed(const rkci::ArraySliceView<const uint8_t> &bytes)
+{
+	if (m_resultCode != rkc::ResultCodes::kOK)
+		return rkci::Result::Propagate(m_resultCode);
+
+	rkci::Result result(AppendAndLex(bytes));
+
+	m_resultCode = result.GetCode();
+	return result;
+}
+
+rkci::Result IRkcModuleLoad::Finish()
+{
+	if (m_resultCode != rkc::ResultCodes::kOK)
+		return rkci::Result::Propagate(m_resultCode);
+
+	m_lexer.SetMoreInputExpected(false);
+
+	rkci::Result result(LexAvailableTokens());
+
+	m_resultCode = result.GetCode();
+	return result;
+}
+
+void IRkcModuleLoad::Destroy()
+{
+	IRkcContext &context = m_context;
+	rkci::IAllocator &alloc = context.GetAllocator();
+
+	this->~IRkcModuleLoad();
+	alloc.Release(this);
+
+	context.EndCompile();
+}
+
+rkci::Result IRkcModuleLoad::AppendAndLex(const rkci::ArraySliceView<const uint8_t> &bytes)
+{
+	RKC_CHECK(m_stream.Append(bytes));
+
+	return LexAvailableTokens();
+}
+
+rkci::Result IRkcModuleLoad::LexAvailableTokens()
+{
+	rkci::SymbolPool &symbolPool = m_context.GetSymbolPool();
+
+	for (;;)
+	{
+		RKC_CHECK_RV(rkci::LexToken, lexToken, m_lexer.GetNextToken());
+
+		if (lexToken.m_tokenType == rkci::LexTokenType::kName)
+			RKC_CHECK(symbolPool.Intern(lexToken.m_charBuffer.Slice()).DiscardValue());
+
+		// A token cut off by the end of the input keeps its bytes so far in the lexer, so only the bytes
+		// after its end position have to stay in the stream
+		m_stream.DiscardBefore(lexToken.m_endPos.m_filePos);
+
+		if (lexToken.m_tokenType == rkci::LexTokenType::kNeedMoreInput || lexToken.m_tokenType == rkci::LexTokenType::kEndOfFile)
+			break;
+	}
+
+	return rkci::Result::Ok();
+}
+
+int RkcBeginModuleLoad(IRkcContext *context, IRkcModuleLoad **outLoad)
+{
+	rkci::IAllocator &alloc = context->GetAllocator();
+
+	void *loadMemory = alloc.Alloc(sizeof(IRkcModuleLoad));
+	if (!loadMemory)
+		return rkc::ResultCodes::kOutOfMemory;
+
+	context->BeginCompile();
+
+	*outLoad = new (loadMemory) IRkcModuleLoad(*context);
+	return rkc::ResultCodes::kOK;
+}
+
+int RkcModuleFeed(IRkcModuleLoad *load, const void *bytes, size_t size)
+{
+	const rkci::ArraySliceView<const uint8_t> byteSlice(static_cast<const uint8_t*>(bytes), size);
+
+	rkci::Result result(load->Feed(byteSlice));
+	result.Handle();
+
+	return result.GetCode();
+}
+
+int RkcModuleFinish(IRkcModuleLoad *load)
+{
+	rkci::Result result(load->Finish());
+	result.Handle();
+
+	load->Destroy();
+
+	return result.GetCode();
+}
+
+void RkcAbortModuleLoad(IRkcModuleLoad *load)
+{
+	if (load)
+		load->Destroy();
+}
+
+int RkcLoadModuleText(IRkcContext *context, const void *text, size_t size)
+{
+	IRkcModuleLoad *load = nullptr;
+
+	const int beginResult = RkcBeginModuleLoad(context, &load);
+	if (beginResult != rkc::ResultCodes::kOK)
+		return beginResult;
+
+	const int feedResult = RkcModuleFeed(load, text, size);
+	if (feedResult != rkc::ResultCodes::kOK)
+	{
+		RkcAbortModuleLoad(load);
+		return feedResult;
+	}
+
+	return RkcModuleFinish(load);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "rkclib.h"
+#include "FeedStream.h"
+#include "Lexer.h"
+
+struct IRkcContext;
+
+// A module being loaded from source pushed by the host.  Every Feed lexes as many complete tokens as
+// the bytes received so far allow.  A token cut off by the end of the received bytes is continued by
+// the next Feed from where it was cut off, so a long token spanning many feeds is only lexed once.
+struct IRkcModuleLoad
+{
+public:
+	explicit IRkcModuleLoad(IRkcContext &context);
+
+	rkci::Result Feed(const rkci::ArraySliceView<const uint8_t> &bytes);
+	rkci::Result Finish();
+
+	// Ends the load's compile on the context and releases the load's own memory
+	void Destroy();
+
+private:
+	rkci::Result AppendAndLex(const rkci::ArraySliceView<const uint8_t> &bytes);
+	rkci::Result LexAvailableTokens();
+
+	IRkcContext &m_context;
+	rkci::FeedStream m_stream;
+	rkci::Lexer m_lexer;
+
+	// A failed load keeps returning its first error
+	rkc::ResultCode_t m_resultCode;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "rkclib.h"
+#include "IStream.h"
+
+struct RkcStream : public rkci::IStream
+{
+	explicit RkcStream(const RkcStreamSpec &streamSpec);
+
+	 size_t Read(void *buf, size_t size) override;
+	 size_t Write(void *buf, size_t size) override;
+	 rkcUFilePos_t Tell() const override;
+	 bool SeekStart(rkcUFilePos_t pos) override;
+	 bool SeekEnd(rkcFilePos_t pos) override;
+	 bool SeekCurrent(rkcFilePos_t pos) override;
+	 bool IsReadable() const override;
+	 bool IsWritable() const override;
+	 void Close() override;
+
+	 RkcStreamSpec m_streamSpec;
+};
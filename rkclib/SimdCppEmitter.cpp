@@ -0,0 +1,3122 @@
+#include "SimdCppEmitter.h"
+#include "ArraySliceView.h"
+#include "CustomFloatFormat.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+#include <math.h>
+#include <string.h>
+
+rkci::SimdCppEmitter::SimdCppEmitter(IAllocator *alloc, const SimdTarget &target)
+	: m_target(target)
+	, m_out(nullptr)
+	, m_typeFormats(alloc)
+	, m_storageFormats(alloc)
+	, m_customFloatUses(alloc)
+	, m_valueFormats(alloc)
+	, m_usesExecMask(false)
+	, m_usesBufferAccess(false)
+	, m_rangeChecks(false)
+	, m_isValueChecked(alloc)
+	, m_isValueUsed(alloc)
+	, m_isParamAtLaneIndex(alloc)
+	, m_execStack(alloc)
+	, m_uniformity(alloc)
+	, m_ranges(alloc)
+	, m_accessPatterns(alloc)
+	, m_indent(0)
+{
+	for (size_t i = 0; i < 4; i++)
+		m_checkBitsUsed[i] = false;
+}
+
+void rkci::SimdCppEmitter::SetRangeChecks(bool rangeChecks)
+{
+	m_rangeChecks = rangeChecks;
+}
+
+rkci::Result rkci::SimdCppEmitter::Emit(const Kernel::Function &function, Vector<uint8_t> &outText)
+{
+	RKC_CHECK(function.Validate());
+
+	if (!IsValidIdentifier(function.GetName()))
+		return rkc::ResultCodes::kInvalidOperation;
+
+	m_out = &outText;
+
+	RKC_CHECK(m_uniformity.Analyze(function));
+	RKC_CHECK(ScanKernel(function));
+	RKC_CHECK(EmitPrologue(function));
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		if (m_maskBitsUsed[i])
+		{
+			RKC_CHECK(EmitMaskType(static_cast<uint8_t>(8u << i)));
+		}
+	}
+
+	for (size_t i = 0; i < kNumFormats; i++)
+	{
+		if (m_formatUsed[i])
+		{
+			RKC_CHECK(EmitVectorType(static_cast<SimdElementFormat>(i)));
+		}
+	}
+
+	if (m_formatUsed[static_cast<size_t>(SimdElementFormat::kFloat16)])
+	{
+		RKC_CHECK(EmitHalfOperations());
+	}
+
+	for (size_t from = 0; from < kNumFormats; from++)
+	{
+		for (size_t to = 0; to < kNumFormats; to++)
+		{
+			if (m_conversionUsed[from][to])
+			{
+				RKC_CHECK(EmitConversion(static_cast<SimdElementFormat>(from), static_cast<SimdElementFormat>(to)));
+			}
+		}
+	}
+
+	for (size_t i = 0; i < kNumFormats; i++)
+	{
+		if (m_indexFormatUsed[i])
+		{
+			RKC_CHECK(EmitIndexOperations(static_cast<SimdElementFormat>(i)));
+		}
+	}
+
+	for (size_t i = 0; i < kNumFormats; i++)
+	{
+		if (m_runFormatUsed[i])
+		{
+			RKC_CHECK(EmitRunOperations(static_cast<SimdElementFormat>(i)));
+		}
+	}
+
+	for (size_t i = 0; i < kNumFormats; i++)
+	{
+		if (m_accessFormatUsed[i])
+		{
+			RKC_CHECK(EmitAccessOperations(static_cast<SimdElementFormat>(i)));
+		}
+	}
+
+	const size_t numTypes = function.NumTypes();
+	for (size_t i = 0; i < numTypes; i++)
+	{
+		RKC_CHECK(EmitCustomFloatOperations(function, static_cast<Kernel::TypeIndex_t>(i)));
+	}
+
+	RKC_CHECK(EmitBlock(function));
+	RKC_CHECK(EmitEntryPoint(function));
+
+	m_out = nullptr;
+
+	return Result::Ok();
+}
+
+void rkci::SimdCppEmitter::SetVar(TemplateVars &vars, char name, const char *value)
+{
+	char *dest = vars.m_values[name - 'A'];
+	const size_t length = strlen(value);
+
+	RKC_ASSERT(length < sizeof(vars.m_values[0]));
+	memcpy(dest, value, length + 1);
+}
+
+void rkci::SimdCppEmitter::SetVarConcat(TemplateVars &vars, char name, const char *const *parts, size_t numParts)
+{
+	char *dest = vars.m_values[name - 'A'];
+	size_t length = 0;
+
+	for (size_t i = 0; i < numParts; i++)
+	{
+		const size_t partLength = strlen(parts[i]);
+
+		RKC_ASSERT(length + partLength < sizeof(vars.m_values[0]));
+		memcpy(dest + length, parts[i], partLength);
+		length += partLength;
+	}
+
+	dest[length] = '\0';
+}
+
+void rkci::SimdCppEmitter::SetVarNumber(TemplateVars &vars, char name, uint64_t value)
+{
+	char digits[24];
+	size_t pos = sizeof(digits);
+
+	digits[--pos] = '\0';
+	do
+	{
+		digits[--pos] = static_cast<char>('0' + value % 10u);
+		value /= 10u;
+	} while (value != 0);
+
+	SetVar(vars, name, digits + pos);
+}
+
+void rkci::SimdCppEmitter::SetVarHex(TemplateVars &vars, char name, uint64_t value)
+{
+	static const char kHexDigits[] = "0123456789abcdef";
+
+	char digits[24];
+	size_t pos = sizeof(digits);
+
+	digits[--pos] = '\0';
+	digits[--pos] = 'u';
+	do
+	{
+		digits[--pos] = kHexDigits[value % 16u];
+		value /= 16u;
+	} while (value != 0);
+
+	digits[--pos] = 'x';
+	digits[--pos] = '0';
+
+	SetVar(vars, name, digits + pos);
+}
+
+rkci::Result rkci::SimdCppEmitter::Append(const char *text)
+{
+	return AppendBytes(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+rkci::Result rkci::SimdCppEmitter::AppendBytes(const uint8_t *bytes, size_t count)
+{
+	AllocatorTagScope tagScope(*m_out->GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	return m_out->AppendRange(ArraySliceView<const uint8_t>(bytes, count));
+}
+
+rkci::Result rkci::SimdCppEmitter::AppendSlice(const ArraySliceView<const uint8_t> &bytes)
+{
+	AllocatorTagScope tagScope(*m_out->GetAllocator(), rkc::AllocatorTags::kBackend);
+
+	return m_out->AppendRange(bytes);
+}
+
+rkci::Result rkci::SimdCppEmitter::AppendDecimal(uint64_t value)
+{
+	TemplateVars vars;
+	SetVarNumber(vars, 'D', value);
+
+	return Append(vars.m_values['D' - 'A']);
+}
+
+// Appends text, replacing $ followed by a capital letter with that template variable
+rkci::Result rkci::SimdCppEmitter::AppendTemplate(const char *text, const TemplateVars &vars)
+{
+	const char *runStart = text;
+	const char *pos = text;
+
+	while (*pos != '\0')
+	{
+		if (pos[0] == '$' && pos[1] >= 'A' && pos[1] <= 'Z')
+		{
+			RKC_CHECK(AppendBytes(reinterpret_cast<const uint8_t*>(runStart), static_cast<size_t>(pos - runStart)));
+			RKC_CHECK(Append(vars.m_values[pos[1] - 'A']));
+
+			pos += 2;
+			runStart = pos;
+		}
+		else
+			pos++;
+	}
+
+	return AppendBytes(reinterpret_cast<const uint8_t*>(runStart), static_cast<size_t>(pos - runStart));
+}
+
+const char *rkci::SimdCppEmitter::GetFormatName(SimdElementFormat format)
+{
+	switch (format)
+	{
+	case SimdElementFormat::kInt8:
+		return "i8";
+	case SimdElementFormat::kUInt8:
+		return "u8";
+	case SimdElementFormat::kInt16:
+		return "i16";
+	case SimdElementFormat::kUInt16:
+		return "u16";
+	case SimdElementFormat::kInt32:
+		return "i32";
+	case SimdElementFormat::kUInt32:
+		return "u32";
+	case SimdElementFormat::kInt64:
+		return "i64";
+	case SimdElementFormat::kUInt64:
+		return "u64";
+	case SimdElementFormat::kFloat16:
+		return "f16";
+	case SimdElementFormat::kFloat32:
+		return "f32";
+	case SimdElementFormat::kFloat64:
+		return "f64";
+	default:
+		return "";
+	}
+}
+
+const char *rkci::SimdCppEmitter::GetElementCType(SimdElementFormat format)
+{
+	switch (format)
+	{
+	case SimdElementFormat::kInt8:
+		return "int8_t";
+	case SimdElementFormat::kUInt8:
+		return "uint8_t";
+	case SimdElementFormat::kInt16:
+		return "int16_t";
+	case SimdElementFormat::kUInt16:
+	case SimdElementFormat::kFloat16:
+		return "uint16_t";
+	case SimdElementFormat::kInt32:
+		return "int32_t";
+	case SimdElementFormat::kUInt32:
+		return "uint32_t";
+	case SimdElementFormat::kInt64:
+		return "int64_t";
+	case SimdElementFormat::kUInt64:
+		return "uint64_t";
+	case SimdElementFormat::kFloat32:
+		return "float";
+	case SimdElementFormat::kFloat64:
+		return "double";
+	default:
+		return "";
+	}
+}
+
+const char *rkci::SimdCppEmitter::GetIntRegisterType(uint16_t registerBits)
+{
+	if (registerBits == 512)
+		return "__m512i";
+	if (registerBits == 256)
+		return "__m256i";
+
+	return "__m128i";
+}
+
+uint16_t rkci::SimdCppEmitter::GetMaskRegisterBits(uint8_t bits) const
+{
+	uint16_t registerBits = 128;
+	while (registerBits < bits * m_target.GetNumLanes())
+		registerBits = static_cast<uint16_t>(registerBits * 2);
+
+	return registerBits;
+}
+
+const char *rkci::SimdCppEmitter::GetIntrinsicPrefix(uint16_t registerBits)
+{
+	if (registerBits == 512)
+		return "_mm512";
+	if (registerBits == 256)
+		return "_mm256";
+
+	return "_mm";
+}
+
+// $V vector type, $M mask type, $H mask storage, $E element type, $R register type, $P intrinsic
+// prefix, $S element suffix, $Q min/max/compare suffix, $O set1 suffix, $C set1 argument type,
+// $B integer register suffix, $L lanes, $N lane bits, $K element bits
+void rkci::SimdCppEmitter::BuildVectorVars(SimdElementFormat format, TemplateVars &vars) const
+{
+	const uint8_t numLanes = m_target.GetNumLanes();
+	const uint8_t elementBits = SimdTarget::GetElementBits(format);
+	const uint16_t registerBits = m_target.GetRegisterBits(format);
+
+	BuildMaskVars(elementBits, vars);
+
+	SetVarNumber(vars, 'L', numLanes);
+
+	const char *nameParts[] = { "rkcv_", GetFormatName(format), "x", vars.m_values['L' - 'A'] };
+	SetVarConcat(vars, 'V', nameParts, 4);
+
+	SetVar(vars, 'E', GetElementCType(format));
+	SetVar(vars, 'P', GetIntrinsicPrefix(registerBits));
+	SetVarNumber(vars, 'K', elementBits);
+
+	if (registerBits == 512)
+		SetVar(vars, 'B', "si512");
+	else if (registerBits == 256)
+		SetVar(vars, 'B', "si256");
+	else
+		SetVar(vars, 'B', "si128");
+
+	if (format == SimdElementFormat::kFloat32)
+	{
+		SetVar(vars, 'R', (registerBits == 512) ? "__m512" : (registerBits == 256) ? "__m256" : "__m128");
+		SetVar(vars, 'S', "ps");
+		SetVar(vars, 'Q', "ps");
+		SetVar(vars, 'O', "ps");
+		SetVar(vars, 'C', "float");
+		return;
+	}
+
+	if (format == SimdElementFormat::kFloat64)
+	{
+		SetVar(vars, 'R', (registerBits == 512) ? "__m512d" : (registerBits == 256) ? "__m256d" : "__m128d");
+		SetVar(vars, 'S', "pd");
+		SetVar(vars, 'Q', "pd");
+		SetVar(vars, 'O', "pd");
+		SetVar(vars, 'C', "double");
+		return;
+	}
+
+	const bool isSigned = SimdTarget::IsSignedFormat(format);
+
+	SetVar(vars, 'R', GetIntRegisterType(registerBits));
+
+	switch (elementBits)
+	{
+	case 8:
+		SetVar(vars, 'S', "epi8");
+		SetVar(vars, 'Q', isSigned ? "epi8" : "epu8");
+		SetVar(vars, 'O', "epi8");
+		SetVar(vars, 'C', "char");
+		break;
+	case 16:
+		SetVar(vars, 'S', "epi16");
+		SetVar(vars, 'Q', isSigned ? "epi16" : "epu16");
+		SetVar(vars, 'O', "epi16");
+		SetVar(vars, 'C', "short");
+		break;
+	case 32:
+		SetVar(vars, 'S', "epi32");
+		SetVar(vars, 'Q', isSigned ? "epi32" : "epu32");
+		SetVar(vars, 'O', "epi32");
+		SetVar(vars, 'C', "int");
+		break;
+	default:
+		SetVar(vars, 'S', "epi64");
+		SetVar(vars, 'Q', isSigned ? "epi64" : "epu64");
+		SetVar(vars, 'O', (registerBits == 512) ? "epi64" : "epi64x");
+		SetVar(vars, 'C', "long long");
+		break;
+	}
+}
+
+// Masks are vectors of all-ones and all-zero lanes as wide as the elements they were computed from,
+// except on AVX-512 where every mask is a mask register.  Mask types set $M, $H, $N and, for vector
+// masks, $R, $P, $B and $S.
+void rkci::SimdCppEmitter::BuildMaskVars(uint8_t bits, TemplateVars &vars) const
+{
+	const uint8_t numLanes = m_target.GetNumLanes();
+
+	TemplateVars numbers;
+	SetVarNumber(numbers, 'K', bits);
+	SetVarNumber(numbers, 'L', numLanes);
+
+	const char *nameParts[] = { "rkcm_", numbers.m_values['K' - 'A'], "x", numbers.m_values['L' - 'A'] };
+	SetVarConcat(vars, 'M', nameParts, 4);
+	SetVarHex(vars, 'N', (static_cast<uint64_t>(1) << numLanes) - 1u);
+
+	if (m_target.GetIsa() == SimdIsa::kAVX512)
+	{
+		SetVar(vars, 'H', "__mmask16");
+		return;
+	}
+
+	const uint16_t registerBits = GetMaskRegisterBits(bits);
+
+	SetVar(vars, 'H', GetIntRegisterType(registerBits));
+	SetVar(vars, 'R', GetIntRegisterType(registerBits));
+	SetVar(vars, 'P', GetIntrinsicPrefix(registerBits));
+	SetVar(vars, 'B', (registerBits == 256) ? "si256" : "si128");
+
+	if (bits == 8)
+		SetVar(vars, 'S', "epi8");
+	else if (bits == 16)
+		SetVar(vars, 'S', "epi16");
+	else if (bits == 32)
+		SetVar(vars, 'S', "epi32");
+	else
+		SetVar(vars, 'S', "epi64");
+}
+
+// $D is the value's name, and $T its vector or mask type
+void rkci::SimdCppEmitter::BuildValueVars(const Kernel::Function &function, Kernel::ValueIndex_t value, TemplateVars &vars) const
+{
+	const Kernel::TypeIndex_t type = function.GetInstruction(value).m_type;
+	const SimdElementFormat format = m_valueFormats[value];
+
+	TemplateVars typeVars;
+	BuildVectorVars(format, typeVars);
+
+	if (function.GetType(type).m_kind == Kernel::TypeKind::kMask)
+		SetVar(vars, 'T', typeVars.m_values['M' - 'A']);
+	else
+		SetVar(vars, 'T', typeVars.m_values['V' - 'A']);
+
+	SetVarNumber(vars, 'D', value);
+}
+
+// $I is the integer vector type that holds the bits of a float format, $G its element type, $A its
+// intrinsic suffix, and $W its format name
+void rkci::SimdCppEmitter::BuildCustomFloatVars(SimdElementFormat floatFormat, TemplateVars &vars) const
+{
+	const SimdElementFormat bitsFormat = GetFloatBitsFormat(floatFormat);
+
+	BuildVectorVars(floatFormat, vars);
+
+	TemplateVars bitsVars;
+	BuildVectorVars(bitsFormat, bitsVars);
+
+	SetVar(vars, 'I', bitsVars.m_values['V' - 'A']);
+	SetVar(vars, 'G', bitsVars.m_values['E' - 'A']);
+	SetVar(vars, 'A', bitsVars.m_values['S' - 'A']);
+	SetVar(vars, 'W', GetFormatName(bitsFormat));
+}
+
+rkci::Result rkci::SimdCppEmitter::ScanKernel(const Kernel::Function &function)
+{
+	for (size_t i = 0; i < kNumFormats; i++)
+	{
+		m_formatUsed[i] = false;
+		m_indexFormatUsed[i] = false;
+		m_runFormatUsed[i] = false;
+		m_accessFormatUsed[i] = false;
+		for (size_t j = 0; j < kNumFormats; j++)
+			m_conversionUsed[i][j] = false;
+	}
+
+	for (size_t i = 0; i < 4; i++)
+		m_maskBitsUsed[i] = false;
+
+	m_typeFormats = Vector<SimdElementFormat>(m_typeFormats.GetAllocator());
+	m_storageFormats = Vector<SimdElementFormat>(m_storageFormats.GetAllocator());
+	m_customFloatUses = Vector<CustomFloatUses>(m_customFloatUses.GetAllocator());
+
+	const size_t numTypes = function.NumTypes();
+	for (size_t i = 0; i < numTypes; i++)
+	{
+		RKC_CHECK_RV(SimdElementFormat, format, SimdTarget::SelectElementFormat(function, static_cast<Kernel::TypeIndex_t>(i)));
+
+		// Custom floatspecs are held in their wide format, but buffers and uniforms hold their encoding
+		SimdElementFormat storageFormat = format;
+		if (IsCustomFloatType(function, static_cast<Kernel::TypeIndex_t>(i)))
+		{
+			RKC_CHECK_RV(CustomFloatFormat, customFormat, CustomFloatFormat::Create(function.GetType(static_cast<Kernel::TypeIndex_t>(i)).m_floatSpec));
+			storageFormat = customFormat.GetStorageFormat();
+		}
+
+		AllocatorTagScope tagScope(*m_typeFormats.GetAllocator(), rkc::AllocatorTags::kBackend);
+		RKC_CHECK(m_typeFormats.Append(format));
+		RKC_CHECK(m_storageFormats.Append(storageFormat));
+	}
+
+	{
+		AllocatorTagScope tagScope(*m_customFloatUses.GetAllocator(), rkc::AllocatorTags::kBackend);
+		RKC_CHECK(m_customFloatUses.Resize(numTypes));
+	}
+
+	RKC_CHECK(m_ranges.Analyze(function));
+	RKC_CHECK(SelectValueFormats(function));
+	RKC_CHECK(m_accessPatterns.Analyze(function, m_uniformity, m_ranges));
+
+	// Only the formats that values are actually held in have to fit the target
+	const size_t numParams = function.NumParams();
+	for (size_t i = 0; i < numParams; i++)
+	{
+		RKC_CHECK(UseFormat(m_typeFormats[function.GetParam(static_cast<Kernel::ParamIndex_t>(i)).m_type]));
+	}
+
+	const size_t numVariables = function.NumVariables();
+	for (size_t i = 0; i < numVariables; i++)
+	{
+		RKC_CHECK(UseFormat(m_typeFormats[function.GetVariable(static_cast<Kernel::VariableIndex_t>(i)).m_type]));
+	}
+
+	m_usesExecMask = false;
+	m_usesBufferAccess = false;
+
+	const size_t numInstructions = function.NumInstructions();
+
+	{
+		AllocatorTagScope tagScope(*m_isValueUsed.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_isValueUsed.Resize(0));
+		RKC_CHECK(m_isValueUsed.Resize(numInstructions));
+		RKC_CHECK(m_isParamAtLaneIndex.Resize(0));
+		RKC_CHECK(m_isParamAtLaneIndex.Resize(function.NumParams()));
+	}
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::ValueIndex_t index = static_cast<Kernel::ValueIndex_t>(i);
+		const Kernel::Instruction &instr = function.GetInstruction(index);
+
+		switch (instr.m_opcode)
+		{
+		case Kernel::Opcode::kIf:
+		case Kernel::Opcode::kElse:
+		case Kernel::Opcode::kEndIf:
+		case Kernel::Opcode::kBreakable:
+		case Kernel::Opcode::kEndBreakable:
+		case Kernel::Opcode::kBreak:
+			// Structured control flow has to go through ConditionMasking first
+			return rkc::ResultCodes::kInvalidOperation;
+
+		case Kernel::Opcode::kBeginMasked:
+		case Kernel::Opcode::kWriteVar:
+			m_usesExecMask = true;
+			break;
+
+		default:
+			break;
+		}
+
+		// Accesses at the lane index only check the buffer's length in partial blocks, and accesses at
+		// any other index always do (see EmitRunOperations and EmitAccessOperations)
+		if (instr.m_opcode == Kernel::Opcode::kLoad || instr.m_opcode == Kernel::Opcode::kStore)
+		{
+			const Kernel::TypeIndex_t dataType = function.GetParam(static_cast<Kernel::ParamIndex_t>(instr.m_immediate)).m_type;
+			const SimdElementFormat dataFormat = m_storageFormats[dataType];
+
+			RKC_CHECK(UseFormat(dataFormat));
+
+			m_runFormatUsed[static_cast<size_t>(dataFormat)] = true;
+			m_usesBufferAccess = true;
+
+			if (function.GetInstruction(instr.m_operands[0]).m_opcode == Kernel::Opcode::kLaneIndex)
+				m_isParamAtLaneIndex[static_cast<size_t>(instr.m_immediate)] = 1;
+			else
+			{
+				m_indexFormatUsed[static_cast<size_t>(m_valueFormats[instr.m_operands[0]])] = true;
+				m_accessFormatUsed[static_cast<size_t>(dataFormat)] = true;
+			}
+		}
+
+		if (Kernel::Function::DefinesValue(instr.m_opcode))
+		{
+			RKC_CHECK(UseFormat(m_valueFormats[i]));
+		}
+
+		if (instr.m_opcode == Kernel::Opcode::kConvert && function.GetType(instr.m_type).m_kind != Kernel::TypeKind::kMask)
+		{
+			const SimdElementFormat fromFormat = GetValueFormat(function, instr.m_operands[0]);
+			const SimdElementFormat toFormat = m_valueFormats[i];
+
+			if (IsCustomFloatType(function, instr.m_type))
+			{
+				SimdElementFormat exactFormat = toFormat;
+				RKC_CHECK(GetCustomFloatConvertFormat(function, index, exactFormat));
+				RKC_CHECK(UseFormat(exactFormat));
+
+				if (fromFormat != exactFormat)
+					m_conversionUsed[static_cast<size_t>(fromFormat)][static_cast<size_t>(exactFormat)] = true;
+
+				if (exactFormat == toFormat)
+					m_customFloatUses[instr.m_type].m_round = true;
+				else
+				{
+					m_customFloatUses[instr.m_type].m_roundFromF64 = true;
+					m_conversionUsed[static_cast<size_t>(exactFormat)][static_cast<size_t>(toFormat)] = true;
+				}
+			}
+			else if (fromFormat != toFormat)
+				m_conversionUsed[static_cast<size_t>(fromFormat)][static_cast<size_t>(toFormat)] = true;
+		}
+
+		switch (instr.m_opcode)
+		{
+		case Kernel::Opcode::kParam:
+		case Kernel::Opcode::kLoad:
+			if (IsCustomFloatType(function, instr.m_type))
+				m_customFloatUses[instr.m_type].m_unpack = true;
+			break;
+
+		case Kernel::Opcode::kStore:
+			{
+				const Kernel::TypeIndex_t paramType = function.GetParam(static_cast<Kernel::ParamIndex_t>(instr.m_immediate)).m_type;
+				if (IsCustomFloatType(function, paramType))
+					m_customFloatUses[paramType].m_pack = true;
+			}
+			break;
+
+		case Kernel::Opcode::kAdd:
+		case Kernel::Opcode::kSub:
+		case Kernel::Opcode::kMul:
+			if (IsCustomFloatType(function, instr.m_type))
+				m_customFloatUses[instr.m_type].m_round = true;
+			break;
+
+		default:
+			break;
+		}
+
+		// Operands held in a different format than their user computes in go through a conversion,
+		// except for masks, constants and uniforms, which are cheaper to rebuild.  Rebuilt operands and
+		// loads and stores at the lane index, which address the lane's element directly, don't read the
+		// operand's variable.
+		const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+		for (size_t operandIndex = 0; operandIndex < numOperands; operandIndex++)
+		{
+			const Kernel::ValueIndex_t operand = instr.m_operands[operandIndex];
+			const Kernel::Instruction &operandInstr = function.GetInstruction(operand);
+			const SimdElementFormat operandFormat = m_valueFormats[operand];
+			const SimdElementFormat requiredFormat = GetOperandFormat(function, index, operandIndex);
+
+			if (operandIndex == 0 && (instr.m_opcode == Kernel::Opcode::kLoad || instr.m_opcode == Kernel::Opcode::kStore)
+				&& operandInstr.m_opcode == Kernel::Opcode::kLaneIndex)
+				continue;
+
+			if (requiredFormat == SimdElementFormat::kCount || requiredFormat == operandFormat)
+			{
+				m_isValueUsed[operand] = 1;
+				continue;
+			}
+
+			const bool isMask = (function.GetType(operandInstr.m_type).m_kind == Kernel::TypeKind::kMask);
+			if (!isMask && (operandInstr.m_opcode == Kernel::Opcode::kConstant || operandInstr.m_opcode == Kernel::Opcode::kParam))
+				continue;
+
+			m_isValueUsed[operand] = 1;
+
+			if (isMask)
+				continue;
+
+			m_conversionUsed[static_cast<size_t>(operandFormat)][static_cast<size_t>(requiredFormat)] = true;
+		}
+	}
+
+	// Custom floatspec helpers work on the bits of the wide format, and pack and unpack through integer
+	// conversions to and from the storage format
+	for (size_t i = 0; i < numTypes; i++)
+	{
+		const CustomFloatUses &uses = m_customFloatUses[i];
+		const SimdElementFormat bitsFormat = GetFloatBitsFormat(m_typeFormats[i]);
+		const size_t bitsIndex = static_cast<size_t>(bitsFormat);
+		const size_t storageIndex = static_cast<size_t>(m_storageFormats[i]);
+
+		if (uses.m_round || uses.m_pack || uses.m_unpack)
+		{
+			RKC_CHECK(UseFormat(bitsFormat));
+		}
+
+		if (uses.m_roundFromF64)
+		{
+			RKC_CHECK(UseFormat(SimdElementFormat::kFloat64));
+			RKC_CHECK(UseFormat(SimdElementFormat::kInt64));
+		}
+
+		if (uses.m_pack)
+		{
+			RKC_CHECK(UseFormat(m_storageFormats[i]));
+			m_conversionUsed[bitsIndex][storageIndex] = true;
+		}
+
+		if (uses.m_unpack)
+		{
+			RKC_CHECK(UseFormat(m_storageFormats[i]));
+			m_conversionUsed[storageIndex][bitsIndex] = true;
+		}
+	}
+
+	// The execution mask is kept in 8-bit lanes
+	if (m_usesExecMask)
+		m_maskBitsUsed[0] = true;
+
+	return Result::Ok();
+}
+
+// Integer values that can't overflow are held in the narrowest format that holds their range, which
+// can be narrower than their type's.  Adds, subtracts, multiplies and bitwise operations give the
+// same low bits whatever width they're done at, so they're done at the width of their result, and
+// the others at a width that holds all of their operands.
+rkci::Result rkci::SimdCppEmitter::SelectValueFormats(const Kernel::Function &function)
+{
+	const size_t numInstructions = function.NumInstructions();
+
+	{
+		AllocatorTagScope tagScope(*m_valueFormats.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_valueFormats.Resize(0));
+		RKC_CHECK(m_valueFormats.Resize(numInstructions));
+		RKC_CHECK(m_isValueChecked.Resize(0));
+		RKC_CHECK(m_isValueChecked.Resize(numInstructions));
+	}
+
+	for (size_t i = 0; i < 4; i++)
+		m_checkBitsUsed[i] = false;
+
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::ValueIndex_t index = static_cast<Kernel::ValueIndex_t>(i);
+		const Kernel::Instruction &instr = function.GetInstruction(index);
+
+		if (!Kernel::Function::DefinesValue(instr.m_opcode))
+			continue;
+
+		const Kernel::TypeKind kind = function.GetType(instr.m_type).m_kind;
+		const SimdElementFormat typeFormat = m_typeFormats[instr.m_type];
+
+		SimdElementFormat format = typeFormat;
+		bool isNarrowable = false;
+		RangeAnalysis::Range range;
+		range.m_min = 0;
+		range.m_max = 0;
+
+		// Checked results are computed wide enough to hold whatever the operation can produce, except
+		// for conversions from floats, which are checked before converting
+		if (m_rangeChecks && kind == Kernel::TypeKind::kInt && m_ranges.MayOverflow(index))
+		{
+			m_isValueChecked[i] = 1;
+
+			SimdElementFormat checkFormat = typeFormat;
+			if (instr.m_opcode == Kernel::Opcode::kConvert)
+				checkFormat = GetValueFormat(function, instr.m_operands[0]);
+
+			if (!SimdTarget::IsFloatFormat(checkFormat))
+			{
+				// Results that can leave 64 bits would need a carry-out check that isn't done yet
+				if (!m_ranges.GetExactRange(index, range))
+					return rkc::ResultCodes::kNotYetImplemented;
+
+				format = SimdTarget::SelectIntFormat(range.m_min, range.m_max);
+				checkFormat = format;
+			}
+
+			m_valueFormats[i] = format;
+			m_checkBitsUsed[GetMaskBitsIndex(SimdTarget::GetElementBits(checkFormat))] = true;
+			continue;
+		}
+
+		switch (instr.m_opcode)
+		{
+		case Kernel::Opcode::kConstant:
+		case Kernel::Opcode::kConvert:
+		case Kernel::Opcode::kAdd:
+		case Kernel::Opcode::kSub:
+		case Kernel::Opcode::kMul:
+		case Kernel::Opcode::kAnd:
+		case Kernel::Opcode::kOr:
+		case Kernel::Opcode::kXor:
+		case Kernel::Opcode::kNot:
+			if (kind == Kernel::TypeKind::kInt && !m_ranges.MayOverflow(index))
+			{
+				range = m_ranges.GetRange(index);
+				isNarrowable = true;
+			}
+			else if (kind == Kernel::TypeKind::kMask && instr.m_opcode != Kernel::Opcode::kConstant && instr.m_opcode != Kernel::Opcode::kConvert)
+			{
+				// Mask operations keep the lane width of their first operand
+				format = m_valueFormats[instr.m_operands[0]];
+			}
+			break;
+
+		case Kernel::Opcode::kMin:
+		case Kernel::Opcode::kMax:
+		case Kernel::Opcode::kSelect:
+		case Kernel::Opcode::kCmpEq:
+		case Kernel::Opcode::kCmpNe:
+		case Kernel::Opcode::kCmpLt:
+		case Kernel::Opcode::kCmpLe:
+		case Kernel::Opcode::kCmpGt:
+		case Kernel::Opcode::kCmpGe:
+			{
+				// Selects pick between their last two operands
+				const size_t firstOperand = (instr.m_opcode == Kernel::Opcode::kSelect) ? 1 : 0;
+				const Kernel::ValueIndex_t a = instr.m_operands[firstOperand];
+				const Kernel::ValueIndex_t b = instr.m_operands[firstOperand + 1];
+
+				if (function.GetType(function.GetInstruction(a).m_type).m_kind == Kernel::TypeKind::kInt)
+				{
+					const RangeAnalysis::Range &rangeA = m_ranges.GetRange(a);
+					const RangeAnalysis::Range &rangeB = m_ranges.GetRange(b);
+
+					range.m_min = (rangeA.m_min < rangeB.m_min) ? rangeA.m_min : rangeB.m_min;
+					range.m_max = (rangeA.m_max > rangeB.m_max) ? rangeA.m_max : rangeB.m_max;
+					isNarrowable = true;
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if (isNarrowable)
+		{
+			const SimdElementFormat narrowFormat = SimdTarget::SelectIntFormat(range.m_min, range.m_max);
+			if (SimdTarget::GetElementBits(narrowFormat) < SimdTarget::GetElementBits(typeFormat))
+				format = narrowFormat;
+		}
+
+		m_valueFormats[i] = format;
+	}
+
+	return Result::Ok();
+}
+
+// Returns kCount if the operand is used in whatever format it's held in
+rkci::SimdElementFormat rkci::SimdCppEmitter::GetOperandFormat(const Kernel::Function &function, Kernel::ValueIndex_t user, size_t operandIndex) const
+{
+	const Kernel::Instruction &instr = function.GetInstruction(user);
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kAdd:
+	case Kernel::Opcode::kSub:
+	case Kernel::Opcode::kMul:
+	case Kernel::Opcode::kMin:
+	case Kernel::Opcode::kMax:
+	case Kernel::Opcode::kAnd:
+	case Kernel::Opcode::kOr:
+	case Kernel::Opcode::kXor:
+	case Kernel::Opcode::kNot:
+	case Kernel::Opcode::kCmpEq:
+	case Kernel::Opcode::kCmpNe:
+	case Kernel::Opcode::kCmpLt:
+	case Kernel::Opcode::kCmpLe:
+	case Kernel::Opcode::kCmpGt:
+	case Kernel::Opcode::kCmpGe:
+		return m_valueFormats[user];
+
+	case Kernel::Opcode::kSelect:
+		return (operandIndex == 0) ? SimdElementFormat::kCount : m_valueFormats[user];
+
+	case Kernel::Opcode::kStore:
+		if (operandIndex == 0)
+			return SimdElementFormat::kCount;
+		return m_typeFormats[function.GetParam(static_cast<Kernel::ParamIndex_t>(instr.m_immediate)).m_type];
+
+	case Kernel::Opcode::kWriteVar:
+		return m_typeFormats[function.GetVariable(static_cast<Kernel::VariableIndex_t>(instr.m_immediate)).m_type];
+
+	default:
+		return SimdElementFormat::kCount;
+	}
+}
+
+rkci::Result rkci::SimdCppEmitter::UseFormat(SimdElementFormat format)
+{
+	// Half-precision arithmetic is done in float32 lanes
+	if (format == SimdElementFormat::kFloat16)
+	{
+		RKC_CHECK(UseFormat(SimdElementFormat::kFloat32));
+	}
+
+	if (m_target.GetRegisterBits(format) == 0)
+		return rkc::ResultCodes::kNotYetImplemented;
+
+	m_formatUsed[static_cast<size_t>(format)] = true;
+	m_maskBitsUsed[GetMaskBitsIndex(SimdTarget::GetElementBits(format))] = true;
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitPrologue(const Kernel::Function &function)
+{
+	RKC_CHECK(Append("// Generated by rkc: kernel "));
+	RKC_CHECK(AppendSlice(function.GetName()));
+	RKC_CHECK(Append(", "));
+	RKC_CHECK(AppendDecimal(m_target.GetNumLanes()));
+
+	switch (m_target.GetIsa())
+	{
+	case SimdIsa::kSSE42:
+		RKC_CHECK(Append(" lanes, SSE4.2\n"));
+		break;
+	case SimdIsa::kAVX2:
+		RKC_CHECK(Append(" lanes, AVX2\n#if defined(__GNUC__) && !defined(__AVX2__)\n#error \"Compile with -mavx2\"\n#endif\n"));
+		break;
+	case SimdIsa::kAVX512:
+		RKC_CHECK(Append(" lanes, AVX-512\n#if defined(__GNUC__) && !(defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512DQ__) && defined(__AVX512VL__))\n#error \"Compile with -mavx512f -mavx512bw -mavx512dq -mavx512vl\"\n#endif\n"));
+		break;
+	default:
+		return rkc::ResultCodes::kInternalError;
+	}
+
+	RKC_CHECK(Append("\n"
+		"#include <immintrin.h>\n"
+		"#include <stddef.h>\n"
+		"#include <stdint.h>\n"
+		"#include <string.h>\n"
+		"\n"
+		"static inline float rkc_f32_from_bits(uint32_t bits) { float f; memcpy(&f, &bits, sizeof(f)); return f; }\n"
+		"static inline double rkc_f64_from_bits(uint64_t bits) { double f; memcpy(&f, &bits, sizeof(f)); return f; }\n"
+		"\n"));
+
+	if (!m_formatUsed[static_cast<size_t>(SimdElementFormat::kFloat16)])
+		return Result::Ok();
+
+	if (m_target.HasF16C())
+	{
+		RKC_CHECK(Append("#if defined(__GNUC__) && !defined(__F16C__)\n#error \"Compile with -mf16c\"\n#endif\n\n"));
+	}
+
+	// Software half-precision conversions, which match F16C bit for bit: rounding is to nearest even,
+	// and NaNs come out quiet with their payload's high bits.  Float64 always converts this way.
+	// HalfToFloat32Bits, Float32BitsToHalf and Float64BitsToHalf are the same conversions on the host.
+	return Append(
+		"static inline float rkc_f16_to_f32(uint16_t h)\n"
+		"{\n"
+		"\tconst uint32_t sign = (uint32_t)(h & 0x8000u) << 16;\n"
+		"\tconst uint32_t exponent = (h >> 10) & 0x1fu;\n"
+		"\tuint32_t mantissa = h & 0x3ffu;\n"
+		"\tif (exponent == 0x1fu)\n"
+		"\t\treturn rkc_f32_from_bits(sign | 0x7f800000u | (mantissa << 13) | ((mantissa != 0) ? 0x400000u : 0u));\n"
+		"\tif (exponent != 0)\n"
+		"\t\treturn rkc_f32_from_bits(sign | ((exponent + 112u) << 23) | (mantissa << 13));\n"
+		"\tif (mantissa == 0)\n"
+		"\t\treturn rkc_f32_from_bits(sign);\n"
+		"\tuint32_t normalExponent = 113;\n"
+		"\twhile (!(mantissa & 0x400u))\n"
+		"\t{\n"
+		"\t\tmantissa <<= 1;\n"
+		"\t\tnormalExponent--;\n"
+		"\t}\n"
+		"\treturn rkc_f32_from_bits(sign | (normalExponent << 23) | ((mantissa & 0x3ffu) << 13));\n"
+		"}\n"
+		"\n"
+		"static inline uint16_t rkc_round_to_f16(uint32_t sign, int32_t halfExponent, uint64_t significand, int fractionBits)\n"
+		"{\n"
+		"\tif (halfExponent >= 31)\n"
+		"\t\treturn (uint16_t)(sign | 0x7c00u);\n"
+		"\tint shift = fractionBits - 10;\n"
+		"\tuint32_t result = 0;\n"
+		"\tif (halfExponent >= 1)\n"
+		"\t\tresult = ((uint32_t)(halfExponent - 1) << 10) + (uint32_t)(significand >> shift);\n"
+		"\telse\n"
+		"\t{\n"
+		"\t\tshift += 1 - halfExponent;\n"
+		"\t\tif (shift > fractionBits + 1)\n"
+		"\t\t\treturn (uint16_t)sign;\n"
+		"\t\tresult = (uint32_t)(significand >> shift);\n"
+		"\t}\n"
+		"\tconst uint64_t remainder = significand & (((uint64_t)1 << shift) - 1u);\n"
+		"\tconst uint64_t halfway = (uint64_t)1 << (shift - 1);\n"
+		"\tif (remainder > halfway || (remainder == halfway && (result & 1u)))\n"
+		"\t\tresult++;\n"
+		"\treturn (uint16_t)(sign | result);\n"
+		"}\n"
+		"\n"
+		"static inline uint16_t rkc_f32_to_f16(float f)\n"
+		"{\n"
+		"\tuint32_t bits;\n"
+		"\tmemcpy(&bits, &f, sizeof(bits));\n"
+		"\tconst uint32_t sign = (bits >> 16) & 0x8000u;\n"
+		"\tconst uint32_t exponent = (bits >> 23) & 0xffu;\n"
+		"\tconst uint32_t mantissa = bits & 0x7fffffu;\n"
+		"\tif (exponent == 0xffu)\n"
+		"\t\treturn (uint16_t)(sign | 0x7c00u | ((mantissa != 0) ? (0x200u | (mantissa >> 13)) : 0u));\n"
+		"\tif (exponent == 0)\n"
+		"\t\treturn (uint16_t)sign;\n"
+		"\treturn rkc_round_to_f16(sign, (int32_t)exponent - 112, mantissa | 0x800000u, 23);\n"
+		"}\n"
+		"\n"
+		"static inline uint16_t rkc_f64_to_f16(double f)\n"
+		"{\n"
+		"\tuint64_t bits;\n"
+		"\tmemcpy(&bits, &f, sizeof(bits));\n"
+		"\tconst uint32_t sign = (uint32_t)(bits >> 48) & 0x8000u;\n"
+		"\tconst uint32_t exponent = (uint32_t)(bits >> 52) & 0x7ffu;\n"
+		"\tconst uint64_t mantissa = bits & 0xfffffffffffffull;\n"
+		"\tif (exponent == 0x7ffu)\n"
+		"\t\treturn (uint16_t)(sign | 0x7c00u | ((mantissa != 0) ? (0x200u | (uint32_t)(mantissa >> 42)) : 0u));\n"
+		"\tif (exponent == 0)\n"
+		"\t\treturn (uint16_t)sign;\n"
+		"\treturn rkc_round_to_f16(sign, (int32_t)exponent - 1008, mantissa | 0x10000000000000ull, 52);\n"
+		"}\n"
+		"\n");
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitMaskType(uint8_t bits)
+{
+	TemplateVars vars;
+	BuildMaskVars(bits, vars);
+
+	RKC_CHECK(AppendTemplate("struct $M\n{\n\t$H v;\n};\n\n", vars));
+
+	if (m_target.GetIsa() == SimdIsa::kAVX512)
+	{
+		return AppendTemplate(
+			"static inline $M $M_and($M a, $M b) { $M r; r.v = (__mmask16)(a.v & b.v); return r; }\n"
+			"static inline $M $M_or($M a, $M b) { $M r; r.v = (__mmask16)(a.v | b.v); return r; }\n"
+			"static inline $M $M_xor($M a, $M b) { $M r; r.v = (__mmask16)(a.v ^ b.v); return r; }\n"
+			"static inline $M $M_not($M a) { $M r; r.v = (__mmask16)(~a.v & $N); return r; }\n"
+			"static inline uint32_t $M_tobits($M m) { return (uint32_t)m.v; }\n"
+			"static inline $M $M_frombits(uint32_t bits) { $M r; r.v = (__mmask16)bits; return r; }\n"
+			"static inline $M $M_select($M m, $M a, $M b) { $M r; r.v = (__mmask16)((a.v & m.v) | (b.v & ~m.v)); return r; }\n"
+			"\n", vars);
+	}
+
+	RKC_CHECK(AppendTemplate(
+		"static inline $M $M_and($M a, $M b) { $M r; r.v = $P_and_$B(a.v, b.v); return r; }\n"
+		"static inline $M $M_or($M a, $M b) { $M r; r.v = $P_or_$B(a.v, b.v); return r; }\n"
+		"static inline $M $M_xor($M a, $M b) { $M r; r.v = $P_xor_$B(a.v, b.v); return r; }\n"
+		"static inline $M $M_not($M a) { $M r; r.v = $P_xor_$B(a.v, $P_set1_epi32(-1)); return r; }\n"
+		"static inline $M $M_select($M m, $M a, $M b) { $M r; r.v = $P_blendv_epi8(b.v, a.v, m.v); return r; }\n"
+		, vars));
+
+	const bool isWide = (GetMaskRegisterBits(bits) == 256);
+
+	// Lane bits come from the move-mask of the narrowest lane size that has one, packing 16-bit lanes
+	// down to bytes first
+	const char *toBits = nullptr;
+	switch (bits)
+	{
+	case 8:
+		toBits = "_mm_movemask_epi8(m.v)";
+		break;
+	case 16:
+		toBits = isWide
+			? "_mm_movemask_epi8(_mm_packs_epi16(_mm256_castsi256_si128(m.v), _mm256_extracti128_si256(m.v, 1)))"
+			: "_mm_movemask_epi8(_mm_packs_epi16(m.v, _mm_setzero_si128()))";
+		break;
+	case 32:
+		toBits = "$P_movemask_ps($P_cast$B_ps(m.v))";
+		break;
+	default:
+		toBits = "$P_movemask_pd($P_cast$B_pd(m.v))";
+		break;
+	}
+
+	RKC_CHECK(AppendTemplate("static inline uint32_t $M_tobits($M m) { return (uint32_t)", vars));
+	RKC_CHECK(AppendTemplate(toBits, vars));
+	RKC_CHECK(AppendTemplate(" & $N; }\n", vars));
+
+	// Going back, every lane picks out its own bit of the broadcast bits and compares against it
+	switch (bits)
+	{
+	case 8:
+		RKC_CHECK(AppendTemplate(
+			"static inline $M $M_frombits(uint32_t bits)\n"
+			"{\n"
+			"\tconst __m128i laneBits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);\n"
+			"\tconst __m128i bytes = _mm_shuffle_epi8(_mm_cvtsi32_si128((int)bits), _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1));\n"
+			"\t$M r;\n"
+			"\tr.v = _mm_cmpeq_epi8(_mm_and_si128(bytes, laneBits), laneBits);\n"
+			"\treturn r;\n"
+			"}\n", vars));
+		break;
+	case 16:
+		RKC_CHECK(AppendTemplate("static inline $M $M_frombits(uint32_t bits)\n{\n\tconst $R laneBits = $P_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128", vars));
+		if (isWide)
+		{
+			RKC_CHECK(Append(", 256, 512, 1024, 2048, 4096, 8192, 16384, (short)0x8000"));
+		}
+		RKC_CHECK(AppendTemplate(");\n"
+			"\t$M r;\n"
+			"\tr.v = $P_cmpeq_epi16($P_and_$B($P_set1_epi16((short)bits), laneBits), laneBits);\n"
+			"\treturn r;\n"
+			"}\n", vars));
+		break;
+	case 32:
+		RKC_CHECK(AppendTemplate("static inline $M $M_frombits(uint32_t bits)\n{\n\tconst $R laneBits = $P_setr_epi32(1, 2, 4, 8", vars));
+		if (isWide)
+		{
+			RKC_CHECK(Append(", 16, 32, 64, 128"));
+		}
+		RKC_CHECK(AppendTemplate(");\n"
+			"\t$M r;\n"
+			"\tr.v = $P_cmpeq_epi32($P_and_$B($P_set1_epi32((int)bits), laneBits), laneBits);\n"
+			"\treturn r;\n"
+			"}\n", vars));
+		break;
+	default:
+		RKC_CHECK(AppendTemplate("static inline $M $M_frombits(uint32_t bits)\n{\n\tconst $R laneBits = ", vars));
+		RKC_CHECK(Append(isWide ? "_mm256_setr_epi64x(1, 2, 4, 8)" : "_mm_set_epi64x(2, 1)"));
+		RKC_CHECK(AppendTemplate(";\n"
+			"\t$M r;\n"
+			"\tr.v = $P_cmpeq_epi64($P_and_$B($P_set1_epi64x((long long)bits), laneBits), laneBits);\n"
+			"\treturn r;\n"
+			"}\n", vars));
+		break;
+	}
+
+	return Append("\n");
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitVectorType(SimdElementFormat format)
+{
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+
+	// Half-precision lanes are held as 16-bit integers
+	const bool isHalf = (format == SimdElementFormat::kFloat16);
+	const bool isFloat = SimdTarget::IsFloatFormat(format) && !isHalf;
+	const bool isSigned = SimdTarget::IsSignedFormat(format);
+	const uint8_t elementBits = SimdTarget::GetElementBits(format);
+	const bool isAVX512 = (m_target.GetIsa() == SimdIsa::kAVX512);
+	const bool isFullRegister = (elementBits * m_target.GetNumLanes() == m_target.GetRegisterBits(format));
+
+	RKC_CHECK(AppendTemplate("struct $V\n{\n\t$R v;\n};\n\n", vars));
+
+	// Loads and stores.  A partial register only moves the bytes that hold lanes.
+	if (isFloat)
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_loadn(const $E *p, size_t n) { $V r; r.v = $P_setzero_$S(); memcpy(&r.v, p, sizeof($E) * n); return r; }\n"
+			"static inline $V $V_load(const $E *p) { $V r; r.v = $P_loadu_$S(p); return r; }\n"
+			"static inline void $V_storen($E *p, $V a, size_t n) { memcpy(p, &a.v, sizeof($E) * n); }\n"
+			"static inline void $V_store($E *p, $V a) { $P_storeu_$S(p, a.v); }\n"
+			, vars));
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_loadn(const $E *p, size_t n) { $V r; r.v = $P_setzero_$B(); memcpy(&r.v, p, sizeof($E) * n); return r; }\n"
+			"static inline void $V_storen($E *p, $V a, size_t n) { memcpy(p, &a.v, sizeof($E) * n); }\n"
+			, vars));
+
+		if (isFullRegister)
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline $V $V_load(const $E *p) { $V r; r.v = $P_loadu_$B((const $R *)p); return r; }\n"
+				"static inline void $V_store($E *p, $V a) { $P_storeu_$B(($R *)p, a.v); }\n"
+				, vars));
+		}
+		else
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline $V $V_load(const $E *p) { return $V_loadn(p, $L); }\n"
+				"static inline void $V_store($E *p, $V a) { $V_storen(p, a, $L); }\n"
+				, vars));
+		}
+
+		if (!isHalf)
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline $V $V_iota(size_t base) { $E t[$L]; for (size_t i = 0; i < $L; i++) t[i] = ($E)(base + i); return $V_loadn(t, $L); }\n"
+				, vars));
+		}
+	}
+
+	// Masked stores write the lanes whose bits are set
+	if (isAVX512)
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline void $V_storem($E *p, $V a, uint32_t bits) { $P_mask_storeu_$S(p, (__mmask16)bits, a.v); }\n"
+			, vars));
+	}
+	else if (m_target.GetIsa() == SimdIsa::kAVX2 && elementBits >= 32 && isFullRegister)
+	{
+		if (isFloat)
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline void $V_storem($E *p, $V a, uint32_t bits) { $P_maskstore_$S(p, $M_frombits(bits).v, a.v); }\n"
+				, vars));
+		}
+		else
+		{
+			RKC_CHECK(AppendTemplate((elementBits == 32)
+				? "static inline void $V_storem($E *p, $V a, uint32_t bits) { $P_maskstore_epi32((int *)p, $M_frombits(bits).v, a.v); }\n"
+				: "static inline void $V_storem($E *p, $V a, uint32_t bits) { $P_maskstore_epi64((long long *)p, $M_frombits(bits).v, a.v); }\n"
+				, vars));
+		}
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline void $V_storem($E *p, $V a, uint32_t bits)\n"
+			"{\n"
+			"\t$E t[$L];\n"
+			"\tmemcpy(t, &a.v, sizeof(t));\n"
+			"\tfor (size_t i = 0; i < $L; i++)\n"
+			"\t{\n"
+			"\t\tif (bits & (1u << i))\n"
+			"\t\t\tp[i] = t[i];\n"
+			"\t}\n"
+			"}\n"
+			, vars));
+	}
+
+	RKC_CHECK(AppendTemplate("static inline $V $V_splat($E s) { $V r; r.v = $P_set1_$O(($C)s); return r; }\n", vars));
+
+	// Everything else that half-precision lanes do goes through float32 (see EmitHalfOperations)
+	if (isHalf)
+	{
+		RKC_CHECK(AppendTemplate(isAVX512
+			? "static inline $V $V_select($M m, $V a, $V b) { $V r; r.v = $P_mask_blend_$S(m.v, b.v, a.v); return r; }\n"
+			: "static inline $V $V_select($M m, $V a, $V b) { $V r; r.v = $P_blendv_epi8(b.v, a.v, m.v); return r; }\n"
+			, vars));
+
+		return Append("\n");
+	}
+
+	RKC_CHECK(AppendTemplate(
+		"static inline $V $V_add($V a, $V b) { $V r; r.v = $P_add_$S(a.v, b.v); return r; }\n"
+		"static inline $V $V_sub($V a, $V b) { $V r; r.v = $P_sub_$S(a.v, b.v); return r; }\n"
+		, vars));
+
+	// Multiplies keep the low bits of the product, which are the same for signed and unsigned lanes
+	if (isFloat || elementBits == 16 || elementBits == 32 || (elementBits == 64 && isAVX512))
+	{
+		RKC_CHECK(AppendTemplate(isFloat
+			? "static inline $V $V_mul($V a, $V b) { $V r; r.v = $P_mul_$S(a.v, b.v); return r; }\n"
+			: "static inline $V $V_mul($V a, $V b) { $V r; r.v = $P_mullo_$S(a.v, b.v); return r; }\n"
+			, vars));
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_mul($V a, $V b)\n"
+			"{\n"
+			"\t$E x[$L];\n"
+			"\t$E y[$L];\n"
+			"\tmemcpy(x, &a.v, sizeof(x));\n"
+			"\tmemcpy(y, &b.v, sizeof(y));\n"
+			"\tfor (size_t i = 0; i < $L; i++)\n"
+			"\t\tx[i] = ($E)((uint64_t)x[i] * (uint64_t)y[i]);\n"
+			"\treturn $V_loadn(x, $L);\n"
+			"}\n"
+			, vars));
+	}
+
+	if (!isFloat)
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_and($V a, $V b) { $V r; r.v = $P_and_$B(a.v, b.v); return r; }\n"
+			"static inline $V $V_or($V a, $V b) { $V r; r.v = $P_or_$B(a.v, b.v); return r; }\n"
+			"static inline $V $V_xor($V a, $V b) { $V r; r.v = $P_xor_$B(a.v, b.v); return r; }\n"
+			"static inline $V $V_not($V a) { $V r; r.v = $P_xor_$B(a.v, $P_set1_epi32(-1)); return r; }\n"
+			, vars));
+	}
+
+	// Comparisons
+	if (isAVX512)
+	{
+		const char *predicates[6];
+		if (isFloat)
+		{
+			predicates[0] = "_CMP_EQ_OQ";
+			predicates[1] = "_CMP_NEQ_UQ";
+			predicates[2] = "_CMP_LT_OQ";
+			predicates[3] = "_CMP_LE_OQ";
+			predicates[4] = "_CMP_GT_OQ";
+			predicates[5] = "_CMP_GE_OQ";
+		}
+		else
+		{
+			predicates[0] = "_MM_CMPINT_EQ";
+			predicates[1] = "_MM_CMPINT_NE";
+			predicates[2] = "_MM_CMPINT_LT";
+			predicates[3] = "_MM_CMPINT_LE";
+			predicates[4] = "_MM_CMPINT_NLE";
+			predicates[5] = "_MM_CMPINT_NLT";
+		}
+
+		const char *names[6] = { "eq", "ne", "lt", "le", "gt", "ge" };
+		for (size_t i = 0; i < 6; i++)
+		{
+			RKC_CHECK(AppendTemplate("static inline $M $V_cmp", vars));
+			RKC_CHECK(Append(names[i]));
+			RKC_CHECK(AppendTemplate("($V a, $V b) { $M r; r.v = (__mmask16)($P_cmp_$Q_mask(a.v, b.v, ", vars));
+			RKC_CHECK(Append(predicates[i]));
+			RKC_CHECK(AppendTemplate(") & $N); return r; }\n", vars));
+		}
+
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_select($M m, $V a, $V b) { $V r; r.v = $P_mask_blend_$S(m.v, b.v, a.v); return r; }\n"
+			, vars));
+	}
+	else if (isFloat)
+	{
+		if (m_target.GetRegisterBits(format) == 128)
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline $M $V_cmpeq($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmpeq_$S(a.v, b.v)); return r; }\n"
+				"static inline $M $V_cmpne($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmpneq_$S(a.v, b.v)); return r; }\n"
+				"static inline $M $V_cmplt($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmplt_$S(a.v, b.v)); return r; }\n"
+				"static inline $M $V_cmple($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmple_$S(a.v, b.v)); return r; }\n"
+				"static inline $M $V_cmpgt($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmpgt_$S(a.v, b.v)); return r; }\n"
+				"static inline $M $V_cmpge($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmpge_$S(a.v, b.v)); return r; }\n"
+				, vars));
+		}
+		else
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline $M $V_cmpeq($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmp_$S(a.v, b.v, _CMP_EQ_OQ)); return r; }\n"
+				"static inline $M $V_cmpne($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmp_$S(a.v, b.v, _CMP_NEQ_UQ)); return r; }\n"
+				"static inline $M $V_cmplt($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmp_$S(a.v, b.v, _CMP_LT_OQ)); return r; }\n"
+				"static inline $M $V_cmple($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmp_$S(a.v, b.v, _CMP_LE_OQ)); return r; }\n"
+				"static inline $M $V_cmpgt($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmp_$S(a.v, b.v, _CMP_GT_OQ)); return r; }\n"
+				"static inline $M $V_cmpge($V a, $V b) { $M r; r.v = $P_cast$S_$B($P_cmp_$S(a.v, b.v, _CMP_GE_OQ)); return r; }\n"
+				, vars));
+		}
+
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_select($M m, $V a, $V b) { $V r; r.v = $P_blendv_$S(b.v, a.v, $P_cast$B_$S(m.v)); return r; }\n"
+			, vars));
+	}
+	else
+	{
+		// Only signed greater-than exists, so unsigned lanes are compared with their sign bits flipped
+		if (isSigned)
+		{
+			RKC_CHECK(AppendTemplate("static inline $R $V_gt($R a, $R b) { return $P_cmpgt_$S(a, b); }\n", vars));
+		}
+		else
+		{
+			RKC_CHECK(AppendTemplate(
+				"static inline $R $V_gt($R a, $R b) { const $R bias = $V_splat(($E)((uint64_t)1 << ($K - 1))).v; return $P_cmpgt_$S($P_xor_$B(a, bias), $P_xor_$B(b, bias)); }\n"
+				, vars));
+		}
+
+		RKC_CHECK(AppendTemplate(
+			"static inline $M $V_cmpeq($V a, $V b) { $M r; r.v = $P_cmpeq_$S(a.v, b.v); return r; }\n"
+			"static inline $M $V_cmpne($V a, $V b) { $M r; r.v = $P_xor_$B($P_cmpeq_$S(a.v, b.v), $P_set1_epi32(-1)); return r; }\n"
+			"static inline $M $V_cmplt($V a, $V b) { $M r; r.v = $V_gt(b.v, a.v); return r; }\n"
+			"static inline $M $V_cmple($V a, $V b) { $M r; r.v = $P_xor_$B($V_gt(a.v, b.v), $P_set1_epi32(-1)); return r; }\n"
+			"static inline $M $V_cmpgt($V a, $V b) { $M r; r.v = $V_gt(a.v, b.v); return r; }\n"
+			"static inline $M $V_cmpge($V a, $V b) { $M r; r.v = $P_xor_$B($V_gt(b.v, a.v), $P_set1_epi32(-1)); return r; }\n"
+			"static inline $V $V_select($M m, $V a, $V b) { $V r; r.v = $P_blendv_epi8(b.v, a.v, m.v); return r; }\n"
+			, vars));
+	}
+
+	// 64-bit integer min and max are AVX-512 only
+	if (isFloat || elementBits < 64 || isAVX512)
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_min($V a, $V b) { $V r; r.v = $P_min_$Q(a.v, b.v); return r; }\n"
+			"static inline $V $V_max($V a, $V b) { $V r; r.v = $P_max_$Q(a.v, b.v); return r; }\n"
+			, vars));
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $V $V_min($V a, $V b) { return $V_select($V_cmpgt(a, b), b, a); }\n"
+			"static inline $V $V_max($V a, $V b) { return $V_select($V_cmpgt(a, b), a, b); }\n"
+			, vars));
+	}
+
+	return Append("\n");
+}
+
+// Half-precision values are widened to float32 for every operation and rounded back, which gives the
+// same result as doing it in half precision since float32 has more than twice the precision.  F16C
+// does the conversions where it's available, and otherwise they're done a lane at a time in software
+// with the same results, down to NaN payloads.
+rkci::Result rkci::SimdCppEmitter::EmitHalfOperations()
+{
+	TemplateVars vars;
+	BuildVectorVars(SimdElementFormat::kFloat16, vars);
+
+	TemplateVars floatVars;
+	BuildVectorVars(SimdElementFormat::kFloat32, floatVars);
+
+	// $W is the float32 vector type, $G its intrinsic prefix, and $F its mask type
+	SetVar(vars, 'W', floatVars.m_values['V' - 'A']);
+	SetVar(vars, 'G', floatVars.m_values['P' - 'A']);
+	SetVar(vars, 'F', floatVars.m_values['M' - 'A']);
+
+	if (m_target.HasF16C())
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $W $V_tof32($V a) { $W r; r.v = $G_cvtph_ps(a.v); return r; }\n"
+			"static inline $V $V_fromf32($W a) { $V r; r.v = $G_cvtps_ph(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); return r; }\n"
+			, vars));
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate(
+			"static inline $W $V_tof32($V a)\n"
+			"{\n"
+			"\tuint16_t x[$L];\n"
+			"\tfloat y[$L];\n"
+			"\tmemcpy(x, &a.v, sizeof(x));\n"
+			"\tfor (size_t i = 0; i < $L; i++)\n"
+			"\t\ty[i] = rkc_f16_to_f32(x[i]);\n"
+			"\treturn $W_loadn(y, $L);\n"
+			"}\n"
+			"static inline $V $V_fromf32($W a)\n"
+			"{\n"
+			"\tfloat x[$L];\n"
+			"\tuint16_t y[$L];\n"
+			"\tmemcpy(x, &a.v, sizeof(x));\n"
+			"\tfor (size_t i = 0; i < $L; i++)\n"
+			"\t\ty[i] = rkc_f32_to_f16(x[i]);\n"
+			"\treturn $V_loadn(y, $L);\n"
+			"}\n"
+			, vars));
+	}
+
+	const char *binaryOps[] = { "add", "sub", "mul", "min", "max" };
+	for (size_t i = 0; i < sizeof(binaryOps) / sizeof(binaryOps[0]); i++)
+	{
+		SetVar(vars, 'I', binaryOps[i]);
+		RKC_CHECK(AppendTemplate("static inline $V $V_$I($V a, $V b) { return $V_fromf32($W_$I($V_tof32(a), $V_tof32(b))); }\n", vars));
+	}
+
+	const char *compareOps[] = { "cmpeq", "cmpne", "cmplt", "cmple", "cmpgt", "cmpge" };
+	for (size_t i = 0; i < sizeof(compareOps) / sizeof(compareOps[0]); i++)
+	{
+		SetVar(vars, 'I', compareOps[i]);
+		RKC_CHECK(AppendTemplate("static inline $M $V_$I($V a, $V b) { return $M_frombits($F_tobits($W_$I($V_tof32(a), $V_tof32(b)))); }\n", vars));
+	}
+
+	return Append("\n");
+}
+
+// Conversions go through memory one lane at a time, which the host compiler is free to vectorize.
+// Half-precision values go through float32, except from float64, which is rounded directly so that
+// it's only rounded once.
+rkci::Result rkci::SimdCppEmitter::EmitConversion(SimdElementFormat fromFormat, SimdElementFormat toFormat)
+{
+	TemplateVars vars;
+	BuildVectorVars(toFormat, vars);
+
+	TemplateVars fromVars;
+	BuildVectorVars(fromFormat, fromVars);
+
+	TemplateVars floatVars;
+	BuildVectorVars(SimdElementFormat::kFloat32, floatVars);
+
+	SetVar(vars, 'F', fromVars.m_values['V' - 'A']);
+	SetVar(vars, 'G', fromVars.m_values['E' - 'A']);
+	SetVar(vars, 'I', GetFormatName(fromFormat));
+	SetVar(vars, 'W', floatVars.m_values['V' - 'A']);
+
+	if (fromFormat == SimdElementFormat::kFloat16)
+	{
+		if (toFormat == SimdElementFormat::kFloat32)
+			return AppendTemplate("static inline $V $V_from_$I($F a) { return $F_tof32(a); }\n\n", vars);
+
+		return AppendTemplate(
+			"static inline $V $V_from_$I($F a)\n"
+			"{\n"
+			"\tconst $W w = $F_tof32(a);\n"
+			"\tfloat x[$L];\n"
+			"\t$E y[$L];\n"
+			"\tmemcpy(x, &w.v, sizeof(x));\n"
+			"\tfor (size_t i = 0; i < $L; i++)\n"
+			"\t\ty[i] = ($E)x[i];\n"
+			"\treturn $V_loadn(y, $L);\n"
+			"}\n"
+			"\n", vars);
+	}
+
+	if (toFormat == SimdElementFormat::kFloat16)
+	{
+		if (fromFormat == SimdElementFormat::kFloat32)
+			return AppendTemplate("static inline $V $V_from_$I($F a) { return $V_fromf32(a); }\n\n", vars);
+
+		if (fromFormat == SimdElementFormat::kFloat64)
+		{
+			return AppendTemplate(
+				"static inline $V $V_from_$I($F a)\n"
+				"{\n"
+				"\tdouble x[$L];\n"
+				"\tuint16_t y[$L];\n"
+				"\tmemcpy(x, &a.v, sizeof(x));\n"
+				"\tfor (size_t i = 0; i < $L; i++)\n"
+				"\t\ty[i] = rkc_f64_to_f16(x[i]);\n"
+				"\treturn $V_loadn(y, $L);\n"
+				"}\n"
+				"\n", vars);
+		}
+
+		// Integers that float32 can't hold exactly are beyond the half-precision range either way
+		return AppendTemplate(
+			"static inline $V $V_from_$I($F a)\n"
+			"{\n"
+			"\t$G x[$L];\n"
+			"\tfloat y[$L];\n"
+			"\tmemcpy(x, &a.v, sizeof(x));\n"
+			"\tfor (size_t i = 0; i < $L; i++)\n"
+			"\t\ty[i] = (float)x[i];\n"
+			"\treturn $V_fromf32($W_loadn(y, $L));\n"
+			"}\n"
+			"\n", vars);
+	}
+
+	return AppendTemplate(
+		"static inline $V $V_from_$I($F a)\n"
+		"{\n"
+		"\t$G x[$L];\n"
+		"\t$E y[$L];\n"
+		"\tmemcpy(x, &a.v, sizeof(x));\n"
+		"\tfor (size_t i = 0; i < $L; i++)\n"
+		"\t\ty[i] = ($E)x[i];\n"
+		"\treturn $V_loadn(y, $L);\n"
+		"}\n"
+		"\n", vars);
+}
+
+// Custom floatspec helpers are named after their type's index, and work on the bits of the wide
+// format.  Denormals are the exception: adding a power of two whose last mantissa bit is the smallest
+// denormal has the FPU round to a whole number of them, and leaves that number in the low bits.
+// Indexes are widened to 64 bits, where negative indexes wrap around past the end of any buffer
+rkci::Result rkci::SimdCppEmitter::EmitIndexOperations(SimdElementFormat format)
+{
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+
+	return AppendTemplate(
+		"static inline uint64_t rkc_lane0($V a) { $E t; memcpy(&t, &a.v, sizeof(t)); return (uint64_t)t; }\n"
+		"static inline void rkc_lanes($V a, uint64_t *out) { $E t[$L]; memcpy(t, &a.v, sizeof(t)); for (size_t i = 0; i < $L; i++) out[i] = (uint64_t)t[i]; }\n"
+		"\n"
+		, vars);
+}
+
+// Contiguous runs are one vector access when the whole run is inside the buffer, which is the case
+// for every block but the ones at the edges, and otherwise only touch lanes whose bits are set and
+// whose element is before the buffer's length.  Partial blocks access the lane index's run this way.
+rkci::Result rkci::SimdCppEmitter::EmitRunOperations(SimdElementFormat format)
+{
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+
+	return AppendTemplate(
+		"static inline $V $V_loadrun(const $E *p, uint64_t first, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tif (first <= length && length - first >= $L)\n"
+		"\t\treturn $V_load(p + first);\n"
+		"\t$E t[$L];\n"
+		"\tfor (size_t i = 0; i < $L; i++)\n"
+		"\t\tt[i] = ((bits & (1u << i)) && first + i < length) ? p[first + i] : ($E)0;\n"
+		"\treturn $V_loadn(t, $L);\n"
+		"}\n"
+		"static inline void $V_storerun($E *p, uint64_t first, $V a, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tif (first <= length && length - first >= $L)\n"
+		"\t{\n"
+		"\t\tif (bits == $N)\n"
+		"\t\t\t$V_store(p + first, a);\n"
+		"\t\telse\n"
+		"\t\t\t$V_storem(p + first, a, bits);\n"
+		"\t\treturn;\n"
+		"\t}\n"
+		"\t$E t[$L];\n"
+		"\tmemcpy(t, &a.v, sizeof(t));\n"
+		"\tfor (size_t i = 0; i < $L; i++)\n"
+		"\t{\n"
+		"\t\tif ((bits & (1u << i)) && first + i < length)\n"
+		"\t\t\tp[first + i] = t[i];\n"
+		"\t}\n"
+		"}\n"
+		"\n"
+		, vars);
+}
+
+// Accesses at an index check it against the buffer's length, and only touch lanes whose bits are set.
+// A uniform store with several active lanes stores the highest one, the same as a scatter with every
+// lane at the same index.
+rkci::Result rkci::SimdCppEmitter::EmitAccessOperations(SimdElementFormat format)
+{
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+
+	RKC_CHECK(AppendTemplate(
+		"static inline $V $V_loadat(const $E *p, uint64_t i, size_t length) { return $V_splat((i < length) ? p[i] : ($E)0); }\n"
+		"template<class TIndex>\n"
+		"static inline $V $V_gather(const $E *p, TIndex idx, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tuint64_t i[$L];\n"
+		"\trkc_lanes(idx, i);\n"
+		"\t$E t[$L];\n"
+		"\tfor (size_t k = 0; k < $L; k++)\n"
+		"\t\tt[k] = ((bits & (1u << k)) && i[k] < length) ? p[i[k]] : ($E)0;\n"
+		"\treturn $V_loadn(t, $L);\n"
+		"}\n"
+		"static inline void $V_storeat($E *p, uint64_t i, $V a, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tif (bits == 0 || i >= length)\n"
+		"\t\treturn;\n"
+		"\t$E t[$L];\n"
+		"\tmemcpy(t, &a.v, sizeof(t));\n"
+		"\tsize_t k = $L - 1;\n"
+		"\twhile (!(bits & (1u << k)))\n"
+		"\t\tk--;\n"
+		"\tp[i] = t[k];\n"
+		"}\n"
+		"template<class TIndex>\n"
+		"static inline void $V_scatter($E *p, TIndex idx, $V a, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tuint64_t i[$L];\n"
+		"\trkc_lanes(idx, i);\n"
+		"\t$E t[$L];\n"
+		"\tmemcpy(t, &a.v, sizeof(t));\n"
+		"\tfor (size_t k = 0; k < $L; k++)\n"
+		"\t{\n"
+		"\t\tif ((bits & (1u << k)) && i[k] < length)\n"
+		"\t\t\tp[i[k]] = t[k];\n"
+		"\t}\n"
+		"}\n"
+		, vars));
+
+	// Gather and scatter instructions take 32-bit indexes for 32-bit elements
+	const SimdIsa isa = m_target.GetIsa();
+	const uint8_t elementBits = SimdTarget::GetElementBits(format);
+	const bool isFullRegister = (elementBits * m_target.GetNumLanes() == m_target.GetRegisterBits(format));
+
+	if ((isa == SimdIsa::kAVX2 || isa == SimdIsa::kAVX512) && elementBits == 32 && isFullRegister && format != SimdElementFormat::kFloat16)
+	{
+		const SimdElementFormat indexFormats[] = { SimdElementFormat::kInt32, SimdElementFormat::kUInt32 };
+
+		for (size_t i = 0; i < 2; i++)
+		{
+			if (m_indexFormatUsed[static_cast<size_t>(indexFormats[i])])
+			{
+				RKC_CHECK(EmitHardwareGather(format, indexFormats[i]));
+			}
+		}
+	}
+
+	return Append("\n");
+}
+
+// Lanes are in the buffer if their index is in [0, length), which is a signed comparison as long as
+// length - 1 fits in an int, and the generic versions handle the rest
+rkci::Result rkci::SimdCppEmitter::EmitHardwareGather(SimdElementFormat format, SimdElementFormat indexFormat)
+{
+	TemplateVars indexVars;
+	BuildVectorVars(indexFormat, indexVars);
+
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+	SetVar(vars, 'A', indexVars.m_values['V' - 'A']);
+
+	const bool isFloat = (format == SimdElementFormat::kFloat32);
+	const uint16_t registerBits = m_target.GetRegisterBits(format);
+
+	SetVar(vars, 'Y', isFloat ? "ps" : vars.m_values['B' - 'A']);
+	SetVar(vars, 'Z', (registerBits == 512) ? "__mmask16" : "__mmask8");
+	SetVar(vars, 'G', (registerBits == 512) ? "mask" : "mmask");
+
+	if (m_target.GetIsa() == SimdIsa::kAVX2)
+	{
+		return AppendTemplate(isFloat
+			? "static inline $V $V_gather(const $E *p, $A idx, uint32_t bits, size_t length)\n"
+			"{\n"
+			"\tif (length - 1u > 0x7fffffffu)\n"
+			"\t\treturn $V_gather<$A>(p, idx, bits, length);\n"
+			"\tconst $H outside = $P_or_$B($P_cmpgt_epi32(idx.v, $P_set1_epi32((int)(length - 1u))), $P_cmpgt_epi32($P_setzero_$B(), idx.v));\n"
+			"\t$V r;\n"
+			"\tr.v = $P_mask_i32gather_ps($P_setzero_ps(), p, idx.v, $P_cast$B_ps($P_andnot_$B(outside, $M_frombits(bits).v)), 4);\n"
+			"\treturn r;\n"
+			"}\n"
+			: "static inline $V $V_gather(const $E *p, $A idx, uint32_t bits, size_t length)\n"
+			"{\n"
+			"\tif (length - 1u > 0x7fffffffu)\n"
+			"\t\treturn $V_gather<$A>(p, idx, bits, length);\n"
+			"\tconst $H outside = $P_or_$B($P_cmpgt_epi32(idx.v, $P_set1_epi32((int)(length - 1u))), $P_cmpgt_epi32($P_setzero_$B(), idx.v));\n"
+			"\t$V r;\n"
+			"\tr.v = $P_mask_i32gather_epi32($P_setzero_$B(), (const int *)p, idx.v, $P_andnot_$B(outside, $M_frombits(bits).v), 4);\n"
+			"\treturn r;\n"
+			"}\n"
+			, vars);
+	}
+
+	return AppendTemplate(
+		"static inline $V $V_gather(const $E *p, $A idx, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tif (length - 1u > 0x7fffffffu)\n"
+		"\t\treturn $V_gather<$A>(p, idx, bits, length);\n"
+		"\tconst uint32_t outside = (uint32_t)($P_cmpgt_epi32_mask(idx.v, $P_set1_epi32((int)(length - 1u))) | $P_cmpgt_epi32_mask($P_setzero_$B(), idx.v));\n"
+		"\t$V r;\n"
+		"\tr.v = $P_$G_i32gather_$S($P_setzero_$Y(), ($Z)(bits & ~outside), idx.v, p, 4);\n"
+		"\treturn r;\n"
+		"}\n"
+		"static inline void $V_scatter($E *p, $A idx, $V a, uint32_t bits, size_t length)\n"
+		"{\n"
+		"\tif (length - 1u > 0x7fffffffu)\n"
+		"\t{\n"
+		"\t\t$V_scatter<$A>(p, idx, a, bits, length);\n"
+		"\t\treturn;\n"
+		"\t}\n"
+		"\tconst uint32_t outside = (uint32_t)($P_cmpgt_epi32_mask(idx.v, $P_set1_epi32((int)(length - 1u))) | $P_cmpgt_epi32_mask($P_setzero_$B(), idx.v));\n"
+		"\t$P_mask_i32scatter_$S(p, ($Z)(bits & ~outside), idx.v, a.v, 4);\n"
+		"}\n"
+		, vars);
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitCustomFloatOperations(const Kernel::Function &function, Kernel::TypeIndex_t type)
+{
+	const CustomFloatUses &uses = m_customFloatUses[type];
+	if (!uses.m_round && !uses.m_roundFromF64 && !uses.m_pack && !uses.m_unpack)
+		return Result::Ok();
+
+	const FloatSpec &floatSpec = function.GetType(type).m_floatSpec;
+	RKC_CHECK_RV(CustomFloatFormat, customFormat, CustomFloatFormat::Create(floatSpec));
+
+	// $D is the type's index, $U the storage vector type, and $T the storage format name
+	TemplateVars vars;
+	SetVarNumber(vars, 'D', type);
+
+	TemplateVars storageVars;
+	BuildVectorVars(customFormat.GetStorageFormat(), storageVars);
+	SetVar(vars, 'U', storageVars.m_values['V' - 'A']);
+	SetVar(vars, 'T', GetFormatName(customFormat.GetStorageFormat()));
+
+	const int16_t exponentOfOne = floatSpec.GetExponentOfOne();
+
+	RKC_CHECK(AppendTemplate("// Type $D: ", vars));
+	RKC_CHECK(Append(floatSpec.IsSigned() ? "signed, " : "unsigned, "));
+	RKC_CHECK(AppendDecimal(floatSpec.GetExponentBits()));
+	RKC_CHECK(Append(" exponent bits, "));
+	RKC_CHECK(AppendDecimal(floatSpec.GetMantissaBits()));
+	RKC_CHECK(Append(" mantissa bits, exponent of one "));
+	RKC_CHECK(Append((exponentOfOne < 0) ? "-" : ""));
+	RKC_CHECK(AppendDecimal(static_cast<uint64_t>((exponentOfOne < 0) ? -exponentOfOne : exponentOfOne)));
+	RKC_CHECK(Append(floatSpec.SupportsDenormals() ? ", denormals" : ""));
+	RKC_CHECK(Append(floatSpec.SupportsNans() ? ", NaNs" : ""));
+	RKC_CHECK(Append("\n"));
+
+	if (uses.m_round)
+	{
+		RKC_CHECK(EmitCustomFloatRound(customFormat, customFormat.GetWideFormat(), vars));
+	}
+
+	if (uses.m_roundFromF64)
+	{
+		RKC_CHECK(EmitCustomFloatRound(customFormat, SimdElementFormat::kFloat64, vars));
+	}
+
+	if (uses.m_pack)
+	{
+		RKC_CHECK(EmitCustomFloatPack(customFormat, vars));
+	}
+
+	if (uses.m_unpack)
+	{
+		RKC_CHECK(EmitCustomFloatUnpack(customFormat, vars));
+	}
+
+	return Append("\n");
+}
+
+// Rounds to nearest even the same way as CustomFloatFormat::Round.  Rounding from float64 into a
+// float32 wide format is named with an _f64 suffix, and returns float64.
+rkci::Result rkci::SimdCppEmitter::EmitCustomFloatRound(const CustomFloatFormat &customFormat, SimdElementFormat sourceFormat, TemplateVars &vars)
+{
+	const FloatSpec &floatSpec = customFormat.GetFloatSpec();
+	const CustomFloatFormat::RoundingParams params = customFormat.GetRoundingParams(sourceFormat);
+	const uint64_t signBit = static_cast<uint64_t>(1) << (SimdTarget::GetElementBits(sourceFormat) - 1);
+	const uint64_t dropMask = (static_cast<uint64_t>(1) << params.m_dropBits) - 1u;
+	const uint64_t keepMask = ((signBit << 1) - 1u) & ~dropMask;
+
+	BuildCustomFloatVars(sourceFormat, vars);
+	SetVar(vars, 'F', (sourceFormat == customFormat.GetWideFormat()) ? "" : "_f64");
+	SetVarNumber(vars, 'J', params.m_dropBits);
+	SetVarHex(vars, 'X', signBit - 1u);
+
+	RKC_CHECK(AppendTemplate(
+		"static inline $V rkcs$D_round$F($V a)\n"
+		"{\n"
+		"\t$I x;\n"
+		"\tx.v = $P_cast$S_$B(a.v);\n"
+		"\tconst $I m = $I_and(x, $I_splat(($G)$Xll));\n"
+		, vars));
+
+	SetVarHex(vars, 'X', (dropMask >> 1));
+	SetVarHex(vars, 'Y', keepMask);
+
+	RKC_CHECK(AppendTemplate(
+		"\t$I lsb;\n"
+		"\tlsb.v = $P_srli_$A(m.v, $J);\n"
+		"\t$I r = $I_and($I_add($I_add(m, $I_splat(($G)$Xll)), $I_and(lsb, $I_splat(($G)1))), $I_splat(($G)$Yll));\n"
+		, vars));
+
+	if (floatSpec.SupportsDenormals())
+	{
+		SetVarHex(vars, 'X', params.m_denormalBase);
+		SetVarHex(vars, 'Y', params.m_minNormal);
+
+		RKC_CHECK(AppendTemplate(
+			"\t$V t;\n"
+			"\tt.v = $P_cast$B_$S($I_splat(($G)$Xll).v);\n"
+			"\t$V ax;\n"
+			"\tax.v = $P_cast$B_$S(m.v);\n"
+			"\t$I den;\n"
+			"\tden.v = $P_cast$S_$B($V_sub($V_add(ax, t), t).v);\n"
+			"\tr = $I_select($I_cmpgt($I_splat(($G)$Yll), m), den, r);\n"
+			, vars));
+	}
+	else
+	{
+		SetVarHex(vars, 'X', params.m_minNormal);
+		SetVarHex(vars, 'Y', params.m_flushThreshold);
+
+		RKC_CHECK(AppendTemplate(
+			"\tr = $I_select($I_cmpgt($I_splat(($G)$Xll), m), $I_splat(($G)$Xll), r);\n"
+			"\tr = $I_select($I_cmpgt($I_splat(($G)$Yll), m), $I_splat(($G)0), r);\n"
+			, vars));
+	}
+
+	SetVarHex(vars, 'X', params.m_overflowThreshold - 1u);
+	SetVarHex(vars, 'Y', floatSpec.SupportsNans() ? params.m_infinity : params.m_maxFinite);
+
+	RKC_CHECK(AppendTemplate("\tr = $I_select($I_cmpgt(m, $I_splat(($G)$Xll)), $I_splat(($G)$Yll), r);\n", vars));
+
+	SetVarHex(vars, 'X', signBit);
+
+	RKC_CHECK(AppendTemplate(floatSpec.IsSigned()
+		? "\tr = $I_or(r, $I_and(x, $I_splat(($G)$Xll)));\n"
+		: "\tr = $I_select($I_cmpgt($I_splat(($G)0), x), $I_splat(($G)0), r);\n"
+		, vars));
+
+	// NaNs are quieted and keep the high bits of their payload
+	SetVarHex(vars, 'X', params.m_infinity);
+	SetVarHex(vars, 'Y', params.m_quietBit);
+	SetVarHex(vars, 'Z', floatSpec.IsSigned() ? keepMask : (keepMask & (signBit - 1u)));
+
+	RKC_CHECK(AppendTemplate(floatSpec.SupportsNans()
+		? "\tr = $I_select($I_cmpgt(m, $I_splat(($G)$Xll)), $I_and($I_or(x, $I_splat(($G)$Yll)), $I_splat(($G)$Zll)), r);\n"
+		: "\tr = $I_select($I_cmpgt(m, $I_splat(($G)$Xll)), $I_splat(($G)0), r);\n"
+		, vars));
+
+	return AppendTemplate(
+		"\t$V result;\n"
+		"\tresult.v = $P_cast$B_$S(r.v);\n"
+		"\treturn result;\n"
+		"}\n"
+		, vars);
+}
+
+// Normal values are rebased against the smallest normal, whose exponent field is 1
+rkci::Result rkci::SimdCppEmitter::EmitCustomFloatPack(const CustomFloatFormat &customFormat, TemplateVars &vars)
+{
+	const FloatSpec &floatSpec = customFormat.GetFloatSpec();
+	const SimdElementFormat wideFormat = customFormat.GetWideFormat();
+	const CustomFloatFormat::RoundingParams params = customFormat.GetRoundingParams(wideFormat);
+	const uint8_t elementBits = SimdTarget::GetElementBits(wideFormat);
+	const uint64_t signBit = static_cast<uint64_t>(1) << (elementBits - 1);
+	const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+	const uint32_t encodedBits = floatSpec.GetExponentBits() + mantissaBits;
+
+	BuildCustomFloatVars(wideFormat, vars);
+	SetVarNumber(vars, 'J', params.m_dropBits);
+	SetVarHex(vars, 'X', signBit - 1u);
+	SetVarHex(vars, 'Y', params.m_minNormal);
+	SetVarHex(vars, 'Z', static_cast<uint64_t>(1) << mantissaBits);
+
+	RKC_CHECK(AppendTemplate(
+		"static inline $U rkcs$D_pack($V a)\n"
+		"{\n"
+		"\t$I x;\n"
+		"\tx.v = $P_cast$S_$B(a.v);\n"
+		"\tconst $I m = $I_and(x, $I_splat(($G)$Xll));\n"
+		"\t$I p;\n"
+		"\tp.v = $P_srli_$A($I_sub(m, $I_splat(($G)$Yll)).v, $J);\n"
+		"\tp = $I_add(p, $I_splat(($G)$Zll));\n"
+		, vars));
+
+	if (floatSpec.SupportsDenormals())
+	{
+		SetVarHex(vars, 'X', params.m_denormalBase);
+
+		RKC_CHECK(AppendTemplate(
+			"\tconst $I t = $I_splat(($G)$Xll);\n"
+			"\t$V ax;\n"
+			"\tax.v = $P_cast$B_$S(m.v);\n"
+			"\t$V sum;\n"
+			"\tsum.v = $P_cast$B_$S(t.v);\n"
+			"\tsum = $V_add(ax, sum);\n"
+			"\t$I den;\n"
+			"\tden.v = $P_cast$S_$B(sum.v);\n"
+			"\tp = $I_select($I_cmpgt($I_splat(($G)$Yll), m), $I_sub(den, t), p);\n"
+			, vars));
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate("\tp = $I_select($I_cmpgt($I_splat(($G)$Yll), m), $I_splat(($G)0), p);\n", vars));
+	}
+
+	if (floatSpec.SupportsNans())
+	{
+		SetVarHex(vars, 'X', params.m_infinity - 1u);
+		SetVarHex(vars, 'Y', (params.m_quietBit << 1) - 1u);
+		SetVarHex(vars, 'Z', ((static_cast<uint64_t>(1) << floatSpec.GetExponentBits()) - 1u) << mantissaBits);
+
+		RKC_CHECK(AppendTemplate(
+			"\t$I q;\n"
+			"\tq.v = $P_srli_$A($I_and(m, $I_splat(($G)$Yll)).v, $J);\n"
+			"\tp = $I_select($I_cmpgt(m, $I_splat(($G)$Xll)), $I_or(q, $I_splat(($G)$Zll)), p);\n"
+			, vars));
+	}
+
+	if (floatSpec.IsSigned())
+	{
+		SetVarHex(vars, 'X', signBit);
+		SetVarNumber(vars, 'Y', elementBits - 1u - encodedBits);
+
+		RKC_CHECK(AppendTemplate(
+			"\t$I s;\n"
+			"\ts.v = $P_srli_$A($I_and(x, $I_splat(($G)$Xll)).v, $Y);\n"
+			"\tp = $I_or(p, s);\n"
+			, vars));
+	}
+
+	return AppendTemplate(
+		"\treturn $U_from_$W(p);\n"
+		"}\n"
+		, vars);
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitCustomFloatUnpack(const CustomFloatFormat &customFormat, TemplateVars &vars)
+{
+	const FloatSpec &floatSpec = customFormat.GetFloatSpec();
+	const SimdElementFormat wideFormat = customFormat.GetWideFormat();
+	const CustomFloatFormat::RoundingParams params = customFormat.GetRoundingParams(wideFormat);
+	const uint8_t elementBits = SimdTarget::GetElementBits(wideFormat);
+	const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+	const uint32_t encodedBits = floatSpec.GetExponentBits() + mantissaBits;
+
+	BuildCustomFloatVars(wideFormat, vars);
+	SetVarNumber(vars, 'J', params.m_dropBits);
+	SetVarHex(vars, 'X', (static_cast<uint64_t>(1) << encodedBits) - 1u);
+	SetVarHex(vars, 'Y', static_cast<uint64_t>(1) << mantissaBits);
+	SetVarHex(vars, 'Z', params.m_minNormal);
+
+	RKC_CHECK(AppendTemplate(
+		"static inline $V rkcs$D_unpack($U a)\n"
+		"{\n"
+		"\tconst $I p = $I_from_$T(a);\n"
+		"\tconst $I field = $I_and(p, $I_splat(($G)$Xll));\n"
+		"\t$I x;\n"
+		"\tx.v = $P_slli_$A($I_sub(field, $I_splat(($G)$Yll)).v, $J);\n"
+		"\tx = $I_add(x, $I_splat(($G)$Zll));\n"
+		, vars));
+
+	if (floatSpec.SupportsDenormals())
+	{
+		SetVarHex(vars, 'X', params.m_denormalBase);
+
+		RKC_CHECK(AppendTemplate(
+			"\t$V t;\n"
+			"\tt.v = $P_cast$B_$S($I_splat(($G)$Xll).v);\n"
+			"\t$V den;\n"
+			"\tden.v = $P_cast$B_$S($I_or(field, $I_splat(($G)$Xll)).v);\n"
+			"\tden = $V_sub(den, t);\n"
+			"\t$I denBits;\n"
+			"\tdenBits.v = $P_cast$S_$B(den.v);\n"
+			"\tx = $I_select($I_cmpgt($I_splat(($G)$Yll), field), denBits, x);\n"
+			, vars));
+	}
+	else
+	{
+		RKC_CHECK(AppendTemplate("\tx = $I_select($I_cmpgt($I_splat(($G)$Yll), field), $I_splat(($G)0), x);\n", vars));
+	}
+
+	if (floatSpec.SupportsNans())
+	{
+		SetVarHex(vars, 'X', (((static_cast<uint64_t>(1) << floatSpec.GetExponentBits()) - 1u) << mantissaBits) - 1u);
+		SetVarHex(vars, 'Y', (static_cast<uint64_t>(1) << mantissaBits) - 1u);
+		SetVarHex(vars, 'Z', params.m_infinity);
+
+		RKC_CHECK(AppendTemplate(
+			"\t$I q;\n"
+			"\tq.v = $P_slli_$A($I_and(field, $I_splat(($G)$Yll)).v, $J);\n"
+			"\tx = $I_select($I_cmpgt(field, $I_splat(($G)$Xll)), $I_or(q, $I_splat(($G)$Zll)), x);\n"
+			, vars));
+	}
+
+	if (floatSpec.IsSigned())
+	{
+		SetVarHex(vars, 'X', static_cast<uint64_t>(1) << encodedBits);
+		SetVarNumber(vars, 'Y', elementBits - 1u - encodedBits);
+
+		RKC_CHECK(AppendTemplate(
+			"\t$I s;\n"
+			"\ts.v = $P_slli_$A($I_and(p, $I_splat(($G)$Xll)).v, $Y);\n"
+			"\tx = $I_or(x, s);\n"
+			, vars));
+	}
+
+	return AppendTemplate(
+		"\t$V result;\n"
+		"\tresult.v = $P_cast$B_$S(x.v);\n"
+		"\treturn result;\n"
+		"}\n"
+		, vars);
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitParamList(const Kernel::Function &function, bool withTypes)
+{
+	const size_t numParams = function.NumParams();
+	for (size_t i = 0; i < numParams; i++)
+	{
+		const Kernel::Param &param = function.GetParam(static_cast<Kernel::ParamIndex_t>(i));
+
+		RKC_CHECK(Append(", "));
+		if (withTypes)
+		{
+			if (param.m_kind == Kernel::ParamKind::kInputBuffer)
+			{
+				RKC_CHECK(Append("const "));
+			}
+
+			RKC_CHECK(Append(GetElementCType(m_storageFormats[param.m_type])));
+			RKC_CHECK(Append((param.m_kind == Kernel::ParamKind::kUniform) ? " " : " *"));
+		}
+
+		RKC_CHECK(Append("p"));
+		RKC_CHECK(AppendDecimal(i));
+
+		// Buffers are followed by their length
+		if (param.m_kind != Kernel::ParamKind::kUniform)
+		{
+			RKC_CHECK(Append(withTypes ? ", size_t p" : ", p"));
+			RKC_CHECK(AppendDecimal(i));
+			RKC_CHECK(Append("len"));
+		}
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitBlock(const Kernel::Function &function)
+{
+	RKC_CHECK(Append(m_rangeChecks ? "template<bool TIsTail>\nstatic inline uint32_t " : "template<bool TIsTail>\nstatic inline void "));
+	RKC_CHECK(AppendSlice(function.GetName()));
+	RKC_CHECK(Append("_block(size_t laneBase, size_t numActive"));
+	RKC_CHECK(EmitParamList(function, true));
+	RKC_CHECK(Append(")\n{\n\t(void)numActive;\n"));
+
+	// Loads and stores outside of masked regions use every active lane
+	if (m_usesBufferAccess)
+	{
+		TemplateVars vars;
+		BuildMaskVars(8, vars);
+
+		RKC_CHECK(AppendTemplate(
+			"\tconst uint32_t activeBits = TIsTail ? (uint32_t)((1u << numActive) - 1u) : $N;\n"
+			"\t(void)activeBits;\n"
+			, vars));
+	}
+
+	// Execution masks are named after the instruction that opened their region, and the outermost one
+	// is every active lane.  Instruction 0 never opens a region, so that name is free.
+	if (m_usesExecMask)
+	{
+		TemplateVars vars;
+		BuildMaskVars(8, vars);
+
+		RKC_CHECK(AppendTemplate(
+			"\tconst $M exec0 = $M_frombits(TIsTail ? (uint32_t)((1u << numActive) - 1u) : $N);\n"
+			"\tconst bool execAll0 = !TIsTail;\n"
+			"\t(void)exec0;\n"
+			"\t(void)execAll0;\n"
+			, vars));
+	}
+
+	RKC_CHECK(EmitVariables(function));
+
+	// Error masks for range checks are named after their lane size
+	for (size_t i = 0; i < 4; i++)
+	{
+		if (m_checkBitsUsed[i])
+		{
+			TemplateVars vars;
+			BuildMaskVars(static_cast<uint8_t>(8u << i), vars);
+			SetVarNumber(vars, 'K', 8u << i);
+
+			RKC_CHECK(AppendTemplate("\t$M err$K = $M_frombits(0);\n", vars));
+		}
+	}
+
+	{
+		AllocatorTagScope tagScope(*m_execStack.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_execStack.Resize(0));
+		RKC_CHECK(m_execStack.Append(0));
+	}
+
+	m_indent = 1;
+
+	const size_t numInstructions = function.NumInstructions();
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		RKC_CHECK(EmitInstruction(function, static_cast<Kernel::ValueIndex_t>(i)));
+	}
+
+	if (m_rangeChecks)
+	{
+		RKC_CHECK(EmitBlockErrors());
+	}
+
+	return Append("}\n\n");
+}
+
+// The block's error masks are only reduced once, at the end, and lanes past the end of the input are
+// dropped then
+rkci::Result rkci::SimdCppEmitter::EmitBlockErrors()
+{
+	bool isFirst = true;
+
+	RKC_CHECK(Append("\treturn "));
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		if (!m_checkBitsUsed[i])
+			continue;
+
+		TemplateVars vars;
+		BuildMaskVars(static_cast<uint8_t>(8u << i), vars);
+		SetVarNumber(vars, 'K', 8u << i);
+
+		RKC_CHECK(Append(isFirst ? "(" : " | "));
+		RKC_CHECK(AppendTemplate("$M_tobits(err$K)", vars));
+		isFirst = false;
+	}
+
+	if (isFirst)
+		return Append("0;\n");
+
+	TemplateVars vars;
+	BuildMaskVars(8, vars);
+
+	return AppendTemplate(") & (TIsTail ? (uint32_t)((1u << numActive) - 1u) : $N);\n", vars);
+}
+
+// Variables are x followed by their index, and start out as zero
+rkci::Result rkci::SimdCppEmitter::EmitVariables(const Kernel::Function &function)
+{
+	const size_t numVariables = function.NumVariables();
+	for (size_t i = 0; i < numVariables; i++)
+	{
+		const Kernel::TypeIndex_t type = function.GetVariable(static_cast<Kernel::VariableIndex_t>(i)).m_type;
+
+		TemplateVars vars;
+		BuildVectorVars(m_typeFormats[type], vars);
+		SetVarNumber(vars, 'I', i);
+
+		if (function.GetType(type).m_kind == Kernel::TypeKind::kMask)
+		{
+			RKC_CHECK(AppendTemplate("\t$M x$I = $M_frombits(0);\n", vars));
+		}
+		else
+		{
+			RKC_CHECK(AppendTemplate("\t$V x$I = $V_splat(($E)0);\n", vars));
+		}
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitInstruction(const Kernel::Function &function, Kernel::ValueIndex_t index)
+{
+	const Kernel::Instruction &instr = function.GetInstruction(index);
+
+	if (!Kernel::Function::DefinesValue(instr.m_opcode))
+		return EmitStatement(function, index);
+
+	// $X, $Y and $Z are the operand names, $A is the type that the operands are read as, and $I is an
+	// immediate
+	TemplateVars vars;
+	RKC_CHECK(PrepareOperands(function, index, vars));
+
+	BuildValueVars(function, index, vars);
+
+	const Kernel::Type &type = function.GetType(instr.m_type);
+	const SimdElementFormat format = m_valueFormats[index];
+
+	if (Kernel::Function::IsComparison(instr.m_opcode))
+	{
+		TemplateVars operandVars;
+		BuildVectorVars(format, operandVars);
+		SetVar(vars, 'A', operandVars.m_values['V' - 'A']);
+	}
+	else if (Kernel::Function::GetNumOperands(instr.m_opcode) > 0)
+	{
+		TemplateVars operandVars;
+		BuildValueVars(function, instr.m_operands[0], operandVars);
+		SetVar(vars, 'A', operandVars.m_values['T' - 'A']);
+	}
+
+	// Custom floatspec results use their type's helpers, named after its index in $J, and their
+	// encoding is held in $U
+	const bool isCustomFloat = IsCustomFloatType(function, instr.m_type);
+	if (isCustomFloat)
+	{
+		TemplateVars storageVars;
+		BuildVectorVars(m_storageFormats[instr.m_type], storageVars);
+		SetVar(vars, 'U', storageVars.m_values['V' - 'A']);
+		SetVarNumber(vars, 'J', instr.m_type);
+	}
+
+	RKC_CHECK(AppendIndent());
+	RKC_CHECK(AppendTemplate("const $T v$D = ", vars));
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kConstant:
+		RKC_CHECK(AppendConstant(function, index, format));
+		break;
+
+	case Kernel::Opcode::kParam:
+		SetVarNumber(vars, 'I', instr.m_immediate);
+		RKC_CHECK(AppendTemplate(isCustomFloat ? "rkcs$J_unpack($U_splat(p$I))" : "$T_splat(p$I)", vars));
+		break;
+
+	case Kernel::Opcode::kLaneIndex:
+		RKC_CHECK(AppendTemplate("$T_iota(laneBase)", vars));
+		break;
+
+	case Kernel::Opcode::kLoad:
+		SetVarNumber(vars, 'I', instr.m_immediate);
+		if (function.GetInstruction(instr.m_operands[0]).m_opcode == Kernel::Opcode::kLaneIndex)
+		{
+			RKC_CHECK(AppendTemplate(isCustomFloat
+				? "rkcs$J_unpack(TIsTail ? $U_loadrun(p$I, laneBase, activeBits, p$Ilen) : $U_load(p$I + laneBase))"
+				: "TIsTail ? $T_loadrun(p$I, laneBase, activeBits, p$Ilen) : $T_load(p$I + laneBase)", vars));
+			break;
+		}
+
+		SetVar(vars, 'G', isCustomFloat ? vars.m_values['U' - 'A'] : vars.m_values['T' - 'A']);
+
+		if (isCustomFloat)
+		{
+			RKC_CHECK(AppendTemplate("rkcs$J_unpack(", vars));
+		}
+
+		switch (m_accessPatterns.GetAccessPattern(index))
+		{
+		case AccessPattern::kUniform:
+			RKC_CHECK(AppendTemplate("$G_loadat(p$I, rkc_lane0($X), p$Ilen)", vars));
+			break;
+		case AccessPattern::kContiguous:
+			RKC_CHECK(AppendTemplate("$G_loadrun(p$I, rkc_lane0($X), activeBits, p$Ilen)", vars));
+			break;
+		default:
+			RKC_CHECK(AppendTemplate("$G_gather(p$I, $X, activeBits, p$Ilen)", vars));
+			break;
+		}
+
+		if (isCustomFloat)
+		{
+			RKC_CHECK(Append(")"));
+		}
+		break;
+
+	case Kernel::Opcode::kConvert:
+		{
+			const SimdElementFormat fromFormat = GetValueFormat(function, instr.m_operands[0]);
+			if (isCustomFloat)
+			{
+				// Converted exactly first, and then rounded once (see GetCustomFloatConvertFormat)
+				SimdElementFormat exactFormat = format;
+				RKC_CHECK(GetCustomFloatConvertFormat(function, index, exactFormat));
+
+				TemplateVars exactVars;
+				BuildVectorVars(exactFormat, exactVars);
+				SetVar(vars, 'W', exactVars.m_values['V' - 'A']);
+				SetVar(vars, 'I', GetFormatName(fromFormat));
+
+				RKC_CHECK(AppendTemplate((exactFormat == format) ? "rkcs$J_round(" : "$T_from_f64(rkcs$J_round_f64(", vars));
+				RKC_CHECK(AppendTemplate((fromFormat == exactFormat) ? "$X" : "$W_from_$I($X)", vars));
+				RKC_CHECK(Append((exactFormat == format) ? ")" : "))"));
+			}
+			else if (fromFormat == format)
+			{
+				RKC_CHECK(AppendTemplate("$X", vars));
+			}
+			else if (type.m_kind == Kernel::TypeKind::kMask)
+			{
+				RKC_CHECK(AppendTemplate("$T_frombits($A_tobits($X))", vars));
+			}
+			else
+			{
+				SetVar(vars, 'I', GetFormatName(fromFormat));
+				RKC_CHECK(AppendTemplate("$T_from_$I($X)", vars));
+			}
+		}
+		break;
+
+	case Kernel::Opcode::kAdd:
+		RKC_CHECK(AppendTemplate(isCustomFloat ? "rkcs$J_round($T_add($X, $Y))" : "$T_add($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kSub:
+		RKC_CHECK(AppendTemplate(isCustomFloat ? "rkcs$J_round($T_sub($X, $Y))" : "$T_sub($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kMul:
+		RKC_CHECK(AppendTemplate(isCustomFloat ? "rkcs$J_round($T_mul($X, $Y))" : "$T_mul($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kMin:
+		RKC_CHECK(AppendTemplate("$T_min($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kMax:
+		RKC_CHECK(AppendTemplate("$T_max($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kAnd:
+		RKC_CHECK(AppendTemplate("$T_and($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kOr:
+		RKC_CHECK(AppendTemplate("$T_or($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kXor:
+		RKC_CHECK(AppendTemplate("$T_xor($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kNot:
+		RKC_CHECK(AppendTemplate("$T_not($X)", vars));
+		break;
+
+	case Kernel::Opcode::kCmpEq:
+		RKC_CHECK(AppendTemplate("$A_cmpeq($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kCmpNe:
+		RKC_CHECK(AppendTemplate("$A_cmpne($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kCmpLt:
+		RKC_CHECK(AppendTemplate("$A_cmplt($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kCmpLe:
+		RKC_CHECK(AppendTemplate("$A_cmple($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kCmpGt:
+		RKC_CHECK(AppendTemplate("$A_cmpgt($X, $Y)", vars));
+		break;
+	case Kernel::Opcode::kCmpGe:
+		RKC_CHECK(AppendTemplate("$A_cmpge($X, $Y)", vars));
+		break;
+
+	case Kernel::Opcode::kReadVar:
+		SetVarNumber(vars, 'I', instr.m_immediate);
+		RKC_CHECK(AppendTemplate("x$I", vars));
+		break;
+
+	case Kernel::Opcode::kSelect:
+		{
+			// The mask may come from lanes of a different width than the selected values
+			TemplateVars valueVars;
+			BuildVectorVars(format, valueVars);
+
+			if (SimdTarget::GetElementBits(GetValueFormat(function, instr.m_operands[0])) != SimdTarget::GetElementBits(format))
+			{
+				SetVar(vars, 'M', valueVars.m_values['M' - 'A']);
+				RKC_CHECK(AppendTemplate("$T_select($M_frombits($A_tobits($X)), $Y, $Z)", vars));
+			}
+			else
+			{
+				RKC_CHECK(AppendTemplate("$T_select($X, $Y, $Z)", vars));
+			}
+		}
+		break;
+
+	default:
+		return rkc::ResultCodes::kInternalError;
+	}
+
+	RKC_CHECK(Append(";\n"));
+
+	if (m_isValueChecked[index])
+	{
+		RKC_CHECK(EmitRangeCheck(function, index));
+	}
+
+	if (!m_isValueUsed[index])
+	{
+		// Keeps the host's compiler quiet about values that nothing reads
+		RKC_CHECK(AppendIndent());
+		RKC_CHECK(AppendTemplate("(void)v$D;\n", vars));
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitStatement(const Kernel::Function &function, Kernel::ValueIndex_t index)
+{
+	const Kernel::Instruction &instr = function.GetInstruction(index);
+	Kernel::ValueIndex_t execIndex = m_execStack[m_execStack.Count() - 1];
+
+	// $X and $Y are the operand names, $A is the first operand's type, $I is an immediate, $K is the
+	// current execution mask, and $J is the one that the instruction opens
+	TemplateVars vars;
+	RKC_CHECK(PrepareOperands(function, index, vars));
+
+	if (Kernel::Function::GetNumOperands(instr.m_opcode) > 0)
+	{
+		TemplateVars operandVars;
+		BuildValueVars(function, instr.m_operands[0], operandVars);
+		SetVar(vars, 'A', operandVars.m_values['T' - 'A']);
+	}
+
+	SetVarNumber(vars, 'I', instr.m_immediate);
+	SetVarNumber(vars, 'J', index);
+	SetVarNumber(vars, 'K', execIndex);
+
+	switch (instr.m_opcode)
+	{
+	case Kernel::Opcode::kStore:
+		{
+			const Kernel::TypeIndex_t type = function.GetParam(static_cast<Kernel::ParamIndex_t>(instr.m_immediate)).m_type;
+
+			TemplateVars valueVars;
+			BuildVectorVars(m_storageFormats[type], valueVars);
+			SetVar(vars, 'T', valueVars.m_values['V' - 'A']);
+
+			// Custom floatspec values are stored as their encoding
+			if (IsCustomFloatType(function, type))
+			{
+				SetVarNumber(vars, 'D', type);
+
+				RKC_CHECK(AppendIndent());
+				RKC_CHECK(AppendTemplate("const $T s$J = rkcs$D_pack($Y);\n", vars));
+
+				const char *parts[] = { "s", vars.m_values['J' - 'A'] };
+				SetVarConcat(vars, 'Y', parts, 2);
+			}
+
+			RKC_CHECK(AppendIndent());
+
+			if (function.GetInstruction(instr.m_operands[0]).m_opcode != Kernel::Opcode::kLaneIndex)
+			{
+				if (execIndex == 0)
+					SetVar(vars, 'B', "activeBits");
+				else
+				{
+					const char *parts[] = { "execBits", vars.m_values['K' - 'A'] };
+					SetVarConcat(vars, 'B', parts, 2);
+				}
+
+				switch (m_accessPatterns.GetAccessPattern(index))
+				{
+				case AccessPattern::kUniform:
+					return AppendTemplate("$T_storeat(p$I, rkc_lane0($X), $Y, $B, p$Ilen);\n", vars);
+				case AccessPattern::kContiguous:
+					return AppendTemplate("$T_storerun(p$I, rkc_lane0($X), $Y, $B, p$Ilen);\n", vars);
+				default:
+					return AppendTemplate("$T_scatter(p$I, $X, $Y, $B, p$Ilen);\n", vars);
+				}
+			}
+
+			// Partial blocks can run past the end of the buffer, even with every lane executing
+			if (execIndex == 0)
+				return AppendTemplate("if (TIsTail) $T_storerun(p$I, laneBase, $Y, activeBits, p$Ilen); else $T_store(p$I + laneBase, $Y);\n", vars);
+
+			return AppendTemplate("if (TIsTail) $T_storerun(p$I, laneBase, $Y, execBits$K, p$Ilen); else if (execAll$K) $T_store(p$I + laneBase, $Y); else $T_storem(p$I + laneBase, $Y, execBits$K);\n", vars);
+		}
+
+	case Kernel::Opcode::kWriteVar:
+		{
+			const Kernel::VariableIndex_t variable = static_cast<Kernel::VariableIndex_t>(instr.m_immediate);
+			const Kernel::TypeIndex_t type = function.GetVariable(variable).m_type;
+			const SimdElementFormat format = m_typeFormats[type];
+			const uint8_t maskBits = SimdTarget::GetElementBits(format);
+
+			RKC_CHECK(AppendIndent());
+
+			// Uniform variables are only written where every lane or none is executing, and writing the
+			// inactive lanes too keeps them the same in every lane
+			if (m_uniformity.IsVariableUniform(variable))
+				return AppendTemplate("x$I = $X;\n", vars);
+
+			TemplateVars typeVars;
+			BuildVectorVars(format, typeVars);
+
+			// Mask variables blend with the mask type's select, and others with the vector type's
+			if (function.GetType(type).m_kind == Kernel::TypeKind::kMask)
+				SetVar(vars, 'T', typeVars.m_values['M' - 'A']);
+			else
+				SetVar(vars, 'T', typeVars.m_values['V' - 'A']);
+
+			RKC_CHECK(AppendTemplate("x$I = execAll$K ? $X : $T_select(", vars));
+			RKC_CHECK(EmitExecMaskAs(maskBits));
+			return AppendTemplate(", $X, x$I);\n", vars);
+		}
+
+	case Kernel::Opcode::kBeginMasked:
+		{
+			TemplateVars maskVars;
+			BuildMaskVars(8, maskVars);
+			SetVar(vars, 'M', maskVars.m_values['M' - 'A']);
+
+			RKC_CHECK(AppendIndent());
+
+			// Every lane agrees on a uniform mask, so the region keeps the enclosing execution mask
+			if (m_uniformity.IsValueUniform(instr.m_operands[0]))
+			{
+				RKC_CHECK(AppendTemplate("if ($A_tobits($X) != 0)\n", vars));
+			}
+			else
+			{
+				if (SimdTarget::GetElementBits(GetValueFormat(function, instr.m_operands[0])) == 8)
+				{
+					RKC_CHECK(AppendTemplate("const $M exec$J = $M_and(exec$K, $X);\n", vars));
+				}
+				else
+				{
+					RKC_CHECK(AppendTemplate("const $M exec$J = $M_and(exec$K, $M_frombits($A_tobits($X)));\n", vars));
+				}
+
+				RKC_CHECK(AppendIndent());
+				RKC_CHECK(AppendTemplate("const uint32_t execBits$J = $M_tobits(exec$J);\n", vars));
+				RKC_CHECK(AppendIndent());
+				RKC_CHECK(AppendTemplate("if (execBits$J != 0)\n", vars));
+
+				execIndex = index;
+			}
+
+			RKC_CHECK(AppendIndent());
+			RKC_CHECK(Append("{\n"));
+
+			m_indent++;
+
+			{
+				AllocatorTagScope tagScope(*m_execStack.GetAllocator(), rkc::AllocatorTags::kBackend);
+				RKC_CHECK(m_execStack.Append(execIndex));
+			}
+
+			if (execIndex != index)
+				return Result::Ok();
+
+			// Stores and writes in the region skip the masking when every lane is still on
+			SetVarHex(vars, 'N', (static_cast<uint64_t>(1) << m_target.GetNumLanes()) - 1u);
+
+			RKC_CHECK(AppendIndent());
+			RKC_CHECK(AppendTemplate("const bool execAll$J = (execBits$J == $N);\n", vars));
+			RKC_CHECK(AppendIndent());
+			return AppendTemplate("(void)execAll$J;\n", vars);
+		}
+
+	case Kernel::Opcode::kEndMasked:
+		RKC_CHECK(m_execStack.Resize(m_execStack.Count() - 1));
+		m_indent--;
+		RKC_CHECK(AppendIndent());
+		return Append("}\n");
+
+	case Kernel::Opcode::kLoop:
+		RKC_CHECK(AppendIndent());
+		RKC_CHECK(Append("for (;;)\n"));
+		RKC_CHECK(AppendIndent());
+		m_indent++;
+		return Append("{\n");
+
+	case Kernel::Opcode::kEndLoop:
+		m_indent--;
+		RKC_CHECK(AppendIndent());
+		return Append("}\n");
+
+	case Kernel::Opcode::kBreakIfNone:
+		RKC_CHECK(AppendIndent());
+		return AppendTemplate("if ($A_tobits($X) == 0) break;\n", vars);
+
+	default:
+		return rkc::ResultCodes::kInternalError;
+	}
+}
+
+// Conversions to a custom floatspec convert exactly to a float format first and then round once,
+// since rounding twice can land on the wrong side of a tie.  The exact format is the wide format,
+// or float64 for values that the wide format can't hold exactly.
+rkci::Result rkci::SimdCppEmitter::GetCustomFloatConvertFormat(const Kernel::Function &function, Kernel::ValueIndex_t index, SimdElementFormat &outFormat) const
+{
+	const SimdElementFormat fromFormat = GetValueFormat(function, function.GetInstruction(index).m_operands[0]);
+	const SimdElementFormat wideFormat = m_valueFormats[index];
+
+	if (SimdTarget::IsFloatFormat(fromFormat))
+		outFormat = (fromFormat == SimdElementFormat::kFloat64) ? fromFormat : wideFormat;
+	else if (SimdTarget::GetElementBits(fromFormat) <= 16)
+		outFormat = wideFormat;
+	else if (SimdTarget::GetElementBits(fromFormat) <= 32)
+		outFormat = SimdElementFormat::kFloat64;
+	else
+		return rkc::ResultCodes::kNotYetImplemented;	// Float64 doesn't hold every 64-bit integer
+
+	return Result::Ok();
+}
+
+// Names the operands of an instruction, first converting the ones that it reads in a different
+// format than they're held in
+rkci::Result rkci::SimdCppEmitter::PrepareOperands(const Kernel::Function &function, Kernel::ValueIndex_t index, TemplateVars &vars)
+{
+	const Kernel::Instruction &instr = function.GetInstruction(index);
+	const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+
+	for (size_t i = 0; i < numOperands; i++)
+	{
+		const Kernel::ValueIndex_t operand = instr.m_operands[i];
+		const Kernel::Instruction &operandInstr = function.GetInstruction(operand);
+		const SimdElementFormat operandFormat = m_valueFormats[operand];
+		const SimdElementFormat requiredFormat = GetOperandFormat(function, index, i);
+		const char name = static_cast<char>('X' + i);
+
+		TemplateVars convVars;
+		SetVarNumber(convVars, 'D', operand);
+		SetVarNumber(convVars, 'J', index);
+		SetVarNumber(convVars, 'K', i);
+
+		if (requiredFormat == SimdElementFormat::kCount || requiredFormat == operandFormat)
+		{
+			const char *parts[] = { "v", convVars.m_values['D' - 'A'] };
+			SetVarConcat(vars, name, parts, 2);
+			continue;
+		}
+
+		const char *parts[] = { "u", convVars.m_values['J' - 'A'], "_", convVars.m_values['K' - 'A'] };
+		SetVarConcat(vars, name, parts, 4);
+
+		TemplateVars operandVars;
+		BuildValueVars(function, operand, operandVars);
+
+		BuildVectorVars(requiredFormat, convVars);
+		SetVar(convVars, 'A', operandVars.m_values['T' - 'A']);
+		SetVar(convVars, 'I', GetFormatName(operandFormat));
+		SetVar(convVars, 'U', vars.m_values[name - 'A']);
+		SetVarNumber(convVars, 'N', operandInstr.m_immediate);
+
+		const bool isMask = (function.GetType(operandInstr.m_type).m_kind == Kernel::TypeKind::kMask);
+
+		RKC_CHECK(AppendIndent());
+		RKC_CHECK(AppendTemplate(isMask ? "const $M $U = " : "const $V $U = ", convVars));
+
+		if (isMask)
+		{
+			RKC_CHECK(AppendTemplate("$M_frombits($A_tobits(v$D))", convVars));
+		}
+		else if (operandInstr.m_opcode == Kernel::Opcode::kConstant)
+		{
+			RKC_CHECK(AppendConstant(function, operand, requiredFormat));
+		}
+		else if (operandInstr.m_opcode == Kernel::Opcode::kParam)
+		{
+			RKC_CHECK(AppendTemplate("$V_splat(($E)p$N)", convVars));
+		}
+		else
+		{
+			RKC_CHECK(AppendTemplate("$V_from_$I(v$D)", convVars));
+		}
+
+		RKC_CHECK(Append(";\n"));
+	}
+
+	return Result::Ok();
+}
+
+// Appends a constant as a value of the given format, which it fits in
+rkci::Result rkci::SimdCppEmitter::AppendConstant(const Kernel::Function &function, Kernel::ValueIndex_t value, SimdElementFormat format)
+{
+	const Kernel::Instruction &instr = function.GetInstruction(value);
+
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+
+	if (function.GetType(instr.m_type).m_kind == Kernel::TypeKind::kMask)
+	{
+		SetVarHex(vars, 'N', (static_cast<uint64_t>(1) << m_target.GetNumLanes()) - 1u);
+		return AppendTemplate((instr.m_immediate != 0) ? "$M_frombits($N)" : "$M_frombits(0)", vars);
+	}
+
+	// Custom floatspec constants are their encoding, and are unpacked here instead of in the kernel
+	if (IsCustomFloatType(function, instr.m_type))
+	{
+		RKC_CHECK_RV(CustomFloatFormat, customFormat, CustomFloatFormat::Create(function.GetType(instr.m_type).m_floatSpec));
+		return AppendSplat(format, customFormat.Unpack(instr.m_immediate));
+	}
+
+	return AppendSplat(format, instr.m_immediate);
+}
+
+// Appends a vector with every lane set to an immediate, which is the bits of the value for floats
+rkci::Result rkci::SimdCppEmitter::AppendSplat(SimdElementFormat format, uint64_t immediate)
+{
+	TemplateVars vars;
+	BuildVectorVars(format, vars);
+
+	if (format == SimdElementFormat::kFloat16)
+	{
+		SetVarHex(vars, 'I', immediate & 0xffffu);
+		return AppendTemplate("$V_splat((uint16_t)$I)", vars);
+	}
+
+	if (format == SimdElementFormat::kFloat32)
+	{
+		SetVarHex(vars, 'I', immediate & 0xffffffffu);
+		return AppendTemplate("$V_splat(rkc_f32_from_bits($I))", vars);
+	}
+
+	if (format == SimdElementFormat::kFloat64)
+	{
+		SetVarHex(vars, 'I', immediate);
+		return AppendTemplate("$V_splat(rkc_f64_from_bits($Ill))", vars);
+	}
+
+	// Written as a negated magnitude so that no literal is out of range for its type
+	const int64_t intValue = static_cast<int64_t>(immediate);
+	SetVarNumber(vars, 'I', (intValue < 0) ? (0u - immediate) : immediate);
+
+	if (intValue == INT64_MIN)
+		return AppendTemplate("$V_splat(($E)(-9223372036854775807ll - 1))", vars);
+
+	return AppendTemplate((intValue < 0) ? "$V_splat(($E)(-$Ill))" : "$V_splat(($E)$Iull)", vars);
+}
+
+// Appends the current execution mask as a mask of the given lane size
+rkci::Result rkci::SimdCppEmitter::EmitExecMaskAs(uint8_t bits)
+{
+	TemplateVars vars;
+	BuildMaskVars(8, vars);
+	SetVarNumber(vars, 'K', m_execStack[m_execStack.Count() - 1]);
+
+	if (bits == 8)
+		return AppendTemplate("exec$K", vars);
+
+	TemplateVars targetVars;
+	BuildMaskVars(bits, targetVars);
+	SetVar(vars, 'T', targetVars.m_values['M' - 'A']);
+
+	// Narrowed execution masks already have their bits
+	if (m_execStack[m_execStack.Count() - 1] != 0)
+		return AppendTemplate("$T_frombits(execBits$K)", vars);
+
+	return AppendTemplate("$T_frombits($M_tobits(exec$K))", vars);
+}
+
+// Lanes that leave their declared range set their bit in the error mask of their lane size.  Only the
+// ends of the range that the result can actually pass are compared.
+rkci::Result rkci::SimdCppEmitter::EmitRangeCheck(const Kernel::Function &function, Kernel::ValueIndex_t index)
+{
+	const Kernel::Instruction &instr = function.GetInstruction(index);
+	const Kernel::Type &type = function.GetType(instr.m_type);
+	const bool isFromFloat = (instr.m_opcode == Kernel::Opcode::kConvert && SimdTarget::IsFloatFormat(GetValueFormat(function, instr.m_operands[0])));
+	const SimdElementFormat checkFormat = isFromFloat ? GetValueFormat(function, instr.m_operands[0]) : m_valueFormats[index];
+
+	TemplateVars vars;
+	BuildVectorVars(checkFormat, vars);
+	SetVarNumber(vars, 'D', isFromFloat ? instr.m_operands[0] : index);
+	SetVarNumber(vars, 'K', SimdTarget::GetElementBits(checkFormat));
+
+	RKC_CHECK(AppendIndent());
+	RKC_CHECK(AppendTemplate("err$K = $M_or(err$K, ", vars));
+
+	const bool isMasked = (m_execStack[m_execStack.Count() - 1] != 0);
+	if (isMasked)
+	{
+		RKC_CHECK(AppendTemplate("$M_and(", vars));
+	}
+
+	if (isFromFloat)
+	{
+		// In range if it truncates to an integer in range, so if it's strictly between min - 1 and
+		// max + 1.  NaN fails both compares.
+		uint64_t lowBits = 0;
+		if (checkFormat == SimdElementFormat::kFloat16)
+			lowBits = RoundToFloatBits(checkFormat, (type.m_minValue == INT64_MIN) ? INT64_MIN : (type.m_minValue - 1), false);
+		else if (type.m_minValue == INT64_MIN)
+		{
+			// Everything this large is an integer, so the bound is the float just under -2^63
+			if (checkFormat == SimdElementFormat::kFloat32)
+			{
+				const float bound = nextafterf(-9223372036854775808.0f, -INFINITY);
+				uint32_t bits = 0;
+				memcpy(&bits, &bound, sizeof(bits));
+				lowBits = bits;
+			}
+			else
+			{
+				const double bound = nextafter(-9223372036854775808.0, -INFINITY);
+				memcpy(&lowBits, &bound, sizeof(lowBits));
+			}
+		}
+		else
+			lowBits = RoundToFloatBits(checkFormat, type.m_minValue - 1, false);
+
+		const uint64_t highBits = RoundToFloatBits(checkFormat, (type.m_maxValue == INT64_MAX) ? INT64_MAX : (type.m_maxValue + 1), true);
+
+		RKC_CHECK(AppendTemplate("$M_not($M_and($V_cmpgt(v$D, ", vars));
+		RKC_CHECK(AppendSplat(checkFormat, lowBits));
+		RKC_CHECK(AppendTemplate("), $V_cmplt(v$D, ", vars));
+		RKC_CHECK(AppendSplat(checkFormat, highBits));
+		RKC_CHECK(Append(")))"));
+	}
+	else
+	{
+		RangeAnalysis::Range range;
+		if (!m_ranges.GetExactRange(index, range))
+			return rkc::ResultCodes::kInternalError;
+
+		const bool checkLow = (range.m_min < type.m_minValue);
+		const bool checkHigh = (range.m_max > type.m_maxValue);
+
+		if (checkLow && checkHigh)
+		{
+			RKC_CHECK(AppendTemplate("$M_or(", vars));
+		}
+
+		if (checkLow)
+		{
+			RKC_CHECK(AppendTemplate("$V_cmplt(v$D, ", vars));
+			RKC_CHECK(AppendSplat(checkFormat, static_cast<uint64_t>(type.m_minValue)));
+			RKC_CHECK(Append(")"));
+		}
+
+		if (checkLow && checkHigh)
+		{
+			RKC_CHECK(Append(", "));
+		}
+
+		if (checkHigh)
+		{
+			RKC_CHECK(AppendTemplate("$V_cmpgt(v$D, ", vars));
+			RKC_CHECK(AppendSplat(checkFormat, static_cast<uint64_t>(type.m_maxValue)));
+			RKC_CHECK(Append(")"));
+		}
+
+		if (checkLow && checkHigh)
+		{
+			RKC_CHECK(Append(")"));
+		}
+	}
+
+	if (isMasked)
+	{
+		RKC_CHECK(Append(", "));
+		RKC_CHECK(EmitExecMaskAs(SimdTarget::GetElementBits(checkFormat)));
+		RKC_CHECK(Append(")"));
+	}
+
+	return Append(");\n");
+}
+
+rkci::Result rkci::SimdCppEmitter::AppendIndent()
+{
+	for (uint32_t i = 0; i < m_indent; i++)
+	{
+		RKC_CHECK(Append("\t"));
+	}
+
+	return Result::Ok();
+}
+
+rkci::Result rkci::SimdCppEmitter::EmitEntryPoint(const Kernel::Function &function)
+{
+	const ArraySliceView<const uint8_t> name = function.GetName();
+
+	TemplateVars vars;
+	SetVarNumber(vars, 'L', m_target.GetNumLanes());
+
+	// With range checks, the blocks' errors are collected and only tested once at the end
+	const char *blockCall = m_rangeChecks ? "\t\terrorBits |= " : "\t\t";
+
+	RKC_CHECK(Append(m_rangeChecks ? "extern \"C\" int " : "extern \"C\" void "));
+	RKC_CHECK(AppendSlice(name));
+	RKC_CHECK(Append("(size_t count"));
+	RKC_CHECK(EmitParamList(function, true));
+	RKC_CHECK(Append(")\n{\n"));
+	if (m_rangeChecks)
+	{
+		RKC_CHECK(Append("\tuint32_t errorBits = 0;\n"));
+	}
+
+	// Whole blocks access the lane index's elements without checking them, so they stop at the end of
+	// the shortest buffer accessed there, and partial blocks check each lane for the rest
+	RKC_CHECK(Append("\tsize_t fullCount = count;\n"));
+
+	const size_t numParams = function.NumParams();
+	for (size_t i = 0; i < numParams; i++)
+	{
+		if (m_isParamAtLaneIndex[i])
+		{
+			TemplateVars paramVars;
+			SetVarNumber(paramVars, 'I', i);
+
+			RKC_CHECK(AppendTemplate("\tif (p$Ilen < fullCount)\n\t\tfullCount = p$Ilen;\n", paramVars));
+		}
+	}
+
+	RKC_CHECK(AppendTemplate("\tsize_t laneBase = 0;\n\tfor (; fullCount - laneBase >= $L; laneBase += $L)\n", vars));
+	RKC_CHECK(Append(blockCall));
+	RKC_CHECK(AppendSlice(name));
+	RKC_CHECK(AppendTemplate("_block<false>(laneBase, $L", vars));
+	RKC_CHECK(EmitParamList(function, false));
+	RKC_CHECK(AppendTemplate(");\n\twhile (laneBase < count)\n\t{\n\t\tconst size_t numActive = (count - laneBase < $L) ? (count - laneBase) : $L;\n", vars));
+	RKC_CHECK(Append(blockCall));
+	RKC_CHECK(AppendSlice(name));
+	RKC_CHECK(Append("_block<true>(laneBase, numActive"));
+	RKC_CHECK(EmitParamList(function, false));
+	RKC_CHECK(Append(");\n\t\tlaneBase += numActive;\n\t}\n"));
+
+	if (m_rangeChecks)
+	{
+		RKC_CHECK(Append("\treturn (errorBits != 0) ? 1 : 0;\n"));
+	}
+
+	return Append("}\n");
+}
+
+rkci::SimdElementFormat rkci::SimdCppEmitter::GetValueFormat(const Kernel::Function &function, Kernel::ValueIndex_t value) const
+{
+	(void)function;
+	return m_valueFormats[value];
+}
+
+// Gets the bits of the float nearest to an integer in one direction
+uint64_t rkci::SimdCppEmitter::RoundToFloatBits(SimdElementFormat format, int64_t value, bool roundUp)
+{
+	if (format == SimdElementFormat::kFloat16)
+	{
+		// Past the largest finite value, 65504, the next one up is infinity
+		const uint64_t magnitude = (value < 0) ? (0u - static_cast<uint64_t>(value)) : static_cast<uint64_t>(value);
+		const bool roundsAway = (value < 0) ? !roundUp : roundUp;
+
+		if (magnitude > 65504u)
+			return ((value < 0) ? 0x8000u : 0u) | (roundsAway ? 0x7c00u : 0x7bffu);
+
+		uint64_t bits = 0;
+		if (magnitude != 0)
+		{
+			uint8_t topBit = 0;
+			while ((magnitude >> (topBit + 1)) != 0)
+				topBit++;
+
+			// 11 significant bits, and positive halves count up in the same order as their bits
+			const uint8_t dropBits = (topBit > 10) ? static_cast<uint8_t>(topBit - 10) : 0;
+			const uint64_t significand = (topBit > 10) ? (magnitude >> dropBits) : (magnitude << (10 - topBit));
+
+			bits = (static_cast<uint64_t>(topBit + 15) << 10) + significand - 0x400u;
+			if (roundsAway && (magnitude & ((static_cast<uint64_t>(1) << dropBits) - 1u)) != 0)
+				bits++;
+		}
+
+		return ((value < 0) ? 0x8000u : 0u) | bits;
+	}
+
+	// Floats this far from zero are all integers, and 2^63 is the only one that doesn't fit in an
+	// int64_t, so comparing through int64_t is exact
+	if (format == SimdElementFormat::kFloat32)
+	{
+		float rounded = static_cast<float>(value);
+		const bool isAbove = (rounded >= 9223372036854775808.0f || static_cast<int64_t>(rounded) > value);
+		const bool isBelow = (rounded < 9223372036854775808.0f && static_cast<int64_t>(rounded) < value);
+
+		if (roundUp && isBelow)
+			rounded = nextafterf(rounded, INFINITY);
+		else if (!roundUp && isAbove)
+			rounded = nextafterf(rounded, -INFINITY);
+
+		uint32_t bits = 0;
+		memcpy(&bits, &rounded, sizeof(bits));
+		return bits;
+	}
+
+	double rounded = static_cast<double>(value);
+	const bool isAbove = (rounded >= 9223372036854775808.0 || static_cast<int64_t>(rounded) > value);
+	const bool isBelow = (rounded < 9223372036854775808.0 && static_cast<int64_t>(rounded) < value);
+
+	if (roundUp && isBelow)
+		rounded = nextafter(rounded, INFINITY);
+	else if (!roundUp && isAbove)
+		rounded = nextafter(rounded, -INFINITY);
+
+	uint64_t bits = 0;
+	memcpy(&bits, &rounded, sizeof(bits));
+	return bits;
+}
+
+// The same as the emitted rkc_f16_to_f32
+uint32_t rkci::SimdCppEmitter::HalfToFloat32Bits(uint16_t halfBits)
+{
+	const uint32_t sign = static_cast<uint32_t>(halfBits & 0x8000u) << 16;
+	const uint32_t exponent = (halfBits >> 10) & 0x1fu;
+	uint32_t mantissa = halfBits & 0x3ffu;
+
+	if (exponent == 0x1fu)
+		return sign | 0x7f800000u | (mantissa << 13) | ((mantissa != 0) ? 0x400000u : 0u);
+
+	if (exponent != 0)
+		return sign | ((exponent + 112u) << 23) | (mantissa << 13);
+
+	if (mantissa == 0)
+		return sign;
+
+	uint32_t normalExponent = 113;
+	while (!(mantissa & 0x400u))
+	{
+		mantissa <<= 1;
+		normalExponent--;
+	}
+
+	return sign | (normalExponent << 23) | ((mantissa & 0x3ffu) << 13);
+}
+
+// The same as the emitted rkc_f32_to_f16
+uint16_t rkci::SimdCppEmitter::Float32BitsToHalf(uint32_t floatBits)
+{
+	const uint32_t sign = (floatBits >> 16) & 0x8000u;
+	const uint32_t exponent = (floatBits >> 23) & 0xffu;
+	const uint32_t mantissa = floatBits & 0x7fffffu;
+
+	if (exponent == 0xffu)
+		return static_cast<uint16_t>(sign | 0x7c00u | ((mantissa != 0) ? (0x200u | (mantissa >> 13)) : 0u));
+
+	if (exponent == 0)
+		return static_cast<uint16_t>(sign);
+
+	return RoundToHalf(sign, static_cast<int32_t>(exponent) - 112, mantissa | 0x800000u, 23);
+}
+
+// The same as the emitted rkc_f64_to_f16
+uint16_t rkci::SimdCppEmitter::Float64BitsToHalf(uint64_t floatBits)
+{
+	const uint32_t sign = static_cast<uint32_t>(floatBits >> 48) & 0x8000u;
+	const uint32_t exponent = static_cast<uint32_t>(floatBits >> 52) & 0x7ffu;
+	const uint64_t mantissa = floatBits & 0xfffffffffffffull;
+
+	if (exponent == 0x7ffu)
+		return static_cast<uint16_t>(sign | 0x7c00u | ((mantissa != 0) ? (0x200u | static_cast<uint32_t>(mantissa >> 42)) : 0u));
+
+	if (exponent == 0)
+		return static_cast<uint16_t>(sign);
+
+	return RoundToHalf(sign, static_cast<int32_t>(exponent) - 1008, mantissa | 0x10000000000000ull, 52);
+}
+
+// The same as the emitted rkc_round_to_f16
+uint16_t rkci::SimdCppEmitter::RoundToHalf(uint32_t sign, int32_t halfExponent, uint64_t significand, int fractionBits)
+{
+	if (halfExponent >= 31)
+		return static_cast<uint16_t>(sign | 0x7c00u);
+
+	int shift = fractionBits - 10;
+	uint32_t result = 0;
+	if (halfExponent >= 1)
+		result = (static_cast<uint32_t>(halfExponent - 1) << 10) + static_cast<uint32_t>(significand >> shift);
+	else
+	{
+		shift += 1 - halfExponent;
+		if (shift > fractionBits + 1)
+			return static_cast<uint16_t>(sign);
+		result = static_cast<uint32_t>(significand >> shift);
+	}
+
+	const uint64_t remainder = significand & ((static_cast<uint64_t>(1) << shift) - 1u);
+	const uint64_t halfway = static_cast<uint64_t>(1) << (shift - 1);
+	if (remainder > halfway || (remainder == halfway && (result & 1u)))
+		result++;
+
+	return static_cast<uint16_t>(sign | result);
+}
+
+uint8_t rkci::SimdCppEmitter::GetMaskBitsIndex(uint8_t bits)
+{
+	return (bits == 8) ? 0 : (bits == 16) ? 1 : (bits == 32) ? 2 : 3;
+}
+
+// Floatspecs that aren't IEEE binary16, 32 or 64 (see CustomFloatFormat)
+bool rkci::SimdCppEmitter::IsCustomFloatType(const Kernel::Function &function, Kernel::TypeIndex_t type)
+{
+	const Kernel::Type &typeInfo = function.GetType(type);
+	return typeInfo.m_kind == Kernel::TypeKind::kFloat && !SimdTarget::IsIeeeFloatSpec(typeInfo.m_floatSpec);
+}
+
+// The integer format of the same width as a float format
+rkci::SimdElementFormat rkci::SimdCppEmitter::GetFloatBitsFormat(SimdElementFormat format)
+{
+	return (format == SimdElementFormat::kFloat32) ? SimdElementFormat::kInt32 : SimdElementFormat::kInt64;
+}
+
+bool rkci::SimdCppEmitter::IsValidIdentifier(const ArraySliceView<const uint8_t> &name)
+{
+	const size_t length = name.Count();
+	if (length == 0)
+		return false;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		const uint8_t c = name[i];
+		const bool isLetter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+		const bool isDigit = (c >= '0' && c <= '9');
+
+		if (!isLetter && !(isDigit && i > 0))
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "AccessPatternAnalysis.h"
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "RangeAnalysis.h"
+#include "SimdTarget.h"
+#include "UniformityAnalysis.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	struct IAllocator;
+	template<class T> class ArraySliceView;
+	class CustomFloatFormat;
+	class Result;
+
+	// Emits a kernel as a C++ translation unit that uses SSE, AVX2 or AVX-512 intrinsics, to be built by
+	// the host's C++ compiler.  The translation unit defines an extern "C" function named after the
+	// kernel that takes the element count followed by the kernel parameters in order: uniforms by value
+	// and buffers by pointer followed by their length in elements.
+	//
+	// Each value type gets a small struct wrapping its register with static inline helpers for the
+	// operations the kernel can use, and the kernel body is a sequence of helper calls.  The loop over
+	// elements runs whole vectors up to the end of the shortest buffer accessed at the lane index, and
+	// then partial vectors for the remainder, which check each lane against the buffers' lengths.
+	//
+	// Loads and stores at the lane index move the block's own elements.  Other indexes are classified by
+	// AccessPatternAnalysis: a uniform index is a scalar access, a contiguous run is a vector access when
+	// it's entirely inside the buffer, and anything else is a gather or scatter, which uses the AVX2 and
+	// AVX-512 instructions for 32-bit elements with 32-bit indexes.  Lanes whose index is outside of the
+	// buffer's length read zero and don't store.
+	//
+	// Integer values that provably can't overflow are held in the narrowest lanes that fit their range
+	// (see RangeAnalysis), and are converted where they meet values in other formats.
+	//
+	// Floatspecs that aren't IEEE are held in a wider IEEE format (see CustomFloatFormat), and each one
+	// gets helpers that round to it and that pack and unpack its encoding in buffers and uniforms.
+	//
+	// With range checks on, a checked result is computed in lanes wide enough for its exact range and
+	// compared against its declared range, and failing lanes are ORed into a sticky error mask per lane
+	// size.  Nothing branches on the error masks until the end of the block.
+	//
+	// Control flow has to be in masked form already (see ConditionMasking).  A masked region on a
+	// uniform mask is a plain branch.  Otherwise it narrows the execution mask, is skipped when no lanes
+	// are left, and stores and variable writes inside it only fall back to masking when some lanes are
+	// off.
+	class SimdCppEmitter
+	{
+	public:
+		SimdCppEmitter(IAllocator *alloc, const SimdTarget &target);
+
+		// If set, integer results that can leave their declared range are checked, and the entry point
+		// returns int, nonzero if any element failed a check.  Operations that RangeAnalysis proves
+		// can't overflow aren't checked.
+		void SetRangeChecks(bool rangeChecks);
+
+		// Returns kNotYetImplemented if the kernel uses a type or operation that the target can't emit
+		Result Emit(const Kernel::Function &function, Vector<uint8_t> &outText);
+
+		// Scalar versions of the software half-precision conversions that targets without F16C use, with
+		// values as the bits of their IEEE format
+		static uint32_t HalfToFloat32Bits(uint16_t halfBits);
+		static uint16_t Float32BitsToHalf(uint32_t floatBits);
+		static uint16_t Float64BitsToHalf(uint64_t floatBits);
+
+	private:
+		struct TemplateVars
+		{
+			char m_values[26][32];
+		};
+
+		// Which helpers a custom floatspec type needs
+		struct CustomFloatUses
+		{
+			bool m_round;
+			bool m_roundFromF64;
+			bool m_pack;
+			bool m_unpack;
+		};
+
+		static void SetVar(TemplateVars &vars, char name, const char *value);
+		static void SetVarConcat(TemplateVars &vars, char name, const char *const *parts, size_t numParts);
+		static void SetVarNumber(TemplateVars &vars, char name, uint64_t value);
+		static void SetVarHex(TemplateVars &vars, char name, uint64_t value);
+
+		Result Append(const char *text);
+		Result AppendBytes(const uint8_t *bytes, size_t count);
+		Result AppendSlice(const ArraySliceView<const uint8_t> &bytes);
+		Result AppendDecimal(uint64_t value);
+		Result AppendTemplate(const char *text, const TemplateVars &vars);
+
+		static const char *GetFormatName(SimdElementFormat format);
+		static const char *GetElementCType(SimdElementFormat format);
+		uint16_t GetMaskRegisterBits(uint8_t bits) const;
+		static const char *GetIntRegisterType(uint16_t registerBits);
+		static const char *GetIntrinsicPrefix(uint16_t registerBits);
+
+		void BuildVectorVars(SimdElementFormat format, TemplateVars &vars) const;
+		void BuildMaskVars(uint8_t bits, TemplateVars &vars) const;
+		void BuildValueVars(const Kernel::Function &function, Kernel::ValueIndex_t value, TemplateVars &vars) const;
+		void BuildCustomFloatVars(SimdElementFormat floatFormat, TemplateVars &vars) const;
+
+		Result ScanKernel(const Kernel::Function &function);
+		Result SelectValueFormats(const Kernel::Function &function);
+		SimdElementFormat GetOperandFormat(const Kernel::Function &function, Kernel::ValueIndex_t user, size_t operandIndex) const;
+		Result UseFormat(SimdElementFormat format);
+		Result EmitPrologue(const Kernel::Function &function);
+		Result EmitMaskType(uint8_t bits);
+		Result EmitVectorType(SimdElementFormat format);
+		Result EmitHalfOperations();
+		Result EmitConversion(SimdElementFormat fromFormat, SimdElementFormat toFormat);
+		Result EmitIndexOperations(SimdElementFormat format);
+		Result EmitRunOperations(SimdElementFormat format);
+		Result EmitAccessOperations(SimdElementFormat format);
+		Result EmitHardwareGather(SimdElementFormat format, SimdElementFormat indexFormat);
+		Result EmitCustomFloatOperations(const Kernel::Function &function, Kernel::TypeIndex_t type);
+		Result EmitCustomFloatRound(const CustomFloatFormat &customFormat, SimdElementFormat sourceFormat, TemplateVars &vars);
+		Result EmitCustomFloatPack(const CustomFloatFormat &customFormat, TemplateVars &vars);
+		Result EmitCustomFloatUnpack(const CustomFloatFormat &customFormat, TemplateVars &vars);
+		Result EmitParamList(const Kernel::Function &function, bool withTypes);
+		Result EmitBlock(const Kernel::Function &function);
+		Result EmitBlockErrors();
+		Result EmitVariables(const Kernel::Function &function);
+		Result EmitInstruction(const Kernel::Function &function, Kernel::ValueIndex_t index);
+		Result EmitStatement(const Kernel::Function &function, Kernel::ValueIndex_t index);
+		Result GetCustomFloatConvertFormat(const Kernel::Function &function, Kernel::ValueIndex_t index, SimdElementFormat &outFormat) const;
+		Result PrepareOperands(const Kernel::Function &function, Kernel::ValueIndex_t index, TemplateVars &vars);
+		Result AppendConstant(const Kernel::Function &function, Kernel::ValueIndex_t value, SimdElementFormat format);
+		Result EmitExecMaskAs(uint8_t bits);
+		Result EmitRangeCheck(const Kernel::Function &function, Kernel::ValueIndex_t index);
+		Result AppendSplat(SimdElementFormat format, uint64_t immediate);
+		Result AppendIndent();
+		Result EmitEntryPoint(const Kernel::Function &function);
+
+		SimdElementFormat GetValueFormat(const Kernel::Function &function, Kernel::ValueIndex_t value) const;
+		static bool IsValidIdentifier(const ArraySliceView<const uint8_t> &name);
+		static bool IsCustomFloatType(const Kernel::Function &function, Kernel::TypeIndex_t type);
+		static SimdElementFormat GetFloatBitsFormat(SimdElementFormat format);
+		static uint64_t RoundToFloatBits(SimdElementFormat format, int64_t value, bool roundUp);
+		static uint16_t RoundToHalf(uint32_t sign, int32_t halfExponent, uint64_t significand, int fractionBits);
+		static uint8_t GetMaskBitsIndex(uint8_t bits);
+
+		static const size_t kNumFormats = static_cast<size_t>(SimdElementFormat::kCount);
+
+		SimdTarget m_target;
+		Vector<uint8_t> *m_out;
+		Vector<SimdElementFormat> m_typeFormats;
+		Vector<SimdElementFormat> m_storageFormats;
+		Vector<CustomFloatUses> m_customFloatUses;
+		Vector<SimdElementFormat> m_valueFormats;
+		bool m_formatUsed[kNumFormats];
+		bool m_maskBitsUsed[4];
+		bool m_conversionUsed[kNumFormats][kNumFormats];
+		bool m_indexFormatUsed[kNumFormats];
+		bool m_runFormatUsed[kNumFormats];
+		bool m_accessFormatUsed[kNumFormats];
+		bool m_usesExecMask;
+		bool m_usesBufferAccess;
+		bool m_rangeChecks;
+		bool m_checkBitsUsed[4];
+		Vector<uint8_t> m_isValueChecked;
+		Vector<uint8_t> m_isValueUsed;
+		Vector<uint8_t> m_isParamAtLaneIndex;
+		Vector<Kernel::ValueIndex_t> m_execStack;
+		UniformityAnalysis m_uniformity;
+		RangeAnalysis m_ranges;
+		AccessPatternAnalysis m_accessPatterns;
+		uint32_t m_indent;
+	};
+}
@@ -0,0 +1,180 @@
+#include "SimdTarget.h"
+#include "CustomFloatFormat.h"
+#include "Result.h"
+
+rkci::SimdTarget::SimdTarget(SimdIsa isa, uint8_t numLanes)
+	: m_isa(isa)
+	, m_numLanes(numLanes)
+{
+}
+
+rkci::ResultRV<rkci::SimdTarget> rkci::SimdTarget::Create(SimdIsa isa, uint8_t numLanes)
+{
+	if (numLanes != 4 && numLanes != 8 && numLanes != 16)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	const SimdTarget target(isa, numLanes);
+	if (target.GetRegisterBits(SimdElementFormat::kInt32) == 0)
+		return rkc::ResultCodes::kInvalidOperation;
+
+	return target;
+}
+
+rkci::SimdIsa rkci::SimdTarget::GetDefaultIsa(uint8_t numLanes)
+{
+	if (numLanes <= 4)
+		return SimdIsa::kSSE42;
+	if (numLanes <= 8)
+		return SimdIsa::kAVX2;
+
+	return SimdIsa::kAVX512;
+}
+
+rkci::SimdIsa rkci::SimdTarget::GetIsa() const
+{
+	return m_isa;
+}
+
+bool rkci::SimdTarget::HasF16C() const
+{
+	return m_isa != SimdIsa::kSSE42;
+}
+
+uint8_t rkci::SimdTarget::GetNumLanes() const
+{
+	return m_numLanes;
+}
+
+uint16_t rkci::SimdTarget::GetMaxRegisterBits() const
+{
+	switch (m_isa)
+	{
+	case SimdIsa::kSSE42:
+		return 128;
+	case SimdIsa::kAVX2:
+		return 256;
+	case SimdIsa::kAVX512:
+		return 512;
+	default:
+		return 0;
+	}
+}
+
+uint16_t rkci::SimdTarget::GetRegisterBits(SimdElementFormat format) const
+{
+	uint16_t registerBits = 128;
+	const uint16_t valueBits = static_cast<uint16_t>(GetElementBits(format) * m_numLanes);
+
+	while (registerBits < valueBits)
+		registerBits = static_cast<uint16_t>(registerBits * 2);
+
+	if (registerBits > GetMaxRegisterBits())
+		return 0;
+
+	return registerBits;
+}
+
+rkci::ResultRV<rkci::SimdElementFormat> rkci::SimdTarget::SelectElementFormat(const Kernel::Function &function, Kernel::TypeIndex_t typeIndex)
+{
+	const Kernel::Type *type = &function.GetType(typeIndex);
+	if (type->m_kind == Kernel::TypeKind::kMask)
+		type = &function.GetType(type->m_laneType);
+
+	if (type->m_kind == Kernel::TypeKind::kInt)
+		return SelectIntFormat(type->m_minValue, type->m_maxValue);
+
+	const FloatSpec &floatSpec = type->m_floatSpec;
+	if (IsIeeeFloatSpec(floatSpec))
+	{
+		if (floatSpec.GetExponentBits() == 5)
+			return SimdElementFormat::kFloat16;
+		if (floatSpec.GetExponentBits() == 8)
+			return SimdElementFormat::kFloat32;
+		return SimdElementFormat::kFloat64;
+	}
+
+	// Other floatspecs are held in the wide format that holds them
+	RKC_CHECK_RV(CustomFloatFormat, customFormat, CustomFloatFormat::Create(floatSpec));
+	return customFormat.GetWideFormat();
+}
+
+bool rkci::SimdTarget::IsIeeeFloatSpec(const FloatSpec &floatSpec)
+{
+	if (!floatSpec.IsSigned() || !floatSpec.SupportsDenormals() || !floatSpec.SupportsNans())
+		return false;
+
+	const uint16_t exponentBits = floatSpec.GetExponentBits();
+	const uint16_t mantissaBits = floatSpec.GetMantissaBits();
+	const int16_t exponentOfOne = floatSpec.GetExponentOfOne();
+
+	return (exponentBits == 5 && mantissaBits == 10 && exponentOfOne == 15)
+		|| (exponentBits == 8 && mantissaBits == 23 && exponentOfOne == 127)
+		|| (exponentBits == 11 && mantissaBits == 52 && exponentOfOne == 1023);
+}
+
+rkci::SimdElementFormat rkci::SimdTarget::SelectIntFormat(int64_t minValue, int64_t maxValue)
+{
+	if (minValue >= 0)
+	{
+		if (maxValue <= 0xff)
+			return SimdElementFormat::kUInt8;
+		if (maxValue <= 0xffff)
+			return SimdElementFormat::kUInt16;
+		if (maxValue <= 0xffffffffll)
+			return SimdElementFormat::kUInt32;
+
+		return SimdElementFormat::kUInt64;
+	}
+
+	if (minValue >= -0x80 && maxValue <= 0x7f)
+		return SimdElementFormat::kInt8;
+	if (minValue >= -0x8000 && maxValue <= 0x7fff)
+		return SimdElementFormat::kInt16;
+	if (minValue >= -0x80000000ll && maxValue <= 0x7fffffffll)
+		return SimdElementFormat::kInt32;
+
+	return SimdElementFormat::kInt64;
+}
+
+uint8_t rkci::SimdTarget::GetElementBits(SimdElementFormat format)
+{
+	switch (format)
+	{
+	case SimdElementFormat::kInt8:
+	case SimdElementFormat::kUInt8:
+		return 8;
+	case SimdElementFormat::kInt16:
+	case SimdElementFormat::kUInt16:
+	case SimdElementFormat::kFloat16:
+		return 16;
+	case SimdElementFormat::kInt32:
+	case SimdElementFormat::kUInt32:
+	case SimdElementFormat::kFloat32:
+		return 32;
+	case SimdElementFormat::kInt64:
+	case SimdElementFormat::kUInt64:
+	case SimdElementFormat::kFloat64:
+		return 64;
+	default:
+		return 0;
+	}
+}
+
+bool rkci::SimdTarget::IsFloatFormat(SimdElementFormat format)
+{
+	return format == SimdElementFormat::kFloat16 || format == SimdElementFormat::kFloat32 || format == SimdElementFormat::kFloat64;
+}
+
+bool rkci::SimdTarget::IsSignedFormat(SimdElementFormat format)
+{
+	switch (format)
+	{
+	case SimdElementFormat::kInt8:
+	case SimdElementFormat::kInt16:
+	case SimdElementFormat::kInt32:
+	case SimdElementFormat::kInt64:
+		return true;
+	default:
+		return IsFloatFormat(format);
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "KernelIR.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	template<class T> class ResultRV;
+
+	enum class SimdIsa : uint8_t
+	{
+		kSSE42,
+		kAVX2,
+		kAVX512,	// F, BW, DQ and VL
+	};
+
+	enum class SimdElementFormat : uint8_t
+	{
+		kInt8,
+		kUInt8,
+		kInt16,
+		kUInt16,
+		kInt32,
+		kUInt32,
+		kInt64,
+		kUInt64,
+		kFloat16,
+		kFloat32,
+		kFloat64,
+
+		kCount,
+	};
+
+	// A lane count and the instruction set that the backend emits for.  Every kernel value is held in
+	// the narrowest register that fits one element per lane, so an intspec that fits in 16 bits takes
+	// half the register of a 32-bit one.
+	class SimdTarget
+	{
+	public:
+		SimdTarget(SimdIsa isa, uint8_t numLanes);
+
+		// Lane counts are 4, 8 or 16.  An ISA wider than the lane count needs is allowed, which makes
+		// room for 64-bit elements.
+		static ResultRV<SimdTarget> Create(SimdIsa isa, uint8_t numLanes);
+
+		// The ISA whose registers hold numLanes 32-bit elements
+		static SimdIsa GetDefaultIsa(uint8_t numLanes);
+
+		SimdIsa GetIsa() const;
+		uint8_t GetNumLanes() const;
+
+		// Every AVX2 and AVX-512 part also has F16C's half-precision conversions
+		bool HasF16C() const;
+		uint16_t GetMaxRegisterBits() const;
+
+		// Returns the register size for a value of the format, or 0 if it doesn't fit in one register
+		uint16_t GetRegisterBits(SimdElementFormat format) const;
+
+		// Picks the narrowest format that holds every value of a type.  Masks use the format of their
+		// lane type.  Floatspecs that aren't IEEE binary16, 32 or 64 use the wide format of their
+		// CustomFloatFormat, or return kNotYetImplemented if there isn't one.
+		static ResultRV<SimdElementFormat> SelectElementFormat(const Kernel::Function &function, Kernel::TypeIndex_t type);
+		static SimdElementFormat SelectIntFormat(int64_t minValue, int64_t maxValue);
+
+		static bool IsIeeeFloatSpec(const FloatSpec &floatSpec);
+
+		static uint8_t GetElementBits(SimdElementFormat format);
+		static bool IsFloatFormat(SimdElementFormat format);
+		static bool IsSignedFormat(SimdElementFormat format);
+
+	private:
+		SimdIsa m_isa;
+		uint8_t m_numLanes;
+	};
+}
@@ -0,0 +1,122 @@
+#include "SymbolPool.h"
+#include "ArraySliceView.h"
+#include "Hasher.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+#include <string.h>
+
+rkci::SymbolPool::SymbolPool(IAllocator &alloc)
+	: m_bytes(&alloc)
+	, m_symbols(&alloc)
+	, m_buckets(&alloc)
+{
+}
+
+rkci::ResultRV<rkci::SymbolID_t> rkci::SymbolPool::Intern(const ArraySliceView<const uint8_t> &bytes)
+{
+	const Hash_t hash = HashUtil::ComputePODHash(bytes.Count() ? &bytes[0] : nullptr, bytes.Count());
+
+	if (m_buckets.Count() != 0)
+	{
+		const size_t bucket = FindBucket(bytes, hash);
+		if (m_buckets[bucket] != kEmptyBucket)
+			return m_buckets[bucket];
+	}
+
+	const size_t numSymbols = m_symbols.Count();
+	const size_t offset = m_bytes.Count();
+	if (numSymbols >= kEmptyBucket || bytes.Count() > 0xffffffffu - offset)
+		return rkc::ResultCodes::kIntegerOverflow;
+
+	// Keep the load factor at or below 1/2
+	if ((numSymbols + 1) * 2 > m_buckets.Count())
+	{
+		size_t numBuckets = m_buckets.Count() * 2;
+		if (numBuckets < 64)
+			numBuckets = 64;
+
+		RKC_CHECK(Rehash(numBuckets));
+	}
+
+	SymbolEntry entry;
+	entry.m_offset = static_cast<uint32_t>(offset);
+	entry.m_length = static_cast<uint32_t>(bytes.Count());
+	entry.m_hash = hash;
+
+	RKC_CHECK(m_bytes.AppendRange(bytes));
+	RKC_CHECK(m_symbols.Append(entry));
+
+	const SymbolID_t symbol = static_cast<SymbolID_t>(numSymbols);
+	m_buckets[FindBucket(bytes, hash)] = symbol;
+
+	return symbol;
+}
+
+bool rkci::SymbolPool::Find(const ArraySliceView<const uint8_t> &bytes, SymbolID_t &outSymbol) const
+{
+	if (m_buckets.Count() == 0)
+		return false;
+
+	const Hash_t hash = HashUtil::ComputePODHash(bytes.Count() ? &bytes[0] : nullptr, bytes.Count());
+	const uint32_t symbol = m_buckets[FindBucket(bytes, hash)];
+	if (symbol == kEmptyBucket)
+		return false;
+
+	outSymbol = symbol;
+	return true;
+}
+
+rkci::ArraySliceView<const uint8_t> rkci::SymbolPool::GetBytes(SymbolID_t symbol) const
+{
+	const SymbolEntry &entry = m_symbols[symbol];
+	return m_bytes.Slice().Subrange(entry.m_offset, entry.m_length);
+}
+
+size_t rkci::SymbolPool::NumSymbols() const
+{
+	return m_symbols.Count();
+}
+
+size_t rkci::SymbolPool::FindBucket(const ArraySliceView<const uint8_t> &bytes, Hash_t hash) const
+{
+	const size_t mask = m_buckets.Count() - 1;
+	size_t bucket = static_cast<size_t>(hash) & mask;
+
+	for (;;)
+	{
+		const uint32_t symbol = m_buckets[bucket];
+		if (symbol == kEmptyBucket)
+			return bucket;
+
+		const SymbolEntry &entry = m_symbols[symbol];
+		if (entry.m_hash == hash && entry.m_length == bytes.Count())
+		{
+			if (entry.m_length == 0 || !memcmp(&m_bytes[entry.m_offset], &bytes[0], entry.m_length))
+				return bucket;
+		}
+
+		bucket = (bucket + 1) & mask;
+	}
+}
+
+rkci::Result rkci::SymbolPool::Rehash(size_t numBuckets)
+{
+	RKC_ASSERT((numBuckets & (numBuckets - 1)) == 0);
+
+	RKC_CHECK(m_buckets.ResizeNoConstruct(numBuckets));
+	memset(&m_buckets[0], 0xff, numBuckets * sizeof(uint32_t));
+
+	const size_t mask = numBuckets - 1;
+	const size_t numSymbols = m_symbols.Count();
+	for (size_t i = 0; i < numSymbols; i++)
+	{
+		size_t bucket = static_cast<size_t>(m_symbols[i].m_hash) & mask;
+		while (m_buckets[bucket] != kEmptyBucket)
+			bucket = (bucket + 1) & mask;
+
+		m_buckets[bucket] = static_cast<uint32_t>(i);
+	}
+
+	return Result::Ok();
+}
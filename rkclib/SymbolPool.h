@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "Vector.h"
+
+#include <stdint.h>
+
+namespace rkci
+{
+	struct IAllocator;
+	class Result;
+	template<class T> class ArraySliceView;
+	template<class T> class ResultRV;
+
+	typedef uint32_t SymbolID_t;
+
+	// Interns byte strings so that identical names share one ID.  IDs are dense and stay valid for
+	// the lifetime of the pool, so a long-lived pool can be shared by every compile in a context.
+	class SymbolPool
+	{
+	public:
+		explicit SymbolPool(IAllocator &alloc);
+
+		ResultRV<SymbolID_t> Intern(const ArraySliceView<const uint8_t> &bytes);
+		bool Find(const ArraySliceView<const uint8_t> &bytes, SymbolID_t &outSymbol) const;
+
+		ArraySliceView<const uint8_t> GetBytes(SymbolID_t symbol) const;
+		size_t NumSymbols() const;
+
+	private:
+		struct SymbolEntry
+		{
+			uint32_t m_offset;
+			uint32_t m_length;
+			Hash_t m_hash;
+		};
+
+		static const uint32_t kEmptyBucket = 0xffffffffu;
+
+		size_t FindBucket(const ArraySliceView<const uint8_t> &bytes, Hash_t hash) const;
+		Result Rehash(size_t numBuckets);
+
+		Vector<uint8_t> m_bytes;
+		Vector<SymbolEntry> m_symbols;
+		Vector<uint32_t> m_buckets;
+	};
+}
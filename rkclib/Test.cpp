@@ -6,13 +6,61 @@ namespace rkci
 
 	namespace Tests
 	{
+		Result AccessPatterns(IAllocator &alloc);
+		Result AstModuleFile(IAllocator &alloc);
 		Result BigAtof(IAllocator &alloc);
+		Result BigUFloat(IAllocator &alloc);
+		Result ConstantFolding(IAllocator &alloc);
+		Result Composite(IAllocator &alloc);
+		Result ContextCaches(IAllocator &alloc);
+		Result ConditionMasks(IAllocator &alloc);
+		Result CustomFloatFormat(IAllocator &alloc);
+		Result ExportInterface(IAllocator &alloc);
+		Result FloatSpec(IAllocator &alloc);
+		Result HalfConversions(IAllocator &alloc);
+		Result LexerBatches(IAllocator &alloc);
+		Result LexerRecovery(IAllocator &alloc);
+		Result ModuleBlobs(IAllocator &alloc);
+		Result MonomorphCache(IAllocator &alloc);
+		Result NumUtils(IAllocator &alloc);
+		Result RangeCheckText(IAllocator &alloc);
+		Result ReadAhead(IAllocator &alloc);
+		Result SimdKernelText(IAllocator &alloc);
+		Result StreamedLexing(IAllocator &alloc);
+		Result TrackingAllocator(IAllocator &alloc);
+		Result Uniformity(IAllocator &alloc);
+		Result ValueRanges(IAllocator &alloc);
+		Result Vector(IAllocator &alloc);
 	}
 }
 
 static rkci::Result RkcTestInternal(rkci::IAllocator &alloc)
 {
+	RKC_CHECK(rkci::Tests::AstModuleFile(alloc));
 	RKC_CHECK(rkci::Tests::BigAtof(alloc));
+	RKC_CHECK(rkci::Tests::BigUFloat(alloc));
+	RKC_CHECK(rkci::Tests::FloatSpec(alloc));
+	RKC_CHECK(rkci::Tests::CustomFloatFormat(alloc));
+	RKC_CHECK(rkci::Tests::HalfConversions(alloc));
+	RKC_CHECK(rkci::Tests::ConstantFolding(alloc));
+	RKC_CHECK(rkci::Tests::LexerRecovery(alloc));
+	RKC_CHECK(rkci::Tests::StreamedLexing(alloc));
+	RKC_CHECK(rkci::Tests::LexerBatches(alloc));
+	RKC_CHECK(rkci::Tests::ReadAhead(alloc));
+	RKC_CHECK(rkci::Tests::Composite(alloc));
+	RKC_CHECK(rkci::Tests::ContextCaches(alloc));
+	RKC_CHECK(rkci::Tests::ExportInterface(alloc));
+	RKC_CHECK(rkci::Tests::ModuleBlobs(alloc));
+	RKC_CHECK(rkci::Tests::MonomorphCache(alloc));
+	RKC_CHECK(rkci::Tests::ConditionMasks(alloc));
+	RKC_CHECK(rkci::Tests::Uniformity(alloc));
+	RKC_CHECK(rkci::Tests::ValueRanges(alloc));
+	RKC_CHECK(rkci::Tests::AccessPatterns(alloc));
+	RKC_CHECK(rkci::Tests::RangeCheckText(alloc));
+	RKC_CHECK(rkci::Tests::SimdKernelText(alloc));
+	RKC_CHECK(rkci::Tests::NumUtils(alloc));
+	RKC_CHECK(rkci::Tests::Vector(alloc));
+	RKC_CHECK(rkci::Tests::TrackingAllocator(alloc));
 
 	return rkci::Result::Ok();
 }
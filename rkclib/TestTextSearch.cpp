@@ -0,0 +1,29 @@
+#include "TestTextSearch.h"
+#include "SimdTarget.h"
+
+#include <stdio.h>
+#include <string.h>
+
+bool rkci::Tests::EmittedTextContains(const Vector<uint8_t> &text, const char *str)
+{
+	const size_t strLength = strlen(str);
+	const size_t textLength = text.Count();
+
+	for (size_t i = 0; i + strLength <= textLength; i++)
+	{
+		if (memcmp(&text[i], str, strLength) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool rkci::Tests::EmittedTextContainsLanes(const Vector<uint8_t> &text, const char *pattern, const SimdTarget &target)
+{
+	const unsigned int numLanes = target.GetNumLanes();
+
+	char str[256];
+	snprintf(str, sizeof(str), pattern, numLanes, numLanes, numLanes);
+
+	return EmittedTextContains(text, str);
+}
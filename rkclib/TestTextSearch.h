@@ -0,0 +1,18 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	class SimdTarget;
+
+	namespace Tests
+	{
+		// Checks emitted source text for a string
+		bool EmittedTextContains(const Vector<uint8_t> &text, const char *str);
+
+		// Checks a string built from a pattern with the lane count in it up to 3 times, such as "rkcv_f32x%u_load"
+		bool EmittedTextContainsLanes(const Vector<uint8_t> &text, const char *pattern, const SimdTarget &target);
+	}
+}
@@ -0,0 +1,147 @@
+#include "AccessPatternAnalysis.h"
+#include "ArraySliceView.h"
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "RangeAnalysis.h"
+#include "Result.h"
+#include "UniformityAnalysis.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		struct ExpectedAccessPattern
+		{
+			Kernel::ValueIndex_t m_access;
+			AccessPattern m_pattern;
+		};
+
+		struct ExpectedLaneStride
+		{
+			Kernel::ValueIndex_t m_value;
+			bool m_isLinear;
+			int64_t m_stride;
+		};
+
+		Result AccessPatterns(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+			const Kernel::TypeIndex_t NT = Kernel::kInvalidTypeIndex;
+
+			Kernel::Function function(&alloc);
+			RKC_CHECK(function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("access"), 6)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(0, 1000));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, offsetType, function.AddIntType(-50, 50));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, valueType, function.AddIntType(-100000, 100000));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, inParam, function.AddParam(Kernel::ParamKind::kInputBuffer, valueType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, offsetParam, function.AddParam(Kernel::ParamKind::kUniform, offsetType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, valueType));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, indexType, N, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, lane, function.AddInstruction(Kernel::Opcode::kConvert, valueType, laneIndex, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, offsetParamValue, function.AddInstruction(Kernel::Opcode::kParam, offsetType, N, N, N, offsetParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, offset, function.AddInstruction(Kernel::Opcode::kConvert, valueType, offsetParamValue, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, one, function.AddInstruction(Kernel::Opcode::kConstant, valueType, N, N, N, 1));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, two, function.AddInstruction(Kernel::Opcode::kConstant, valueType, N, N, N, 2));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, three, function.AddInstruction(Kernel::Opcode::kConstant, valueType, N, N, N, 3));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, thousand, function.AddInstruction(Kernel::Opcode::kConstant, valueType, N, N, N, 1000));
+
+			// Uniform indexes, including a varying one whose lane index cancels out
+			RKC_CHECK_RV(Kernel::ValueIndex_t, uniformLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, offset, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, constantLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, three, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, cancelled, function.AddInstruction(Kernel::Opcode::kSub, valueType, lane, lane, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, cancelledLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, cancelled, N, N, inParam));
+
+			// Contiguous runs at the lane index and offset from it
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, laneIndex, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, shifted, function.AddInstruction(Kernel::Opcode::kAdd, valueType, lane, offset, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, shiftedLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, shifted, N, N, inParam));
+
+			// Strides from products with a constant on either side, which carry through sums and differences
+			RKC_CHECK_RV(Kernel::ValueIndex_t, doubled, function.AddInstruction(Kernel::Opcode::kMul, valueType, lane, two, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, oddIndex, function.AddInstruction(Kernel::Opcode::kSub, valueType, doubled, one, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, oddLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, oddIndex, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, tripled, function.AddInstruction(Kernel::Opcode::kMul, valueType, three, lane, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, reversed, function.AddInstruction(Kernel::Opcode::kSub, valueType, offset, tripled, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, reversedLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, reversed, N, N, inParam));
+
+			// Loaded indexes, products with a uniform that's only known at run time, and results that can
+			// overflow and wrap are arbitrary
+			RKC_CHECK_RV(Kernel::ValueIndex_t, loadedIndexLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, laneLoad, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, scaled, function.AddInstruction(Kernel::Opcode::kMul, valueType, lane, offset, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, scaledLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, scaled, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, overflowing, function.AddInstruction(Kernel::Opcode::kMul, valueType, lane, thousand, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, overflowingLoad, function.AddInstruction(Kernel::Opcode::kLoad, valueType, overflowing, N, N, inParam));
+
+			// Stores are classified the same way
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneStore, function.AddInstruction(Kernel::Opcode::kStore, NT, laneIndex, laneLoad, N, outParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, uniformStore, function.AddInstruction(Kernel::Opcode::kStore, NT, offset, uniformLoad, N, outParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, stridedStore, function.AddInstruction(Kernel::Opcode::kStore, NT, doubled, oddLoad, N, outParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, scatterStore, function.AddInstruction(Kernel::Opcode::kStore, NT, laneLoad, shiftedLoad, N, outParam));
+
+			UniformityAnalysis uniformity(&alloc);
+			RKC_CHECK(uniformity.Analyze(function));
+
+			RangeAnalysis ranges(&alloc);
+			RKC_CHECK(ranges.Analyze(function));
+
+			AccessPatternAnalysis accessPatterns(&alloc);
+			RKC_CHECK(accessPatterns.Analyze(function, uniformity, ranges));
+
+			const ExpectedAccessPattern expectedPatterns[] =
+			{
+				{ uniformLoad, AccessPattern::kUniform },
+				{ constantLoad, AccessPattern::kUniform },
+				{ cancelledLoad, AccessPattern::kUniform },
+				{ laneLoad, AccessPattern::kContiguous },
+				{ shiftedLoad, AccessPattern::kContiguous },
+				{ oddLoad, AccessPattern::kStrided },
+				{ reversedLoad, AccessPattern::kStrided },
+				{ loadedIndexLoad, AccessPattern::kArbitrary },
+				{ scaledLoad, AccessPattern::kArbitrary },
+				{ overflowingLoad, AccessPattern::kArbitrary },
+				{ laneStore, AccessPattern::kContiguous },
+				{ uniformStore, AccessPattern::kUniform },
+				{ stridedStore, AccessPattern::kStrided },
+				{ scatterStore, AccessPattern::kArbitrary },
+			};
+
+			for (size_t i = 0; i < sizeof(expectedPatterns) / sizeof(expectedPatterns[0]); i++)
+			{
+				if (accessPatterns.GetAccessPattern(expectedPatterns[i].m_access) != expectedPatterns[i].m_pattern)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			const ExpectedLaneStride expectedStrides[] =
+			{
+				{ laneIndex, true, 1 },
+				{ lane, true, 1 },
+				{ offset, true, 0 },
+				{ cancelled, true, 0 },
+				{ shifted, true, 1 },
+				{ doubled, true, 2 },
+				{ oddIndex, true, 2 },
+				{ tripled, true, 3 },
+				{ reversed, true, -3 },
+				{ laneLoad, false, 0 },
+				{ scaled, false, 0 },
+				{ overflowing, false, 0 },
+			};
+
+			for (size_t i = 0; i < sizeof(expectedStrides) / sizeof(expectedStrides[0]); i++)
+			{
+				const ExpectedLaneStride &expectedStride = expectedStrides[i];
+
+				int64_t stride = 0;
+				if (accessPatterns.GetLaneStride(expectedStride.m_value, stride) != expectedStride.m_isLinear)
+					return rkc::ResultCodes::kInternalError;
+
+				if (expectedStride.m_isLinear && stride != expectedStride.m_stride)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "Ast.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static ArraySliceView<const uint8_t> AstTestString(const char *str)
+		{
+			return ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(str), strlen(str));
+		}
+
+		static bool AstStringEquals(const ArraySliceView<const uint8_t> &bytes, const char *str)
+		{
+			const size_t length = strlen(str);
+			return bytes.Count() == length && (length == 0 || !memcmp(&bytes[0], str, length));
+		}
+
+		// Builds a module with a root over one name node per string
+		static Result BuildAstTestModule(Ast::ModuleFile &module, const char *const *names, size_t numNames)
+		{
+			Ast::NodeIndex_t children[8];
+			RKC_ASSERT(numNames <= sizeof(children) / sizeof(children[0]));
+
+			for (size_t i = 0; i < numNames; i++)
+			{
+				RKC_CHECK_RV(Ast::StringIndex_t, stringIndex, module.AddString(AstTestString(names[i])));
+				RKC_CHECK_RV(Ast::NodeIndex_t, nameNode, module.AddNode(Ast::NodeKind::kName, ArraySliceView<const Ast::NodeIndex_t>(), stringIndex, static_cast<uint32_t>(i * 10)));
+				children[i] = nameNode;
+			}
+
+			RKC_CHECK_RV(Ast::NodeIndex_t, root, module.AddNode(Ast::NodeKind::kModule, ArraySliceView<const Ast::NodeIndex_t>(children, numNames), 0, 0));
+			module.SetRoot(root);
+
+			return Result::Ok();
+		}
+
+		static bool AstTestModuleMatches(const Ast::ModuleFile &module, const char *const *names, size_t numNames)
+		{
+			const Ast::NodeIndex_t root = module.GetRoot();
+			if (root == Ast::kInvalidNodeIndex || module.GetKind(root) != Ast::NodeKind::kModule)
+				return false;
+
+			if (module.NumNodes() != numNames + 1)
+				return false;
+
+			ArraySliceView<const Ast::NodeIndex_t> children = module.GetChildren(root);
+			if (children.Count() != numNames)
+				return false;
+
+			for (size_t i = 0; i < numNames; i++)
+			{
+				const Ast::NodeIndex_t child = children[i];
+				if (module.GetKind(child) != Ast::NodeKind::kName || module.GetChildren(child).Count() != 0)
+					return false;
+
+				const Ast::Node &node = module.GetNode(child);
+				if (node.m_filePos != i * 10 || !AstStringEquals(module.GetString(node.m_data), names[i]))
+					return false;
+			}
+
+			return true;
+		}
+
+		// Move-assigns a parsed module over one that still owns its own arena and nodes, then walks the
+		// result, so the tree has to survive the destination's arena being released
+		static Result CheckAstModuleMoveAssign(IAllocator &alloc)
+		{
+			static const char *const kSourceNames[] = { "alpha", "beta", "gamma", "delta" };
+			static const char *const kDestNames[] = { "unrelated", "names" };
+			const size_t kNumSourceNames = sizeof(kSourceNames) / sizeof(kSourceNames[0]);
+			const size_t kNumDestNames = sizeof(kDestNames) / sizeof(kDestNames[0]);
+
+			RKC_CHECK_RV(Ast::ModuleFile, source, Ast::ModuleFile::Create(alloc, 64));
+			RKC_CHECK(BuildAstTestModule(source, kSourceNames, kNumSourceNames));
+
+			RKC_CHECK_RV(Ast::ModuleFile, dest, Ast::ModuleFile::Create(alloc, 64));
+			RKC_CHECK(BuildAstTestModule(dest, kDestNames, kNumDestNames));
+
+			const Arena *sourceArena = source.GetArena();
+
+			dest = static_cast<Ast::ModuleFile&&>(source);
+
+			if (dest.GetArena() != sourceArena || source.GetArena() != nullptr)
+				return rkc::ResultCodes::kInternalError;
+
+			if (!AstTestModuleMatches(dest, kSourceNames, kNumSourceNames))
+				return rkc::ResultCodes::kInternalError;
+
+			// The moved-in module can still grow from its arena
+			RKC_CHECK_RV(Ast::StringIndex_t, extraString, dest.AddString(AstTestString("epsilon")));
+			RKC_CHECK_RV(Ast::NodeIndex_t, extraNode, dest.AddNode(Ast::NodeKind::kName, ArraySliceView<const Ast::NodeIndex_t>(), extraString, 0));
+
+			if (dest.GetKind(extraNode) != Ast::NodeKind::kName || !AstStringEquals(dest.GetString(extraString), "epsilon"))
+				return rkc::ResultCodes::kInternalError;
+
+			if (dest.NumNodes() != kNumSourceNames + 2 || dest.GetChildren(dest.GetRoot()).Count() != kNumSourceNames)
+				return rkc::ResultCodes::kInternalError;
+
+			// Self-assignment leaves the module intact
+			Ast::ModuleFile &destRef = dest;
+			dest = static_cast<Ast::ModuleFile&&>(destRef);
+
+			if (dest.GetArena() != sourceArena || !AstStringEquals(dest.GetString(extraString), "epsilon"))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result AstModuleFile(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckAstModuleMoveAssign(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
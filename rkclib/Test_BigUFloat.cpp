@@ -0,0 +1,176 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "BigUBinFloatProto.h"
+#include "BigUDecFloatProto.h"
+#include "BigUFloat.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static Result CheckBigUFloatShift(IAllocator &alloc)
+		{
+			BigUBinFloat_t value(1, alloc);
+
+			// The low place can reach the minimum
+			RKC_CHECK(value.ShiftInPlace(BigUBinFloat_t::kMinLowPlace));
+			if (value.GetLowPlace() != BigUBinFloat_t::kMinLowPlace)
+				return rkc::ResultCodes::kInternalError;
+
+#if !RKC_IS_DEBUG
+			// Errors assert in debug builds, so going past the minimum is only checked in release builds
+			{
+				Result result(value.ShiftInPlace(-1));
+				result.Handle();
+
+				if (result.GetCode() != rkc::ResultCodes::kIntegerOverflow || value.GetLowPlace() != BigUBinFloat_t::kMinLowPlace)
+					return rkc::ResultCodes::kInternalError;
+			}
+#endif
+
+			RKC_CHECK(value.ShiftInPlace(BigUBinFloat_t::kMaxLowPlace - BigUBinFloat_t::kMinLowPlace - 1));
+			if (value.GetLowPlace() != BigUBinFloat_t::kMaxLowPlace - 1)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// (high * 2^32 + low) * 2^exponent
+		static ResultRV<BigUBinFloat_t> MakeBigUBinFloat(uint32_t high, uint32_t low, int32_t exponent, IAllocator &alloc)
+		{
+			BigUBinFloat_t value(low, alloc);
+			BigUBinFloat_t highValue(high, alloc);
+
+			RKC_CHECK(highValue.ShiftInPlace(32));
+			RKC_CHECK(value.AddInPlace(highValue));
+			RKC_CHECK(value.ShiftInPlace(exponent));
+
+			return value;
+		}
+
+		static Result CheckBigUFloatSubtract(IAllocator &alloc)
+		{
+			// The sum of two fragments overflows a fragment, so the carry has to be computed in a wider type
+			RKC_CHECK_RV(BigUBinFloat_t, binValue, MakeBigUBinFloat(1, 0xffffffffu, 0, alloc));
+			RKC_CHECK(binValue.SubtractInPlace(BigUBinFloat_t(1, alloc)));
+
+			RKC_CHECK_RV(BigUBinFloat_t, binExpected, MakeBigUBinFloat(1, 0xfffffffeu, 0, alloc));
+			if (binValue != binExpected)
+				return rkc::ResultCodes::kInternalError;
+
+			// Borrowing across fragments
+			RKC_CHECK_RV(BigUBinFloat_t, binBorrow, MakeBigUBinFloat(1, 0, 0, alloc));
+			RKC_CHECK(binBorrow.SubtractInPlace(BigUBinFloat_t(1, alloc)));
+			if (binBorrow != BigUBinFloat_t(0xffffffffu, alloc))
+				return rkc::ResultCodes::kInternalError;
+
+			BigUDecFloat_t decValue(1, alloc);
+			RKC_CHECK(decValue.ShiftInPlace(8));
+			RKC_CHECK(decValue.SubtractInPlace(BigUDecFloat_t(1, alloc)));
+			if (decValue != BigUDecFloat_t(99999999, alloc))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		static Result CheckBigUFloatMultiply(IAllocator &alloc)
+		{
+			BigUDecFloat_t decValue(12345, alloc);
+			RKC_CHECK(decValue.MultiplyInPlace(BigUDecFloat_t()));
+			if (!decValue.IsZero())
+				return rkc::ResultCodes::kInternalError;
+
+			BigUDecFloat_t decZero;
+			RKC_CHECK(decZero.MultiplyInPlace(BigUDecFloat_t(12345, alloc)));
+			if (!decZero.IsZero())
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK_RV(BigUBinFloat_t, binValue, MakeBigUBinFloat(3, 5, -40, alloc));
+			RKC_CHECK(binValue.MultiplyInPlace(BigUBinFloat_t()));
+			if (!binValue.IsZero())
+				return rkc::ResultCodes::kInternalError;
+
+			BigUDecFloat_t decProduct(12345, alloc);
+			RKC_CHECK(decProduct.MultiplyInPlace(BigUDecFloat_t(1001, alloc)));
+			if (decProduct != BigUDecFloat_t(12357345, alloc))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// Checks that a is less than b with every comparison operator
+		template<class T>
+		static Result CheckBigUFloatLess(const rkci::BigUFloat<T> &a, const rkci::BigUFloat<T> &b)
+		{
+			if (!(a < b) || !(a <= b) || a > b || a >= b || a == b)
+				return rkc::ResultCodes::kInternalError;
+
+			if (b < a || b <= a || !(b > a) || !(b >= a) || !(b != a))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		template<class T>
+		static Result CheckBigUFloatEqual(const rkci::BigUFloat<T> &a, const rkci::BigUFloat<T> &b)
+		{
+			if (a < b || !(a <= b) || a > b || !(a >= b) || !(a == b))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		static Result CheckBigUFloatCompare(IAllocator &alloc)
+		{
+			// Same low place, so the fragments line up
+			RKC_CHECK(CheckBigUFloatLess(BigUBinFloat_t(5, alloc), BigUBinFloat_t(7, alloc)));
+			RKC_CHECK(CheckBigUFloatEqual(BigUBinFloat_t(5, alloc), BigUBinFloat_t(5, alloc)));
+
+			// Different low places with the same top digit, within one fragment and across fragments
+			RKC_CHECK(CheckBigUFloatLess(BigUBinFloat_t(5, alloc), BigUBinFloat_t(6, alloc)));
+
+			RKC_CHECK_RV(BigUBinFloat_t, binLow, MakeBigUBinFloat(1, 1, 0, alloc));
+			RKC_CHECK_RV(BigUBinFloat_t, binHigh, MakeBigUBinFloat(1, 2, 0, alloc));
+			RKC_CHECK(CheckBigUFloatLess(binLow, binHigh));
+
+			RKC_CHECK_RV(BigUBinFloat_t, binWideLow, MakeBigUBinFloat(0x80000000u, 3, -20, alloc));
+			RKC_CHECK_RV(BigUBinFloat_t, binWideHigh, MakeBigUBinFloat(0x80000000u, 4, -20, alloc));
+			RKC_CHECK(CheckBigUFloatLess(binWideLow, binWideHigh));
+
+			RKC_CHECK_RV(BigUBinFloat_t, binWideSame, MakeBigUBinFloat(0x80000000u, 3, -20, alloc));
+			RKC_CHECK(CheckBigUFloatEqual(binWideLow, binWideSame));
+
+			// 123456789 against 123456790, which has a higher low place
+			BigUDecFloat_t decLow(1, alloc);
+			RKC_CHECK(decLow.ShiftInPlace(8));
+			RKC_CHECK(decLow.AddInPlace(BigUDecFloat_t(23456789, alloc)));
+
+			BigUDecFloat_t decHigh(12345679, alloc);
+			RKC_CHECK(decHigh.ShiftInPlace(1));
+			RKC_CHECK(CheckBigUFloatLess(decLow, decHigh));
+
+			// Zero is less than every other value, including ones below 1
+			BigUBinFloat_t binFraction(1, alloc);
+			RKC_CHECK(binFraction.ShiftInPlace(-5));
+			RKC_CHECK(CheckBigUFloatLess(BigUBinFloat_t(), binFraction));
+			RKC_CHECK(CheckBigUFloatLess(BigUBinFloat_t(), binHigh));
+			RKC_CHECK(CheckBigUFloatEqual(BigUBinFloat_t(), BigUBinFloat_t()));
+
+			BigUDecFloat_t decFraction(25, alloc);
+			RKC_CHECK(decFraction.ShiftInPlace(-2));
+			RKC_CHECK(CheckBigUFloatLess(BigUDecFloat_t(), decFraction));
+
+			return Result::Ok();
+		}
+
+		Result BigUFloat(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckBigUFloatShift(alloc));
+			RKC_CHECK(CheckBigUFloatSubtract(alloc));
+			RKC_CHECK(CheckBigUFloatMultiply(alloc));
+			RKC_CHECK(CheckBigUFloatCompare(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,484 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "IAllocator.h"
+#include "KernelIR.h"
+#include "MonomorphCache.h"
+#include "RkcComposite.h"
+#include "RkcContext.h"
+#include "Vector.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static const size_t kNumCompositeChainModules = 2000;
+		static const size_t kNumCompositeGraphModules = 200;
+		static const size_t kNumCompositeWorkers = 4;
+
+		// A refused job that ran where it was submitted would nest a few frames per module of the chain
+		static const uintptr_t kMaxCompositeStackGrowth = 64 * 1024;
+
+		static const char kCompositeModuleText[] = "value = other + 1\n";
+
+		struct CompositeTestState
+		{
+			std::atomic<uint32_t> m_sequence;
+
+			// Only tracked when every module runs on the compiling thread
+			bool m_trackStack;
+			uintptr_t m_lowestStack;
+			uintptr_t m_highestStack;
+		};
+
+		struct CompositeTestSource
+		{
+			CompositeTestState *m_state;
+			size_t m_pos;
+
+			// Sequence numbers of the first and last read of the source
+			uint32_t m_firstRead;
+			uint32_t m_lastRead;
+		};
+
+		static size_t CompositeTestRead(void *userdata, void *buf, size_t size)
+		{
+			CompositeTestSource *source = static_cast<CompositeTestSource*>(userdata);
+			CompositeTestState *state = source->m_state;
+
+			const uint32_t sequence = ++state->m_sequence;
+			if (source->m_firstRead == 0)
+				source->m_firstRead = sequence;
+			source->m_lastRead = sequence;
+
+			if (state->m_trackStack)
+			{
+				const uintptr_t stackPos = reinterpret_cast<uintptr_t>(&sequence);
+				if (state->m_lowestStack == 0 || stackPos < state->m_lowestStack)
+					state->m_lowestStack = stackPos;
+				if (stackPos > state->m_highestStack)
+					state->m_highestStack = stackPos;
+			}
+
+			const size_t available = sizeof(kCompositeModuleText) - 1 - source->m_pos;
+			if (size > available)
+				size = available;
+
+			memcpy(buf, kCompositeModuleText + source->m_pos, size);
+			source->m_pos += size;
+
+			return size;
+		}
+
+		static size_t CompositeTestWrite(void *, const void *, size_t)
+		{
+			return 0;
+		}
+
+		static rkcUFilePos_t CompositeTestTell(void *userdata)
+		{
+			return static_cast<const CompositeTestSource*>(userdata)->m_pos;
+		}
+
+		static int CompositeTestSeekStart(void *userdata, rkcUFilePos_t pos)
+		{
+			if (pos > sizeof(kCompositeModuleText) - 1)
+				return 0;
+
+			static_cast<CompositeTestSource*>(userdata)->m_pos = static_cast<size_t>(pos);
+			return 1;
+		}
+
+		static int CompositeTestSeekRelative(void *, rkcFilePos_t)
+		{
+			return 0;
+		}
+
+		static void CompositeTestClose(void *)
+		{
+		}
+
+		static RkcStreamFunctions g_compositeTestStreamFunctions =
+		{
+			CompositeTestRead,
+			CompositeTestWrite,
+			CompositeTestTell,
+			CompositeTestSeekStart,
+			CompositeTestSeekRelative,
+			CompositeTestSeekRelative,
+			CompositeTestClose,
+		};
+
+		static void *CompositeTestRealloc(void *userdata, void *buf, size_t newSize)
+		{
+			return static_cast<IAllocator*>(userdata)->Realloc(buf, newSize);
+		}
+
+		static ArraySliceView<const uint8_t> CompositeTestModuleName(char (&buffer)[32], size_t index)
+		{
+			const int length = snprintf(buffer, sizeof(buffer), "m%zu", index);
+			return ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(buffer), static_cast<size_t>(length));
+		}
+
+		// A job system that runs each job as soon as it's submitted
+		static int SubmitSerialJob(void *, void (*jobFunc)(void *jobData), void *jobData)
+		{
+			jobFunc(jobData);
+			return 1;
+		}
+
+		// A job system that refuses every job, so the library runs them all
+		static int SubmitRefusedJob(void *, void (*)(void *jobData), void *)
+		{
+			return 0;
+		}
+
+		// A pool of worker threads that refuses every third job
+		class CompositeTestThreadPool
+		{
+		public:
+			explicit CompositeTestThreadPool(IAllocator &alloc);
+
+			void Start();
+			void Stop();
+
+			static int Submit(void *userdata, void (*jobFunc)(void *jobData), void *jobData);
+
+		private:
+			struct Job
+			{
+				void (*m_jobFunc)(void *jobData);
+				void *m_jobData;
+			};
+
+			static void WorkerMain(CompositeTestThreadPool *pool);
+
+			Vector<Job> m_jobs;
+			size_t m_nextJob;
+			size_t m_numSubmitted;
+			bool m_isStopping;
+
+			std::mutex m_mutex;
+			std::condition_variable m_jobAvailable;
+			std::thread m_workers[kNumCompositeWorkers];
+		};
+
+		CompositeTestThreadPool::CompositeTestThreadPool(IAllocator &alloc)
+			: m_jobs(&alloc)
+			, m_nextJob(0)
+			, m_numSubmitted(0)
+			, m_isStopping(false)
+		{
+		}
+
+		void CompositeTestThreadPool::Start()
+		{
+			for (size_t i = 0; i < kNumCompositeWorkers; i++)
+				m_workers[i] = std::thread(WorkerMain, this);
+		}
+
+		void CompositeTestThreadPool::Stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_isStopping = true;
+				m_jobAvailable.notify_all();
+			}
+
+			for (size_t i = 0; i < kNumCompositeWorkers; i++)
+				m_workers[i].join();
+		}
+
+		int CompositeTestThreadPool::Submit(void *userdata, void (*jobFunc)(void *jobData), void *jobData)
+		{
+			CompositeTestThreadPool *pool = static_cast<CompositeTestThreadPool*>(userdata);
+
+			std::lock_guard<std::mutex> lock(pool->m_mutex);
+
+			if (++pool->m_numSubmitted % 3 == 0)
+				return 0;
+
+			Job job;
+			job.m_jobFunc = jobFunc;
+			job.m_jobData = jobData;
+
+			Result appendResult(pool->m_jobs.Append(job));
+			appendResult.Handle();
+			if (!appendResult.IsOK())
+				return 0;
+
+			pool->m_jobAvailable.notify_one();
+			return 1;
+		}
+
+		void CompositeTestThreadPool::WorkerMain(CompositeTestThreadPool *pool)
+		{
+			std::unique_lock<std::mutex> lock(pool->m_mutex);
+
+			for (;;)
+			{
+				if (pool->m_nextJob == pool->m_jobs.Count())
+				{
+					if (pool->m_isStopping)
+						return;
+
+					pool->m_jobAvailable.wait(lock);
+					continue;
+				}
+
+				const Job job = pool->m_jobs[pool->m_nextJob++];
+
+				lock.unlock();
+				job.m_jobFunc(job.m_jobData);
+				lock.lock();
+			}
+		}
+
+		// Adds numModules modules, where module i imports module i - 1 and, if isGraph is set, also module
+		// i / 2, so that modules become ready in several orders
+		static Result BuildCompositeTest(IRkcComposite &composite, CompositeTestSource *sources, CompositeTestState &state, size_t numModules, bool isGraph)
+		{
+			for (size_t i = 0; i < numModules; i++)
+			{
+				CompositeTestSource &source = sources[i];
+				source.m_state = &state;
+				source.m_pos = 0;
+				source.m_firstRead = 0;
+				source.m_lastRead = 0;
+
+				RkcStreamSpec streamSpec;
+				streamSpec.m_functions = &g_compositeTestStreamFunctions;
+				streamSpec.m_permissions = RkcStreamPermission_Read;
+				streamSpec.m_userdata = &source;
+
+				char moduleName[32];
+				RKC_CHECK_RV(size_t, moduleIndex, composite.AddProgram(CompositeTestModuleName(moduleName, i), streamSpec));
+
+				if (moduleIndex != i)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			for (size_t i = 1; i < numModules; i++)
+			{
+				char importName[32];
+				RKC_CHECK(composite.AddImport(i, CompositeTestModuleName(importName, i - 1)));
+
+				if (isGraph && i / 2 != i - 1)
+				{
+					RKC_CHECK(composite.AddImport(i, CompositeTestModuleName(importName, i / 2)));
+				}
+			}
+
+			return Result::Ok();
+		}
+
+		// Checks that every module was compiled, and that each of its imports was read to the end before
+		// the module's own source was first read
+		static bool CompositeTestOrderIsValid(const CompositeTestSource *sources, size_t numModules, bool isGraph)
+		{
+			for (size_t i = 0; i < numModules; i++)
+			{
+				if (sources[i].m_firstRead == 0)
+					return false;
+
+				if (i == 0)
+					continue;
+
+				if (sources[i - 1].m_lastRead >= sources[i].m_firstRead)
+					return false;
+
+				if (isGraph && sources[i / 2].m_lastRead >= sources[i].m_firstRead)
+					return false;
+			}
+
+			return true;
+		}
+
+		static Result CheckCompositeOrder(IRkcContext &context, IAllocator &alloc, const RkcJobSystem *jobSystem, size_t numModules, bool isGraph, bool trackStack)
+		{
+			Vector<CompositeTestSource> sources(&alloc);
+			RKC_CHECK(sources.ResizeNoConstruct(numModules));
+
+			CompositeTestState state;
+			state.m_sequence = 0;
+			state.m_trackStack = trackStack;
+			state.m_lowestStack = 0;
+			state.m_highestStack = 0;
+
+			IRkcComposite composite(context);
+
+			RKC_CHECK(BuildCompositeTest(composite, &sources[0], state, numModules, isGraph));
+			RKC_CHECK(composite.Compile(jobSystem));
+
+			RkcCompositeCompileStats stats;
+			composite.GetCompileStats(stats);
+
+			if (stats.m_numModulesCompiled != numModules || stats.m_numModulesSkipped != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			if (!CompositeTestOrderIsValid(&sources[0], numModules, isGraph))
+				return rkc::ResultCodes::kInternalError;
+
+			if (trackStack && state.m_highestStack - state.m_lowestStack > kMaxCompositeStackGrowth)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+#if !RKC_IS_DEBUG
+		// Module 2 imports itself through module 1, so only module 0 is ever ready
+		static Result CheckCompositeCycle(IRkcContext &context, IAllocator &alloc)
+		{
+			const size_t kNumCycleModules = 3;
+
+			Vector<CompositeTestSource> sources(&alloc);
+			RKC_CHECK(sources.ResizeNoConstruct(kNumCycleModules));
+
+			CompositeTestState state;
+			state.m_sequence = 0;
+			state.m_trackStack = false;
+			state.m_lowestStack = 0;
+			state.m_highestStack = 0;
+
+			IRkcComposite composite(context);
+
+			RKC_CHECK(BuildCompositeTest(composite, &sources[0], state, kNumCycleModules, false));
+
+			char importName[32];
+			RKC_CHECK(composite.AddImport(1, CompositeTestModuleName(importName, 2)));
+
+			Result compileResult(composite.Compile(nullptr));
+			compileResult.Handle();
+
+			if (compileResult.GetCode() != rkc::ResultCodes::kCompositeImportCycle)
+				return rkc::ResultCodes::kInternalError;
+
+			// A failed compile still ends the context's compile
+			if (context.IsCompiling())
+				return rkc::ResultCodes::kInternalError;
+
+			// Nothing is compiled once a cycle is found
+			for (size_t i = 0; i < kNumCycleModules; i++)
+			{
+				if (sources[i].m_firstRead != 0)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+#endif
+
+		// Modules request instantiations from the composite's cache, so a second module asking for the same one
+		// reuses it, and the counts last across compiles
+		static Result CheckCompositeInstantiations(IRkcContext &context, IAllocator &alloc)
+		{
+			IRkcComposite composite(context);
+			MonomorphCache &cache = composite.GetMonomorphCache();
+
+			Kernel::Function kernel(&alloc);
+			RKC_CHECK_RV(Kernel::TypeIndex_t, smallType, kernel.AddIntType(0, 10));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, largeType, kernel.AddIntType(0, 1000));
+
+			const MonomorphCache::TypeArgument smallArgs[] = { MonomorphCache::MakeTypeArgument(kernel, smallType) };
+			const MonomorphCache::TypeArgument largeArgs[] = { MonomorphCache::MakeTypeArgument(kernel, largeType) };
+
+			const char *genericName = "clamp";
+			RKC_CHECK_RV(SymbolID_t, generic, context.GetSymbolPool().Intern(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(genericName), strlen(genericName))));
+
+			bool isNew = false;
+			RKC_CHECK_RV(MonomorphCache::InstanceID_t, firstModuleInstance, cache.FindOrAdd(generic, ArraySliceView<const MonomorphCache::TypeArgument>(smallArgs, 1), isNew));
+			if (!isNew)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK_RV(MonomorphCache::InstanceID_t, secondModuleInstance, cache.FindOrAdd(generic, ArraySliceView<const MonomorphCache::TypeArgument>(smallArgs, 1), isNew));
+			if (isNew || secondModuleInstance != firstModuleInstance)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK_RV(MonomorphCache::InstanceID_t, otherInstance, cache.FindOrAdd(generic, ArraySliceView<const MonomorphCache::TypeArgument>(largeArgs, 1), isNew));
+			if (!isNew || otherInstance == firstModuleInstance)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK(composite.Compile(nullptr));
+
+			RkcCompositeCompileStats stats;
+			composite.GetCompileStats(stats);
+
+			if (stats.m_numInstantiations != 2 || stats.m_numInstantiationsReused != 1)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		static Result CheckCompositeJobSystems(IRkcContext &context, IAllocator &alloc)
+		{
+			RKC_CHECK(CheckCompositeOrder(context, alloc, nullptr, kNumCompositeChainModules, false, false));
+			RKC_CHECK(CheckCompositeOrder(context, alloc, nullptr, kNumCompositeGraphModules, true, false));
+
+			RkcJobSystem serialJobs;
+			serialJobs.m_submit = SubmitSerialJob;
+			serialJobs.m_userdata = nullptr;
+
+			RKC_CHECK(CheckCompositeOrder(context, alloc, &serialJobs, kNumCompositeGraphModules, true, false));
+
+			// Refused jobs must not nest as the chain gets longer
+			RkcJobSystem refusingJobs;
+			refusingJobs.m_submit = SubmitRefusedJob;
+			refusingJobs.m_userdata = nullptr;
+
+			RKC_CHECK(CheckCompositeOrder(context, alloc, &refusingJobs, kNumCompositeChainModules, false, true));
+			RKC_CHECK(CheckCompositeOrder(context, alloc, &refusingJobs, kNumCompositeGraphModules, true, false));
+
+			CompositeTestThreadPool pool(alloc);
+			pool.Start();
+
+			RkcJobSystem threadedJobs;
+			threadedJobs.m_submit = CompositeTestThreadPool::Submit;
+			threadedJobs.m_userdata = &pool;
+
+			Result chainResult(CheckCompositeOrder(context, alloc, &threadedJobs, kNumCompositeChainModules, false, false));
+			chainResult.Handle();
+
+			Result graphResult(chainResult.IsOK() ? CheckCompositeOrder(context, alloc, &threadedJobs, kNumCompositeGraphModules, true, false) : chainResult.GetCode());
+			graphResult.Handle();
+
+			pool.Stop();
+
+			if (!graphResult.IsOK())
+				return graphResult.GetCode();
+
+#if !RKC_IS_DEBUG
+			RKC_CHECK(CheckCompositeCycle(context, alloc));
+#endif
+
+			return Result::Ok();
+		}
+
+		Result Composite(IAllocator &alloc)
+		{
+			RkcAllocatorSpec allocSpec;
+			allocSpec.m_realloc = CompositeTestRealloc;
+			allocSpec.m_userdata = &alloc;
+
+			RkcContextOptions options;
+			options.m_structSize = sizeof(RkcContextOptions);
+			options.m_trackAllocations = 0;
+			options.m_readAheadBufferSize = 0;
+			options.m_lexerBufferSize = 0;
+			options.m_readAheadThreads = 0;
+
+			IRkcContext context(allocSpec, options);
+
+			RKC_CHECK(CheckCompositeInstantiations(context, alloc));
+
+			return CheckCompositeJobSystems(context, alloc);
+		}
+	}
+}
@@ -0,0 +1,340 @@
+#include "ArraySliceView.h"
+#include "ConditionMasking.h"
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Result.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// Types and parameters shared by the masking test kernels: an index type, a small integer type and
+		// its mask, one input buffer and one output buffer
+		struct MaskingTestKernel
+		{
+			explicit MaskingTestKernel(IAllocator *alloc);
+
+			Result Init();
+
+			ResultRV<Kernel::ValueIndex_t> Add(Kernel::Opcode opcode, Kernel::TypeIndex_t type, Kernel::ValueIndex_t operand0, Kernel::ValueIndex_t operand1, uint64_t immediate);
+			ResultRV<Kernel::ValueIndex_t> AddStatement(Kernel::Opcode opcode, Kernel::ValueIndex_t operand0, uint64_t immediate);
+
+			Kernel::Function m_function;
+			Kernel::TypeIndex_t m_indexType;
+			Kernel::TypeIndex_t m_valueType;
+			Kernel::TypeIndex_t m_maskType;
+			Kernel::ParamIndex_t m_inParam;
+			Kernel::ParamIndex_t m_outParam;
+		};
+
+		MaskingTestKernel::MaskingTestKernel(IAllocator *alloc)
+			: m_function(alloc)
+			, m_indexType(0)
+			, m_valueType(0)
+			, m_maskType(0)
+			, m_inParam(0)
+			, m_outParam(0)
+		{
+		}
+
+		Result MaskingTestKernel::Init()
+		{
+			RKC_CHECK(m_function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("masking"), 7)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, m_function.AddIntType(0, 0x7fffffff));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, valueType, m_function.AddIntType(-1000, 1000));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, maskType, m_function.AddMaskType(valueType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, inParam, m_function.AddParam(Kernel::ParamKind::kInputBuffer, valueType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, m_function.AddParam(Kernel::ParamKind::kOutputBuffer, valueType));
+
+			m_indexType = indexType;
+			m_valueType = valueType;
+			m_maskType = maskType;
+			m_inParam = inParam;
+			m_outParam = outParam;
+
+			return Result::Ok();
+		}
+
+		ResultRV<Kernel::ValueIndex_t> MaskingTestKernel::Add(Kernel::Opcode opcode, Kernel::TypeIndex_t type, Kernel::ValueIndex_t operand0, Kernel::ValueIndex_t operand1, uint64_t immediate)
+		{
+			return m_function.AddInstruction(opcode, type, operand0, operand1, Kernel::kInvalidValueIndex, immediate);
+		}
+
+		ResultRV<Kernel::ValueIndex_t> MaskingTestKernel::AddStatement(Kernel::Opcode opcode, Kernel::ValueIndex_t operand0, uint64_t immediate)
+		{
+			return m_function.AddInstruction(opcode, Kernel::kInvalidTypeIndex, operand0, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, immediate);
+		}
+
+		static bool MaskedOpcodesMatch(const Kernel::Function &function, const Kernel::Opcode *expected, size_t numExpected)
+		{
+			if (function.NumInstructions() != numExpected)
+				return false;
+
+			for (size_t i = 0; i < numExpected; i++)
+			{
+				if (function.GetInstruction(static_cast<Kernel::ValueIndex_t>(i)).m_opcode != expected[i])
+					return false;
+			}
+
+			return true;
+		}
+
+		// Statements after an unconditional break are dropped, and a loop whose body always breaks runs
+		// once without looping or needing a flag
+		static Result CheckMaskingDeadCode(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			MaskingTestKernel kernel(&alloc);
+			RKC_CHECK(kernel.Init());
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, kernel.Add(Kernel::Opcode::kLaneIndex, kernel.m_indexType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, value, kernel.Add(Kernel::Opcode::kLoad, kernel.m_valueType, laneIndex, N, kernel.m_inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, breakable, kernel.AddStatement(Kernel::Opcode::kBreakable, N, 0));
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kLoop, N, 0).DiscardValue());
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, value, kernel.m_outParam).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kBreak, N, breakable).DiscardValue());
+			RKC_CHECK_RV(Kernel::ValueIndex_t, deadValue, kernel.Add(Kernel::Opcode::kAdd, kernel.m_valueType, value, value, 0));
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, deadValue, kernel.m_outParam).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndLoop, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndBreakable, N, 0).DiscardValue());
+			RKC_CHECK_RV(Kernel::ValueIndex_t, liveValue, kernel.Add(Kernel::Opcode::kSub, kernel.m_valueType, value, value, 0));
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, liveValue, kernel.m_outParam).DiscardValue());
+
+			Kernel::Function masked(&alloc);
+			ConditionMasking masking(&alloc);
+			RKC_CHECK(masking.Run(kernel.m_function, masked));
+
+			const Kernel::Opcode expected[] =
+			{
+				Kernel::Opcode::kLaneIndex,
+				Kernel::Opcode::kLoad,
+				Kernel::Opcode::kStore,
+				Kernel::Opcode::kSub,
+				Kernel::Opcode::kStore,
+			};
+
+			if (!MaskedOpcodesMatch(masked, expected, sizeof(expected) / sizeof(expected[0])))
+				return rkc::ResultCodes::kInternalError;
+
+			if (masking.GetNumFlagVariables() != 0 || masked.NumVariables() != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// A break out of a loop's enclosing breakable clears the loop's flag.  The flag of the if that
+		// contains the break is only cleared along with the loop's, so it shares the loop's variable.
+		static Result CheckMaskingOuterBreak(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			MaskingTestKernel kernel(&alloc);
+			RKC_CHECK(kernel.Init());
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, kernel.Add(Kernel::Opcode::kLaneIndex, kernel.m_indexType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, value, kernel.Add(Kernel::Opcode::kLoad, kernel.m_valueType, laneIndex, N, kernel.m_inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, zero, kernel.Add(Kernel::Opcode::kConstant, kernel.m_valueType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isPositive, kernel.Add(Kernel::Opcode::kCmpGt, kernel.m_maskType, value, zero, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, breakable, kernel.AddStatement(Kernel::Opcode::kBreakable, N, 0));
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kLoop, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kIf, isPositive, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kBreak, N, breakable).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndIf, N, 0).DiscardValue());
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, value, kernel.m_outParam).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndLoop, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndBreakable, N, 0).DiscardValue());
+
+			Kernel::Function masked(&alloc);
+			ConditionMasking masking(&alloc);
+			RKC_CHECK(masking.Run(kernel.m_function, masked));
+
+			const Kernel::Opcode expected[] =
+			{
+				Kernel::Opcode::kConstant,		// Flag clear
+				Kernel::Opcode::kConstant,		// Flag set
+				Kernel::Opcode::kLaneIndex,
+				Kernel::Opcode::kLoad,
+				Kernel::Opcode::kConstant,
+				Kernel::Opcode::kCmpGt,
+				Kernel::Opcode::kWriteVar,		// Loop flag set
+				Kernel::Opcode::kLoop,
+				Kernel::Opcode::kReadVar,
+				Kernel::Opcode::kBeginMasked,	// Loop body
+				Kernel::Opcode::kBeginMasked,	// If
+				Kernel::Opcode::kWriteVar,		// Break clears the loop flag
+				Kernel::Opcode::kEndMasked,
+				Kernel::Opcode::kReadVar,
+				Kernel::Opcode::kBeginMasked,	// Rest of the loop body
+				Kernel::Opcode::kStore,
+				Kernel::Opcode::kEndMasked,
+				Kernel::Opcode::kEndMasked,
+				Kernel::Opcode::kReadVar,
+				Kernel::Opcode::kBreakIfNone,
+				Kernel::Opcode::kEndLoop,
+			};
+
+			if (!MaskedOpcodesMatch(masked, expected, sizeof(expected) / sizeof(expected[0])))
+				return rkc::ResultCodes::kInternalError;
+
+			if (masking.GetNumFlagVariables() != 1 || masked.NumVariables() != 1)
+				return rkc::ResultCodes::kInternalError;
+
+			// Every flag access is to the one variable, the set writes 1 and the break writes 0
+			const size_t flagAccesses[] = { 6, 8, 11, 13, 18 };
+			for (size_t i = 0; i < sizeof(flagAccesses) / sizeof(flagAccesses[0]); i++)
+			{
+				if (masked.GetInstruction(static_cast<Kernel::ValueIndex_t>(flagAccesses[i])).m_immediate != 0)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			if (masked.GetInstruction(6).m_operands[0] != 1 || masked.GetInstruction(11).m_operands[0] != 0
+				|| masked.GetInstruction(0).m_immediate != 0 || masked.GetInstruction(1).m_immediate != 1)
+				return rkc::ResultCodes::kInternalError;
+
+			// The if is masked by the copied condition, and everything else by reads of the flag
+			if (masked.GetInstruction(10).m_operands[0] != 5 || masked.GetInstruction(9).m_operands[0] != 8
+				|| masked.GetInstruction(14).m_operands[0] != 13 || masked.GetInstruction(19).m_operands[0] != 18)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// A break out of an inner breakable clears the flag of the if it's in without clearing the loop's
+		// flag, so that flag gets its own variable
+		static Result CheckMaskingFlagVariables(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			MaskingTestKernel kernel(&alloc);
+			RKC_CHECK(kernel.Init());
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, kernel.Add(Kernel::Opcode::kLaneIndex, kernel.m_indexType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, value, kernel.Add(Kernel::Opcode::kLoad, kernel.m_valueType, laneIndex, N, kernel.m_inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, zero, kernel.Add(Kernel::Opcode::kConstant, kernel.m_valueType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isPositive, kernel.Add(Kernel::Opcode::kCmpGt, kernel.m_maskType, value, zero, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isNegative, kernel.Add(Kernel::Opcode::kCmpLt, kernel.m_maskType, value, zero, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, outerBreakable, kernel.AddStatement(Kernel::Opcode::kBreakable, N, 0));
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kLoop, N, 0).DiscardValue());
+			RKC_CHECK_RV(Kernel::ValueIndex_t, innerBreakable, kernel.AddStatement(Kernel::Opcode::kBreakable, N, 0));
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kIf, isPositive, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kBreak, N, innerBreakable).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndIf, N, 0).DiscardValue());
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, value, kernel.m_outParam).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndBreakable, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kIf, isNegative, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kBreak, N, outerBreakable).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndIf, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndLoop, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndBreakable, N, 0).DiscardValue());
+
+			Kernel::Function masked(&alloc);
+			ConditionMasking masking(&alloc);
+			RKC_CHECK(masking.Run(kernel.m_function, masked));
+
+			if (masking.GetNumFlagVariables() != 2 || masked.NumVariables() != 2)
+				return rkc::ResultCodes::kInternalError;
+
+			// Each break clears a different variable, and the loop keeps going on the outer one
+			Kernel::VariableIndex_t clearedVariables[2] = { 0, 0 };
+			size_t numClears = 0;
+			Kernel::VariableIndex_t loopVariable = 0;
+
+			const size_t numInstructions = masked.NumInstructions();
+			for (size_t i = 0; i < numInstructions; i++)
+			{
+				const Kernel::Instruction &instr = masked.GetInstruction(static_cast<Kernel::ValueIndex_t>(i));
+
+				if (instr.m_opcode == Kernel::Opcode::kWriteVar && masked.GetInstruction(instr.m_operands[0]).m_immediate == 0)
+				{
+					if (numClears == 2)
+						return rkc::ResultCodes::kInternalError;
+
+					clearedVariables[numClears++] = static_cast<Kernel::VariableIndex_t>(instr.m_immediate);
+				}
+
+				if (instr.m_opcode == Kernel::Opcode::kBreakIfNone)
+					loopVariable = static_cast<Kernel::VariableIndex_t>(masked.GetInstruction(instr.m_operands[0]).m_immediate);
+			}
+
+			if (numClears != 2 || clearedVariables[0] == clearedVariables[1] || clearedVariables[1] != loopVariable)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// Nested ifs narrow the mask one region at a time, an else runs masked by the inverted condition,
+		// and an empty branch doesn't get a region
+		static Result CheckMaskingNarrowing(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			MaskingTestKernel kernel(&alloc);
+			RKC_CHECK(kernel.Init());
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, kernel.Add(Kernel::Opcode::kLaneIndex, kernel.m_indexType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, value, kernel.Add(Kernel::Opcode::kLoad, kernel.m_valueType, laneIndex, N, kernel.m_inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, zero, kernel.Add(Kernel::Opcode::kConstant, kernel.m_valueType, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isPositive, kernel.Add(Kernel::Opcode::kCmpGt, kernel.m_maskType, value, zero, 0));
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kIf, isPositive, 0).DiscardValue());
+			RKC_CHECK_RV(Kernel::ValueIndex_t, hundred, kernel.Add(Kernel::Opcode::kConstant, kernel.m_valueType, N, N, 100));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isLarge, kernel.Add(Kernel::Opcode::kCmpGt, kernel.m_maskType, value, hundred, 0));
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kIf, isLarge, 0).DiscardValue());
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, hundred, kernel.m_outParam).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndIf, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kElse, N, 0).DiscardValue());
+			RKC_CHECK(kernel.Add(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, zero, kernel.m_outParam).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndIf, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kIf, isPositive, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kElse, N, 0).DiscardValue());
+			RKC_CHECK(kernel.AddStatement(Kernel::Opcode::kEndIf, N, 0).DiscardValue());
+
+			Kernel::Function masked(&alloc);
+			ConditionMasking masking(&alloc);
+			RKC_CHECK(masking.Run(kernel.m_function, masked));
+
+			const Kernel::Opcode expected[] =
+			{
+				Kernel::Opcode::kLaneIndex,
+				Kernel::Opcode::kLoad,
+				Kernel::Opcode::kConstant,
+				Kernel::Opcode::kCmpGt,
+				Kernel::Opcode::kBeginMasked,
+				Kernel::Opcode::kConstant,
+				Kernel::Opcode::kCmpGt,
+				Kernel::Opcode::kBeginMasked,
+				Kernel::Opcode::kStore,
+				Kernel::Opcode::kEndMasked,
+				Kernel::Opcode::kEndMasked,
+				Kernel::Opcode::kNot,
+				Kernel::Opcode::kBeginMasked,
+				Kernel::Opcode::kStore,
+				Kernel::Opcode::kEndMasked,
+			};
+
+			if (!MaskedOpcodesMatch(masked, expected, sizeof(expected) / sizeof(expected[0])))
+				return rkc::ResultCodes::kInternalError;
+
+			if (masked.GetInstruction(4).m_operands[0] != 3 || masked.GetInstruction(7).m_operands[0] != 6
+				|| masked.GetInstruction(11).m_operands[0] != 3 || masked.GetInstruction(11).m_type != kernel.m_maskType
+				|| masked.GetInstruction(12).m_operands[0] != 11)
+				return rkc::ResultCodes::kInternalError;
+
+			if (masking.GetNumFlagVariables() != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result ConditionMasks(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckMaskingDeadCode(alloc));
+			RKC_CHECK(CheckMaskingOuterBreak(alloc));
+			RKC_CHECK(CheckMaskingFlagVariables(alloc));
+			RKC_CHECK(CheckMaskingNarrowing(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,483 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ConstantFolding.h"
+#include "CustomFloatFormat.h"
+#include "FloatSpec.h"
+#include "KernelIR.h"
+#include "Vector.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static const uint32_t kNumFoldingSamples = 2000;
+
+		static uint64_t NextFoldingRandom(uint64_t &state)
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return state >> 11;
+		}
+
+		static uint64_t FloatToBits(float value)
+		{
+			uint32_t bits = 0;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		static uint64_t DoubleToBits(double value)
+		{
+			uint64_t bits = 0;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		static float FloatFromBits(uint64_t bits)
+		{
+			const uint32_t bits32 = static_cast<uint32_t>(bits);
+			float value = 0.0f;
+			memcpy(&value, &bits32, sizeof(value));
+			return value;
+		}
+
+		static double DoubleFromBits(uint64_t bits)
+		{
+			double value = 0.0;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		// Computes an operation in a wide format the way the SIMD backend does, with the bits of the result
+		static uint64_t ComputeInWideFormat(Kernel::Opcode opcode, SimdElementFormat format, uint64_t a, uint64_t b)
+		{
+			if (format == SimdElementFormat::kFloat32)
+			{
+				const float x = FloatFromBits(a);
+				const float y = FloatFromBits(b);
+				return FloatToBits((opcode == Kernel::Opcode::kAdd) ? (x + y) : ((opcode == Kernel::Opcode::kSub) ? (x - y) : (x * y)));
+			}
+
+			const double x = DoubleFromBits(a);
+			const double y = DoubleFromBits(b);
+			return DoubleToBits((opcode == Kernel::Opcode::kAdd) ? (x + y) : ((opcode == Kernel::Opcode::kSub) ? (x - y) : (x * y)));
+		}
+
+		static bool IsWideNan(SimdElementFormat format, uint64_t bits)
+		{
+			if (format == SimdElementFormat::kFloat32)
+				return (bits & 0x7fffffffu) > 0x7f800000u;
+
+			return (bits & 0x7fffffffffffffffull) > 0x7ff0000000000000ull;
+		}
+
+		// Builds a kernel that stores the result of one operation on each pair of constants, folds it, and
+		// gets the constant that each store ended up with.  Results that weren't folded are reported as
+		// not constant.
+		static Result FoldOperationPairs(IAllocator &alloc, Kernel::Opcode opcode, const Kernel::Type &operandType, const Kernel::Type &resultType, const uint64_t *pairs, uint32_t numPairs, uint64_t *outResults, bool *outIsConstant)
+		{
+			Kernel::Function function(&alloc);
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(0, 0xffff));
+
+			Kernel::TypeIndex_t operandTypeIndex = Kernel::kInvalidTypeIndex;
+			Kernel::TypeIndex_t resultTypeIndex = Kernel::kInvalidTypeIndex;
+			for (int i = 0; i < 2; i++)
+			{
+				const Kernel::Type &type = (i == 0) ? operandType : resultType;
+				Kernel::TypeIndex_t typeIndex = Kernel::kInvalidTypeIndex;
+				if (type.m_kind == Kernel::TypeKind::kInt)
+				{
+					RKC_CHECK_RV(Kernel::TypeIndex_t, intType, function.AddIntType(type.m_minValue, type.m_maxValue));
+					typeIndex = intType;
+				}
+				else
+				{
+					RKC_CHECK_RV(Kernel::TypeIndex_t, floatType, function.AddFloatType(type.m_floatSpec));
+					typeIndex = floatType;
+				}
+
+				if (i == 0)
+					operandTypeIndex = typeIndex;
+				else
+					resultTypeIndex = typeIndex;
+			}
+
+			// Comparisons give a mask, which is stored after converting it to a 0 or 1 integer lane
+			const bool isComparison = Kernel::Function::IsComparison(opcode);
+			Kernel::TypeIndex_t storedTypeIndex = resultTypeIndex;
+			Kernel::TypeIndex_t maskTypeIndex = Kernel::kInvalidTypeIndex;
+			if (isComparison)
+			{
+				RKC_CHECK_RV(Kernel::TypeIndex_t, boolType, function.AddIntType(0, 1));
+				RKC_CHECK_RV(Kernel::TypeIndex_t, maskType, function.AddMaskType(operandTypeIndex));
+				storedTypeIndex = boolType;
+				maskTypeIndex = maskType;
+			}
+
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outputParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, storedTypeIndex));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, indexType, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, 0));
+
+			Kernel::ValueIndex_t zero = Kernel::kInvalidValueIndex;
+			Kernel::ValueIndex_t one = Kernel::kInvalidValueIndex;
+			if (isComparison)
+			{
+				RKC_CHECK_RV(Kernel::ValueIndex_t, zeroValue, function.AddInstruction(Kernel::Opcode::kConstant, storedTypeIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, 0));
+				RKC_CHECK_RV(Kernel::ValueIndex_t, oneValue, function.AddInstruction(Kernel::Opcode::kConstant, storedTypeIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, 1));
+				zero = zeroValue;
+				one = oneValue;
+			}
+
+			const bool isUnary = (Kernel::Function::GetNumOperands(opcode) == 1);
+
+			for (uint32_t i = 0; i < numPairs; i++)
+			{
+				RKC_CHECK_RV(Kernel::ValueIndex_t, a, function.AddInstruction(Kernel::Opcode::kConstant, operandTypeIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, pairs[i * 2 + 0]));
+
+				Kernel::ValueIndex_t b = Kernel::kInvalidValueIndex;
+				if (!isUnary)
+				{
+					RKC_CHECK_RV(Kernel::ValueIndex_t, bValue, function.AddInstruction(Kernel::Opcode::kConstant, operandTypeIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, Kernel::kInvalidValueIndex, pairs[i * 2 + 1]));
+					b = bValue;
+				}
+
+				RKC_CHECK_RV(Kernel::ValueIndex_t, result, function.AddInstruction(opcode, isComparison ? maskTypeIndex : resultTypeIndex, a, b, Kernel::kInvalidValueIndex, 0));
+
+				Kernel::ValueIndex_t stored = result;
+				if (isComparison)
+				{
+					RKC_CHECK_RV(Kernel::ValueIndex_t, selected, function.AddInstruction(Kernel::Opcode::kSelect, storedTypeIndex, result, one, zero, 0));
+					stored = selected;
+				}
+
+				RKC_CHECK_RV(Kernel::ValueIndex_t, store, function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, stored, Kernel::kInvalidValueIndex, outputParam));
+				(void)store;
+			}
+
+			Kernel::Function folded(&alloc);
+			rkci::ConstantFolding folding(&alloc);
+			RKC_CHECK(folding.Run(function, folded));
+
+			uint32_t numStores = 0;
+			const size_t numInstructions = folded.NumInstructions();
+			for (size_t i = 0; i < numInstructions; i++)
+			{
+				const Kernel::Instruction &instr = folded.GetInstruction(static_cast<Kernel::ValueIndex_t>(i));
+				if (instr.m_opcode != Kernel::Opcode::kStore)
+					continue;
+
+				if (numStores == numPairs)
+					return rkc::ResultCodes::kInternalError;
+
+				const Kernel::Instruction &value = folded.GetInstruction(instr.m_operands[1]);
+				outIsConstant[numStores] = (value.m_opcode == Kernel::Opcode::kConstant);
+				outResults[numStores] = value.m_immediate;
+				numStores++;
+			}
+
+			if (numStores != numPairs)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		static Kernel::Type MakeFloatType(const FloatSpec &floatSpec)
+		{
+			return Kernel::Type(Kernel::TypeKind::kFloat, 0, 0, floatSpec, Kernel::kInvalidTypeIndex);
+		}
+
+		static Kernel::Type MakeIntType(int64_t minValue, int64_t maxValue)
+		{
+			return Kernel::Type(Kernel::TypeKind::kInt, minValue, maxValue, FloatSpec(false, 0, 0, 0, false, false), Kernel::kInvalidTypeIndex);
+		}
+
+		// Pairs of encodings, half of them with the same exponent so that they cancel and round at every
+		// position
+		static void MakeFloatPairs(const FloatSpec &floatSpec, uint64_t &random, uint64_t *outPairs)
+		{
+			const uint32_t encodedBits = (floatSpec.IsSigned() ? 1u : 0u) + floatSpec.GetExponentBits() + floatSpec.GetMantissaBits();
+			const uint64_t encodingMask = (encodedBits == 64) ? ~static_cast<uint64_t>(0) : ((static_cast<uint64_t>(1) << encodedBits) - 1u);
+			const uint64_t mantissaMask = (static_cast<uint64_t>(1) << floatSpec.GetMantissaBits()) - 1u;
+
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+			{
+				const uint64_t a = (NextFoldingRandom(random) ^ (NextFoldingRandom(random) << 40)) & encodingMask;
+				uint64_t b = (NextFoldingRandom(random) ^ (NextFoldingRandom(random) << 40)) & encodingMask;
+				if ((i & 1) != 0)
+					b = (a & ~mantissaMask) ^ (b & mantissaMask) ^ (b & (encodingMask & ~(encodingMask >> 1)));
+
+				outPairs[i * 2 + 0] = a;
+				outPairs[i * 2 + 1] = b;
+			}
+		}
+
+		// Arithmetic on IEEE float32 and float64 matches the host's, and on anything else it matches the
+		// SIMD backend's lowering, which computes in the wide format and rounds with CustomFloatFormat
+		static Result CheckFoldedArithmetic(IAllocator &alloc, const FloatSpec &floatSpec, uint64_t *pairs, uint64_t *results, bool *isConstant)
+		{
+			const bool isFloat32 = (floatSpec.GetExponentBits() == 8 && floatSpec.GetMantissaBits() == 23 && floatSpec.IsSigned() && floatSpec.SupportsDenormals() && floatSpec.SupportsNans());
+			const bool isFloat64 = (floatSpec.GetExponentBits() == 11 && floatSpec.GetMantissaBits() == 52 && floatSpec.IsSigned() && floatSpec.SupportsDenormals() && floatSpec.SupportsNans());
+			const Kernel::Opcode opcodes[] = { Kernel::Opcode::kAdd, Kernel::Opcode::kSub, Kernel::Opcode::kMul };
+
+			uint64_t random = 0x2545f4914f6cdd1dull;
+			MakeFloatPairs(floatSpec, random, pairs);
+
+			for (size_t opcodeIndex = 0; opcodeIndex < sizeof(opcodes) / sizeof(opcodes[0]); opcodeIndex++)
+			{
+				const Kernel::Opcode opcode = opcodes[opcodeIndex];
+				RKC_CHECK(FoldOperationPairs(alloc, opcode, MakeFloatType(floatSpec), MakeFloatType(floatSpec), pairs, kNumFoldingSamples, results, isConstant));
+
+				for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+				{
+					bool isNan = false;
+					uint64_t expected = 0;
+					if (isFloat32 || isFloat64)
+					{
+						const SimdElementFormat format = isFloat32 ? SimdElementFormat::kFloat32 : SimdElementFormat::kFloat64;
+						expected = ComputeInWideFormat(opcode, format, pairs[i * 2 + 0], pairs[i * 2 + 1]);
+						isNan = IsWideNan(format, expected);
+					}
+					else
+					{
+						RKC_CHECK_RV(CustomFloatFormat, customFormat, CustomFloatFormat::Create(floatSpec));
+
+						const SimdElementFormat wideFormat = customFormat.GetWideFormat();
+						const uint64_t wideResult = ComputeInWideFormat(opcode, wideFormat, customFormat.Unpack(pairs[i * 2 + 0]), customFormat.Unpack(pairs[i * 2 + 1]));
+						isNan = IsWideNan(wideFormat, wideResult);
+						expected = customFormat.Pack(customFormat.Round(wideFormat, wideResult));
+					}
+
+					if (isNan ? isConstant[i] : (!isConstant[i] || results[i] != expected))
+						return rkc::ResultCodes::kInternalError;
+				}
+			}
+
+			return Result::Ok();
+		}
+
+		static Result CheckFoldedFloat32Operations(IAllocator &alloc, uint64_t *pairs, uint64_t *results, bool *isConstant)
+		{
+			const FloatSpec singleSpec(true, 8, 23, 127, true, true);
+			const Kernel::Opcode opcodes[] =
+			{
+				Kernel::Opcode::kMin, Kernel::Opcode::kMax,
+				Kernel::Opcode::kCmpEq, Kernel::Opcode::kCmpNe, Kernel::Opcode::kCmpLt, Kernel::Opcode::kCmpLe, Kernel::Opcode::kCmpGt, Kernel::Opcode::kCmpGe,
+			};
+
+			uint64_t random = 0x9e3779b97f4a7c15ull;
+			MakeFloatPairs(singleSpec, random, pairs);
+
+			// Zeros of both signs and equal values
+			pairs[0] = 0x80000000u;
+			pairs[1] = 0;
+			pairs[2] = 0;
+			pairs[3] = 0x80000000u;
+			pairs[5] = pairs[4];
+
+			for (size_t opcodeIndex = 0; opcodeIndex < sizeof(opcodes) / sizeof(opcodes[0]); opcodeIndex++)
+			{
+				const Kernel::Opcode opcode = opcodes[opcodeIndex];
+				const bool isComparison = Kernel::Function::IsComparison(opcode);
+				RKC_CHECK(FoldOperationPairs(alloc, opcode, MakeFloatType(singleSpec), isComparison ? MakeIntType(0, 1) : MakeFloatType(singleSpec), pairs, kNumFoldingSamples, results, isConstant));
+
+				for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+				{
+					const float a = FloatFromBits(pairs[i * 2 + 0]);
+					const float b = FloatFromBits(pairs[i * 2 + 1]);
+
+					uint64_t expected = 0;
+					switch (opcode)
+					{
+					case Kernel::Opcode::kMin:
+						expected = pairs[i * 2 + ((a < b) ? 0 : 1)];
+						break;
+					case Kernel::Opcode::kMax:
+						expected = pairs[i * 2 + ((a > b) ? 0 : 1)];
+						break;
+					case Kernel::Opcode::kCmpEq:
+						expected = (a == b) ? 1u : 0u;
+						break;
+					case Kernel::Opcode::kCmpNe:
+						expected = (a != b) ? 1u : 0u;
+						break;
+					case Kernel::Opcode::kCmpLt:
+						expected = (a < b) ? 1u : 0u;
+						break;
+					case Kernel::Opcode::kCmpLe:
+						expected = (a <= b) ? 1u : 0u;
+						break;
+					case Kernel::Opcode::kCmpGt:
+						expected = (a > b) ? 1u : 0u;
+						break;
+					case Kernel::Opcode::kCmpGe:
+						expected = (a >= b) ? 1u : 0u;
+						break;
+					default:
+						return rkc::ResultCodes::kInternalError;
+					}
+
+					if ((a != a || b != b) ? isConstant[i] : (!isConstant[i] || results[i] != expected))
+						return rkc::ResultCodes::kInternalError;
+				}
+			}
+
+			return Result::Ok();
+		}
+
+		static Result CheckFoldedConversions(IAllocator &alloc, uint64_t *pairs, uint64_t *results, bool *isConstant)
+		{
+			const FloatSpec singleSpec(true, 8, 23, 127, true, true);
+			const FloatSpec doubleSpec(true, 11, 52, 1023, true, true);
+			const FloatSpec bfloat16Spec(true, 8, 7, 127, true, true);
+
+			uint64_t random = 0xda942042e4dd58b5ull;
+
+			// Integers to float32, from all magnitudes
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+				pairs[i * 2] = (NextFoldingRandom(random) << 11) >> (NextFoldingRandom(random) % 64);
+
+			RKC_CHECK(FoldOperationPairs(alloc, Kernel::Opcode::kConvert, MakeIntType(INT64_MIN, INT64_MAX), MakeFloatType(singleSpec), pairs, kNumFoldingSamples, results, isConstant));
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+			{
+				if (!isConstant[i] || results[i] != FloatToBits(static_cast<float>(static_cast<int64_t>(pairs[i * 2]))))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Float64 to float32, which rounds, and float32 to bfloat16
+			MakeFloatPairs(doubleSpec, random, pairs);
+
+			RKC_CHECK(FoldOperationPairs(alloc, Kernel::Opcode::kConvert, MakeFloatType(doubleSpec), MakeFloatType(singleSpec), pairs, kNumFoldingSamples, results, isConstant));
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+			{
+				const double value = DoubleFromBits(pairs[i * 2]);
+				if ((value != value) ? isConstant[i] : (!isConstant[i] || results[i] != FloatToBits(static_cast<float>(value))))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			RKC_CHECK_RV(CustomFloatFormat, bfloat16Format, CustomFloatFormat::Create(bfloat16Spec));
+
+			MakeFloatPairs(singleSpec, random, pairs);
+			RKC_CHECK(FoldOperationPairs(alloc, Kernel::Opcode::kConvert, MakeFloatType(singleSpec), MakeFloatType(bfloat16Spec), pairs, kNumFoldingSamples, results, isConstant));
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+			{
+				const bool isNan = IsWideNan(SimdElementFormat::kFloat32, pairs[i * 2]);
+				if (isNan ? isConstant[i] : (!isConstant[i] || results[i] != bfloat16Format.Pack(bfloat16Format.Round(SimdElementFormat::kFloat32, pairs[i * 2]))))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Float32 to integers truncates, and is only folded if it lands in range
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+			{
+				const float value = static_cast<float>(static_cast<int32_t>(NextFoldingRandom(random) % 4000001u) - 2000000) / static_cast<float>(1u << (NextFoldingRandom(random) % 8));
+				pairs[i * 2] = FloatToBits(value);
+			}
+
+			RKC_CHECK(FoldOperationPairs(alloc, Kernel::Opcode::kConvert, MakeFloatType(singleSpec), MakeIntType(-100000, 100000), pairs, kNumFoldingSamples, results, isConstant));
+			for (uint32_t i = 0; i < kNumFoldingSamples; i++)
+			{
+				const float value = FloatFromBits(pairs[i * 2]);
+				const bool isInRange = (value > -100001.0f && value < 100001.0f);
+				if (isInRange ? (!isConstant[i] || static_cast<int64_t>(results[i]) != static_cast<int64_t>(value)) : isConstant[i])
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		// Integer results are only folded if they're in range, chains fold all the way, a select on a
+		// constant mask becomes the value that it selects, and the constants left unused are dropped
+		static Result CheckFoldedIntegers(IAllocator &alloc)
+		{
+			Kernel::Function function(&alloc);
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, intType, function.AddIntType(-100, 100));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, maskType, function.AddMaskType(intType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outputParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, intType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, uniformParam, function.AddParam(Kernel::ParamKind::kUniform, intType));
+
+			const Kernel::ValueIndex_t none = Kernel::kInvalidValueIndex;
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, intType, none, none, none, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, uniform, function.AddInstruction(Kernel::Opcode::kParam, intType, none, none, none, uniformParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, seven, function.AddInstruction(Kernel::Opcode::kConstant, intType, none, none, none, 7));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, minusFive, function.AddInstruction(Kernel::Opcode::kConstant, intType, none, none, none, static_cast<uint64_t>(-5)));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, ninety, function.AddInstruction(Kernel::Opcode::kConstant, intType, none, none, none, 90));
+
+			// (7 + -5) * 7 = 14, which is stored
+			RKC_CHECK_RV(Kernel::ValueIndex_t, sum, function.AddInstruction(Kernel::Opcode::kAdd, intType, seven, minusFive, none, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, product, function.AddInstruction(Kernel::Opcode::kMul, intType, sum, seven, none, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, store0, function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, product, none, outputParam));
+
+			// 90 + 14 leaves the range, so it stays
+			RKC_CHECK_RV(Kernel::ValueIndex_t, overflow, function.AddInstruction(Kernel::Opcode::kAdd, intType, ninety, product, none, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, store1, function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, overflow, none, outputParam));
+
+			// 14 < 90, so this selects the uniform
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isLess, function.AddInstruction(Kernel::Opcode::kCmpLt, maskType, product, ninety, none, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, selected, function.AddInstruction(Kernel::Opcode::kSelect, intType, isLess, uniform, seven, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, store2, function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, selected, none, outputParam));
+
+			(void)store0;
+			(void)store1;
+			(void)store2;
+
+			Kernel::Function folded(&alloc);
+			rkci::ConstantFolding folding(&alloc);
+			RKC_CHECK(folding.Run(function, folded));
+
+			// Lane index, uniform, 90, 14, store, the add, store and store
+			if (folding.GetNumFolded() != 4 || folded.NumInstructions() != 8)
+				return rkc::ResultCodes::kInternalError;
+
+			const Kernel::Instruction &foldedStore0 = folded.GetInstruction(4);
+			const Kernel::Instruction &foldedStore1 = folded.GetInstruction(6);
+			const Kernel::Instruction &foldedStore2 = folded.GetInstruction(7);
+
+			if (foldedStore0.m_opcode != Kernel::Opcode::kStore || folded.GetInstruction(foldedStore0.m_operands[1]).m_opcode != Kernel::Opcode::kConstant || folded.GetInstruction(foldedStore0.m_operands[1]).m_immediate != 14)
+				return rkc::ResultCodes::kInternalError;
+
+			if (foldedStore1.m_opcode != Kernel::Opcode::kStore || folded.GetInstruction(foldedStore1.m_operands[1]).m_opcode != Kernel::Opcode::kAdd)
+				return rkc::ResultCodes::kInternalError;
+
+			if (foldedStore2.m_opcode != Kernel::Opcode::kStore || folded.GetInstruction(foldedStore2.m_operands[1]).m_opcode != Kernel::Opcode::kParam)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result ConstantFolding(IAllocator &alloc)
+		{
+			const FloatSpec floatSpecs[] =
+			{
+				FloatSpec(true, 8, 23, 127, true, true),	// float32
+				FloatSpec(true, 11, 52, 1023, true, true),	// float64
+				FloatSpec(true, 5, 10, 15, true, true),		// float16
+				FloatSpec(true, 8, 7, 127, true, true),		// bfloat16
+				FloatSpec(true, 4, 3, 7, true, false),		// E4M3 that saturates
+				FloatSpec(true, 5, 2, 15, true, true),		// E5M2
+				FloatSpec(false, 5, 6, 15, true, true),		// Unsigned 11-bit
+				FloatSpec(true, 5, 7, 15, false, true),		// No denormals
+			};
+
+			Vector<uint64_t> pairs(&alloc);
+			Vector<uint64_t> results(&alloc);
+			Vector<bool> isConstant(&alloc);
+
+			RKC_CHECK(pairs.Resize(kNumFoldingSamples * 2));
+			RKC_CHECK(results.Resize(kNumFoldingSamples));
+			RKC_CHECK(isConstant.Resize(kNumFoldingSamples));
+
+			for (size_t i = 0; i < sizeof(floatSpecs) / sizeof(floatSpecs[0]); i++)
+			{
+				RKC_CHECK(CheckFoldedArithmetic(alloc, floatSpecs[i], &pairs[0], &results[0], &isConstant[0]));
+			}
+
+			RKC_CHECK(CheckFoldedFloat32Operations(alloc, &pairs[0], &results[0], &isConstant[0]));
+			RKC_CHECK(CheckFoldedConversions(alloc, &pairs[0], &results[0], &isConstant[0]));
+			RKC_CHECK(CheckFoldedIntegers(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "BigUBinFloatProto.h"
+#include "BigUDecFloatProto.h"
+#include "BigUFloat.h"
+#include "DecBin.h"
+#include "DecPowerCache.h"
+#include "FloatSpec.h"
+#include "IAllocator.h"
+#include "MoveOrCopy.h"
+#include "NumStr.h"
+#include "RkcContext.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static const char kContextCacheModuleText[] = "first = second + third * first\n";
+
+		// Values that take the exact, integer and non-exact conversion paths, with powers of 2 and 5 both needed
+		static const char *const kContextCacheNumbers[] =
+		{
+			"0.1",
+			"123456.789",
+			"299792458",
+			"602214076000000000000000",
+			"0.000000000000000000000000000001",
+		};
+
+		static void *ContextCacheTestRealloc(void *userdata, void *buf, size_t newSize)
+		{
+			return static_cast<IAllocator*>(userdata)->Realloc(buf, newSize);
+		}
+
+		// Converts every number with and without the context's power cache and checks that the results match
+		static Result CheckPowerCacheConversions(IRkcContext &context)
+		{
+			const FloatSpec doubleSpec(true, 11, 52, 1023, true, true);
+
+			NumStr numStr(context.GetAllocator());
+			DecPowerCache &powerCache = context.GetPowerCache();
+
+			for (const char *number : kContextCacheNumbers)
+			{
+				uint32_t numTrailingZeroes = 0;
+				RKC_CHECK_RV(BigUDecFloat_t, dec, numStr.DecimalUTF8ToDecFloat(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(number), strlen(number)), numTrailingZeroes));
+
+				RKC_CHECK_RV(BigUBinFloat_t, uncachedBin, DecBin::DecToBin(dec, doubleSpec, numTrailingZeroes, nullptr));
+				RKC_CHECK_RV(BigUBinFloat_t, cachedBin, DecBin::DecToBin(dec, doubleSpec, numTrailingZeroes, &powerCache));
+
+				if (!(uncachedBin == cachedBin))
+					return rkc::ResultCodes::kInternalError;
+
+				RKC_CHECK_RV(BigUDecFloat_t, uncachedDec, DecBin::BinToDec(uncachedBin, nullptr));
+				RKC_CHECK_RV(BigUDecFloat_t, cachedDec, DecBin::BinToDec(cachedBin, &powerCache));
+
+				if (!(uncachedDec == cachedDec))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		Result ContextCaches(IAllocator &alloc)
+		{
+			RkcAllocatorSpec allocSpec;
+			allocSpec.m_realloc = ContextCacheTestRealloc;
+			allocSpec.m_userdata = &alloc;
+
+			RkcContextOptions options;
+			options.m_structSize = sizeof(RkcContextOptions);
+			options.m_trackAllocations = 0;
+			options.m_readAheadBufferSize = 0;
+			options.m_lexerBufferSize = 0;
+			options.m_readAheadThreads = 0;
+
+			IRkcContext context(allocSpec, options);
+
+			// Loading the same module again finds every name already interned
+			RkcContextStats firstLoadStats;
+			if (RkcLoadModuleText(&context, kContextCacheModuleText, sizeof(kContextCacheModuleText) - 1) != rkc::ResultCodes::kOK)
+				return rkc::ResultCodes::kInternalError;
+			RkcGetContextStats(&context, &firstLoadStats);
+
+			RkcContextStats secondLoadStats;
+			if (RkcLoadModuleText(&context, kContextCacheModuleText, sizeof(kContextCacheModuleText) - 1) != rkc::ResultCodes::kOK)
+				return rkc::ResultCodes::kInternalError;
+			RkcGetContextStats(&context, &secondLoadStats);
+
+			if (firstLoadStats.m_numSymbols != 3 || secondLoadStats.m_numSymbols != firstLoadStats.m_numSymbols)
+				return rkc::ResultCodes::kInternalError;
+
+			// The first pass fills the power cache, and the second is served from it
+			RKC_CHECK(CheckPowerCacheConversions(context));
+
+			RkcContextStats firstConversionStats;
+			RkcGetContextStats(&context, &firstConversionStats);
+			if (firstConversionStats.m_numCachedPowers == 0)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK(CheckPowerCacheConversions(context));
+
+			RkcContextStats secondConversionStats;
+			RkcGetContextStats(&context, &secondConversionStats);
+			if (secondConversionStats.m_numCachedPowers != firstConversionStats.m_numCachedPowers)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+	}
+}
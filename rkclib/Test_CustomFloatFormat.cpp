@@ -0,0 +1,214 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "BigUBinFloatProto.h"
+#include "BigUFloat.h"
+#include "CustomFloatFormat.h"
+#include "FloatSpec.h"
+#include "MoveOrCopy.h"
+#include "NumUtils.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static ResultRV<BigUBinFloat_t> MakeBinFloat(uint64_t significand, int32_t exponent, IAllocator &alloc)
+		{
+			BigUBinFloat_t value(static_cast<uint32_t>(significand & 0xffffffffu), alloc);
+			BigUBinFloat_t high(static_cast<uint32_t>(significand >> 32), alloc);
+
+			RKC_CHECK(high.ShiftInPlace(32));
+			RKC_CHECK(value.AddInPlace(high));
+			RKC_CHECK(value.ShiftInPlace(exponent));
+
+			return value;
+		}
+
+		// The magnitude of a finite value of an IEEE format
+		static ResultRV<BigUBinFloat_t> BinFloatFromBits(SimdElementFormat format, uint64_t bits, IAllocator &alloc)
+		{
+			const uint32_t mantissaBits = (format == SimdElementFormat::kFloat32) ? 23 : 52;
+			const int32_t maxExponent = (format == SimdElementFormat::kFloat32) ? 127 : 1023;
+			const uint64_t fieldExponent = (bits >> mantissaBits) & static_cast<uint64_t>(2 * maxExponent + 1);
+			const uint64_t mantissa = bits & ((static_cast<uint64_t>(1) << mantissaBits) - 1u);
+
+			if (fieldExponent == 0)
+				return MakeBinFloat(mantissa, 1 - maxExponent - static_cast<int32_t>(mantissaBits), alloc);
+
+			return MakeBinFloat(mantissa | (static_cast<uint64_t>(1) << mantissaBits), static_cast<int32_t>(fieldExponent) - maxExponent - static_cast<int32_t>(mantissaBits), alloc);
+		}
+
+		// Checks one rounding against NumUtils::RoundToFloatSpec, which doesn't flush, saturate or handle
+		// signs, so those are applied here
+		static Result CheckCustomFloatRound(const CustomFloatFormat &customFormat, SimdElementFormat sourceFormat, uint64_t bits, IAllocator &alloc)
+		{
+			const FloatSpec &floatSpec = customFormat.GetFloatSpec();
+			const uint32_t elementBits = (sourceFormat == SimdElementFormat::kFloat32) ? 32 : 64;
+			const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+			const uint64_t signBit = static_cast<uint64_t>(1) << (elementBits - 1);
+			const uint64_t infinity = (sourceFormat == SimdElementFormat::kFloat32) ? 0x7f800000u : 0x7ff0000000000000ull;
+			const uint64_t magnitude = bits & (signBit - 1u);
+
+			const uint64_t rounded = customFormat.Round(sourceFormat, bits);
+			const uint64_t roundedMagnitude = rounded & (signBit - 1u);
+
+			if (magnitude > infinity)
+			{
+				if (floatSpec.SupportsNans() ? (roundedMagnitude <= infinity) : (rounded != 0))
+					return rkc::ResultCodes::kInternalError;
+				return Result::Ok();
+			}
+
+			if (!floatSpec.IsSigned() && (bits & signBit) != 0)
+			{
+				if (rounded != 0)
+					return rkc::ResultCodes::kInternalError;
+				return Result::Ok();
+			}
+
+			if ((rounded & signBit) != (bits & signBit))
+				return rkc::ResultCodes::kInternalError;
+
+			const int32_t maxExponent = ((1 << floatSpec.GetExponentBits()) - (floatSpec.SupportsNans() ? 2 : 1)) - floatSpec.GetExponentOfOne();
+
+			RKC_CHECK_RV(BigUBinFloat_t, minNormal, MakeBinFloat(1, 1 - floatSpec.GetExponentOfOne(), alloc));
+			RKC_CHECK_RV(BigUBinFloat_t, maxFinite, MakeBinFloat((static_cast<uint64_t>(1) << (mantissaBits + 1)) - 1u, maxExponent - static_cast<int32_t>(mantissaBits), alloc));
+
+			bool isOverflow = (magnitude == infinity);
+			BigUBinFloat_t expected;
+			if (!isOverflow)
+			{
+				RKC_CHECK_RV(BigUBinFloat_t, value, BinFloatFromBits(sourceFormat, magnitude, alloc));
+				RKC_CHECK_RV(BigUBinFloat_t, reference, NumUtils::RoundToFloatSpec(value, floatSpec));
+
+				isOverflow = (reference > maxFinite);
+				if (!floatSpec.SupportsDenormals() && reference < minNormal)
+					reference = BigUBinFloat_t();
+
+				expected = rkci::Move(reference);
+			}
+
+			if (isOverflow)
+			{
+				if (floatSpec.SupportsNans())
+				{
+					if (roundedMagnitude != infinity)
+						return rkc::ResultCodes::kInternalError;
+					return Result::Ok();
+				}
+
+				RKC_CHECK_RV(BigUBinFloat_t, saturated, maxFinite.Clone());
+				expected = rkci::Move(saturated);
+			}
+
+			RKC_CHECK_RV(BigUBinFloat_t, actual, BinFloatFromBits(sourceFormat, roundedMagnitude, alloc));
+			if (actual != expected)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// Tries values around every exponent that the floatspec can reach, with ties at every bit
+		// position as well as pseudo-random mantissas
+		static Result CheckCustomFloatRounding(const CustomFloatFormat &customFormat, SimdElementFormat sourceFormat, IAllocator &alloc)
+		{
+			const FloatSpec &floatSpec = customFormat.GetFloatSpec();
+			const uint32_t mantissaBits = (sourceFormat == SimdElementFormat::kFloat32) ? 23 : 52;
+			const int32_t maxExponent = (sourceFormat == SimdElementFormat::kFloat32) ? 127 : 1023;
+			const uint64_t signBit = (sourceFormat == SimdElementFormat::kFloat32) ? 0x80000000u : 0x8000000000000000ull;
+			const uint64_t mantissaMask = (static_cast<uint64_t>(1) << mantissaBits) - 1u;
+
+			const int32_t lowestExponent = 1 - floatSpec.GetExponentOfOne() - static_cast<int32_t>(floatSpec.GetMantissaBits()) - 3;
+			const int32_t highestExponent = (1 << floatSpec.GetExponentBits()) - floatSpec.GetExponentOfOne() + 1;
+
+			uint64_t random = 0x9e3779b97f4a7c15ull;
+
+			for (int32_t exponent = lowestExponent; exponent <= highestExponent; exponent++)
+			{
+				int32_t fieldExponent = exponent + maxExponent;
+				if (fieldExponent < 0)
+					fieldExponent = 0;
+				else if (fieldExponent > 2 * maxExponent + 1)
+					fieldExponent = 2 * maxExponent + 1;
+
+				const uint64_t exponentBits = static_cast<uint64_t>(fieldExponent) << mantissaBits;
+
+				for (uint32_t sample = 0; sample < 3 * mantissaBits + 16; sample++)
+				{
+					random = random * 6364136223846793005ull + 1442695040888963407ull;
+
+					uint64_t mantissa = (random >> 11) & mantissaMask;
+					if (sample < 3 * mantissaBits)
+					{
+						// A tie at a bit position, and the values on either side of it
+						const uint32_t position = sample / 3;
+						const uint64_t tie = (mantissa & ~((static_cast<uint64_t>(2) << position) - 1u)) | (static_cast<uint64_t>(1) << position);
+						mantissa = (tie + (sample % 3) - 1u) & mantissaMask;
+					}
+
+					RKC_CHECK(CheckCustomFloatRound(customFormat, sourceFormat, exponentBits | mantissa, alloc));
+					RKC_CHECK(CheckCustomFloatRound(customFormat, sourceFormat, signBit | exponentBits | mantissa, alloc));
+				}
+			}
+
+			return Result::Ok();
+		}
+
+		// Every encoding unpacks to a value that packs back to the same encoding and, unless it's a NaN,
+		// rounds to itself.  Floatspecs that flush denormals don't have denormal encodings.
+		static Result CheckCustomFloatEncodings(const CustomFloatFormat &customFormat)
+		{
+			const FloatSpec &floatSpec = customFormat.GetFloatSpec();
+			const uint32_t mantissaBits = floatSpec.GetMantissaBits();
+			const uint32_t encodedBits = (floatSpec.IsSigned() ? 1u : 0u) + floatSpec.GetExponentBits() + mantissaBits;
+			const uint64_t exponentMask = ((static_cast<uint64_t>(1) << floatSpec.GetExponentBits()) - 1u) << mantissaBits;
+
+			for (uint64_t packed = 0; packed < (static_cast<uint64_t>(1) << encodedBits); packed++)
+			{
+				if (!floatSpec.SupportsDenormals() && (packed & exponentMask) == 0 && (packed & ((static_cast<uint64_t>(1) << mantissaBits) - 1u)) != 0)
+					continue;
+
+				const bool isNan = (floatSpec.SupportsNans() && (packed & exponentMask) == exponentMask && (packed & ((static_cast<uint64_t>(1) << mantissaBits) - 1u)) != 0);
+
+				const uint64_t unpacked = customFormat.Unpack(packed);
+				if (customFormat.Pack(unpacked) != packed || (!isNan && customFormat.Round(customFormat.GetWideFormat(), unpacked) != unpacked))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		Result CustomFloatFormat(IAllocator &alloc)
+		{
+			const FloatSpec floatSpecs[] =
+			{
+				FloatSpec(true, 8, 7, 127, true, true),		// bfloat16
+				FloatSpec(true, 4, 3, 7, true, true),		// E4M3
+				FloatSpec(true, 4, 3, 7, true, false),		// E4M3 that saturates
+				FloatSpec(true, 5, 2, 15, true, true),		// E5M2
+				FloatSpec(false, 5, 6, 15, true, true),		// Unsigned 11-bit
+				FloatSpec(false, 5, 5, 15, true, true),		// Unsigned 10-bit
+				FloatSpec(true, 5, 7, 15, false, true),		// No denormals
+				FloatSpec(false, 4, 4, 3, false, false),	// No denormals or NaNs
+				FloatSpec(true, 8, 16, 127, true, true),	// Held in float64
+			};
+
+			for (size_t i = 0; i < sizeof(floatSpecs) / sizeof(floatSpecs[0]); i++)
+			{
+				RKC_CHECK_RV(rkci::CustomFloatFormat, customFormat, rkci::CustomFloatFormat::Create(floatSpecs[i]));
+
+				RKC_CHECK(CheckCustomFloatRounding(customFormat, customFormat.GetWideFormat(), alloc));
+				if (customFormat.GetWideFormat() != SimdElementFormat::kFloat64)
+				{
+					RKC_CHECK(CheckCustomFloatRounding(customFormat, SimdElementFormat::kFloat64, alloc));
+				}
+
+				if (customFormat.GetStorageFormat() != SimdElementFormat::kUInt32)
+				{
+					RKC_CHECK(CheckCustomFloatEncodings(customFormat));
+				}
+			}
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,210 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "ExportInterface.h"
+#include "FeedStream.h"
+#include "Lexer.h"
+
+#include <cstring>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static const char *const kInterfaceBaseSource =
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n";
+
+		// Edits to exported declarations, including the lines that continue them
+		static const char *const kInterfaceChangedSources[] =
+		{
+			"export intspec<0 .. 127> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, double b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Numeric<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte c\n"
+			"}\n",
+
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"globalexport struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+		};
+
+		// Edits to function bodies, local declarations, comments, whitespace and line endings
+		static const char *const kInterfaceStableSources[] =
+		{
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\tif (a < b)\n"
+			"\t{\n"
+			"\t\treturn b - a\n"
+			"\t}\n"
+			"\treturn a - b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+
+			"export intspec<0 .. 255> Byte;\n"
+			"export void Lerp(float a, float b)\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 4\n"
+			"y = x\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+
+			"// Types\n"
+			"export   intspec<0 .. 255>   Byte;\n"
+			"\n"
+			"export void Lerp(float a, float b)  // Interpolates\n"
+			"\twhere T : Arithmetic<T>\n"
+			"{\n"
+			"\treturn a + b\n"
+			"}\n"
+			"x = 3\n"
+			"export struct Pair\n"
+			"{\n"
+			"\tByte a\n"
+			"\tByte b\n"
+			"}\n",
+
+			"export intspec<0 .. 255> Byte;\r\n"
+			"export void Lerp(float a, float b)\r\n"
+			"\twhere T : Arithmetic<T>\r\n"
+			"{\r\n"
+			"\treturn a + b\r\n"
+			"}\r\n"
+			"x = 3\r\n"
+			"export struct Pair\r\n"
+			"{\r\n"
+			"\tByte a\r\n"
+			"\tByte b\r\n"
+			"}\r\n",
+		};
+
+		static Result ComputeTestInterfaceHash(IAllocator &alloc, const char *source, uint64_t &outHash)
+		{
+			FeedStream stream(&alloc);
+			RKC_CHECK(stream.Append(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(source), strlen(source))));
+
+			Lexer lexer(&stream, &alloc, Lexer::kDefaultBufferSize);
+			ExportInterfaceHasher hasher;
+
+			for (;;)
+			{
+				RKC_CHECK_RV(LexToken, token, lexer.GetNextToken());
+
+				hasher.AddToken(token);
+
+				if (token.m_tokenType == LexTokenType::kEndOfFile)
+					break;
+			}
+
+			outHash = hasher.GetHash();
+			return Result::Ok();
+		}
+
+		Result ExportInterface(IAllocator &alloc)
+		{
+			uint64_t baseHash = 0;
+			RKC_CHECK(ComputeTestInterfaceHash(alloc, kInterfaceBaseSource, baseHash));
+
+			const size_t numChangedSources = sizeof(kInterfaceChangedSources) / sizeof(kInterfaceChangedSources[0]);
+			for (size_t i = 0; i < numChangedSources; i++)
+			{
+				uint64_t hash = 0;
+				RKC_CHECK(ComputeTestInterfaceHash(alloc, kInterfaceChangedSources[i], hash));
+
+				if (hash == baseHash)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			const size_t numStableSources = sizeof(kInterfaceStableSources) / sizeof(kInterfaceStableSources[0]);
+			for (size_t i = 0; i < numStableSources; i++)
+			{
+				uint64_t hash = 0;
+				RKC_CHECK(ComputeTestInterfaceHash(alloc, kInterfaceStableSources[i], hash));
+
+				if (hash != baseHash)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "FloatSpec.h"
+#include "KernelIR.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		Result FloatSpec(IAllocator &alloc)
+		{
+			const rkci::FloatSpec e4m3(true, 4, 3, 7, true, false);
+			if (!e4m3.IsSigned() || e4m3.GetExponentBits() != 4 || e4m3.GetMantissaBits() != 3 || e4m3.GetExponentOfOne() != 7)
+				return rkc::ResultCodes::kInternalError;
+
+			// The denormal and NaN flags are independent
+			if (!e4m3.SupportsDenormals() || e4m3.SupportsNans())
+				return rkc::ResultCodes::kInternalError;
+
+			const rkci::FloatSpec flushingSpec(true, 8, 23, 127, false, true);
+			if (flushingSpec.SupportsDenormals() || !flushingSpec.SupportsNans())
+				return rkc::ResultCodes::kInternalError;
+
+			// Floatspecs that only differ in signedness are different kernel types
+			const rkci::FloatSpec unsignedSpec(false, 5, 6, 15, true, false);
+			const rkci::FloatSpec signedSpec(true, 5, 6, 15, true, false);
+			if (unsignedSpec.IsSigned())
+				return rkc::ResultCodes::kInternalError;
+
+			Kernel::Function function(&alloc);
+			RKC_CHECK_RV(Kernel::TypeIndex_t, unsignedType, function.AddFloatType(unsignedSpec));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, signedType, function.AddFloatType(signedSpec));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, unsignedTypeAgain, function.AddFloatType(unsignedSpec));
+
+			if (unsignedType == signedType || unsignedType != unsignedTypeAgain)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+	}
+}
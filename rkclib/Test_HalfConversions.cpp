@@ -0,0 +1,181 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "SimdCppEmitter.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		struct HalfConversionCase
+		{
+			uint64_t m_from;
+			uint64_t m_to;
+		};
+
+		static Result CheckHalfToFloat32()
+		{
+			const HalfConversionCase cases[] =
+			{
+				{ 0x0000u, 0x00000000u },
+				{ 0x8000u, 0x80000000u },
+				{ 0x3c00u, 0x3f800000u },
+				{ 0x7bffu, 0x477fe000u },	// 65504, the largest finite value
+				{ 0x0400u, 0x38800000u },	// Smallest normal
+				{ 0x0001u, 0x33800000u },	// Denormals are normal in float32
+				{ 0x8001u, 0xb3800000u },
+				{ 0x03ffu, 0x387fc000u },
+				{ 0x0155u, 0x37aa8000u },
+				{ 0x7c00u, 0x7f800000u },
+				{ 0xfc00u, 0xff800000u },
+				{ 0x7e00u, 0x7fc00000u },	// NaNs keep their payload and come out quiet
+				{ 0x7c01u, 0x7fc02000u },
+				{ 0xffffu, 0xffffe000u },
+			};
+
+			for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+			{
+				if (SimdCppEmitter::HalfToFloat32Bits(static_cast<uint16_t>(cases[i].m_from)) != cases[i].m_to)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		static Result CheckFloat32ToHalf()
+		{
+			const HalfConversionCase cases[] =
+			{
+				{ 0x00000000u, 0x0000u },
+				{ 0x80000000u, 0x8000u },
+				{ 0x3f800000u, 0x3c00u },
+
+				// Ties round to even, and anything past a tie rounds up
+				{ 0x3f801000u, 0x3c00u },
+				{ 0x3f803000u, 0x3c02u },
+				{ 0x3f801001u, 0x3c01u },
+				{ 0x3f800fffu, 0x3c00u },
+				{ 0xbf803000u, 0xbc02u },
+
+				// Up to the largest finite value, and past it to infinity, where the tie rounds to even
+				{ 0x477fe000u, 0x7bffu },
+				{ 0x477fefffu, 0x7bffu },
+				{ 0x477ff000u, 0x7c00u },
+				{ 0x4f800000u, 0x7c00u },
+				{ 0xc77ff000u, 0xfc00u },
+
+				// Denormals, where a tie with zero rounds to zero and the largest one rounds up to a normal
+				{ 0x38800000u, 0x0400u },
+				{ 0x33800000u, 0x0001u },
+				{ 0x33000000u, 0x0000u },
+				{ 0x33000001u, 0x0001u },
+				{ 0x33400000u, 0x0001u },
+				{ 0x33c00000u, 0x0002u },
+				{ 0x387fc000u, 0x03ffu },
+				{ 0x387fe000u, 0x0400u },
+				{ 0xb4200000u, 0x8002u },
+				{ 0x2f800000u, 0x0000u },
+
+				// Float32 denormals are far below the smallest half and keep their sign
+				{ 0x00000001u, 0x0000u },
+				{ 0x80400000u, 0x8000u },
+
+				{ 0x7f800000u, 0x7c00u },
+				{ 0xff800000u, 0xfc00u },
+
+				// NaNs keep the high bits of their payload and come out quiet
+				{ 0x7fc00000u, 0x7e00u },
+				{ 0x7f802000u, 0x7e01u },
+				{ 0x7f800001u, 0x7e00u },
+				{ 0xffffe000u, 0xffffu },
+			};
+
+			for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+			{
+				if (SimdCppEmitter::Float32BitsToHalf(static_cast<uint32_t>(cases[i].m_from)) != cases[i].m_to)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Every half survives a round trip through float32, except that NaNs come back quiet
+			for (uint32_t halfBits = 0; halfBits < 0x10000u; halfBits++)
+			{
+				const bool isNan = ((halfBits & 0x7c00u) == 0x7c00u && (halfBits & 0x3ffu) != 0);
+				const uint32_t expected = isNan ? (halfBits | 0x200u) : halfBits;
+
+				if (SimdCppEmitter::Float32BitsToHalf(SimdCppEmitter::HalfToFloat32Bits(static_cast<uint16_t>(halfBits))) != expected)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		static Result CheckFloat64ToHalf()
+		{
+			const HalfConversionCase cases[] =
+			{
+				{ 0x0000000000000000ull, 0x0000u },
+				{ 0x8000000000000000ull, 0x8000u },
+				{ 0x3ff0000000000000ull, 0x3c00u },
+
+				// Just past a tie, which would round to the tie and then down to even through float32
+				{ 0x3ff0020000001000ull, 0x3c01u },
+				{ 0x3ff0020000000000ull, 0x3c00u },
+				{ 0x3ff0060000000000ull, 0x3c02u },
+
+				{ 0x40effc0000000000ull, 0x7bffu },
+				{ 0x40effe0000000000ull, 0x7c00u },
+				{ 0x7fefffffffffffffull, 0x7c00u },
+
+				{ 0x3e70000000000000ull, 0x0001u },
+				{ 0x3e60000000000000ull, 0x0000u },
+				{ 0x3e60000000000001ull, 0x0001u },
+				{ 0x0000000000000001ull, 0x0000u },
+				{ 0x8000000000000001ull, 0x8000u },
+
+				{ 0x7ff0000000000000ull, 0x7c00u },
+				{ 0xfff0000000000000ull, 0xfc00u },
+				{ 0x7ff8000000000000ull, 0x7e00u },
+				{ 0x7ff0040000000000ull, 0x7e01u },
+				{ 0x7ff0000000000001ull, 0x7e00u },
+			};
+
+			for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+			{
+				if (SimdCppEmitter::Float64BitsToHalf(cases[i].m_from) != cases[i].m_to)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Float32 values are exact in float64, so they round the same from either.  NaNs are checked above.
+			for (uint64_t i = 0; i < 0x100000000ull; i += 0xfff1u)
+			{
+				const uint32_t floatBits = static_cast<uint32_t>(i);
+				if ((floatBits & 0x7fffffffu) > 0x7f800000u)
+					continue;
+
+				float floatValue = 0.0f;
+				memcpy(&floatValue, &floatBits, sizeof(floatValue));
+
+				const double doubleValue = floatValue;
+				uint64_t doubleBits = 0;
+				memcpy(&doubleBits, &doubleValue, sizeof(doubleBits));
+
+				if (SimdCppEmitter::Float64BitsToHalf(doubleBits) != SimdCppEmitter::Float32BitsToHalf(floatBits))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		Result HalfConversions(IAllocator &alloc)
+		{
+			(void)alloc;
+
+			RKC_CHECK(CheckHalfToFloat32());
+			RKC_CHECK(CheckFloat32ToHalf());
+			RKC_CHECK(CheckFloat64ToHalf());
+
+			return Result::Ok();
+		}
+	}
+}
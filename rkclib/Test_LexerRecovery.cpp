@@ -0,0 +1,77 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "FeedStream.h"
+#include "Lexer.h"
+
+#include <cstring>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		Result LexerRecovery(IAllocator &alloc)
+		{
+			// One error per line from the second line on, followed by a valid line
+			const char *source =
+				"a = 1\n"
+				"b = \"unterminated\n"
+				"c = 12x + 3\n"
+				"d = 'x' \x01 e\n"
+				"f = \"bad \\q escape\" g\r\n"
+				"h = \xff\xfe\n"
+				"ok\n";
+
+			const rkc::ResultCode_t expectedErrors[] =
+			{
+				rkc::ResultCodes::kLexUnexpectedEndOfLine,
+				rkc::ResultCodes::kLexMalformedNumber,
+				rkc::ResultCodes::kLexGarbageCharacter,
+				rkc::ResultCodes::kLexInvalidEscape,
+				rkc::ResultCodes::kLexInvalidUnicode,
+			};
+
+			const size_t numExpectedErrors = sizeof(expectedErrors) / sizeof(expectedErrors[0]);
+
+			FeedStream stream(&alloc);
+			RKC_CHECK(stream.Append(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(source), strlen(source))));
+
+			Lexer lexer(&stream, &alloc, Lexer::kDefaultBufferSize);
+			lexer.SetRecoverFromErrors(true);
+
+			size_t numErrors = 0;
+			size_t numNamesOnValidLines = 0;
+
+			for (;;)
+			{
+				RKC_CHECK_RV(LexToken, token, lexer.GetNextToken());
+
+				if (token.m_tokenType == LexTokenType::kEndOfFile)
+					break;
+
+				if (token.m_tokenType == LexTokenType::kError)
+				{
+					if (numErrors == numExpectedErrors || token.m_errorCode != expectedErrors[numErrors] || token.m_startPos.m_line != numErrors + 1)
+						return rkc::ResultCodes::kInternalError;
+
+					// Error tokens end at the line break, which is lexed as usual
+					RKC_CHECK_RV(LexToken, lineBreak, lexer.GetNextToken());
+					if (lineBreak.m_tokenType != LexTokenType::kEndOfLine)
+						return rkc::ResultCodes::kInternalError;
+
+					numErrors++;
+				}
+				else if (token.m_tokenType == LexTokenType::kName)
+				{
+					if (token.m_startPos.m_line == 0 || token.m_startPos.m_line == numExpectedErrors + 1)
+						numNamesOnValidLines++;
+				}
+			}
+
+			if (numErrors != numExpectedErrors || numNamesOnValidLines != 2)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+	}
+}
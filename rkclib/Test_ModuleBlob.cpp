@@ -0,0 +1,414 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "HashingStream.h"
+#include "Hasher.h"
+#include "IStream.h"
+#include "ModuleBlob.h"
+#include "RkcComposite.h"
+#include "RkcContext.h"
+#include "Vector.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// Seekable in-memory stream that grows when written past its end
+		class BlobTestStream final : public IStream
+		{
+		public:
+			explicit BlobTestStream(IAllocator &alloc);
+
+			Result SetContents(const char *text);
+
+			size_t Read(void *buf, size_t size) override;
+			size_t Write(void *buf, size_t size) override;
+			rkcUFilePos_t Tell() const override;
+			bool SeekStart(rkcUFilePos_t pos) override;
+			bool SeekEnd(rkcFilePos_t pos) override;
+			bool SeekCurrent(rkcFilePos_t pos) override;
+			bool IsReadable() const override;
+			bool IsWritable() const override;
+			void Close() override;
+
+			RkcStreamSpec GetStreamSpec();
+
+			Vector<uint8_t> m_bytes;
+			size_t m_pos;
+
+		private:
+			static size_t SpecRead(void *userdata, void *buf, size_t size);
+			static size_t SpecWrite(void *userdata, const void *buf, size_t size);
+			static rkcUFilePos_t SpecTell(void *userdata);
+			static int SpecSeekStart(void *userdata, rkcUFilePos_t pos);
+			static int SpecSeekEnd(void *userdata, rkcFilePos_t pos);
+			static int SpecSeekCurrent(void *userdata, rkcFilePos_t pos);
+			static void SpecClose(void *userdata);
+
+			static RkcStreamFunctions ms_specFunctions;
+		};
+
+		RkcStreamFunctions BlobTestStream::ms_specFunctions =
+		{
+			BlobTestStream::SpecRead,
+			BlobTestStream::SpecWrite,
+			BlobTestStream::SpecTell,
+			BlobTestStream::SpecSeekStart,
+			BlobTestStream::SpecSeekEnd,
+			BlobTestStream::SpecSeekCurrent,
+			BlobTestStream::SpecClose,
+		};
+
+		BlobTestStream::BlobTestStream(IAllocator &alloc)
+			: m_bytes(&alloc)
+			, m_pos(0)
+		{
+		}
+
+		Result BlobTestStream::SetContents(const char *text)
+		{
+			RKC_CHECK(m_bytes.ResizeNoConstruct(0));
+			RKC_CHECK(m_bytes.AppendRange(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(text), strlen(text))));
+			m_pos = 0;
+
+			return Result::Ok();
+		}
+
+		size_t BlobTestStream::Read(void *buf, size_t size)
+		{
+			const size_t available = m_bytes.Count() - m_pos;
+			if (size > available)
+				size = available;
+
+			if (size > 0)
+				memcpy(buf, &m_bytes[m_pos], size);
+
+			m_pos += size;
+			return size;
+		}
+
+		size_t BlobTestStream::Write(void *buf, size_t size)
+		{
+			if (m_pos + size > m_bytes.Count())
+			{
+				Result resizeResult(m_bytes.ResizeNoConstruct(m_pos + size));
+				resizeResult.Handle();
+				if (!resizeResult.IsOK())
+					return 0;
+			}
+
+			if (size > 0)
+				memcpy(&m_bytes[m_pos], buf, size);
+
+			m_pos += size;
+			return size;
+		}
+
+		rkcUFilePos_t BlobTestStream::Tell() const
+		{
+			return m_pos;
+		}
+
+		bool BlobTestStream::SeekStart(rkcUFilePos_t pos)
+		{
+			if (pos > m_bytes.Count())
+				return false;
+
+			m_pos = static_cast<size_t>(pos);
+			return true;
+		}
+
+		bool BlobTestStream::SeekEnd(rkcFilePos_t pos)
+		{
+			return SeekStart(static_cast<rkcUFilePos_t>(m_bytes.Count() + pos));
+		}
+
+		bool BlobTestStream::SeekCurrent(rkcFilePos_t pos)
+		{
+			return SeekStart(static_cast<rkcUFilePos_t>(m_pos + pos));
+		}
+
+		bool BlobTestStream::IsReadable() const
+		{
+			return true;
+		}
+
+		bool BlobTestStream::IsWritable() const
+		{
+			return true;
+		}
+
+		void BlobTestStream::Close()
+		{
+		}
+
+		RkcStreamSpec BlobTestStream::GetStreamSpec()
+		{
+			RkcStreamSpec spec;
+			spec.m_functions = &ms_specFunctions;
+			spec.m_permissions = RkcStreamPermission_Read | RkcStreamPermission_Write;
+			spec.m_userdata = this;
+
+			return spec;
+		}
+
+		size_t BlobTestStream::SpecRead(void *userdata, void *buf, size_t size)
+		{
+			return static_cast<BlobTestStream*>(userdata)->Read(buf, size);
+		}
+
+		size_t BlobTestStream::SpecWrite(void *userdata, const void *buf, size_t size)
+		{
+			return static_cast<BlobTestStream*>(userdata)->Write(const_cast<void*>(buf), size);
+		}
+
+		rkcUFilePos_t BlobTestStream::SpecTell(void *userdata)
+		{
+			return static_cast<const BlobTestStream*>(userdata)->Tell();
+		}
+
+		int BlobTestStream::SpecSeekStart(void *userdata, rkcUFilePos_t pos)
+		{
+			return static_cast<BlobTestStream*>(userdata)->SeekStart(pos) ? 1 : 0;
+		}
+
+		int BlobTestStream::SpecSeekEnd(void *userdata, rkcFilePos_t pos)
+		{
+			return static_cast<BlobTestStream*>(userdata)->SeekEnd(pos) ? 1 : 0;
+		}
+
+		int BlobTestStream::SpecSeekCurrent(void *userdata, rkcFilePos_t pos)
+		{
+			return static_cast<BlobTestStream*>(userdata)->SeekCurrent(pos) ? 1 : 0;
+		}
+
+		void BlobTestStream::SpecClose(void *)
+		{
+		}
+
+		static bool BlobHeadersEqual(const ModuleBlobHeader &a, const ModuleBlobHeader &b)
+		{
+			return a.m_sourceHash == b.m_sourceHash && a.m_optionsHash == b.m_optionsHash && a.m_interfaceHash == b.m_interfaceHash && a.m_importsInterfaceHash == b.m_importsInterfaceHash;
+		}
+
+		static Result CheckModuleBlobRoundTrip(IAllocator &alloc)
+		{
+			ModuleBlobHeader header;
+			header.m_sourceHash = 0x0123456789abcdefull;
+			header.m_optionsHash = 0xfedcba9876543210ull;
+			header.m_interfaceHash = 0x8000000000000001ull;
+			header.m_importsInterfaceHash = 0x00000000ffffffffull;
+
+			BlobTestStream stream(alloc);
+			RKC_CHECK(ModuleBlob::Write(stream, header));
+
+			if (stream.m_bytes.Count() != ModuleBlobHeader::kSize)
+				return rkc::ResultCodes::kInternalError;
+
+			ModuleBlobHeader readHeader;
+			stream.SeekStart(0);
+			RKC_CHECK_RV(bool, isValid, ModuleBlob::ReadHeader(stream, readHeader));
+
+			if (!isValid || !BlobHeadersEqual(header, readHeader))
+				return rkc::ResultCodes::kInternalError;
+
+			// Truncated blobs, other file types and blobs from other versions are rejected
+			const size_t kNumCorruptions = 4;
+			for (size_t i = 0; i < kNumCorruptions; i++)
+			{
+				BlobTestStream corrupted(alloc);
+				RKC_CHECK(ModuleBlob::Write(corrupted, header));
+
+				if (i == 0)
+				{
+					RKC_CHECK(corrupted.m_bytes.ResizeNoConstruct(ModuleBlobHeader::kSize - 1));
+				}
+				else if (i == 1)
+					corrupted.m_bytes[0] ^= 1;
+				else if (i == 2)
+					corrupted.m_bytes[8]++;
+				else
+					corrupted.m_bytes[12]++;
+
+				corrupted.SeekStart(0);
+				RKC_CHECK_RV(bool, isCorruptedValid, ModuleBlob::ReadHeader(corrupted, readHeader));
+
+				if (isCorruptedValid)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		// The hash of a stream doesn't depend on how its reads were split up
+		static Result CheckHashingStream(IAllocator &alloc)
+		{
+			const size_t kNumBytes = 1000;
+
+			BlobTestStream source(alloc);
+			RKC_CHECK(source.m_bytes.ResizeNoConstruct(kNumBytes));
+			for (size_t i = 0; i < kNumBytes; i++)
+				source.m_bytes[i] = static_cast<uint8_t>(i * 7 + i / 256);
+
+			const uint64_t expectedHash = HashUtil::ComputeStableHash64(&source.m_bytes[0], kNumBytes, HashUtil::kStableHash64Seed);
+
+			const size_t chunkSizes[] = { 1, 7, 64, kNumBytes, kNumBytes * 2 };
+			for (size_t chunkSizeIndex = 0; chunkSizeIndex < sizeof(chunkSizes) / sizeof(chunkSizes[0]); chunkSizeIndex++)
+			{
+				source.SeekStart(0);
+				HashingStream hashingStream(source);
+
+				uint8_t buffer[kNumBytes * 2];
+				size_t numRead = 0;
+				for (;;)
+				{
+					const size_t chunkRead = hashingStream.Read(buffer, chunkSizes[chunkSizeIndex]);
+					if (chunkRead == 0)
+						break;
+
+					numRead += chunkRead;
+				}
+
+				if (numRead != kNumBytes || hashingStream.GetHash() != expectedHash)
+					return rkc::ResultCodes::kInternalError;
+
+				// Seeking would make the hash depend on the read order
+				if (hashingStream.SeekStart(0) || hashingStream.SeekEnd(0) || hashingStream.SeekCurrent(0) || hashingStream.Write(buffer, 1) != 0)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			source.m_bytes[kNumBytes / 2] ^= 0x10;
+			source.SeekStart(0);
+
+			HashingStream changedStream(source);
+			uint8_t buffer[kNumBytes];
+			if (changedStream.Read(buffer, kNumBytes) != kNumBytes || changedStream.GetHash() == expectedHash)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		static const char *const kBlobModuleASource = "export void F(int x)\n{\n\treturn x\n}\n";
+		static const char *const kBlobModuleABodyChangedSource = "export void F(int x)\n{\n\treturn x + 1\n}\n";
+		static const char *const kBlobModuleAInterfaceChangedSource = "export void F(int x, int y)\n{\n\treturn x\n}\n";
+		static const char *const kBlobModuleBSource = "y = F(1)\n";
+
+		struct BlobTestRun
+		{
+			size_t m_numCompiled;
+			size_t m_numSkipped;
+			bool m_isAAccepted;
+			bool m_isBAccepted;
+		};
+
+		static void *BlobTestRealloc(void *userdata, void *buf, size_t newSize)
+		{
+			return static_cast<IAllocator*>(userdata)->Realloc(buf, newSize);
+		}
+
+		static ArraySliceView<const uint8_t> BlobTestName(const char *name)
+		{
+			return ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(name), strlen(name));
+		}
+
+		// Compiles module b importing module a in a new composite, the same way as a directory cache: blobs
+		// from the previous run are offered for each module first, and new blobs are written afterwards
+		static Result RunBlobTestComposite(IRkcContext &context, IAllocator &alloc, const char *sourceA, BlobTestStream &blobA, BlobTestStream &blobB, BlobTestRun &outRun)
+		{
+			BlobTestStream streamA(alloc);
+			BlobTestStream streamB(alloc);
+			RKC_CHECK(streamA.SetContents(sourceA));
+			RKC_CHECK(streamB.SetContents(kBlobModuleBSource));
+
+			IRkcComposite composite(context);
+
+			RKC_CHECK_RV(size_t, moduleA, composite.AddProgram(BlobTestName("a"), streamA.GetStreamSpec()));
+			RKC_CHECK_RV(size_t, moduleB, composite.AddProgram(BlobTestName("b"), streamB.GetStreamSpec()));
+			RKC_CHECK(composite.AddImport(moduleB, BlobTestName("a")));
+
+			outRun.m_isAAccepted = false;
+			outRun.m_isBAccepted = false;
+
+			if (blobA.m_bytes.Count() > 0)
+			{
+				blobA.SeekStart(0);
+				RKC_CHECK_RV(bool, isAccepted, composite.ImportCompiledProgram(moduleA, blobA));
+				outRun.m_isAAccepted = isAccepted;
+			}
+
+			if (blobB.m_bytes.Count() > 0)
+			{
+				blobB.SeekStart(0);
+				RKC_CHECK_RV(bool, isAccepted, composite.ImportCompiledProgram(moduleB, blobB));
+				outRun.m_isBAccepted = isAccepted;
+			}
+
+			RKC_CHECK(composite.Compile(nullptr));
+
+			RkcCompositeCompileStats stats;
+			composite.GetCompileStats(stats);
+			outRun.m_numCompiled = stats.m_numModulesCompiled;
+			outRun.m_numSkipped = stats.m_numModulesSkipped;
+
+			RKC_CHECK(blobA.SetContents(""));
+			RKC_CHECK(blobB.SetContents(""));
+			RKC_CHECK(composite.ExportCompiledProgram(moduleA, blobA));
+			RKC_CHECK(composite.ExportCompiledProgram(moduleB, blobB));
+
+			return Result::Ok();
+		}
+
+		static Result CheckCompiledModuleReuse(IAllocator &alloc)
+		{
+			RkcAllocatorSpec allocSpec;
+			allocSpec.m_realloc = BlobTestRealloc;
+			allocSpec.m_userdata = &alloc;
+
+			RkcContextOptions options;
+			options.m_structSize = sizeof(RkcContextOptions);
+			options.m_trackAllocations = 0;
+			options.m_readAheadBufferSize = 0;
+			options.m_lexerBufferSize = 0;
+			options.m_readAheadThreads = 0;
+
+			IRkcContext context(allocSpec, options);
+
+			BlobTestStream blobA(alloc);
+			BlobTestStream blobB(alloc);
+			BlobTestRun run;
+
+			// Nothing cached yet
+			RKC_CHECK(RunBlobTestComposite(context, alloc, kBlobModuleASource, blobA, blobB, run));
+			if (run.m_numCompiled != 2 || run.m_numSkipped != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			// Unchanged sources reuse both blobs
+			RKC_CHECK(RunBlobTestComposite(context, alloc, kBlobModuleASource, blobA, blobB, run));
+			if (!run.m_isAAccepted || !run.m_isBAccepted || run.m_numCompiled != 0 || run.m_numSkipped != 2)
+				return rkc::ResultCodes::kInternalError;
+
+			// A body edit recompiles the edited module, but not its importer
+			RKC_CHECK(RunBlobTestComposite(context, alloc, kBlobModuleABodyChangedSource, blobA, blobB, run));
+			if (run.m_isAAccepted || !run.m_isBAccepted || run.m_numCompiled != 1 || run.m_numSkipped != 1)
+				return rkc::ResultCodes::kInternalError;
+
+			// An interface edit recompiles the importer too, even though its own blob is accepted
+			RKC_CHECK(RunBlobTestComposite(context, alloc, kBlobModuleAInterfaceChangedSource, blobA, blobB, run));
+			if (run.m_isAAccepted || !run.m_isBAccepted || run.m_numCompiled != 2 || run.m_numSkipped != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result ModuleBlobs(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckModuleBlobRoundTrip(alloc));
+			RKC_CHECK(CheckHashingStream(alloc));
+			RKC_CHECK(CheckCompiledModuleReuse(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,403 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "FloatSpec.h"
+#include "KernelIR.h"
+#include "MonomorphCache.h"
+#include "SymbolPool.h"
+#include "Vector.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static const uint32_t kNumMonomorphRangeArgs = 200;
+		static const uint32_t kNumMonomorphThreads = 4;
+		static const uint32_t kNumMonomorphThreadRounds = 3;
+
+		static ArraySliceView<const uint8_t> MonomorphName(const char *name)
+		{
+			return ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(name), strlen(name));
+		}
+
+		static bool LinkNamesEqual(const Vector<uint8_t> &a, const Vector<uint8_t> &b)
+		{
+			return a.Count() == b.Count() && !memcmp(&a[0], &b[0], a.Count());
+		}
+
+		static ResultRV<Vector<rkci::MonomorphCache::TypeArgument>> MakeMonomorphRangeArgs(Kernel::Function &kernel, IAllocator &alloc)
+		{
+			Vector<rkci::MonomorphCache::TypeArgument> rangeArgs(&alloc);
+			for (uint32_t i = 0; i < kNumMonomorphRangeArgs; i++)
+			{
+				RKC_CHECK_RV(Kernel::TypeIndex_t, type, kernel.AddIntType(0, 1 + static_cast<int64_t>(i)));
+				RKC_CHECK(rangeArgs.Append(rkci::MonomorphCache::MakeTypeArgument(kernel, type)));
+			}
+
+			return rangeArgs;
+		}
+
+		// The name that an instantiation of a range argument is built with, which is the argument's index
+		// in decimal
+		static ArraySliceView<const uint8_t> MonomorphInstanceName(char (&buffer)[16], uint32_t argIndex)
+		{
+			const int length = snprintf(buffer, sizeof(buffer), "%u", argIndex);
+			return ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(buffer), static_cast<size_t>(length));
+		}
+
+		static bool MonomorphFunctionNameIs(const Kernel::Function &function, uint32_t argIndex)
+		{
+			char buffer[16];
+			const ArraySliceView<const uint8_t> expected = MonomorphInstanceName(buffer, argIndex);
+			const ArraySliceView<const uint8_t> name = function.GetName();
+
+			return name.Count() == expected.Count() && !memcmp(&name[0], &expected[0], name.Count());
+		}
+
+		// Checks that type arguments taken from kernels that declare the same types in different orders
+		// find the same instantiation, and that every other combination gets its own
+		static Result CheckMonomorphKeys(IAllocator &alloc)
+		{
+			const FloatSpec float32Spec(true, 8, 23, 127, true, true);
+			const FloatSpec float16Spec(true, 5, 10, 15, true, true);
+
+			Kernel::Function kernelA(&alloc);
+			RKC_CHECK_RV(Kernel::TypeIndex_t, intA, kernelA.AddIntType(0, 255));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, floatA, kernelA.AddFloatType(float32Spec));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, maskA, kernelA.AddMaskType(floatA));
+
+			Kernel::Function kernelB(&alloc);
+			RKC_CHECK_RV(Kernel::TypeIndex_t, halfB, kernelB.AddFloatType(float16Spec));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, halfMaskB, kernelB.AddMaskType(halfB));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, floatB, kernelB.AddFloatType(float32Spec));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, maskB, kernelB.AddMaskType(floatB));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, intB, kernelB.AddIntType(0, 255));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, wideIntB, kernelB.AddIntType(0, 256));
+
+			SymbolPool symbolPool(alloc);
+			RKC_CHECK_RV(SymbolID_t, lerp, symbolPool.Intern(MonomorphName("lerp")));
+			RKC_CHECK_RV(SymbolID_t, clamp, symbolPool.Intern(MonomorphName("clamp")));
+
+			const rkci::MonomorphCache::TypeArgument argsA[] =
+			{
+				rkci::MonomorphCache::MakeTypeArgument(kernelA, floatA),
+				rkci::MonomorphCache::MakeTypeArgument(kernelA, intA),
+				rkci::MonomorphCache::MakeTypeArgument(kernelA, maskA),
+			};
+
+			const rkci::MonomorphCache::TypeArgument argsB[] =
+			{
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, floatB),
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, intB),
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, maskB),
+			};
+
+			const rkci::MonomorphCache::TypeArgument swappedArgs[] =
+			{
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, intB),
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, floatB),
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, maskB),
+			};
+
+			const rkci::MonomorphCache::TypeArgument otherArgs[] =
+			{
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, halfB),
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, wideIntB),
+				rkci::MonomorphCache::MakeTypeArgument(kernelB, halfMaskB),
+			};
+
+			const ArraySliceView<const rkci::MonomorphCache::TypeArgument> sliceA(argsA, 3);
+			const ArraySliceView<const rkci::MonomorphCache::TypeArgument> sliceB(argsB, 3);
+
+			rkci::MonomorphCache cache(alloc);
+
+			bool isNew = false;
+			RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, instanceA, cache.FindOrAdd(lerp, sliceA, isNew));
+			if (!isNew)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, instanceB, cache.FindOrAdd(lerp, sliceB, isNew));
+			if (isNew || instanceB != instanceA)
+				return rkc::ResultCodes::kInternalError;
+
+			// Each of these differs from the first instantiation in one way
+			RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, otherFunction, cache.FindOrAdd(clamp, sliceA, isNew));
+			if (!isNew || otherFunction == instanceA)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, swapped, cache.FindOrAdd(lerp, ArraySliceView<const rkci::MonomorphCache::TypeArgument>(swappedArgs, 3), isNew));
+			if (!isNew)
+				return rkc::ResultCodes::kInternalError;
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				rkci::MonomorphCache::TypeArgument changedArgs[] = { argsA[0], argsA[1], argsA[2] };
+				changedArgs[i] = otherArgs[i];
+
+				RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, changed, cache.FindOrAdd(lerp, ArraySliceView<const rkci::MonomorphCache::TypeArgument>(changedArgs, 3), isNew));
+				if (!isNew || changed == instanceA)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, prefix, cache.FindOrAdd(lerp, sliceA.Subrange(0, 2), isNew));
+			if (!isNew || prefix == instanceA || prefix == swapped)
+				return rkc::ResultCodes::kInternalError;
+
+			if (cache.NumInstances() != 7 || cache.GetNumReused() != 1)
+				return rkc::ResultCodes::kInternalError;
+
+			// Instantiations are only built by the caller that added them
+			if (cache.GetFunction(instanceA) != nullptr)
+				return rkc::ResultCodes::kInternalError;
+
+			Kernel::Function instantiated(&alloc);
+			RKC_CHECK(instantiated.SetName(MonomorphName("lerp_f32")));
+			RKC_CHECK(cache.SetFunction(instanceA, rkci::Move(instantiated)));
+
+			const Kernel::Function *built = cache.GetFunction(instanceA);
+			if (built == nullptr || built->GetName().Count() != 8 || cache.GetFunction(swapped) != nullptr)
+				return rkc::ResultCodes::kInternalError;
+
+			// Building the rest doesn't move the ones that are already built
+			for (rkci::MonomorphCache::InstanceID_t instance = 0; instance < cache.NumInstances(); instance++)
+			{
+				if (instance == instanceA)
+					continue;
+
+				Kernel::Function other(&alloc);
+				RKC_CHECK(other.SetName(MonomorphName("other")));
+				RKC_CHECK(cache.SetFunction(instance, rkci::Move(other)));
+			}
+
+			if (cache.GetFunction(instanceA) != built || built->GetName().Count() != 8 || memcmp(&built->GetName()[0], "lerp_f32", 8))
+				return rkc::ResultCodes::kInternalError;
+
+			// Type arguments are copied out
+			Vector<rkci::MonomorphCache::TypeArgument> typeArgs(&alloc);
+			RKC_CHECK(cache.GetTypeArguments(prefix, typeArgs));
+			if (typeArgs.Count() != 2 || !rkci::MonomorphCache::TypeArgumentsEqual(typeArgs[0], argsB[0]) || !rkci::MonomorphCache::TypeArgumentsEqual(typeArgs[1], argsB[1]))
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK(cache.GetTypeArguments(instanceA, typeArgs));
+			if (typeArgs.Count() != 3 || !rkci::MonomorphCache::TypeArgumentsEqual(typeArgs[2], argsB[2]))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// Checks that the link name only depends on the function's name and the type arguments, not on
+		// symbol IDs or the order that instantiations were added in, and that lookups survive rehashing
+		static Result CheckMonomorphLinkNames(IAllocator &alloc)
+		{
+			Kernel::Function kernel(&alloc);
+			RKC_CHECK_RV(Vector<rkci::MonomorphCache::TypeArgument>, rangeArgs, MakeMonomorphRangeArgs(kernel, alloc));
+
+			SymbolPool poolA(alloc);
+			SymbolPool poolB(alloc);
+			RKC_CHECK_RV(SymbolID_t, sumA, poolA.Intern(MonomorphName("sum")));
+			RKC_CHECK_RV(SymbolID_t, unrelated, poolB.Intern(MonomorphName("unrelated")));
+			RKC_CHECK_RV(SymbolID_t, sumB, poolB.Intern(MonomorphName("sum")));
+
+			// The names need different symbol IDs in the two pools for this to check anything
+			if (sumA == sumB)
+				return rkc::ResultCodes::kInternalError;
+
+			rkci::MonomorphCache cacheA(alloc);
+			rkci::MonomorphCache cacheB(alloc);
+
+			bool isNew = false;
+			for (uint32_t i = 0; i < kNumMonomorphRangeArgs; i++)
+			{
+				RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, instanceA, cacheA.FindOrAdd(sumA, rangeArgs.Slice().Subrange(i, 1), isNew));
+				if (!isNew || instanceA != i)
+					return rkc::ResultCodes::kInternalError;
+
+				RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, instanceB, cacheB.FindOrAdd(sumB, rangeArgs.Slice().Subrange(kNumMonomorphRangeArgs - 1 - i, 1), isNew));
+				if (!isNew || instanceB != i)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			Vector<uint8_t> nameA(&alloc);
+			Vector<uint8_t> nameB(&alloc);
+			for (uint32_t i = 0; i < kNumMonomorphRangeArgs; i++)
+			{
+				rkci::MonomorphCache::InstanceID_t instanceA = 0;
+				rkci::MonomorphCache::InstanceID_t instanceB = 0;
+				if (!cacheA.Find(sumA, rangeArgs.Slice().Subrange(i, 1), instanceA) || instanceA != i)
+					return rkc::ResultCodes::kInternalError;
+
+				if (!cacheB.Find(sumB, rangeArgs.Slice().Subrange(i, 1), instanceB) || instanceB != kNumMonomorphRangeArgs - 1 - i)
+					return rkc::ResultCodes::kInternalError;
+
+				RKC_CHECK(cacheA.GetLinkName(instanceA, poolA, nameA));
+				RKC_CHECK(cacheB.GetLinkName(instanceB, poolB, nameB));
+
+				if (!LinkNamesEqual(nameA, nameB) || nameA.Count() != 21 || memcmp(&nameA[0], "sum_m", 5))
+					return rkc::ResultCodes::kInternalError;
+
+				if (i > 0)
+				{
+					RKC_CHECK(cacheA.GetLinkName(instanceA - 1, poolA, nameB));
+					if (LinkNamesEqual(nameA, nameB))
+						return rkc::ResultCodes::kInternalError;
+				}
+			}
+
+			// A different generic function with the same type arguments gets a different link name
+			RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, unrelatedInstance, cacheB.FindOrAdd(unrelated, rangeArgs.Slice().Subrange(0, 1), isNew));
+			if (!isNew)
+				return rkc::ResultCodes::kInternalError;
+
+			RKC_CHECK(cacheA.GetLinkName(0, poolA, nameA));
+			RKC_CHECK(cacheB.GetLinkName(unrelatedInstance, poolB, nameB));
+			if (LinkNamesEqual(nameA, nameB))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		struct MonomorphTestThread
+		{
+			rkci::MonomorphCache *m_cache;
+			IAllocator *m_alloc;
+			const SymbolPool *m_symbolPool;
+			SymbolID_t m_genericFunction;
+			const Vector<rkci::MonomorphCache::TypeArgument> *m_rangeArgs;
+			uint32_t m_threadIndex;
+
+			uint32_t m_numAdded;
+			rkc::ResultCode_t m_resultCode;
+		};
+
+		// Requests every range argument several times in an order of its own, builds the ones that it
+		// added, and reads back whatever the other threads have built so far
+		static Result RunMonomorphTestThread(MonomorphTestThread &thread)
+		{
+			rkci::MonomorphCache &cache = *thread.m_cache;
+			const Vector<rkci::MonomorphCache::TypeArgument> &rangeArgs = *thread.m_rangeArgs;
+
+			Vector<rkci::MonomorphCache::TypeArgument> typeArgs(thread.m_alloc);
+			Vector<uint8_t> linkName(thread.m_alloc);
+
+			for (uint32_t round = 0; round < kNumMonomorphThreadRounds; round++)
+			{
+				for (uint32_t i = 0; i < kNumMonomorphRangeArgs; i++)
+				{
+					const uint32_t argIndex = (i * 7 + thread.m_threadIndex * 53 + round * 11) % kNumMonomorphRangeArgs;
+					const ArraySliceView<const rkci::MonomorphCache::TypeArgument> args = rangeArgs.Slice().Subrange(argIndex, 1);
+
+					bool isNew = false;
+					RKC_CHECK_RV(rkci::MonomorphCache::InstanceID_t, instance, cache.FindOrAdd(thread.m_genericFunction, args, isNew));
+
+					if (isNew)
+					{
+						thread.m_numAdded++;
+
+						char buffer[16];
+						Kernel::Function function(thread.m_alloc);
+						RKC_CHECK(function.SetName(MonomorphInstanceName(buffer, argIndex)));
+						RKC_CHECK(cache.SetFunction(instance, rkci::Move(function)));
+					}
+
+					const Kernel::Function *function = cache.GetFunction(instance);
+					if (function != nullptr && !MonomorphFunctionNameIs(*function, argIndex))
+						return rkc::ResultCodes::kInternalError;
+
+					RKC_CHECK(cache.GetTypeArguments(instance, typeArgs));
+					if (typeArgs.Count() != 1 || !rkci::MonomorphCache::TypeArgumentsEqual(typeArgs[0], args[0]))
+						return rkc::ResultCodes::kInternalError;
+
+					if (cache.GetGenericFunction(instance) != thread.m_genericFunction || cache.GetTypeArgumentsHash(instance) != rkci::MonomorphCache::ComputeTypeArgumentsHash(args))
+						return rkc::ResultCodes::kInternalError;
+
+					RKC_CHECK(cache.GetLinkName(instance, *thread.m_symbolPool, linkName));
+					if (linkName.Count() != 21 || memcmp(&linkName[0], "sum_m", 5))
+						return rkc::ResultCodes::kInternalError;
+
+					if (cache.NumInstances() > kNumMonomorphRangeArgs || cache.GetNumReused() > kNumMonomorphRangeArgs * kNumMonomorphThreadRounds * kNumMonomorphThreads)
+						return rkc::ResultCodes::kInternalError;
+				}
+			}
+
+			return Result::Ok();
+		}
+
+		static void MonomorphTestThreadMain(MonomorphTestThread *thread)
+		{
+			Result result(RunMonomorphTestThread(*thread));
+			result.Handle();
+
+			thread->m_resultCode = result.GetCode();
+		}
+
+		// Checks that threads sharing one cache add each instantiation exactly once
+		static Result CheckMonomorphThreads(IAllocator &alloc)
+		{
+			Kernel::Function kernel(&alloc);
+			RKC_CHECK_RV(Vector<rkci::MonomorphCache::TypeArgument>, rangeArgs, MakeMonomorphRangeArgs(kernel, alloc));
+
+			SymbolPool symbolPool(alloc);
+			RKC_CHECK_RV(SymbolID_t, sum, symbolPool.Intern(MonomorphName("sum")));
+
+			rkci::MonomorphCache cache(alloc);
+
+			MonomorphTestThread threads[kNumMonomorphThreads];
+			std::thread workers[kNumMonomorphThreads];
+			for (uint32_t i = 0; i < kNumMonomorphThreads; i++)
+			{
+				MonomorphTestThread &thread = threads[i];
+				thread.m_cache = &cache;
+				thread.m_alloc = &alloc;
+				thread.m_symbolPool = &symbolPool;
+				thread.m_genericFunction = sum;
+				thread.m_rangeArgs = &rangeArgs;
+				thread.m_threadIndex = i;
+				thread.m_numAdded = 0;
+				thread.m_resultCode = rkc::ResultCodes::kOK;
+
+				workers[i] = std::thread(MonomorphTestThreadMain, &thread);
+			}
+
+			uint32_t numAdded = 0;
+			for (uint32_t i = 0; i < kNumMonomorphThreads; i++)
+			{
+				workers[i].join();
+
+				if (threads[i].m_resultCode != rkc::ResultCodes::kOK)
+					return threads[i].m_resultCode;
+
+				numAdded += threads[i].m_numAdded;
+			}
+
+			const size_t numRequests = static_cast<size_t>(kNumMonomorphRangeArgs) * kNumMonomorphThreadRounds * kNumMonomorphThreads;
+			if (numAdded != kNumMonomorphRangeArgs || cache.NumInstances() != kNumMonomorphRangeArgs || cache.GetNumReused() != numRequests - kNumMonomorphRangeArgs)
+				return rkc::ResultCodes::kInternalError;
+
+			for (uint32_t i = 0; i < kNumMonomorphRangeArgs; i++)
+			{
+				rkci::MonomorphCache::InstanceID_t instance = 0;
+				if (!cache.Find(sum, rangeArgs.Slice().Subrange(i, 1), instance))
+					return rkc::ResultCodes::kInternalError;
+
+				const Kernel::Function *function = cache.GetFunction(instance);
+				if (function == nullptr || !MonomorphFunctionNameIs(*function, i))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		Result MonomorphCache(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckMonomorphKeys(alloc));
+			RKC_CHECK(CheckMonomorphLinkNames(alloc));
+			RKC_CHECK(CheckMonomorphThreads(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
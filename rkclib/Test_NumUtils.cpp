@@ -0,0 +1,74 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "BigUBinFloatProto.h"
+#include "BigUFloat.h"
+#include "FloatSpec.h"
+#include "MoveOrCopy.h"
+#include "NumUtils.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// significand * 2^exponent
+		static ResultRV<BigUBinFloat_t> MakeRoundingTestValue(uint64_t significand, int32_t exponent, IAllocator &alloc)
+		{
+			BigUBinFloat_t value(static_cast<uint32_t>(significand & 0xffffffffu), alloc);
+			BigUBinFloat_t high(static_cast<uint32_t>(significand >> 32), alloc);
+
+			RKC_CHECK(high.ShiftInPlace(32));
+			RKC_CHECK(value.AddInPlace(high));
+			RKC_CHECK(value.ShiftInPlace(exponent));
+
+			return value;
+		}
+
+		static Result CheckRoundToFloatSpec(uint64_t significand, int32_t exponent, uint64_t expectedSignificand, int32_t expectedExponent, const rkci::FloatSpec &floatSpec, IAllocator &alloc)
+		{
+			RKC_CHECK_RV(BigUBinFloat_t, value, MakeRoundingTestValue(significand, exponent, alloc));
+			RKC_CHECK_RV(BigUBinFloat_t, rounded, rkci::NumUtils::RoundToFloatSpec(value, floatSpec));
+
+			if (expectedSignificand == 0)
+			{
+				if (!rounded.IsZero())
+					return rkc::ResultCodes::kInternalError;
+				return Result::Ok();
+			}
+
+			RKC_CHECK_RV(BigUBinFloat_t, expected, MakeRoundingTestValue(expectedSignificand, expectedExponent, alloc));
+			if (rounded != expected)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result NumUtils(IAllocator &alloc)
+		{
+			const rkci::FloatSpec singleSpec(true, 8, 23, 127, true, true);
+
+			// 1 + 2^-24 is a tie between 1 and the next float, and rounds to the even one
+			RKC_CHECK(CheckRoundToFloatSpec((1u << 24) + 1u, -24, 1, 0, singleSpec, alloc));
+
+			// A tie above an odd mantissa rounds up to the even one
+			RKC_CHECK(CheckRoundToFloatSpec((1u << 24) + 3u, -24, (1u << 22) + 1u, -22, singleSpec, alloc));
+
+			// Bits below the rounding bit only break ties
+			RKC_CHECK(CheckRoundToFloatSpec((static_cast<uint64_t>(1) << 30) + 65u, -30, (1u << 23) + 1u, -23, singleSpec, alloc));
+			RKC_CHECK(CheckRoundToFloatSpec((static_cast<uint64_t>(1) << 30) + 33u, -30, 1, 0, singleSpec, alloc));
+
+			// The smallest denormal is 2^-149.  Half of it is a tie with zero, and anything above half
+			// rounds up to it.
+			RKC_CHECK(CheckRoundToFloatSpec(1, -150, 0, 0, singleSpec, alloc));
+			RKC_CHECK(CheckRoundToFloatSpec((1u << 10) + 1u, -160, 1, -149, singleSpec, alloc));
+			RKC_CHECK(CheckRoundToFloatSpec(1, -151, 0, 0, singleSpec, alloc));
+
+			// 1.5 times the smallest denormal rounds to the even denormal
+			RKC_CHECK(CheckRoundToFloatSpec(3, -150, 1, -148, singleSpec, alloc));
+
+			// Denormal mantissas round below the normal mantissa width
+			RKC_CHECK(CheckRoundToFloatSpec((1u << 20) + (1u << 10) + 1u, -160, (1u << 9) + 1u, -149, singleSpec, alloc));
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#include "ArraySliceView.h"
+#include "CoreDefs.h"
+#include "FloatSpec.h"
+#include "KernelIR.h"
+#include "RangeAnalysis.h"
+#include "Result.h"
+#include "SimdCppEmitter.h"
+#include "SimdTarget.h"
+#include "TestTextSearch.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		struct ExpectedValueRange
+		{
+			Kernel::ValueIndex_t m_value;
+			int64_t m_min;
+			int64_t m_max;
+			bool m_mayOverflow;
+			SimdElementFormat m_format;
+		};
+
+		static Result CheckRangeArithmetic()
+		{
+			int64_t result = 0;
+
+			if (!RangeAnalysis::CheckedAdd(INT64_MAX - 1, 1, result) || result != INT64_MAX || RangeAnalysis::CheckedAdd(INT64_MAX, 1, result)
+				|| RangeAnalysis::CheckedAdd(INT64_MIN, -1, result))
+				return rkc::ResultCodes::kInternalError;
+
+			if (!RangeAnalysis::CheckedSub(-1, INT64_MAX, result) || result != INT64_MIN || RangeAnalysis::CheckedSub(-2, INT64_MAX, result)
+				|| RangeAnalysis::CheckedSub(0, INT64_MIN, result))
+				return rkc::ResultCodes::kInternalError;
+
+			if (!RangeAnalysis::CheckedMul(INT64_MIN, 1, result) || result != INT64_MIN || RangeAnalysis::CheckedMul(INT64_MIN, -1, result)
+				|| RangeAnalysis::CheckedMul(0x100000000ll, 0x80000000ll, result) || !RangeAnalysis::CheckedMul(-0x100000000ll, 0x80000000ll, result)
+				|| result != INT64_MIN)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result ValueRanges(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			RKC_CHECK(CheckRangeArithmetic());
+
+			Kernel::Function function(&alloc);
+			RKC_CHECK(function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("ranges"), 6)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(0, 0x7fffffff));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, byteType, function.AddIntType(0, 255));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, smallType, function.AddIntType(-100, 100));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, wideType, function.AddIntType(-100000, 100000));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, floatType, function.AddFloatType(FloatSpec(true, 8, 23, 127, true, true)));
+
+			RKC_CHECK_RV(Kernel::ParamIndex_t, byteParam, function.AddParam(Kernel::ParamKind::kUniform, byteType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, smallParam, function.AddParam(Kernel::ParamKind::kUniform, smallType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, floatParam, function.AddParam(Kernel::ParamKind::kUniform, floatType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, wideType));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, a, function.AddInstruction(Kernel::Opcode::kParam, byteType, N, N, N, byteParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, b, function.AddInstruction(Kernel::Opcode::kParam, smallType, N, N, N, smallParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, wideA, function.AddInstruction(Kernel::Opcode::kConvert, wideType, a, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, wideB, function.AddInstruction(Kernel::Opcode::kConvert, wideType, b, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, three, function.AddInstruction(Kernel::Opcode::kConstant, wideType, N, N, N, 3));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, unsignedSum, function.AddInstruction(Kernel::Opcode::kAdd, wideType, wideA, three, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, signedSum, function.AddInstruction(Kernel::Opcode::kAdd, wideType, wideA, wideB, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, signedDifference, function.AddInstruction(Kernel::Opcode::kSub, wideType, wideB, wideA, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, unsignedDifference, function.AddInstruction(Kernel::Opcode::kSub, wideType, wideA, wideA, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, signedProduct, function.AddInstruction(Kernel::Opcode::kMul, wideType, wideA, wideB, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, unsignedProduct, function.AddInstruction(Kernel::Opcode::kMul, wideType, wideA, wideA, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, overflowingProduct, function.AddInstruction(Kernel::Opcode::kMul, wideType, unsignedProduct, unsignedProduct, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, narrowedSigned, function.AddInstruction(Kernel::Opcode::kConvert, byteType, b, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, floatValue, function.AddInstruction(Kernel::Opcode::kParam, floatType, N, N, N, floatParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, fromFloat, function.AddInstruction(Kernel::Opcode::kConvert, wideType, floatValue, N, N, 0));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, indexType, N, N, N, 0));
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, overflowingProduct, N, outParam).DiscardValue());
+
+			RangeAnalysis ranges(&alloc);
+			RKC_CHECK(ranges.Analyze(function));
+
+			// Values that may overflow keep their declared range and format, and the rest get the narrowest
+			// format that holds their range
+			const ExpectedValueRange expected[] =
+			{
+				{ a, 0, 255, false, SimdElementFormat::kUInt8 },
+				{ b, -100, 100, false, SimdElementFormat::kInt8 },
+				{ wideA, 0, 255, false, SimdElementFormat::kUInt8 },
+				{ wideB, -100, 100, false, SimdElementFormat::kInt8 },
+				{ three, 3, 3, false, SimdElementFormat::kUInt8 },
+				{ unsignedSum, 3, 258, false, SimdElementFormat::kUInt16 },
+				{ signedSum, -100, 355, false, SimdElementFormat::kInt16 },
+				{ signedDifference, -355, 100, false, SimdElementFormat::kInt16 },
+				{ unsignedDifference, -255, 255, false, SimdElementFormat::kInt16 },
+				{ signedProduct, -25500, 25500, false, SimdElementFormat::kInt16 },
+				{ unsignedProduct, 0, 65025, false, SimdElementFormat::kUInt16 },
+				{ overflowingProduct, -100000, 100000, true, SimdElementFormat::kInt32 },
+				{ narrowedSigned, 0, 255, true, SimdElementFormat::kUInt8 },
+				{ fromFloat, -100000, 100000, true, SimdElementFormat::kInt32 },
+			};
+
+			for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+			{
+				const ExpectedValueRange &expectedRange = expected[i];
+				const RangeAnalysis::Range &range = ranges.GetRange(expectedRange.m_value);
+
+				if (range.m_min != expectedRange.m_min || range.m_max != expectedRange.m_max || ranges.MayOverflow(expectedRange.m_value) != expectedRange.m_mayOverflow)
+					return rkc::ResultCodes::kInternalError;
+
+				if (SimdTarget::SelectIntFormat(range.m_min, range.m_max) != expectedRange.m_format)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Overflowing results still have an exact range unless they can leave 64 bits or come from a float
+			RangeAnalysis::Range exactRange;
+			if (!ranges.GetExactRange(overflowingProduct, exactRange) || exactRange.m_min != 0 || exactRange.m_max != 65025ll * 65025ll)
+				return rkc::ResultCodes::kInternalError;
+
+			if (!ranges.GetExactRange(narrowedSigned, exactRange) || exactRange.m_min != -100 || exactRange.m_max != 100)
+				return rkc::ResultCodes::kInternalError;
+
+			if (ranges.GetExactRange(fromFloat, exactRange))
+				return rkc::ResultCodes::kInternalError;
+
+			// The backend holds each value in the lanes chosen for its range
+			SimdCppEmitter emitter(&alloc, SimdTarget(SimdIsa::kSSE42, 4));
+			Vector<uint8_t> text(&alloc);
+			RKC_CHECK(emitter.Emit(function, text));
+
+			const char *const declarations[] =
+			{
+				"const rkcv_u8x4 v2 = ",
+				"const rkcv_i8x4 v3 = ",
+				"const rkcv_u16x4 v5 = ",
+				"const rkcv_i16x4 v6 = ",
+				"const rkcv_i16x4 v7 = ",
+				"const rkcv_i16x4 v8 = ",
+				"const rkcv_i16x4 v9 = ",
+				"const rkcv_u16x4 v10 = ",
+				"const rkcv_i32x4 v11 = ",
+				"const rkcv_u8x4 v12 = ",
+				"const rkcv_i32x4 v14 = ",
+			};
+
+			for (size_t i = 0; i < sizeof(declarations) / sizeof(declarations[0]); i++)
+			{
+				if (!EmittedTextContains(text, declarations[i]))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#include "ArraySliceView.h"
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Result.h"
+#include "SimdCppEmitter.h"
+#include "SimdTarget.h"
+#include "TestTextSearch.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// out[i] = in[i] * in[i], which can't leave its declared range, and optionally out[i] = in[i] * in[i] * in[i],
+		// which can
+		static Result BuildRangeCheckKernel(Kernel::Function &function, bool mayOverflow)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			RKC_CHECK(function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("checked"), 7)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(0, 0x7fffffff));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, smallType, function.AddIntType(-100, 100));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, wideType, function.AddIntType(-100000, 100000));
+
+			RKC_CHECK_RV(Kernel::ParamIndex_t, inParam, function.AddParam(Kernel::ParamKind::kInputBuffer, smallType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, wideType));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, indexType, N, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, in, function.AddInstruction(Kernel::Opcode::kLoad, smallType, laneIndex, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, wideIn, function.AddInstruction(Kernel::Opcode::kConvert, wideType, in, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, square, function.AddInstruction(Kernel::Opcode::kMul, wideType, wideIn, wideIn, N, 0));
+
+			Kernel::ValueIndex_t result = square;
+			if (mayOverflow)
+			{
+				RKC_CHECK_RV(Kernel::ValueIndex_t, cube, function.AddInstruction(Kernel::Opcode::kMul, wideType, square, wideIn, N, 0));
+				result = cube;
+			}
+
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, result, N, outParam).DiscardValue());
+
+			return Result::Ok();
+		}
+
+		static Result EmitRangeCheckKernel(IAllocator &alloc, const SimdTarget &target, bool mayOverflow, bool rangeChecks, Vector<uint8_t> &text)
+		{
+			Kernel::Function function(&alloc);
+			RKC_CHECK(BuildRangeCheckKernel(function, mayOverflow));
+
+			SimdCppEmitter emitter(&alloc, target);
+			emitter.SetRangeChecks(rangeChecks);
+
+			return emitter.Emit(function, text);
+		}
+
+		static Result CheckRangeCheckKernels(IAllocator &alloc, const SimdTarget &target)
+		{
+			// The blocks return which lanes left their range, and the entry point returns nonzero if any did
+			{
+				Vector<uint8_t> text(&alloc);
+				RKC_CHECK(EmitRangeCheckKernel(alloc, target, true, true, text));
+
+				if (!EmittedTextContains(text, "static inline uint32_t checked_block(")
+					|| !EmittedTextContains(text, "extern \"C\" int checked(size_t count, const int8_t *p0, size_t p0len, int32_t *p1, size_t p1len)")
+					|| !EmittedTextContains(text, "\tuint32_t errorBits = 0;\n")
+					|| !EmittedTextContains(text, "errorBits |= checked_block<false>(")
+					|| !EmittedTextContains(text, "errorBits |= checked_block<true>(")
+					|| !EmittedTextContains(text, "\treturn (errorBits != 0) ? 1 : 0;\n"))
+					return rkc::ResultCodes::kInternalError;
+
+				// Only the product that can overflow is checked, against both ends of its declared range
+				if (!EmittedTextContainsLanes(text, "rkcm_32x%u err32 = rkcm_32x%u_frombits(0);", target)
+					|| !EmittedTextContainsLanes(text, "rkcv_i32x%u_cmplt(v4, rkcv_i32x%u_splat((int32_t)(-100000ll)))", target)
+					|| !EmittedTextContainsLanes(text, "rkcv_i32x%u_cmpgt(v4, rkcv_i32x%u_splat((int32_t)100000ull))", target)
+					|| !EmittedTextContainsLanes(text, "\treturn (rkcm_32x%u_tobits(err32)) & ", target))
+					return rkc::ResultCodes::kInternalError;
+
+				if (EmittedTextContains(text, "(v3, "))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// When nothing can overflow, there's nothing to check, but the entry point still reports
+			{
+				Vector<uint8_t> text(&alloc);
+				RKC_CHECK(EmitRangeCheckKernel(alloc, target, false, true, text));
+
+				if (!EmittedTextContains(text, "extern \"C\" int checked(")
+					|| !EmittedTextContains(text, "\treturn 0;\n}\n")
+					|| EmittedTextContains(text, " err8 = ") || EmittedTextContains(text, " err16 = ")
+					|| EmittedTextContains(text, " err32 = ") || EmittedTextContains(text, " err64 = ")
+					|| EmittedTextContains(text, "_cmplt(v") || EmittedTextContains(text, "_cmpgt(v"))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Without range checks, overflowing values aren't checked and nothing is returned
+			{
+				Vector<uint8_t> text(&alloc);
+				RKC_CHECK(EmitRangeCheckKernel(alloc, target, true, false, text));
+
+				if (!EmittedTextContains(text, "static inline void checked_block(")
+					|| !EmittedTextContains(text, "extern \"C\" void checked(size_t count, const int8_t *p0, size_t p0len, int32_t *p1, size_t p1len)")
+					|| EmittedTextContains(text, "errorBits") || EmittedTextContains(text, " err32 = "))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		Result RangeCheckText(IAllocator &alloc)
+		{
+			const SimdTarget targets[] =
+			{
+				SimdTarget(SimdIsa::kSSE42, 4),
+				SimdTarget(SimdIsa::kAVX2, 8),
+				SimdTarget(SimdIsa::kAVX512, 16),
+			};
+
+			for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+			{
+				RKC_CHECK(CheckRangeCheckKernels(alloc, targets[i]));
+			}
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,389 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "IStream.h"
+#include "ReadAheadStream.h"
+#include "RkcContext.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// Holds the first read of each stream until every expected stream is being read at the same time
+		struct ReadAheadTestRendezvous
+		{
+			std::mutex m_mutex;
+			std::condition_variable m_arrived;
+			size_t m_numExpected;
+			size_t m_numArrived;
+			bool m_timedOut;
+
+			explicit ReadAheadTestRendezvous(size_t numExpected);
+
+			void Arrive();
+		};
+
+		ReadAheadTestRendezvous::ReadAheadTestRendezvous(size_t numExpected)
+			: m_numExpected(numExpected)
+			, m_numArrived(0)
+			, m_timedOut(false)
+		{
+		}
+
+		void ReadAheadTestRendezvous::Arrive()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_numArrived++;
+			m_arrived.notify_all();
+
+			if (!m_arrived.wait_for(lock, std::chrono::seconds(10), [this] { return m_numArrived >= m_numExpected; }))
+				m_timedOut = true;
+		}
+
+		// Produces a known byte pattern in short reads, and records the thread that read it
+		class ReadAheadTestStream final : public IStream
+		{
+		public:
+			ReadAheadTestStream(size_t size, size_t maxReadSize, uint8_t seed);
+
+			size_t Read(void *buf, size_t size) override;
+			size_t Write(void *buf, size_t size) override;
+			rkcUFilePos_t Tell() const override;
+			bool SeekStart(rkcUFilePos_t pos) override;
+			bool SeekEnd(rkcFilePos_t pos) override;
+			bool SeekCurrent(rkcFilePos_t pos) override;
+			bool IsReadable() const override;
+			bool IsWritable() const override;
+			void Close() override;
+
+			static uint8_t GetExpectedByte(uint8_t seed, size_t pos);
+
+			size_t m_size;
+			size_t m_maxReadSize;
+			size_t m_position;
+			uint8_t m_seed;
+			std::thread::id m_readThreadId;
+			bool m_isReadOnManyThreads;
+			ReadAheadTestRendezvous *m_rendezvous;
+		};
+
+		ReadAheadTestStream::ReadAheadTestStream(size_t size, size_t maxReadSize, uint8_t seed)
+			: m_size(size)
+			, m_maxReadSize(maxReadSize)
+			, m_position(0)
+			, m_seed(seed)
+			, m_isReadOnManyThreads(false)
+			, m_rendezvous(nullptr)
+		{
+		}
+
+		size_t ReadAheadTestStream::Read(void *buf, size_t size)
+		{
+			if (m_readThreadId == std::thread::id())
+				m_readThreadId = std::this_thread::get_id();
+			else if (m_readThreadId != std::this_thread::get_id())
+				m_isReadOnManyThreads = true;
+
+			if (m_rendezvous && m_position == 0)
+				m_rendezvous->Arrive();
+
+			if (size > m_maxReadSize)
+				size = m_maxReadSize;
+			if (size > m_size - m_position)
+				size = m_size - m_position;
+
+			uint8_t *bytes = static_cast<uint8_t*>(buf);
+			for (size_t i = 0; i < size; i++)
+				bytes[i] = GetExpectedByte(m_seed, m_position + i);
+
+			m_position += size;
+			return size;
+		}
+
+		size_t ReadAheadTestStream::Write(void *, size_t)
+		{
+			return 0;
+		}
+
+		rkcUFilePos_t ReadAheadTestStream::Tell() const
+		{
+			return m_position;
+		}
+
+		bool ReadAheadTestStream::SeekStart(rkcUFilePos_t)
+		{
+			return false;
+		}
+
+		bool ReadAheadTestStream::SeekEnd(rkcFilePos_t)
+		{
+			return false;
+		}
+
+		bool ReadAheadTestStream::SeekCurrent(rkcFilePos_t)
+		{
+			return false;
+		}
+
+		bool ReadAheadTestStream::IsReadable() const
+		{
+			return true;
+		}
+
+		bool ReadAheadTestStream::IsWritable() const
+		{
+			return false;
+		}
+
+		void ReadAheadTestStream::Close()
+		{
+		}
+
+		uint8_t ReadAheadTestStream::GetExpectedByte(uint8_t seed, size_t pos)
+		{
+			return static_cast<uint8_t>((pos * 31 + (pos >> 8) + seed) & 0xff);
+		}
+
+		// Reads the whole stream in reads of varying sizes, checking the bytes and the position
+		static bool ReadAheadStreamMatches(ReadAheadStream &stream, size_t size, uint8_t seed)
+		{
+			uint8_t readBuffer[100];
+			size_t position = 0;
+			size_t readSize = 1;
+
+			for (;;)
+			{
+				const size_t numRead = stream.Read(readBuffer, readSize);
+				if (numRead == 0)
+					break;
+
+				for (size_t i = 0; i < numRead; i++)
+				{
+					if (readBuffer[i] != ReadAheadTestStream::GetExpectedByte(seed, position + i))
+						return false;
+				}
+
+				position += numRead;
+				if (stream.Tell() != position)
+					return false;
+
+				readSize = (readSize * 7 + 3) % sizeof(readBuffer) + 1;
+			}
+
+			// The end stays the end
+			return position == size && stream.Read(readBuffer, sizeof(readBuffer)) == 0;
+		}
+
+		struct ReadAheadTestWorker
+		{
+			ReadAheadPool *m_pool;
+			IAllocator *m_alloc;
+			ReadAheadTestStream *m_baseStream;
+			size_t m_bufferSize;
+			std::thread::id m_workerThreadId;
+			bool m_succeeded;
+		};
+
+		static void RunReadAheadTestWorker(ReadAheadTestWorker *worker)
+		{
+			worker->m_workerThreadId = std::this_thread::get_id();
+
+			ReadAheadStream stream(*worker->m_baseStream, *worker->m_pool, worker->m_alloc, worker->m_bufferSize);
+
+			Result startResult(stream.Start());
+			worker->m_succeeded = startResult.IsOK() && ReadAheadStreamMatches(stream, worker->m_baseStream->m_size, worker->m_baseStream->m_seed);
+			startResult.Handle();
+		}
+
+		static Result CheckReadAheadSingleStream(IAllocator &alloc)
+		{
+			ReadAheadPool pool(0);
+
+			// Sizes around multiples of the buffer size, including an empty stream
+			const size_t sizes[] = { 0, 1, 63, 64, 65, 128, 1000 };
+			for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+			{
+				ReadAheadTestStream baseStream(sizes[i], 7, static_cast<uint8_t>(i));
+				ReadAheadStream stream(baseStream, pool, &alloc, 64);
+				RKC_CHECK(stream.Start());
+
+				if (!ReadAheadStreamMatches(stream, sizes[i], static_cast<uint8_t>(i)))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			// Destroying a stream that was only partly read stops its reads
+			{
+				ReadAheadTestStream baseStream(100000, 4096, 9);
+				ReadAheadStream stream(baseStream, pool, &alloc, 64);
+				RKC_CHECK(stream.Start());
+
+				uint8_t byte = 0;
+				if (stream.Read(&byte, 1) != 1 || byte != ReadAheadTestStream::GetExpectedByte(9, 0))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+#if !RKC_IS_DEBUG
+			{
+				ReadAheadTestStream baseStream(10, 10, 0);
+				ReadAheadStream stream(baseStream, pool, &alloc, 0);
+
+				Result startResult(stream.Start());
+				startResult.Handle();
+
+				if (startResult.GetCode() != rkc::ResultCodes::kInvalidOperation)
+					return rkc::ResultCodes::kInternalError;
+			}
+#endif
+
+			return Result::Ok();
+		}
+
+		// Streams read at the same time on several threads share a pool limited to one thread
+		static Result CheckReadAheadSharedThread(IAllocator &alloc)
+		{
+			const size_t kNumWorkers = 4;
+
+			ReadAheadPool pool(1);
+			ReadAheadTestStream baseStreams[kNumWorkers] =
+			{
+				ReadAheadTestStream(5000, 13, 1),
+				ReadAheadTestStream(3000, 64, 2),
+				ReadAheadTestStream(7000, 5, 3),
+				ReadAheadTestStream(100, 1, 4),
+			};
+
+			ReadAheadTestWorker workers[kNumWorkers];
+			std::thread workerThreads[kNumWorkers];
+
+			for (size_t i = 0; i < kNumWorkers; i++)
+			{
+				workers[i].m_pool = &pool;
+				workers[i].m_alloc = &alloc;
+				workers[i].m_baseStream = &baseStreams[i];
+				workers[i].m_bufferSize = 32 + i * 16;
+				workers[i].m_succeeded = false;
+
+				workerThreads[i] = std::thread(RunReadAheadTestWorker, &workers[i]);
+			}
+
+			for (size_t i = 0; i < kNumWorkers; i++)
+				workerThreads[i].join();
+
+			for (size_t i = 0; i < kNumWorkers; i++)
+			{
+				if (!workers[i].m_succeeded || baseStreams[i].m_isReadOnManyThreads)
+					return rkc::ResultCodes::kInternalError;
+
+				if (baseStreams[i].m_readThreadId != baseStreams[0].m_readThreadId || baseStreams[i].m_readThreadId == workers[i].m_workerThreadId)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		// Each stream's first read blocks until every stream is being read, which only finishes if the pool
+		// has a thread for each of them
+		static Result CheckReadAheadConcurrentFills(IAllocator &alloc)
+		{
+			const size_t kNumWorkers = 4;
+
+			ReadAheadPool pool(kNumWorkers);
+			ReadAheadTestRendezvous rendezvous(kNumWorkers);
+			ReadAheadTestStream baseStreams[kNumWorkers] =
+			{
+				ReadAheadTestStream(2000, 100, 5),
+				ReadAheadTestStream(3000, 7, 6),
+				ReadAheadTestStream(1000, 64, 7),
+				ReadAheadTestStream(500, 3, 8),
+			};
+
+			ReadAheadTestWorker workers[kNumWorkers];
+			std::thread workerThreads[kNumWorkers];
+
+			for (size_t i = 0; i < kNumWorkers; i++)
+			{
+				baseStreams[i].m_rendezvous = &rendezvous;
+
+				workers[i].m_pool = &pool;
+				workers[i].m_alloc = &alloc;
+				workers[i].m_baseStream = &baseStreams[i];
+				workers[i].m_bufferSize = 64;
+				workers[i].m_succeeded = false;
+
+				workerThreads[i] = std::thread(RunReadAheadTestWorker, &workers[i]);
+			}
+
+			for (size_t i = 0; i < kNumWorkers; i++)
+				workerThreads[i].join();
+
+			if (rendezvous.m_timedOut)
+				return rkc::ResultCodes::kInternalError;
+
+			// Later buffers of a stream may be filled by any thread, but the first reads were all in flight at once
+			for (size_t i = 0; i < kNumWorkers; i++)
+			{
+				if (!workers[i].m_succeeded)
+					return rkc::ResultCodes::kInternalError;
+
+				for (size_t j = 0; j < i; j++)
+				{
+					if (baseStreams[i].m_readThreadId == baseStreams[j].m_readThreadId)
+						return rkc::ResultCodes::kInternalError;
+				}
+			}
+
+			// The thread limit is clamped, and 0 selects the default
+			if (ReadAheadPool(0).GetMaxThreads() != ReadAheadPool::kDefaultMaxThreads || ReadAheadPool(1000).GetMaxThreads() != ReadAheadPool::kMaxThreads)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		// Options structs from hosts built against an older header only have the fields that existed then
+		static Result CheckReadAheadContextOptions()
+		{
+			RkcContextOptions options;
+			options.m_structSize = sizeof(RkcContextOptions);
+			options.m_trackAllocations = 1;
+			options.m_readAheadBufferSize = 4096;
+			options.m_lexerBufferSize = 100;
+			options.m_readAheadThreads = 3;
+
+			RkcContextOptions readOptions;
+			if (!IRkcContext::ReadOptions(&options, readOptions) || readOptions.m_readAheadBufferSize != 4096 || readOptions.m_lexerBufferSize != 100 || readOptions.m_readAheadThreads != 3)
+				return rkc::ResultCodes::kInternalError;
+
+			options.m_structSize = offsetof(RkcContextOptions, m_readAheadBufferSize);
+			if (!IRkcContext::ReadOptions(&options, readOptions))
+				return rkc::ResultCodes::kInternalError;
+
+			if (readOptions.m_structSize != sizeof(RkcContextOptions) || readOptions.m_trackAllocations != 1 || readOptions.m_readAheadBufferSize != 0 || readOptions.m_lexerBufferSize != 0 || readOptions.m_readAheadThreads != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			options.m_structSize = 0;
+			if (IRkcContext::ReadOptions(&options, readOptions))
+				return rkc::ResultCodes::kInternalError;
+
+			if (!IRkcContext::ReadOptions(nullptr, readOptions) || readOptions.m_trackAllocations != 0 || readOptions.m_readAheadBufferSize != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result ReadAhead(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckReadAheadSingleStream(alloc));
+			RKC_CHECK(CheckReadAheadSharedThread(alloc));
+			RKC_CHECK(CheckReadAheadConcurrentFills(alloc));
+			RKC_CHECK(CheckReadAheadContextOptions());
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,286 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "RkcContext.h"
+#include "RkcLexer.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// Read-only host stream over a string
+		class LexerBatchTestSource
+		{
+		public:
+			explicit LexerBatchTestSource(const char *text);
+
+			RkcStreamSpec GetStreamSpec();
+
+		private:
+			static size_t SpecRead(void *userdata, void *buf, size_t size);
+			static size_t SpecWrite(void *userdata, const void *buf, size_t size);
+			static rkcUFilePos_t SpecTell(void *userdata);
+			static int SpecSeekStart(void *userdata, rkcUFilePos_t pos);
+			static int SpecSeekEnd(void *userdata, rkcFilePos_t pos);
+			static int SpecSeekCurrent(void *userdata, rkcFilePos_t pos);
+			static void SpecClose(void *userdata);
+
+			static RkcStreamFunctions ms_specFunctions;
+
+			const char *m_text;
+			size_t m_size;
+			size_t m_pos;
+		};
+
+		RkcStreamFunctions LexerBatchTestSource::ms_specFunctions =
+		{
+			LexerBatchTestSource::SpecRead,
+			LexerBatchTestSource::SpecWrite,
+			LexerBatchTestSource::SpecTell,
+			LexerBatchTestSource::SpecSeekStart,
+			LexerBatchTestSource::SpecSeekEnd,
+			LexerBatchTestSource::SpecSeekCurrent,
+			LexerBatchTestSource::SpecClose,
+		};
+
+		LexerBatchTestSource::LexerBatchTestSource(const char *text)
+			: m_text(text)
+			, m_size(strlen(text))
+			, m_pos(0)
+		{
+		}
+
+		RkcStreamSpec LexerBatchTestSource::GetStreamSpec()
+		{
+			RkcStreamSpec spec;
+			spec.m_functions = &ms_specFunctions;
+			spec.m_permissions = RkcStreamPermission_Read;
+			spec.m_userdata = this;
+
+			return spec;
+		}
+
+		size_t LexerBatchTestSource::SpecRead(void *userdata, void *buf, size_t size)
+		{
+			LexerBatchTestSource *source = static_cast<LexerBatchTestSource*>(userdata);
+
+			const size_t available = source->m_size - source->m_pos;
+			if (size > available)
+				size = available;
+
+			if (size > 0)
+				memcpy(buf, source->m_text + source->m_pos, size);
+
+			source->m_pos += size;
+			return size;
+		}
+
+		size_t LexerBatchTestSource::SpecWrite(void *, const void *, size_t)
+		{
+			return 0;
+		}
+
+		rkcUFilePos_t LexerBatchTestSource::SpecTell(void *userdata)
+		{
+			return static_cast<const LexerBatchTestSource*>(userdata)->m_pos;
+		}
+
+		int LexerBatchTestSource::SpecSeekStart(void *, rkcUFilePos_t)
+		{
+			return 0;
+		}
+
+		int LexerBatchTestSource::SpecSeekEnd(void *, rkcFilePos_t)
+		{
+			return 0;
+		}
+
+		int LexerBatchTestSource::SpecSeekCurrent(void *, rkcFilePos_t)
+		{
+			return 0;
+		}
+
+		void LexerBatchTestSource::SpecClose(void *)
+		{
+		}
+
+		struct LexerBatchExpectedToken
+		{
+			rkc::TokenType_t m_tokenType;
+			rkcUFilePos_t m_startOffset;
+			rkcUFilePos_t m_endOffset;
+			size_t m_line;
+			size_t m_col;
+		};
+
+		static const char *const kLexerBatchSource =
+			"x = \"s\" // note\n"
+			"/* a * b / c */ 0x1F 'q'\n";
+
+		static const LexerBatchExpectedToken kLexerBatchExpectedTokens[] =
+		{
+			{ rkc::TokenTypes::kName, 0, 1, 0, 0 },
+			{ rkc::TokenTypes::kWhitespace, 1, 2, 0, 1 },
+			{ rkc::TokenTypes::kPunctuation, 2, 3, 0, 2 },
+			{ rkc::TokenTypes::kWhitespace, 3, 4, 0, 3 },
+			{ rkc::TokenTypes::kString, 4, 7, 0, 4 },
+			{ rkc::TokenTypes::kWhitespace, 7, 8, 0, 7 },
+			{ rkc::TokenTypes::kLineComment, 8, 15, 0, 8 },
+			{ rkc::TokenTypes::kEndOfLine, 15, 16, 0, 15 },
+			{ rkc::TokenTypes::kBlockComment, 16, 31, 1, 0 },
+			{ rkc::TokenTypes::kWhitespace, 31, 32, 1, 15 },
+			{ rkc::TokenTypes::kNumber, 32, 36, 1, 16 },
+			{ rkc::TokenTypes::kWhitespace, 36, 37, 1, 20 },
+			{ rkc::TokenTypes::kCharacterLiteral, 37, 40, 1, 21 },
+			{ rkc::TokenTypes::kEndOfLine, 40, 41, 1, 24 },
+			{ rkc::TokenTypes::kEndOfFile, 41, 41, 2, 0 },
+		};
+
+		static void *LexerBatchTestRealloc(void *userdata, void *buf, size_t newSize)
+		{
+			return static_cast<IAllocator*>(userdata)->Realloc(buf, newSize);
+		}
+
+		static RkcContextOptions GetLexerBatchContextOptions()
+		{
+			RkcContextOptions options;
+			options.m_structSize = sizeof(RkcContextOptions);
+			options.m_trackAllocations = 0;
+			options.m_readAheadBufferSize = 0;
+			options.m_lexerBufferSize = 0;
+			options.m_readAheadThreads = 0;
+
+			return options;
+		}
+
+		// Any batch size produces the same tokens, with the end of file token last and nothing after it
+		static Result CheckLexerBatchSizes(IRkcContext &context)
+		{
+			const size_t numExpected = sizeof(kLexerBatchExpectedTokens) / sizeof(kLexerBatchExpectedTokens[0]);
+			const size_t batchSizes[] = { 1, 2, 4, numExpected, 100 };
+
+			for (size_t i = 0; i < sizeof(batchSizes) / sizeof(batchSizes[0]); i++)
+			{
+				LexerBatchTestSource source(kLexerBatchSource);
+				const RkcStreamSpec streamSpec = source.GetStreamSpec();
+
+				RkcLexerOptions lexerOptions;
+				if (!IRkcLexer::ReadOptions(nullptr, lexerOptions))
+					return rkc::ResultCodes::kInternalError;
+
+				IRkcLexer lexer(context, streamSpec, lexerOptions);
+
+				RkcToken tokens[100];
+				size_t numTokens = 0;
+
+				for (;;)
+				{
+					size_t numBatchTokens = 0;
+					RKC_CHECK(lexer.LexBatch(tokens + numTokens, batchSizes[i], numBatchTokens));
+
+					if (numBatchTokens > batchSizes[i])
+						return rkc::ResultCodes::kInternalError;
+
+					numTokens += numBatchTokens;
+					if (numBatchTokens == 0)
+						break;
+				}
+
+				if (numTokens != numExpected)
+					return rkc::ResultCodes::kInternalError;
+
+				for (size_t j = 0; j < numTokens; j++)
+				{
+					const LexerBatchExpectedToken &expected = kLexerBatchExpectedTokens[j];
+					const RkcToken &token = tokens[j];
+
+					if (token.m_tokenType != expected.m_tokenType || token.m_startOffset != expected.m_startOffset || token.m_endOffset != expected.m_endOffset
+						|| token.m_line != expected.m_line || token.m_col != expected.m_col || token.m_errorCode != 0)
+						return rkc::ResultCodes::kInternalError;
+				}
+			}
+
+			return Result::Ok();
+		}
+
+		// With error recovery, malformed lines become error tokens and lexing carries on
+		static Result CheckLexerBatchRecovery(IRkcContext &context)
+		{
+			LexerBatchTestSource source("a \x01\nb\n");
+			const RkcStreamSpec streamSpec = source.GetStreamSpec();
+
+			RkcLexerOptions lexerOptions;
+			lexerOptions.m_structSize = sizeof(RkcLexerOptions);
+			lexerOptions.m_recoverFromErrors = 1;
+
+			IRkcLexer lexer(context, streamSpec, lexerOptions);
+
+			RkcToken tokens[16];
+			size_t numTokens = 0;
+			RKC_CHECK(lexer.LexBatch(tokens, 16, numTokens));
+
+			// a, whitespace, error, line break, b, line break, end of file
+			if (numTokens != 7 || tokens[2].m_tokenType != rkc::TokenTypes::kError || tokens[2].m_errorCode != rkc::ResultCodes::kLexGarbageCharacter)
+				return rkc::ResultCodes::kInternalError;
+
+			if (tokens[4].m_tokenType != rkc::TokenTypes::kName || tokens[6].m_tokenType != rkc::TokenTypes::kEndOfFile)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+#if !RKC_IS_DEBUG
+		// Without error recovery, the tokens before the error are written, and the error is returned again by
+		// every later batch
+		static Result CheckLexerBatchStickyError(IRkcContext &context)
+		{
+			LexerBatchTestSource source("a \x01 b\nc\n");
+			const RkcStreamSpec streamSpec = source.GetStreamSpec();
+
+			RkcLexerOptions lexerOptions;
+			lexerOptions.m_structSize = sizeof(RkcLexerOptions);
+			lexerOptions.m_recoverFromErrors = 0;
+
+			IRkcLexer lexer(context, streamSpec, lexerOptions);
+
+			RkcToken tokens[16];
+			size_t numTokens = 0;
+
+			Result firstResult(lexer.LexBatch(tokens, 16, numTokens));
+			firstResult.Handle();
+
+			if (firstResult.GetCode() != rkc::ResultCodes::kLexGarbageCharacter || numTokens != 2)
+				return rkc::ResultCodes::kInternalError;
+
+			for (int i = 0; i < 2; i++)
+			{
+				Result laterResult(lexer.LexBatch(tokens, 16, numTokens));
+				laterResult.Handle();
+
+				if (laterResult.GetCode() != firstResult.GetCode() || numTokens != 0)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+#endif
+
+		Result LexerBatches(IAllocator &alloc)
+		{
+			RkcAllocatorSpec allocSpec;
+			allocSpec.m_realloc = LexerBatchTestRealloc;
+			allocSpec.m_userdata = &alloc;
+
+			IRkcContext context(allocSpec, GetLexerBatchContextOptions());
+
+			RKC_CHECK(CheckLexerBatchSizes(context));
+			RKC_CHECK(CheckLexerBatchRecovery(context));
+#if !RKC_IS_DEBUG
+			RKC_CHECK(CheckLexerBatchStickyError(context));
+#endif
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,168 @@
+#include "ArraySliceView.h"
+#include "CoreDefs.h"
+#include "FloatSpec.h"
+#include "KernelIR.h"
+#include "Result.h"
+#include "SimdCppEmitter.h"
+#include "SimdTarget.h"
+#include "TestTextSearch.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// out[i] = in[i] + scale, with a constant that nothing reads
+		static Result BuildSimdLaneKernel(Kernel::Function &function)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			RKC_CHECK(function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("lanes"), 5)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(0, 0x7fffffff));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, floatType, function.AddFloatType(FloatSpec(true, 8, 23, 127, true, true)));
+
+			RKC_CHECK_RV(Kernel::ParamIndex_t, inParam, function.AddParam(Kernel::ParamKind::kInputBuffer, floatType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, scaleParam, function.AddParam(Kernel::ParamKind::kUniform, floatType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, floatType));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, indexType, N, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, in, function.AddInstruction(Kernel::Opcode::kLoad, floatType, laneIndex, N, N, inParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, scale, function.AddInstruction(Kernel::Opcode::kParam, floatType, N, N, N, scaleParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, sum, function.AddInstruction(Kernel::Opcode::kAdd, floatType, in, scale, N, 0));
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kConstant, floatType, N, N, N, 0).DiscardValue());
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, sum, N, outParam).DiscardValue());
+
+			return Result::Ok();
+		}
+
+		// out[i] = in[indexes[i]]
+		static Result BuildSimdGatherKernel(Kernel::Function &function)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+
+			RKC_CHECK(function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("gather"), 6)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, laneIndexType, function.AddIntType(0, 0x7fffffff));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(-100000, 100000));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, floatType, function.AddFloatType(FloatSpec(true, 8, 23, 127, true, true)));
+
+			RKC_CHECK_RV(Kernel::ParamIndex_t, inParam, function.AddParam(Kernel::ParamKind::kInputBuffer, floatType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, indexesParam, function.AddParam(Kernel::ParamKind::kInputBuffer, indexType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, floatType));
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, laneIndexType, N, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, index, function.AddInstruction(Kernel::Opcode::kLoad, indexType, laneIndex, N, N, indexesParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, in, function.AddInstruction(Kernel::Opcode::kLoad, floatType, index, N, N, inParam));
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kStore, Kernel::kInvalidTypeIndex, laneIndex, in, N, outParam).DiscardValue());
+
+			return Result::Ok();
+		}
+
+		static Result CheckSimdLaneKernel(IAllocator &alloc, const SimdTarget &target)
+		{
+			Kernel::Function function(&alloc);
+			RKC_CHECK(BuildSimdLaneKernel(function));
+
+			SimdCppEmitter emitter(&alloc, target);
+			Vector<uint8_t> text(&alloc);
+			RKC_CHECK(emitter.Emit(function, text));
+
+			if (!EmittedTextContains(text, "extern \"C\" void lanes(size_t count, const float *p0, size_t p0len, float p1, float *p2, size_t p2len)"))
+				return rkc::ResultCodes::kInternalError;
+
+			// Whole vectors up to the end of the shorter buffer, then partial vectors for the remainder
+			if (!EmittedTextContains(text, "\tif (p0len < fullCount)\n\t\tfullCount = p0len;\n")
+				|| !EmittedTextContains(text, "\tif (p2len < fullCount)\n\t\tfullCount = p2len;\n")
+				|| !EmittedTextContainsLanes(text, "for (; fullCount - laneBase >= %u; laneBase += %u)", target)
+				|| !EmittedTextContainsLanes(text, "lanes_block<false>(laneBase, %u, p0, p0len, p1, p2, p2len);", target)
+				|| !EmittedTextContains(text, "lanes_block<true>(laneBase, numActive, p0, p0len, p1, p2, p2len);"))
+				return rkc::ResultCodes::kInternalError;
+
+			// Loads and stores at the lane index move the block's own elements, so the index itself is unused,
+			// and only partial vectors check the buffers' lengths
+			if (!EmittedTextContainsLanes(text, "const rkcv_f32x%u v1 = TIsTail ? rkcv_f32x%u_loadrun(p0, laneBase, activeBits, p0len) : rkcv_f32x%u_load(p0 + laneBase);", target)
+				|| !EmittedTextContainsLanes(text, "if (TIsTail) rkcv_f32x%u_storerun(p2, laneBase, v3, activeBits, p2len); else rkcv_f32x%u_store(p2 + laneBase, v3);", target))
+				return rkc::ResultCodes::kInternalError;
+
+			if (!EmittedTextContainsLanes(text, "const rkcv_f32x%u v2 = rkcv_f32x%u_splat(p1);", target)
+				|| !EmittedTextContainsLanes(text, "const rkcv_f32x%u v3 = rkcv_f32x%u_add(v1, v2);", target))
+				return rkc::ResultCodes::kInternalError;
+
+			// Values that nothing reads are cast to void, and only those
+			if (!EmittedTextContains(text, "\t(void)v0;\n") || !EmittedTextContains(text, "\t(void)v4;\n")
+				|| EmittedTextContains(text, "(void)v1;") || EmittedTextContains(text, "(void)v2;") || EmittedTextContains(text, "(void)v3;"))
+				return rkc::ResultCodes::kInternalError;
+
+			// Arbitrary indexes aren't used, so there are no gather helpers
+			if (EmittedTextContains(text, "_gather("))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		static Result CheckSimdGatherKernel(IAllocator &alloc, const SimdTarget &target)
+		{
+			Kernel::Function function(&alloc);
+			RKC_CHECK(BuildSimdGatherKernel(function));
+
+			SimdCppEmitter emitter(&alloc, target);
+			Vector<uint8_t> text(&alloc);
+			RKC_CHECK(emitter.Emit(function, text));
+
+			if (!EmittedTextContains(text, "extern \"C\" void gather(size_t count, const float *p0, size_t p0len, const int32_t *p1, size_t p1len, float *p2, size_t p2len)"))
+				return rkc::ResultCodes::kInternalError;
+
+			// Gathered lanes are checked against the gathered buffer's own length, which doesn't end whole vectors
+			if (!EmittedTextContainsLanes(text, "const rkcv_f32x%u v2 = rkcv_f32x%u_gather(p0, v1, activeBits, p0len);", target)
+				|| EmittedTextContains(text, "if (p0len < fullCount)")
+				|| !EmittedTextContains(text, "\tif (p1len < fullCount)\n") || !EmittedTextContains(text, "\tif (p2len < fullCount)\n"))
+				return rkc::ResultCodes::kInternalError;
+
+			// AVX2 and AVX-512 gather 32-bit elements at 32-bit indexes with hardware gathers, and SSE emulates them
+			const bool hasGather = EmittedTextContains(text, "_mask_i32gather_ps(");
+			switch (target.GetIsa())
+			{
+			case SimdIsa::kSSE42:
+				if (hasGather)
+					return rkc::ResultCodes::kInternalError;
+				break;
+
+			case SimdIsa::kAVX2:
+				if (!hasGather || !EmittedTextContains(text, "_mm256_mask_i32gather_ps(")
+					|| !EmittedTextContains(text, "\tif (length - 1u > 0x7fffffffu)\n") || !EmittedTextContains(text, "_mm256_set1_epi32((int)(length - 1u))"))
+					return rkc::ResultCodes::kInternalError;
+				break;
+
+			case SimdIsa::kAVX512:
+				if (!hasGather || !EmittedTextContains(text, "_mm512_mask_i32gather_ps(")
+					|| !EmittedTextContains(text, "\tif (length - 1u > 0x7fffffffu)\n") || !EmittedTextContains(text, "_mm512_set1_epi32((int)(length - 1u))"))
+					return rkc::ResultCodes::kInternalError;
+				break;
+
+			default:
+				return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		Result SimdKernelText(IAllocator &alloc)
+		{
+			const SimdTarget targets[] =
+			{
+				SimdTarget(SimdIsa::kSSE42, 4),
+				SimdTarget(SimdIsa::kAVX2, 8),
+				SimdTarget(SimdIsa::kAVX512, 16),
+			};
+
+			for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+			{
+				RKC_CHECK(CheckSimdLaneKernel(alloc, targets[i]));
+				RKC_CHECK(CheckSimdGatherKernel(alloc, targets[i]));
+			}
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,350 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "ArraySliceView.h"
+#include "FeedStream.h"
+#include "IStream.h"
+#include "Lexer.h"
+#include "RkcContext.h"
+#include "RkcModuleLoad.h"
+#include "Vector.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// Every token kind, multi-byte characters, escapes and both line ending styles
+		static const char *const kStreamedLexSource =
+			"// line comment with \xc3\xa9 accents\n"
+			"name = identifier_with_a_long_name + 0x1F * 12.5e-3f\r\n"
+			"s = \"string with \\u00e9 and \\\" escapes\"\n"
+			"c = '\\n'   \t  /* block comment ** text */\n"
+			"\xe2\x80\x83\xe2\x80\x83 tail <<= x\n";
+
+		// One error per line, lexed with error recovery
+		static const char *const kStreamedLexErrorSource =
+			"a = 1\n"
+			"b = \"unterminated\n"
+			"c = 12x + 3\n"
+			"d = 'x' \x01 e\n"
+			"f = \"bad \\q escape\" g\r\n"
+			"h = \xff\xfe\n"
+			"ok\n";
+
+		struct StreamedLexTestToken
+		{
+			LexTokenType m_tokenType;
+			size_t m_startLine;
+			size_t m_startCol;
+			size_t m_startFilePos;
+			size_t m_endFilePos;
+			size_t m_charsStart;
+			size_t m_numChars;
+			rkc::ResultCode_t m_errorCode;
+		};
+
+		// Feed stream that counts the bytes read from it, so that lexing the same bytes again shows up
+		class StreamedLexTestStream final : public IStream
+		{
+		public:
+			explicit StreamedLexTestStream(IAllocator &alloc);
+
+			size_t Read(void *buf, size_t size) override;
+			size_t Write(void *buf, size_t size) override;
+			rkcUFilePos_t Tell() const override;
+			bool SeekStart(rkcUFilePos_t pos) override;
+			bool SeekEnd(rkcFilePos_t pos) override;
+			bool SeekCurrent(rkcFilePos_t pos) override;
+			bool IsReadable() const override;
+			bool IsWritable() const override;
+			void Close() override;
+
+			FeedStream m_feedStream;
+			size_t m_numBytesRead;
+		};
+
+		StreamedLexTestStream::StreamedLexTestStream(IAllocator &alloc)
+			: m_feedStream(&alloc)
+			, m_numBytesRead(0)
+		{
+		}
+
+		size_t StreamedLexTestStream::Read(void *buf, size_t size)
+		{
+			const size_t numRead = m_feedStream.Read(buf, size);
+			m_numBytesRead += numRead;
+			return numRead;
+		}
+
+		size_t StreamedLexTestStream::Write(void *, size_t)
+		{
+			return 0;
+		}
+
+		rkcUFilePos_t StreamedLexTestStream::Tell() const
+		{
+			return m_feedStream.Tell();
+		}
+
+		bool StreamedLexTestStream::SeekStart(rkcUFilePos_t pos)
+		{
+			return m_feedStream.SeekStart(pos);
+		}
+
+		bool StreamedLexTestStream::SeekEnd(rkcFilePos_t pos)
+		{
+			return m_feedStream.SeekEnd(pos);
+		}
+
+		bool StreamedLexTestStream::SeekCurrent(rkcFilePos_t pos)
+		{
+			return m_feedStream.SeekCurrent(pos);
+		}
+
+		bool StreamedLexTestStream::IsReadable() const
+		{
+			return true;
+		}
+
+		bool StreamedLexTestStream::IsWritable() const
+		{
+			return false;
+		}
+
+		void StreamedLexTestStream::Close()
+		{
+		}
+
+		static ArraySliceView<const uint8_t> StreamedLexTestBytes(const char *str, size_t start, size_t count)
+		{
+			return ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>(str) + start, count);
+		}
+
+		// Lexes the source with the bytes appended chunkSize at a time, or all at once if chunkSize is 0,
+		// discarding stream bytes before each token's end the same way as a module load
+		static Result LexStreamedTestSource(IAllocator &alloc, const char *source, size_t sourceSize, size_t chunkSize, bool recoverFromErrors, Vector<StreamedLexTestToken> &outTokens, Vector<uint8_t> &outChars, size_t &outNumBytesRead)
+		{
+			StreamedLexTestStream stream(alloc);
+			Lexer lexer(&stream, &alloc, 64);
+			lexer.SetRecoverFromErrors(recoverFromErrors);
+
+			size_t numAppended = 0;
+			if (chunkSize == 0)
+			{
+				RKC_CHECK(stream.m_feedStream.Append(StreamedLexTestBytes(source, 0, sourceSize)));
+				numAppended = sourceSize;
+			}
+			else
+				lexer.SetMoreInputExpected(true);
+
+			for (;;)
+			{
+				if (numAppended < sourceSize)
+				{
+					size_t numBytes = sourceSize - numAppended;
+					if (numBytes > chunkSize)
+						numBytes = chunkSize;
+
+					RKC_CHECK(stream.m_feedStream.Append(StreamedLexTestBytes(source, numAppended, numBytes)));
+					numAppended += numBytes;
+				}
+				else
+					lexer.SetMoreInputExpected(false);
+
+				RKC_CHECK_RV(LexToken, token, lexer.GetNextToken());
+
+				stream.m_feedStream.DiscardBefore(token.m_endPos.m_filePos);
+
+				if (token.m_tokenType == LexTokenType::kNeedMoreInput)
+					continue;
+
+				StreamedLexTestToken recordedToken;
+				recordedToken.m_tokenType = token.m_tokenType;
+				recordedToken.m_startLine = token.m_startPos.m_line;
+				recordedToken.m_startCol = token.m_startPos.m_col;
+				recordedToken.m_startFilePos = token.m_startPos.m_filePos;
+				recordedToken.m_endFilePos = token.m_endPos.m_filePos;
+				recordedToken.m_charsStart = outChars.Count();
+				recordedToken.m_numChars = token.m_charBuffer.Count();
+				recordedToken.m_errorCode = token.m_errorCode;
+
+				RKC_CHECK(outChars.AppendRange(token.m_charBuffer.Slice().ToConst()));
+				RKC_CHECK(outTokens.Append(recordedToken));
+
+				if (token.m_tokenType == LexTokenType::kEndOfFile)
+					break;
+			}
+
+			outNumBytesRead = stream.m_numBytesRead;
+			return Result::Ok();
+		}
+
+		static bool StreamedLexTokensMatch(const Vector<StreamedLexTestToken> &tokensA, const Vector<uint8_t> &charsA, const Vector<StreamedLexTestToken> &tokensB, const Vector<uint8_t> &charsB)
+		{
+			if (tokensA.Count() != tokensB.Count() || charsA.Count() != charsB.Count())
+				return false;
+
+			for (size_t i = 0; i < tokensA.Count(); i++)
+			{
+				const StreamedLexTestToken &a = tokensA[i];
+				const StreamedLexTestToken &b = tokensB[i];
+
+				if (a.m_tokenType != b.m_tokenType || a.m_startLine != b.m_startLine || a.m_startCol != b.m_startCol
+					|| a.m_startFilePos != b.m_startFilePos || a.m_endFilePos != b.m_endFilePos || a.m_errorCode != b.m_errorCode
+					|| a.m_charsStart != b.m_charsStart || a.m_numChars != b.m_numChars)
+					return false;
+			}
+
+			return charsA.Count() == 0 || !memcmp(&charsA[0], &charsB[0], charsA.Count());
+		}
+
+		// Splitting the input anywhere, including inside multi-byte characters and escapes, produces the
+		// same tokens as lexing it in one piece
+		static Result CheckStreamedLexChunking(IAllocator &alloc, const char *source, bool recoverFromErrors)
+		{
+			const size_t sourceSize = strlen(source);
+
+			Vector<StreamedLexTestToken> wholeTokens(&alloc);
+			Vector<uint8_t> wholeChars(&alloc);
+			size_t numBytesRead = 0;
+			RKC_CHECK(LexStreamedTestSource(alloc, source, sourceSize, 0, recoverFromErrors, wholeTokens, wholeChars, numBytesRead));
+
+			const size_t chunkSizes[] = { 1, 2, 3, 5, 7, 64 };
+			for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++)
+			{
+				Vector<StreamedLexTestToken> tokens(&alloc);
+				Vector<uint8_t> chars(&alloc);
+				RKC_CHECK(LexStreamedTestSource(alloc, source, sourceSize, chunkSizes[i], recoverFromErrors, tokens, chars, numBytesRead));
+
+				if (!StreamedLexTokensMatch(wholeTokens, wholeChars, tokens, chars))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		// A long token fed one byte at a time is continued where it was cut off instead of being lexed again
+		// from its start, so each byte is read from the stream about once
+		static Result CheckStreamedLexLongTokens(IAllocator &alloc)
+		{
+			const size_t kTokenLength = 4096;
+			const char *const prefixes[] = { "//", "/*", "\"", "name", " " };
+			const char *const suffixes[] = { "\n", "*/\n", "\"\n", "\n", "\n" };
+			const char fillers[] = { 'x', 'x', 'x', 'x', ' ' };
+
+			for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++)
+			{
+				Vector<uint8_t> source(&alloc);
+				RKC_CHECK(source.AppendRange(StreamedLexTestBytes(prefixes[i], 0, strlen(prefixes[i]))));
+				for (size_t j = 0; j < kTokenLength; j++)
+				{
+					RKC_CHECK(source.Append(static_cast<uint8_t>(fillers[i])));
+				}
+				RKC_CHECK(source.AppendRange(StreamedLexTestBytes(suffixes[i], 0, strlen(suffixes[i]))));
+
+				const char *sourceChars = reinterpret_cast<const char*>(&source[0]);
+
+				Vector<StreamedLexTestToken> tokens(&alloc);
+				Vector<uint8_t> chars(&alloc);
+				size_t numBytesRead = 0;
+				RKC_CHECK(LexStreamedTestSource(alloc, sourceChars, source.Count(), 1, false, tokens, chars, numBytesRead));
+
+				// The long token, the line break and the end of the file
+				if (tokens.Count() != 3 || tokens[0].m_numChars != source.Count() - 1)
+					return rkc::ResultCodes::kInternalError;
+
+				if (numBytesRead > source.Count() * 2)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			return Result::Ok();
+		}
+
+		static void *StreamedLexTestRealloc(void *userdata, void *buf, size_t newSize)
+		{
+			return static_cast<IAllocator*>(userdata)->Realloc(buf, newSize);
+		}
+
+		// Module loads fed one byte at a time, and a failed load that keeps returning its first error
+		static Result CheckStreamedModuleLoad(IAllocator &alloc)
+		{
+			RkcAllocatorSpec allocSpec;
+			allocSpec.m_realloc = StreamedLexTestRealloc;
+			allocSpec.m_userdata = &alloc;
+
+			RkcContextOptions options;
+			options.m_structSize = sizeof(RkcContextOptions);
+			options.m_trackAllocations = 0;
+			options.m_readAheadBufferSize = 0;
+			options.m_lexerBufferSize = 0;
+			options.m_readAheadThreads = 0;
+
+			IRkcContext context(allocSpec, options);
+
+			{
+				IRkcModuleLoad *load = nullptr;
+				if (RkcBeginModuleLoad(&context, &load) != rkc::ResultCodes::kOK)
+					return rkc::ResultCodes::kInternalError;
+
+				const size_t sourceSize = strlen(kStreamedLexSource);
+				for (size_t i = 0; i < sourceSize; i++)
+				{
+					Result feedResult(load->Feed(StreamedLexTestBytes(kStreamedLexSource, i, 1)));
+					if (!feedResult.IsOK())
+					{
+						load->Destroy();
+						return feedResult;
+					}
+
+					feedResult.Handle();
+				}
+
+				Result finishResult(load->Finish());
+				load->Destroy();
+
+				if (!finishResult.IsOK())
+					return finishResult;
+
+				finishResult.Handle();
+			}
+
+#if !RKC_IS_DEBUG
+			{
+				IRkcModuleLoad *load = nullptr;
+				if (RkcBeginModuleLoad(&context, &load) != rkc::ResultCodes::kOK)
+					return rkc::ResultCodes::kInternalError;
+
+				const char *badSource = "a = \x01\n";
+				const char *goodSource = "b = 2\n";
+
+				Result firstResult(load->Feed(StreamedLexTestBytes(badSource, 0, strlen(badSource))));
+				firstResult.Handle();
+
+				Result secondResult(load->Feed(StreamedLexTestBytes(goodSource, 0, strlen(goodSource))));
+				secondResult.Handle();
+
+				Result finishResult(load->Finish());
+				finishResult.Handle();
+
+				load->Destroy();
+
+				if (firstResult.GetCode() != rkc::ResultCodes::kLexGarbageCharacter || secondResult.GetCode() != firstResult.GetCode() || finishResult.GetCode() != firstResult.GetCode())
+					return rkc::ResultCodes::kInternalError;
+			}
+#endif
+
+			return Result::Ok();
+		}
+
+		Result StreamedLexing(IAllocator &alloc)
+		{
+			RKC_CHECK(CheckStreamedLexChunking(alloc, kStreamedLexSource, false));
+			RKC_CHECK(CheckStreamedLexChunking(alloc, kStreamedLexErrorSource, true));
+			RKC_CHECK(CheckStreamedLexLongTokens(alloc));
+			RKC_CHECK(CheckStreamedModuleLoad(alloc));
+
+			return Result::Ok();
+		}
+	}
+}
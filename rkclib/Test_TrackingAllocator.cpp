@@ -0,0 +1,108 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "TrackingAllocator.h"
+
+#include <thread>
+
+namespace rkci
+{
+	namespace Tests
+	{
+		static const size_t kNumTrackingThreads = 4;
+		static const size_t kNumTrackingAllocations = 2000;
+
+		struct TrackingThreadData
+		{
+			TrackingAllocator *m_alloc;
+			rkc::AllocatorTag_t m_tag;
+			bool m_succeeded;
+		};
+
+		// Tags the allocations with the thread's tag, except for the first block, which is allocated before
+		// the tag is pushed
+		static void TrackingThreadMain(TrackingThreadData *data)
+		{
+			TrackingAllocator &alloc = *data->m_alloc;
+
+			void *untaggedBlock = alloc.Alloc(16);
+			data->m_succeeded = (untaggedBlock != nullptr);
+
+			{
+				AllocatorTagScope tagScope(alloc, data->m_tag);
+
+				for (size_t i = 0; i < kNumTrackingAllocations; i++)
+				{
+					void *block = alloc.Alloc(8 + i % 64);
+					if (!block)
+					{
+						data->m_succeeded = false;
+						continue;
+					}
+
+					block = alloc.Realloc(block, 128);
+					if (!block)
+					{
+						data->m_succeeded = false;
+						continue;
+					}
+
+					alloc.Release(block);
+				}
+			}
+
+			alloc.Release(untaggedBlock);
+		}
+
+		Result TrackingAllocator(IAllocator &alloc)
+		{
+			rkci::TrackingAllocator trackingAlloc(alloc);
+
+			// A tag pushed on this thread doesn't apply to the workers' allocations
+			AllocatorTagScope tagScope(trackingAlloc, rkc::AllocatorTags::kAst);
+
+			const rkc::AllocatorTag_t workerTags[kNumTrackingThreads] = { rkc::AllocatorTags::kLexer, rkc::AllocatorTags::kBigNum, rkc::AllocatorTags::kHashMap, rkc::AllocatorTags::kLexer };
+
+			TrackingThreadData threadData[kNumTrackingThreads];
+			std::thread threads[kNumTrackingThreads];
+			for (size_t i = 0; i < kNumTrackingThreads; i++)
+			{
+				threadData[i].m_alloc = &trackingAlloc;
+				threadData[i].m_tag = workerTags[i];
+				threadData[i].m_succeeded = false;
+				threads[i] = std::thread(TrackingThreadMain, &threadData[i]);
+			}
+
+			for (size_t i = 0; i < kNumTrackingThreads; i++)
+				threads[i].join();
+
+			for (size_t i = 0; i < kNumTrackingThreads; i++)
+			{
+				if (!threadData[i].m_succeeded)
+					return rkc::ResultCodes::kOutOfMemory;
+			}
+
+			RkcAllocatorStats stats;
+			trackingAlloc.GetStats(stats);
+
+			const size_t numAllocations = kNumTrackingThreads * (kNumTrackingAllocations + 1);
+			if (stats.m_numAllocations != numAllocations || stats.m_numReleases != numAllocations || stats.m_liveBytes != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			if (stats.m_numReallocsInPlace + stats.m_numReallocsMoved != kNumTrackingThreads * kNumTrackingAllocations)
+				return rkc::ResultCodes::kInternalError;
+
+			const RkcAllocatorTagStats *tagStats = stats.m_tags;
+			if (tagStats[rkc::AllocatorTags::kGeneral].m_numAllocations != kNumTrackingThreads
+				|| tagStats[rkc::AllocatorTags::kLexer].m_numAllocations != 2 * kNumTrackingAllocations
+				|| tagStats[rkc::AllocatorTags::kBigNum].m_numAllocations != kNumTrackingAllocations
+				|| tagStats[rkc::AllocatorTags::kHashMap].m_numAllocations != kNumTrackingAllocations
+				|| tagStats[rkc::AllocatorTags::kAst].m_numAllocations != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			if (tagStats[rkc::AllocatorTags::kBigNum].m_peakBytes < 128 || tagStats[rkc::AllocatorTags::kBigNum].m_liveBytes != 0)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+	}
+}
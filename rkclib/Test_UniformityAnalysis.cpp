@@ -0,0 +1,99 @@
+#include "ArraySliceView.h"
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Result.h"
+#include "UniformityAnalysis.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		Result Uniformity(IAllocator &alloc)
+		{
+			const Kernel::ValueIndex_t N = Kernel::kInvalidValueIndex;
+			const Kernel::TypeIndex_t NT = Kernel::kInvalidTypeIndex;
+
+			Kernel::Function function(&alloc);
+			RKC_CHECK(function.SetName(ArraySliceView<const uint8_t>(reinterpret_cast<const uint8_t*>("uniformity"), 10)));
+
+			RKC_CHECK_RV(Kernel::TypeIndex_t, indexType, function.AddIntType(0, 0x7fffffff));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, valueType, function.AddIntType(-100000, 100000));
+			RKC_CHECK_RV(Kernel::TypeIndex_t, maskType, function.AddMaskType(valueType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, inParam, function.AddParam(Kernel::ParamKind::kInputBuffer, valueType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, scaleParam, function.AddParam(Kernel::ParamKind::kUniform, valueType));
+			RKC_CHECK_RV(Kernel::ParamIndex_t, outParam, function.AddParam(Kernel::ParamKind::kOutputBuffer, valueType));
+
+			RKC_CHECK_RV(Kernel::VariableIndex_t, plainVariable, function.AddVariable(valueType));
+			RKC_CHECK_RV(Kernel::VariableIndex_t, uniformMaskedVariable, function.AddVariable(valueType));
+			RKC_CHECK_RV(Kernel::VariableIndex_t, varyingMaskedVariable, function.AddVariable(valueType));
+			RKC_CHECK_RV(Kernel::VariableIndex_t, varyingValueVariable, function.AddVariable(valueType));
+			RKC_CHECK_RV(Kernel::VariableIndex_t, copyVariable, function.AddVariable(valueType));
+
+			// Uniform parameters and constants, and arithmetic and comparisons on only them
+			RKC_CHECK_RV(Kernel::ValueIndex_t, scale, function.AddInstruction(Kernel::Opcode::kParam, valueType, N, N, N, scaleParam));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, two, function.AddInstruction(Kernel::Opcode::kConstant, valueType, N, N, N, 2));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, scaled, function.AddInstruction(Kernel::Opcode::kMul, valueType, scale, two, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isLarge, function.AddInstruction(Kernel::Opcode::kCmpGt, maskType, scaled, two, N, 0));
+
+			// The lane index taints everything computed from it, even when mixed with uniform values
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneIndex, function.AddInstruction(Kernel::Opcode::kLaneIndex, indexType, N, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneValue, function.AddInstruction(Kernel::Opcode::kConvert, valueType, laneIndex, N, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneSum, function.AddInstruction(Kernel::Opcode::kAdd, valueType, scaled, laneValue, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneProduct, function.AddInstruction(Kernel::Opcode::kMul, valueType, laneSum, two, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, isLaneLarge, function.AddInstruction(Kernel::Opcode::kCmpGt, maskType, laneProduct, scaled, N, 0));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, laneSelect, function.AddInstruction(Kernel::Opcode::kSelect, valueType, isLarge, laneValue, two, 0));
+
+			// Loads aren't uniform even at a uniform index
+			RKC_CHECK_RV(Kernel::ValueIndex_t, loaded, function.AddInstruction(Kernel::Opcode::kLoad, valueType, scaled, N, N, inParam));
+
+			// Copied before the variable it copies is found to be varying, which takes another pass
+			RKC_CHECK_RV(Kernel::ValueIndex_t, copySource, function.AddInstruction(Kernel::Opcode::kReadVar, valueType, N, N, N, varyingMaskedVariable));
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kWriteVar, NT, copySource, N, N, copyVariable).DiscardValue());
+
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kWriteVar, NT, scaled, N, N, plainVariable).DiscardValue());
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kWriteVar, NT, laneSum, N, N, varyingValueVariable).DiscardValue());
+
+			// A uniform value written under a uniform mask is written to every lane or none
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kBeginMasked, NT, isLarge, N, N, 0).DiscardValue());
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kWriteVar, NT, two, N, N, uniformMaskedVariable).DiscardValue());
+
+			// Under a varying mask, the same value only reaches some lanes
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kBeginMasked, NT, isLaneLarge, N, N, 0).DiscardValue());
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kWriteVar, NT, two, N, N, varyingMaskedVariable).DiscardValue());
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kEndMasked, NT, N, N, N, 0).DiscardValue());
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kEndMasked, NT, N, N, N, 0).DiscardValue());
+
+			RKC_CHECK_RV(Kernel::ValueIndex_t, plainRead, function.AddInstruction(Kernel::Opcode::kReadVar, valueType, N, N, N, plainVariable));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, uniformMaskedRead, function.AddInstruction(Kernel::Opcode::kReadVar, valueType, N, N, N, uniformMaskedVariable));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, varyingMaskedRead, function.AddInstruction(Kernel::Opcode::kReadVar, valueType, N, N, N, varyingMaskedVariable));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, copyRead, function.AddInstruction(Kernel::Opcode::kReadVar, valueType, N, N, N, copyVariable));
+			RKC_CHECK_RV(Kernel::ValueIndex_t, readSum, function.AddInstruction(Kernel::Opcode::kAdd, valueType, plainRead, uniformMaskedRead, N, 0));
+			RKC_CHECK(function.AddInstruction(Kernel::Opcode::kStore, NT, laneIndex, readSum, N, outParam).DiscardValue());
+
+			UniformityAnalysis uniformity(&alloc);
+			RKC_CHECK(uniformity.Analyze(function));
+
+			const Kernel::ValueIndex_t uniformValues[] = { scale, two, scaled, isLarge, plainRead, uniformMaskedRead, readSum };
+			for (size_t i = 0; i < sizeof(uniformValues) / sizeof(uniformValues[0]); i++)
+			{
+				if (!uniformity.IsValueUniform(uniformValues[i]))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			const Kernel::ValueIndex_t varyingValues[] = { laneIndex, laneValue, laneSum, laneProduct, isLaneLarge, laneSelect, loaded, copySource, varyingMaskedRead, copyRead };
+			for (size_t i = 0; i < sizeof(varyingValues) / sizeof(varyingValues[0]); i++)
+			{
+				if (uniformity.IsValueUniform(varyingValues[i]))
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			if (!uniformity.IsVariableUniform(plainVariable) || !uniformity.IsVariableUniform(uniformMaskedVariable))
+				return rkc::ResultCodes::kInternalError;
+
+			if (uniformity.IsVariableUniform(varyingMaskedVariable) || uniformity.IsVariableUniform(varyingValueVariable) || uniformity.IsVariableUniform(copyVariable))
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+	}
+}
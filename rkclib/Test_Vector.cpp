@@ -0,0 +1,98 @@
+#include "CoreDefs.h"
+#include "Result.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	namespace Tests
+	{
+		// Not trivially copyable, so the vector moves these one at a time and destroys the old copies
+		struct VectorTestItem
+		{
+			explicit VectorTestItem(uint32_t value);
+			VectorTestItem(const VectorTestItem &other);
+			VectorTestItem(VectorTestItem &&other);
+			~VectorTestItem();
+
+			uint32_t m_value;
+		};
+
+		VectorTestItem::VectorTestItem(uint32_t value)
+			: m_value(value)
+		{
+		}
+
+		VectorTestItem::VectorTestItem(const VectorTestItem &other)
+			: m_value(other.m_value)
+		{
+		}
+
+		VectorTestItem::VectorTestItem(VectorTestItem &&other)
+			: m_value(other.m_value)
+		{
+			other.m_value = 0xdddddddd;
+		}
+
+		VectorTestItem::~VectorTestItem()
+		{
+			m_value = 0xdddddddd;
+		}
+
+		// Trivially copyable, so the vector copies these with memcpy and grows with Realloc
+		struct TrivialVectorTestItem
+		{
+			explicit TrivialVectorTestItem(uint32_t value);
+
+			uint32_t m_value;
+		};
+
+		TrivialVectorTestItem::TrivialVectorTestItem(uint32_t value)
+			: m_value(value)
+		{
+		}
+
+		template<class T, size_t TStaticSize>
+		static Result CheckVectorSelfAppend(IAllocator &alloc)
+		{
+			rkci::Vector<T, TStaticSize> vec(&alloc);
+			for (uint32_t i = 0; i < 4; i++)
+				RKC_CHECK(vec.Append(T(i)));
+
+			// Fill the vector to capacity, so every append below has to grow it
+			for (uint32_t i = 4; vec.Count() < TStaticSize || vec.Count() < VectorGrowthPolicy<T>::kMinimumCapacity; i++)
+				RKC_CHECK(vec.Append(T(i)));
+
+			const rkci::Vector<T, TStaticSize> &constVec = vec;
+			const size_t initialCount = vec.Count();
+
+			RKC_CHECK(vec.AppendRange(constVec.Slice()));
+			RKC_CHECK(vec.AppendRange(constVec.Slice().Subrange(1, 2)));
+			RKC_CHECK(vec.Append(constVec[3]));
+
+			const size_t numExpected = initialCount * 2 + 3;
+			if (vec.Count() != numExpected)
+				return rkc::ResultCodes::kInternalError;
+
+			for (size_t i = 0; i < initialCount; i++)
+			{
+				if (vec[i].m_value != i || vec[initialCount + i].m_value != i)
+					return rkc::ResultCodes::kInternalError;
+			}
+
+			if (vec[initialCount * 2].m_value != 1 || vec[initialCount * 2 + 1].m_value != 2 || vec[initialCount * 2 + 2].m_value != 3)
+				return rkc::ResultCodes::kInternalError;
+
+			return Result::Ok();
+		}
+
+		Result Vector(IAllocator &alloc)
+		{
+			RKC_CHECK((CheckVectorSelfAppend<VectorTestItem, 0>(alloc)));
+			RKC_CHECK((CheckVectorSelfAppend<VectorTestItem, 4>(alloc)));
+			RKC_CHECK((CheckVectorSelfAppend<TrivialVectorTestItem, 0>(alloc)));
+			RKC_CHECK((CheckVectorSelfAppend<TrivialVectorTestItem, 4>(alloc)));
+
+			return Result::Ok();
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace rkc
+{
+	namespace TokenTypes
+	{
+		// Token types reported by RkcLexBatch
+		enum TokenType
+		{
+			kUnknown = 0,
+
+			kWhitespace,
+			kName,
+			kString,
+			kNumber,
+			kLineComment,
+			kBlockComment,
+			kEndOfLine,
+			kEndOfFile,
+			kPunctuation,
+			kCharacterLiteral,
+
+			// Malformed input up to the end of the line, only produced when recovering from errors
+			kError,
+		};
+	}
+
+	typedef TokenTypes::TokenType TokenType_t;
+}
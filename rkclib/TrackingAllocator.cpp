@@ -0,0 +1,178 @@
+#include "TrackingAllocator.h"
+
+#include <string.h>
+
+namespace rkci
+{
+	namespace TrackingAllocatorInternal
+	{
+		static const size_t kMaxTagDepth = 32;
+
+		struct TagStackEntry
+		{
+			const TrackingAllocator *m_alloc;
+			rkc::AllocatorTag_t m_tag;
+		};
+
+		// Tags belong to the work a thread is doing, so each thread has its own stack, shared by every
+		// tracking allocator that it uses.  Entries record which allocator they were pushed on.
+		struct ThreadTagStack
+		{
+			StaticArray<TagStackEntry, kMaxTagDepth> m_entries;
+			size_t m_depth;
+		};
+
+		// Zero-initialized, so every thread's stack starts empty
+		static thread_local ThreadTagStack tls_tagStack;
+	}
+}
+
+rkci::TrackingAllocator::TrackingAllocator(IAllocator &backingAlloc)
+	: m_backingAlloc(backingAlloc)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void *rkci::TrackingAllocator::Realloc(void *buf, size_t newSize)
+{
+	if (buf == nullptr)
+	{
+		if (newSize == 0)
+			return nullptr;
+
+		uint8_t *block = nullptr;
+		if (newSize <= static_cast<size_t>(-1) - kHeaderSize)
+			block = static_cast<uint8_t*>(m_backingAlloc.Alloc(kHeaderSize + newSize));
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!block)
+		{
+			m_stats.m_numFailedAllocations++;
+			return nullptr;
+		}
+
+		BlockHeader *header = reinterpret_cast<BlockHeader*>(block);
+		header->m_size = newSize;
+		header->m_tag = GetCurrentTag();
+
+		m_stats.m_numAllocations++;
+		m_stats.m_tags[header->m_tag].m_numAllocations++;
+		AddLiveBytes(header->m_tag, newSize);
+
+		return block + kHeaderSize;
+	}
+
+	uint8_t *oldBlock = static_cast<uint8_t*>(buf) - kHeaderSize;
+	const BlockHeader oldHeader = *reinterpret_cast<const BlockHeader*>(oldBlock);
+
+	if (newSize == 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			RemoveLiveBytes(oldHeader.m_tag, oldHeader.m_size);
+			m_stats.m_numReleases++;
+		}
+
+		m_backingAlloc.Release(oldBlock);
+		return nullptr;
+	}
+
+	uint8_t *newBlock = nullptr;
+	if (newSize <= static_cast<size_t>(-1) - kHeaderSize)
+		newBlock = static_cast<uint8_t*>(m_backingAlloc.Realloc(oldBlock, kHeaderSize + newSize));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!newBlock)
+	{
+		m_stats.m_numFailedAllocations++;
+		return nullptr;
+	}
+
+	if (newBlock == oldBlock)
+		m_stats.m_numReallocsInPlace++;
+	else
+		m_stats.m_numReallocsMoved++;
+
+	// Resized blocks stay attributed to the subsystem that allocated them
+	reinterpret_cast<BlockHeader*>(newBlock)->m_size = newSize;
+	RemoveLiveBytes(oldHeader.m_tag, oldHeader.m_size);
+	AddLiveBytes(oldHeader.m_tag, newSize);
+
+	return newBlock + kHeaderSize;
+}
+
+void rkci::TrackingAllocator::PushTag(rkc::AllocatorTag_t tag)
+{
+	RKC_ASSERT(tag >= 0 && tag < rkc::AllocatorTags::kCount);
+
+	TrackingAllocatorInternal::ThreadTagStack &tagStack = TrackingAllocatorInternal::tls_tagStack;
+
+	// Tags nested deeper than the stack are attributed to the deepest tracked tag
+	if (tagStack.m_depth < TrackingAllocatorInternal::kMaxTagDepth)
+	{
+		TrackingAllocatorInternal::TagStackEntry &entry = tagStack.m_entries[tagStack.m_depth];
+		entry.m_alloc = this;
+		entry.m_tag = tag;
+	}
+
+	tagStack.m_depth++;
+}
+
+void rkci::TrackingAllocator::PopTag()
+{
+	TrackingAllocatorInternal::ThreadTagStack &tagStack = TrackingAllocatorInternal::tls_tagStack;
+
+	RKC_ASSERT(tagStack.m_depth > 0);
+	tagStack.m_depth--;
+}
+
+void rkci::TrackingAllocator::GetStats(RkcAllocatorStats &outStats) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	outStats = m_stats;
+}
+
+rkc::AllocatorTag_t rkci::TrackingAllocator::GetCurrentTag() const
+{
+	const TrackingAllocatorInternal::ThreadTagStack &tagStack = TrackingAllocatorInternal::tls_tagStack;
+
+	size_t depth = tagStack.m_depth;
+	if (depth > TrackingAllocatorInternal::kMaxTagDepth)
+		depth = TrackingAllocatorInternal::kMaxTagDepth;
+
+	while (depth > 0)
+	{
+		depth--;
+
+		const TrackingAllocatorInternal::TagStackEntry &entry = tagStack.m_entries[depth];
+		if (entry.m_alloc == this)
+			return entry.m_tag;
+	}
+
+	return rkc::AllocatorTags::kGeneral;
+}
+
+void rkci::TrackingAllocator::AddLiveBytes(rkc::AllocatorTag_t tag, size_t size)
+{
+	RkcAllocatorTagStats &tagStats = m_stats.m_tags[tag];
+
+	m_stats.m_liveBytes += size;
+	if (m_stats.m_liveBytes > m_stats.m_peakBytes)
+		m_stats.m_peakBytes = m_stats.m_liveBytes;
+
+	tagStats.m_liveBytes += size;
+	if (tagStats.m_liveBytes > tagStats.m_peakBytes)
+		tagStats.m_peakBytes = tagStats.m_liveBytes;
+}
+
+void rkci::TrackingAllocator::RemoveLiveBytes(rkc::AllocatorTag_t tag, size_t size)
+{
+	RKC_ASSERT(m_stats.m_liveBytes >= size);
+	RKC_ASSERT(m_stats.m_tags[tag].m_liveBytes >= size);
+
+	m_stats.m_liveBytes -= size;
+	m_stats.m_tags[tag].m_liveBytes -= size;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "IAllocator.h"
+#include "StaticArray.h"
+#include "rkclib.h"
+
+#include <mutex>
+
+namespace rkci
+{
+	// Allocator that forwards to another allocator and records usage statistics, attributed to the
+	// subsystem tag at the top of the tag stack at the time of the allocation.  It can be used from
+	// several threads at once if the backing allocator can.  Each thread has its own tag stack.
+	class TrackingAllocator final : public IAllocator
+	{
+	public:
+		explicit TrackingAllocator(IAllocator &backingAlloc);
+
+		void *Realloc(void *buf, size_t newSize) override;
+		void PushTag(rkc::AllocatorTag_t tag) override;
+		void PopTag() override;
+
+		void GetStats(RkcAllocatorStats &outStats) const;
+
+	private:
+		struct BlockHeader
+		{
+			size_t m_size;
+			rkc::AllocatorTag_t m_tag;
+		};
+
+		static const size_t kMaxAlignment = alignof(max_align_t);
+		static const size_t kHeaderSize = (sizeof(BlockHeader) + kMaxAlignment - 1) / kMaxAlignment * kMaxAlignment;
+
+		rkc::AllocatorTag_t GetCurrentTag() const;
+		void AddLiveBytes(rkc::AllocatorTag_t tag, size_t size);
+		void RemoveLiveBytes(rkc::AllocatorTag_t tag, size_t size);
+
+		IAllocator &m_backingAlloc;
+
+		// Guards m_stats
+		mutable std::mutex m_mutex;
+		RkcAllocatorStats m_stats;
+	};
+}
@@ -0,0 +1,112 @@
+#include "UniformityAnalysis.h"
+#include "IAllocator.h"
+#include "Result.h"
+
+rkci::UniformityAnalysis::UniformityAnalysis(IAllocator *alloc)
+	: m_valueUniform(alloc)
+	, m_variableUniform(alloc)
+{
+}
+
+// Variables start out uniform and only ever stop being uniform, so this settles after at most one
+// pass per variable
+rkci::Result rkci::UniformityAnalysis::Analyze(const Kernel::Function &function)
+{
+	RKC_CHECK(function.Validate());
+
+	{
+		AllocatorTagScope tagScope(*m_valueUniform.GetAllocator(), rkc::AllocatorTags::kBackend);
+
+		RKC_CHECK(m_valueUniform.Resize(0));
+		RKC_CHECK(m_valueUniform.Resize(function.NumInstructions()));
+		RKC_CHECK(m_variableUniform.Resize(0));
+		RKC_CHECK(m_variableUniform.Resize(function.NumVariables()));
+	}
+
+	const size_t numVariables = function.NumVariables();
+	for (size_t i = 0; i < numVariables; i++)
+		m_variableUniform[i] = 1;
+
+	bool changed = true;
+	while (changed)
+	{
+		RKC_CHECK(Propagate(function, changed));
+	}
+
+	return Result::Ok();
+}
+
+bool rkci::UniformityAnalysis::IsValueUniform(Kernel::ValueIndex_t value) const
+{
+	return m_valueUniform[value] != 0;
+}
+
+bool rkci::UniformityAnalysis::IsVariableUniform(Kernel::VariableIndex_t variable) const
+{
+	return m_variableUniform[variable] != 0;
+}
+
+rkci::Result rkci::UniformityAnalysis::Propagate(const Kernel::Function &function, bool &outChanged)
+{
+	outChanged = false;
+
+	// Whether each open masked region's mask is varying, and how many of them are
+	Vector<uint8_t> regionStack(m_valueUniform.GetAllocator());
+	size_t numVaryingRegions = 0;
+
+	const size_t numInstructions = function.NumInstructions();
+	for (size_t i = 0; i < numInstructions; i++)
+	{
+		const Kernel::Instruction &instr = function.GetInstruction(static_cast<Kernel::ValueIndex_t>(i));
+		const size_t numOperands = Kernel::Function::GetNumOperands(instr.m_opcode);
+
+		bool isUniform = true;
+		for (size_t operandIndex = 0; operandIndex < numOperands; operandIndex++)
+		{
+			if (!m_valueUniform[instr.m_operands[operandIndex]])
+				isUniform = false;
+		}
+
+		switch (instr.m_opcode)
+		{
+		case Kernel::Opcode::kLaneIndex:
+		case Kernel::Opcode::kLoad:
+			isUniform = false;
+			break;
+
+		case Kernel::Opcode::kReadVar:
+			isUniform = (m_variableUniform[static_cast<size_t>(instr.m_immediate)] != 0);
+			break;
+
+		case Kernel::Opcode::kWriteVar:
+			if (m_variableUniform[static_cast<size_t>(instr.m_immediate)] && (!isUniform || numVaryingRegions > 0))
+			{
+				m_variableUniform[static_cast<size_t>(instr.m_immediate)] = 0;
+				outChanged = true;
+			}
+			break;
+
+		case Kernel::Opcode::kBeginMasked:
+			{
+				AllocatorTagScope tagScope(*regionStack.GetAllocator(), rkc::AllocatorTags::kBackend);
+				RKC_CHECK(regionStack.Append(isUniform ? 0 : 1));
+			}
+
+			if (!isUniform)
+				numVaryingRegions++;
+			break;
+
+		case Kernel::Opcode::kEndMasked:
+			numVaryingRegions -= regionStack[regionStack.Count() - 1];
+			RKC_CHECK(regionStack.Resize(regionStack.Count() - 1));
+			break;
+
+		default:
+			break;
+		}
+
+		m_valueUniform[i] = isUniform ? 1 : 0;
+	}
+
+	return Result::Ok();
+}
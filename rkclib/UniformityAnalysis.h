@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreDefs.h"
+#include "KernelIR.h"
+#include "Vector.h"
+
+namespace rkci
+{
+	struct IAllocator;
+	class Result;
+
+	// Finds the values of a masked kernel that are the same in every lane, so that masked regions on
+	// them can be plain branches.
+	//
+	// Constants and uniform parameters are uniform, lane indexes and loads aren't, and everything else
+	// is uniform if its operands are.  A variable is uniform if every write to it stores a uniform value
+	// and happens outside of any masked region with a varying mask, since those only write some lanes.
+	class UniformityAnalysis
+	{
+	public:
+		explicit UniformityAnalysis(IAllocator *alloc);
+
+		Result Analyze(const Kernel::Function &function);
+
+		bool IsValueUniform(Kernel::ValueIndex_t value) const;
+		bool IsVariableUniform(Kernel::VariableIndex_t variable) const;
+
+	private:
+		Result Propagate(const Kernel::Function &function, bool &outChanged);
+
+		Vector<uint8_t> m_valueUniform;
+		Vector<uint8_t> m_variableUniform;
+	};
+}
@@ -2,6 +2,7 @@
 
 #include "CoreDefs.h"
 #include "Result.h"
+#include "VectorStats.h"
 
 #include <stdint.h>
 
@@ -10,6 +11,36 @@ namespace rkci
 	struct IAllocator;
 
 	template<class T> class ArraySliceView;
+	template<class T, size_t TStaticSize> class Vector;
+
+	// Types that can be moved to a new address with a raw byte copy, without running the move constructor
+	// or the destructor of the old copy.  Vectors of these types grow with a single Realloc.
+	template<class T>
+	class IsTriviallyRelocatable
+	{
+	public:
+		static const bool kValue = std::is_trivially_copyable<T>::value;
+	};
+
+	// Heap-only vectors don't point into themselves, so they can be relocated
+	template<class T>
+	class IsTriviallyRelocatable<Vector<T, 0>>
+	{
+	public:
+		static const bool kValue = true;
+	};
+
+	// Growth factor used by Append, expressed as a fraction.  Specialize to tune per element type.
+	template<class T>
+	class VectorGrowthPolicy
+	{
+	public:
+		static const size_t kGrowthNumerator = 2;
+		static const size_t kGrowthDenominator = 1;
+		static const size_t kMinimumCapacity = 8;
+
+		static size_t ComputeCapacity(size_t currentCapacity, size_t minimumCapacity);
+	};
 
 	template<class T, size_t TStaticSize>
 	class VectorStaticData
@@ -51,6 +82,10 @@ namespace rkci
 
 		Result Append(const T &item);
 		Result Append(T &&item);
+		Result AppendRange(const ArraySliceView<const T> &items);
+
+		// Expands the vector by a number of elements, but does not construct them
+		Result AppendUninitialized(size_t count);
 
 		ArraySliceView<T> Slice();
 		ArraySliceView<const T> Slice() const;
@@ -66,18 +101,32 @@ namespace rkci
 	private:
 		Vector(const Vector<T, TStaticSize> &other) = delete;
 
+		Result GrowForAppend(size_t numAdded);
+		Result Relocate(size_t newCapacity);
+
 		static const size_t kStaticSize = TStaticSize;
 
 		T *m_elements;
 		size_t m_capacity;
 		size_t m_count;
 		IAllocator *m_alloc;
+
+#if RKC_VECTOR_STATS_ENABLED
+		void StatsNoteCount();
+		void StatsTakeFrom(Vector<T, TStaticSize> &other);
+		static VectorStatsSite &GetStatsSite();
+
+		size_t m_statsPeakCount;
+		bool m_statsSpilled;
+		bool m_statsActive;
+#endif
 	};
 }
 
 
 #include <new>
 #include <cassert>
+#include <string.h>
 #include "ArraySliceView.h"
 #include "Cloner.h"
 #include "IAllocator.h"
@@ -99,6 +148,18 @@ static rkci::ResultRV<rkci::Cloner<rkci::Vector<T, TStaticSize>>> Clone(const rk
 	return t.Clone();
 }
 
+template<class T>
+size_t rkci::VectorGrowthPolicy<T>::ComputeCapacity(size_t currentCapacity, size_t minimumCapacity)
+{
+	size_t newCapacity = currentCapacity / kGrowthDenominator * kGrowthNumerator;
+	if (newCapacity < kMinimumCapacity)
+		newCapacity = kMinimumCapacity;
+	if (newCapacity < minimumCapacity)
+		newCapacity = minimumCapacity;
+
+	return newCapacity;
+}
+
 template<class T, size_t TStaticSize>
 T *rkci::VectorStaticData<T, TStaticSize>::GetStaticElements()
 {
@@ -131,6 +192,11 @@ rkci::Vector<T, TStaticSize>::Vector(IAllocator *alloc)
 	, m_capacity(TStaticSize)
 	, m_count(0)
 	, m_alloc(alloc)
+#if RKC_VECTOR_STATS_ENABLED
+	, m_statsPeakCount(0)
+	, m_statsSpilled(false)
+	, m_statsActive(true)
+#endif
 {
 }
 
@@ -140,7 +206,16 @@ rkci::Vector<T, TStaticSize>::Vector(Vector<T, TStaticSize>&& other)
 	, m_capacity(other.m_capacity)
 	, m_count(other.m_count)
 	, m_alloc(other.m_alloc)
+#if RKC_VECTOR_STATS_ENABLED
+	, m_statsPeakCount(0)
+	, m_statsSpilled(false)
+	, m_statsActive(true)
+#endif
 {
+#if RKC_VECTOR_STATS_ENABLED
+	StatsTakeFrom(other);
+#endif
+
 	if (m_capacity <= TStaticSize)
 	{
 		const size_t count = m_count;
@@ -159,6 +234,11 @@ rkci::Vector<T, TStaticSize>::Vector(Vector<T, TStaticSize>&& other)
 template<class T, size_t TStaticSize>
 rkci::Vector<T, TStaticSize>::~Vector()
 {
+#if RKC_VECTOR_STATS_ENABLED
+	if (m_statsActive)
+		GetStatsSite().RecordDestroyed(m_statsPeakCount, m_statsSpilled);
+#endif
+
 	T *elements = m_elements;
 	size_t remaining = m_count;
 
@@ -203,6 +283,17 @@ void rkci::Vector<T, TStaticSize>::Optimize()
 		newElements = this->GetStaticElements();
 		m_capacity = TStaticSize;
 	}
+	else if (IsTriviallyRelocatable<T>::kValue)
+	{
+		newElements = static_cast<T*>(m_alloc->Realloc(elements, sizeof(T) * m_count));
+		if (newElements)
+		{
+			m_elements = newElements;
+			m_capacity = m_count;
+		}
+
+		return;
+	}
 	else
 	{
 		newElements = static_cast<T*>(m_alloc->Alloc(sizeof(T) * m_count));
@@ -262,8 +353,6 @@ rkci::Result rkci::Vector<T, TStaticSize>::Reserve(size_t newSize)
 template<class T, size_t TStaticSize>
 rkci::Result rkci::Vector<T, TStaticSize>::ResizeNoConstruct(size_t newSize)
 {
-	T *elements = m_elements;
-
 	if (newSize <= m_count)
 	{
 		size_t count = m_count;
@@ -280,33 +369,87 @@ rkci::Result rkci::Vector<T, TStaticSize>::ResizeNoConstruct(size_t newSize)
 	if (newSize <= m_capacity)
 	{
 		m_count = newSize;
+#if RKC_VECTOR_STATS_ENABLED
+		StatsNoteCount();
+#endif
 		return Result::Ok();
 	}
 
-	size_t newCapacity = newSize;
-	assert(newCapacity > kStaticSize);
+	assert(newSize > kStaticSize);
+
+	RKC_CHECK(Relocate(newSize));
+	m_count = newSize;
+#if RKC_VECTOR_STATS_ENABLED
+	StatsNoteCount();
+#endif
+
+	return Result::Ok();
+}
+
+template<class T, size_t TStaticSize>
+rkci::Result rkci::Vector<T, TStaticSize>::Relocate(size_t newCapacity)
+{
+	RKC_ASSERT(newCapacity >= m_count && newCapacity > kStaticSize);
+
+#if RKC_VECTOR_STATS_ENABLED
+	m_statsSpilled = true;
+#endif
+
+	T *elements = m_elements;
+	const size_t count = m_count;
+
+	if (IsTriviallyRelocatable<T>::kValue && m_capacity > kStaticSize)
+	{
+		// Already on the heap, let the allocator grow in place if it can
+		T *newElements = static_cast<T*>(m_alloc->Realloc(elements, newCapacity * sizeof(T)));
+		if (!newElements)
+			return ::rkc::ResultCodes::kOutOfMemory;
+
+		m_elements = newElements;
+		m_capacity = newCapacity;
+		return Result::Ok();
+	}
 
 	T *newElements = static_cast<T*>(m_alloc->Alloc(newCapacity * sizeof(T)));
 	if (!newElements)
 		return ::rkc::ResultCodes::kOutOfMemory;
 
-	const size_t oldCount = m_count;
-	for (size_t i = 0; i < oldCount; i++)
-		new (newElements + i) T(static_cast<T&&>(elements[i]));
+	if (IsTriviallyRelocatable<T>::kValue)
+	{
+		if (count > 0)
+			memcpy(static_cast<void*>(newElements), static_cast<const void*>(elements), count * sizeof(T));
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++)
+			new (newElements + i) T(static_cast<T&&>(elements[i]));
 
-	for (size_t i = 0; i < oldCount; i++)
-		elements[oldCount - 1 - i].~T();
+		for (size_t i = 0; i < count; i++)
+			elements[count - 1 - i].~T();
+	}
 
 	if (m_capacity > kStaticSize)
-		m_alloc->Release(m_elements);
+		m_alloc->Release(elements);
 
 	m_elements = newElements;
 	m_capacity = newCapacity;
-	m_count = newSize;
 
 	return Result::Ok();
 }
 
+template<class T, size_t TStaticSize>
+rkci::Result rkci::Vector<T, TStaticSize>::GrowForAppend(size_t numAdded)
+{
+	const size_t requiredCapacity = m_count + numAdded;
+	if (requiredCapacity < m_count)
+		return ::rkc::ResultCodes::kOutOfMemory;
+
+	if (requiredCapacity <= m_capacity)
+		return Result::Ok();
+
+	return Relocate(VectorGrowthPolicy<T>::ComputeCapacity(m_capacity, requiredCapacity));
+}
+
 template<class T, size_t TStaticSize>
 void rkci::Vector<T, TStaticSize>::ResizeNoConstructStatic(size_t newSize)
 {
@@ -339,20 +482,21 @@ void rkci::Vector<T, TStaticSize>::ResizeNoConstructStatic(size_t newSize)
 template<class T, size_t TStaticSize>
 rkci::Result rkci::Vector<T, TStaticSize>::Append(const T &item)
 {
-	const size_t oldCount = m_count;
-
-	if (m_count == m_capacity)
-	{
-		size_t newCapacity = m_capacity * 2;
-		if (newCapacity < 8)
-			newCapacity = 8;
+	// The item can be an element of this vector, which moves if the vector grows
+	const T *src = &item;
+	const bool isOwnElement = (src >= m_elements && src < m_elements + m_count);
+	const size_t ownIndex = isOwnElement ? static_cast<size_t>(src - m_elements) : 0;
 
-		RKC_CHECK(Reserve(newCapacity));
-	}
+	RKC_CHECK(GrowForAppend(1));
 
-	RKC_CHECK(ResizeNoConstruct(oldCount + 1));
+	if (isOwnElement)
+		src = m_elements + ownIndex;
 
-	new (m_elements + oldCount) T(item);
+	new (m_elements + m_count) T(*src);
+	m_count++;
+#if RKC_VECTOR_STATS_ENABLED
+	StatsNoteCount();
+#endif
 
 	return Result::Ok();
 }
@@ -360,20 +504,61 @@ rkci::Result rkci::Vector<T, TStaticSize>::Append(const T &item)
 template<class T, size_t TStaticSize>
 rkci::Result rkci::Vector<T, TStaticSize>::Append(T &&item)
 {
-	const size_t oldCount = m_count;
+	RKC_CHECK(GrowForAppend(1));
 
-	if (m_count == m_capacity)
-	{
-		size_t newCapacity = m_capacity * 2;
-		if (newCapacity < 8)
-			newCapacity = 8;
+	new (m_elements + m_count) T(static_cast<T&&>(item));
+	m_count++;
+#if RKC_VECTOR_STATS_ENABLED
+	StatsNoteCount();
+#endif
+
+	return Result::Ok();
+}
 
-		RKC_CHECK(Reserve(newCapacity));
+template<class T, size_t TStaticSize>
+rkci::Result rkci::Vector<T, TStaticSize>::AppendRange(const ArraySliceView<const T> &items)
+{
+	const size_t numItems = items.Count();
+	if (numItems == 0)
+		return Result::Ok();
+
+	// The items can be part of this vector, which moves if the vector grows
+	const T *src = &items[0];
+	const bool isOwnRange = (src >= m_elements && src < m_elements + m_count);
+	const size_t ownIndex = isOwnRange ? static_cast<size_t>(src - m_elements) : 0;
+
+	RKC_CHECK(GrowForAppend(numItems));
+
+	if (isOwnRange)
+		src = m_elements + ownIndex;
+
+	T *dest = m_elements + m_count;
+
+	if (std::is_trivially_copyable<T>::value)
+		memcpy(static_cast<void*>(dest), static_cast<const void*>(src), numItems * sizeof(T));
+	else
+	{
+		for (size_t i = 0; i < numItems; i++)
+			new (dest + i) T(src[i]);
 	}
 
-	RKC_CHECK(ResizeNoConstruct(oldCount + 1));
+	m_count += numItems;
+#if RKC_VECTOR_STATS_ENABLED
+	StatsNoteCount();
+#endif
 
-	new (m_elements + oldCount) T(static_cast<T&&>(item));
+	return Result::Ok();
+}
+
+template<class T, size_t TStaticSize>
+rkci::Result rkci::Vector<T, TStaticSize>::AppendUninitialized(size_t count)
+{
+	RKC_CHECK(GrowForAppend(count));
+
+	m_count += count;
+#if RKC_VECTOR_STATS_ENABLED
+	StatsNoteCount();
+#endif
 
 	return Result::Ok();
 }
@@ -424,17 +609,23 @@ rkci::Vector<T, TStaticSize> &rkci::Vector<T, TStaticSize>::operator=(rkci::Vect
 	for (size_t i = 0; i < oldCount; i++)
 		m_elements[i].~T();
 
-	const size_t oldCapacity = m_capacity;
-	m_capacity = other.m_capacity;
-	m_count = other.m_count;
-	m_alloc = other.m_alloc;
+#if RKC_VECTOR_STATS_ENABLED
+	if (m_statsActive)
+		GetStatsSite().RecordDestroyed(m_statsPeakCount, m_statsSpilled);
+	StatsTakeFrom(other);
+#endif
 
-	if (oldCapacity > TStaticSize)
+	// The old buffer goes back to the allocator that it came from
+	if (m_capacity > TStaticSize)
 	{
 		RKC_ASSERT(m_elements != this->GetStaticElements());
 		m_alloc->Release(m_elements);
 	}
 
+	m_capacity = other.m_capacity;
+	m_count = other.m_count;
+	m_alloc = other.m_alloc;
+
 	if (m_capacity > TStaticSize)
 		m_elements = other.m_elements;
 	else
@@ -459,3 +650,36 @@ rkci::IAllocator *rkci::Vector<T, TStaticSize>::GetAllocator() const
 {
 	return m_alloc;
 }
+
+#if RKC_VECTOR_STATS_ENABLED
+
+template<class T, size_t TStaticSize>
+void rkci::Vector<T, TStaticSize>::StatsNoteCount()
+{
+	if (m_count > m_statsPeakCount)
+		m_statsPeakCount = m_count;
+
+	m_statsActive = true;
+}
+
+// Moved-from vectors hand their history to the destination so each logical vector is recorded once
+template<class T, size_t TStaticSize>
+void rkci::Vector<T, TStaticSize>::StatsTakeFrom(Vector<T, TStaticSize> &other)
+{
+	m_statsPeakCount = other.m_statsPeakCount;
+	m_statsSpilled = other.m_statsSpilled;
+	m_statsActive = other.m_statsActive;
+
+	other.m_statsPeakCount = 0;
+	other.m_statsSpilled = false;
+	other.m_statsActive = false;
+}
+
+template<class T, size_t TStaticSize>
+rkci::VectorStatsSite &rkci::Vector<T, TStaticSize>::GetStatsSite()
+{
+	static VectorStatsSite site(RKC_FUNCTION_SIGNATURE, TStaticSize, sizeof(T));
+	return site;
+}
+
+#endif
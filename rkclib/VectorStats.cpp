@@ -0,0 +1,94 @@
+#include "VectorStats.h"
+
+#if RKC_VECTOR_STATS_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+std::atomic<rkci::VectorStatsSite*> rkci::VectorStatsSite::ms_firstSite(nullptr);
+
+rkci::VectorStatsSite::VectorStatsSite(const char *signature, size_t staticSize, size_t elementSize)
+	: m_signature(signature)
+	, m_staticSize(staticSize)
+	, m_elementSize(elementSize)
+	, m_numInstances(0)
+	, m_numSpilled(0)
+	, m_maxPeakCount(0)
+	, m_next(nullptr)
+{
+	for (size_t i = 0; i < kNumHistogramBuckets; i++)
+		m_histogram[i] = 0;
+
+	// Sites are created on first use, which can happen on several threads at once
+	VectorStatsSite *firstSite = ms_firstSite.load();
+	do
+	{
+		m_next = firstSite;
+	} while (!ms_firstSite.compare_exchange_weak(firstSite, this));
+
+	if (firstSite == nullptr)
+		atexit(DumpAll);
+}
+
+void rkci::VectorStatsSite::RecordDestroyed(size_t peakCount, bool spilled)
+{
+	m_numInstances++;
+	if (spilled)
+		m_numSpilled++;
+
+	size_t maxPeakCount = m_maxPeakCount.load();
+	while (peakCount > maxPeakCount && !m_maxPeakCount.compare_exchange_weak(maxPeakCount, peakCount))
+	{
+	}
+
+	m_histogram[GetBucketIndex(peakCount)]++;
+}
+
+// Bucket 0 holds empty vectors, bucket N holds peak counts from 2^(N-1) to 2^N-1, and the last bucket holds everything above
+size_t rkci::VectorStatsSite::GetBucketIndex(size_t count)
+{
+	size_t bucket = 0;
+	while (count > 0 && bucket < kNumHistogramBuckets - 1)
+	{
+		count >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+void rkci::VectorStatsSite::DumpAll()
+{
+	fprintf(stderr, "Vector inline storage statistics:\n");
+
+	for (const VectorStatsSite *site = ms_firstSite.load(); site != nullptr; site = site->m_next)
+	{
+		const size_t numInstances = site->m_numInstances.load();
+		if (numInstances == 0)
+			continue;
+
+		const size_t numSpilled = site->m_numSpilled.load();
+
+		fprintf(stderr, "%s\n", site->m_signature);
+		fprintf(stderr, "    Inline: %zu  Element size: %zu  Instances: %zu  Spilled to heap: %zu (%.1f%%)  Max size: %zu\n",
+			site->m_staticSize, site->m_elementSize, numInstances, numSpilled,
+			static_cast<double>(numSpilled) * 100.0 / static_cast<double>(numInstances), site->m_maxPeakCount.load());
+
+		for (size_t i = 0; i < kNumHistogramBuckets; i++)
+		{
+			const size_t count = site->m_histogram[i].load();
+			if (count == 0)
+				continue;
+
+			// Buckets 0 and 1 only hold one size each
+			if (i <= 1)
+				fprintf(stderr, "        %zu: %zu\n", i, count);
+			else if (i == kNumHistogramBuckets - 1)
+				fprintf(stderr, "        %zu+: %zu\n", static_cast<size_t>(1) << (i - 1), count);
+			else
+				fprintf(stderr, "        %zu-%zu: %zu\n", static_cast<size_t>(1) << (i - 1), (static_cast<size_t>(1) << i) - 1, count);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CoreDefs.h"
+
+#if RKC_VECTOR_STATS_ENABLED
+
+#include <atomic>
+
+namespace rkci
+{
+	// Per-instantiation record of Vector sizes, used to tune inline capacities.  Vectors are destroyed on
+	// compile worker threads too, so the counters are atomic.
+	class VectorStatsSite
+	{
+	public:
+		static const size_t kNumHistogramBuckets = 24;
+
+		VectorStatsSite(const char *signature, size_t staticSize, size_t elementSize);
+
+		void RecordDestroyed(size_t peakCount, bool spilled);
+
+		static void DumpAll();
+
+	private:
+		static size_t GetBucketIndex(size_t count);
+
+		const char *m_signature;
+		size_t m_staticSize;
+		size_t m_elementSize;
+
+		std::atomic<size_t> m_numInstances;
+		std::atomic<size_t> m_numSpilled;
+		std::atomic<size_t> m_maxPeakCount;
+		std::atomic<size_t> m_histogram[kNumHistogramBuckets];
+
+		VectorStatsSite *m_next;
+
+		static std::atomic<VectorStatsSite*> ms_firstSite;
+	};
+}
+
+#endif
@@ -1,44 +1,11 @@
 #include "rkclib.h"
+#include "RkcContext.h"
+#include "RkcStream.h"
 #include "Lexer.h"
+#include "ReadAheadStream.h"
 #include "HashMap.h"
 #include "MoveOrCopy.h"
 
-struct RkcAllocator : public rkci::IAllocator
-{
-	explicit RkcAllocator(const RkcAllocatorSpec &allocatorSpec);
-
-	void *Realloc(void *buf, size_t newSize) override;
-
-	RkcAllocatorSpec m_allocSpec;
-};
-
-RkcAllocator::RkcAllocator(const RkcAllocatorSpec &allocatorSpec)
-	: m_allocSpec(allocatorSpec)
-{
-}
-
-void *RkcAllocator::Realloc(void *buf, size_t newSize)
-{
-	return m_allocSpec.m_realloc(m_allocSpec.m_userdata, buf, newSize);
-}
-
-struct RkcStream : public rkci::IStream
-{
-	explicit RkcStream(const RkcStreamSpec &streamSpec);
-
-	 size_t Read(void *buf, size_t size) override;
-	 size_t Write(void *buf, size_t size) override;
-	 rkcUFilePos_t Tell() const override;
-	 bool SeekStart(rkcUFilePos_t pos) override;
-	 bool SeekEnd(rkcFilePos_t pos) override;
-	 bool SeekCurrent(rkcFilePos_t pos) override;
-	 bool IsReadable() const override;
-	 bool IsWritable() const override;
-	 void Close() override;
-
-	 RkcStreamSpec m_streamSpec;
-};
-
 RkcStream::RkcStream(const RkcStreamSpec &streamSpec)
 	: m_streamSpec(streamSpec)
 {
@@ -90,9 +57,65 @@ void RkcStream::Close()
 }
 
 
+static rkci::Result ParseModuleInternal(IRkcContext &context, rkci::IStream *stream)
+{
+	rkci::IAllocator &alloc = context.GetAllocator();
+	rkci::SymbolPool &symbolPool = context.GetSymbolPool();
+
+	rkci::ReadAheadStream readAheadStream(*stream, context.GetReadAheadPool(), &alloc, context.GetReadAheadBufferSize());
+	if (context.GetReadAheadBufferSize() > 0)
+	{
+		RKC_CHECK(readAheadStream.Start());
+		stream = &readAheadStream;
+	}
+
+	rkci::Lexer lexer(stream, &alloc, context.GetLexerBufferSize());
+
+	for (;;)
+	{
+		RKC_CHECK_RV(rkci::LexToken, lexToken, lexer.GetNextToken());
+
+		if (lexToken.m_tokenType == rkci::LexTokenType::kEndOfFile)
+			break;
+
+		if (lexToken.m_tokenType == rkci::LexTokenType::kName)
+			RKC_CHECK(symbolPool.Intern(lexToken.m_charBuffer.Slice()).DiscardValue());
+	}
+
+	return rkci::Result::Ok();
+}
+
+int RkcContextParseModule(IRkcContext *context, const RkcStreamSpec *streamSpec)
+{
+	RkcStream stream(*streamSpec);
+
+	context->BeginCompile();
+
+	rkci::Result result(ParseModuleInternal(*context, &stream));
+	result.Handle();
+
+	context->EndCompile();
+
+	return result.GetCode();
+}
+
+int RkcParseModule(const RkcStreamSpec *streamSpec, const RkcAllocatorSpec *allocSpec)
+{
+	IRkcContext *context = nullptr;
+
+	const int createResult = RkcCreateContext(&context, allocSpec, nullptr);
+	if (createResult != rkc::ResultCodes::kOK)
+		return createResult;
+
+	const int parseResult = RkcContextParseModule(context, streamSpec);
+	RkcDestroyContext(context);
+
+	return parseResult;
+}
+
 rkci::Result TestParseStreamInternal(rkci::IStream *stream, rkci::IAllocator *alloc)
 {
-	rkci::Lexer lexer(stream, alloc);
+	rkci::Lexer lexer(stream, alloc, rkci::Lexer::kDefaultBufferSize);
 
 	for (;;)
 	{
@@ -129,3 +152,12 @@ void RkcTest(const RkcAllocatorSpec *allocSpec)
 
 	RkcRunTests(allocator);
 }
+
+int RkcRunBenchmarks(rkci::IAllocator &alloc);
+
+int RkcBenchmark(const RkcAllocatorSpec *allocSpec)
+{
+	RkcAllocator allocator(*allocSpec);
+
+	return RkcRunBenchmarks(allocator);
+}
@@ -7,6 +7,8 @@
 
 #include "rkccore.h"
 #include "ResultCode.h"
+#include "AllocatorTag.h"
+#include "TokenType.h"
 
 typedef struct RkcAllocatorSpec
 {
@@ -45,6 +47,70 @@ typedef struct RkcStreamFunctions
 } RkcStreamFunctions;
 
 typedef struct IRkcContext IRkcContext;
+typedef struct IRkcComposite IRkcComposite;
+typedef struct IRkcModuleLoad IRkcModuleLoad;
+typedef struct IRkcLexer IRkcLexer;
+
+typedef struct RkcContextOptions
+{
+	// Set to sizeof(RkcContextOptions).  Options added after the host was built take their default values.
+	size_t m_structSize;
+
+	// If non-zero, allocations made through the context are tracked and can be queried with RkcGetAllocatorStats
+	int m_trackAllocations;
+
+	// If non-zero, module sources are read on background threads into buffers of this size while the
+	// lexer consumes the previous buffer.  Useful when sources are on slow storage.  The threads belong to
+	// the context and are shared by all modules, and they call the module streams' read functions, so those
+	// must not rely on being called from the thread that loads the module.
+	size_t m_readAheadBufferSize;
+
+	// Size of the lexer's read buffer, or 0 for the default of 64 KB.  Hosts that know a source's size
+	// can pass it to lex the whole source from one read.
+	size_t m_lexerBufferSize;
+
+	// Most read-ahead threads, or 0 for the default of 4.  A thread is started for each module reading
+	// ahead at the same time, up to this many, so that slow reads of different modules overlap.
+	size_t m_readAheadThreads;
+} RkcContextOptions;
+
+typedef struct RkcAllocatorTagStats
+{
+	size_t m_liveBytes;
+	size_t m_peakBytes;
+	size_t m_numAllocations;
+} RkcAllocatorTagStats;
+
+typedef struct RkcAllocatorStats
+{
+	// Requested bytes currently allocated, excluding tracking overhead
+	size_t m_liveBytes;
+
+	// Highest value of m_liveBytes
+	size_t m_peakBytes;
+
+	size_t m_numAllocations;
+	size_t m_numReleases;
+	size_t m_numFailedAllocations;
+
+	// Reallocations that the host allocator resized without moving the block
+	size_t m_numReallocsInPlace;
+
+	// Reallocations that moved the block to a new address
+	size_t m_numReallocsMoved;
+
+	// Statistics per subsystem, indexed by rkc::AllocatorTags
+	RkcAllocatorTagStats m_tags[rkc::AllocatorTags::kCount];
+} RkcAllocatorStats;
+
+typedef struct RkcContextStats
+{
+	// Distinct names interned by every compile on the context so far
+	size_t m_numSymbols;
+
+	// Powers of 2 and 5 held by the context's literal conversion cache
+	size_t m_numCachedPowers;
+} RkcContextStats;
 
 typedef struct RkcStreamSpec
 {
@@ -58,7 +124,138 @@ typedef struct RkcStreamSpec
 	void *m_userdata;
 } RkcStreamSpec;
 
-extern "C" int RkcCreateContext(IRkcContext **outContext, const RkcAllocatorSpec *alloc);
+typedef struct RkcJobSystem
+{
+	// Schedules jobFunc(jobData) to run, possibly on another thread.  Returns non-zero if the job was
+	// accepted, or 0 to have the library run the job itself once the compiling thread or a running job
+	// is free.  Jobs may be submitted from inside other jobs.  A job system that would run a job inside
+	// m_submit should return 0 instead, since long import chains would otherwise nest one job per
+	// module.  When a job system is used, the context's allocator must be thread-safe.
+	int (*m_submit)(void *userdata, void (*jobFunc)(void *jobData), void *jobData);
+	void *m_userdata;
+} RkcJobSystem;
+
+typedef struct RkcUnresolvedImport
+{
+	// Index of the importing module, as returned by RkcCompositeAddProgram
+	size_t m_importerIndex;
+
+	// Name of the missing module.  Valid until the composite or its context is next modified.
+	const uint8_t *m_name;
+	size_t m_nameLength;
+} RkcUnresolvedImport;
+
+typedef struct RkcCompositeCompileStats
+{
+	// Modules compiled by the last RkcCompositeCompile, including failed ones
+	size_t m_numModulesCompiled;
+
+	// Modules reused because neither their source nor the export interface of their imports changed
+	size_t m_numModulesSkipped;
+
+	// Distinct generic function instantiations in the composite, and requests for an instantiation that
+	// already existed.  These count every compile of the composite, since its modules share them.
+	size_t m_numInstantiations;
+	size_t m_numInstantiationsReused;
+} RkcCompositeCompileStats;
+
+typedef struct RkcToken
+{
+	// One of rkc::TokenTypes
+	int m_tokenType;
+
+	// Byte offsets of the token in the source.  The end offset is exclusive.
+	rkcUFilePos_t m_startOffset;
+	rkcUFilePos_t m_endOffset;
+
+	// Zero-based line and column of the start of the token.  Columns count characters, not bytes.
+	size_t m_line;
+	size_t m_col;
+
+	// For error tokens, the rkc::ResultCodes value describing the error.  0 for other tokens.
+	int m_errorCode;
+} RkcToken;
+
+typedef struct RkcLexerOptions
+{
+	// Set to sizeof(RkcLexerOptions).  Options added after the host was built take their default values.
+	size_t m_structSize;
+
+	// If non-zero, lexical errors produce error tokens instead of failing, and lexing resumes at the next
+	// line, so that every error in a source can be reported in one pass
+	int m_recoverFromErrors;
+} RkcLexerOptions;
+
+// Creates a context.  options may be null to use the defaults.
+extern "C" int RkcCreateContext(IRkcContext **outContext, const RkcAllocatorSpec *alloc, const RkcContextOptions *options);
+extern "C" void RkcDestroyContext(IRkcContext *context);
+extern "C" int RkcGetAllocatorStats(const IRkcContext *context, RkcAllocatorStats *outStats);
+
+// Reports how much the context's caches hold, so that hosts can check that warm-up is being reused
+extern "C" int RkcGetContextStats(const IRkcContext *context, RkcContextStats *outStats);
+
+// Parses a module using the context's caches.  Contexts are meant to be reused for many compiles.
+extern "C" int RkcContextParseModule(IRkcContext *context, const RkcStreamSpec *stream);
+
+// Composites are graphs of modules connected by imports.  Modules are compiled in import order, and
+// modules that don't depend on each other are compiled concurrently when a job system is provided.
+extern "C" int RkcCreateComposite(IRkcContext *context, IRkcComposite **outComposite);
+extern "C" void RkcDestroyComposite(IRkcComposite *composite);
+
+// Adds a module.  The stream must remain valid for the lifetime of the composite, or until it is
+// replaced with RkcCompositeUpdateProgram.  It must be seekable, since an importer is read again when
+// the export interface of one of its imports changes.
+extern "C" int RkcCompositeAddProgram(IRkcComposite *composite, const char *moduleName, const RkcStreamSpec *stream, size_t *outModuleIndex);
+extern "C" int RkcCompositeAddImport(IRkcComposite *composite, size_t importerIndex, const char *importedModuleName);
+
+// Replaces a module's source after it was edited.  On the next compile, the module is recompiled, and
+// its importers are only recompiled if its export interface changed.
+extern "C" int RkcCompositeUpdateProgram(IRkcComposite *composite, size_t moduleIndex, const RkcStreamSpec *stream);
+
+// Writes up to *inOutCount unresolved imports to outImports and sets *inOutCount to the total number
+// of unresolved imports.  outImports may be null to only query the count.
+extern "C" int RkcCompositeGetUnresolvedImports(const IRkcComposite *composite, RkcUnresolvedImport *outImports, size_t *inOutCount);
+
+// Compiles every module in the composite.  jobSystem may be null to compile on the calling thread.
+extern "C" int RkcCompositeCompile(IRkcComposite *composite, const RkcJobSystem *jobSystem);
+extern "C" int RkcCompositeGetCompileStats(const IRkcComposite *composite, RkcCompositeCompileStats *outStats);
+
+// Writes a module compiled by the last RkcCompositeCompile to a versioned module blob, which can be
+// stored in a cache and imported into a composite in a later run
+extern "C" int RkcCompiledProgramExport(const IRkcComposite *composite, size_t moduleIndex, const RkcStreamSpec *outStream);
+
+// Marks a module as compiled from a module blob, so that the next compile skips it.  Must be called
+// after the module's imports are added.  *outAccepted is set to 0 if the blob doesn't match the
+// module's current source, compiler version or options, in which case the module is compiled normally.
+// Blobs depend on the export interfaces of the module's imports, so a module whose imports changed is
+// still recompiled.
+extern "C" int RkcCompositeImportCompiledProgram(IRkcComposite *composite, size_t moduleIndex, const RkcStreamSpec *inStream, int *outAccepted);
+
+// Push-style module loading, for sources that arrive in chunks, such as from a pipe or an asynchronous
+// file system.  Each RkcModuleFeed lexes as much of the source as the bytes received so far allow, and
+// the bytes don't need to stay valid after it returns.  A load counts as a compile on its context until
+// it is finished or aborted.
+extern "C" int RkcBeginModuleLoad(IRkcContext *context, IRkcModuleLoad **outLoad);
+extern "C" int RkcModuleFeed(IRkcModuleLoad *load, const void *bytes, size_t size);
+
+// Processes the end of the source and releases the load, whether or not it succeeded
+extern "C" int RkcModuleFinish(IRkcModuleLoad *load);
+extern "C" void RkcAbortModuleLoad(IRkcModuleLoad *load);
+
+// Loads a module whose whole source is already in memory
+extern "C" int RkcLoadModuleText(IRkcContext *context, const void *text, size_t size);
+
+// Lexers tokenize a source without compiling it, for tools such as syntax highlighters.  The stream
+// must remain valid for the lifetime of the lexer.  options may be null to use the defaults.
+extern "C" int RkcCreateLexer(IRkcContext *context, const RkcStreamSpec *stream, const RkcLexerOptions *options, IRkcLexer **outLexer);
+extern "C" void RkcDestroyLexer(IRkcLexer *lexer);
+
+// Writes up to maxTokens tokens to outTokens and sets *outNumTokens to the number written.  The end of
+// file token is the last one written, and later calls write no tokens.  If lexing fails, the tokens
+// before the error are still written, and later calls write no tokens and return the same error.
+extern "C" int RkcLexBatch(IRkcLexer *lexer, RkcToken *outTokens, size_t maxTokens, size_t *outNumTokens);
+
+// Parses a module with a temporary context
 extern "C" int RkcParseModule(const RkcStreamSpec *stream, const RkcAllocatorSpec *alloc);
 
 #endif